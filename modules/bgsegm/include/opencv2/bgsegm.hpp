@@ -183,7 +183,82 @@ public:
 @param decisionThreshold Threshold value, above which it is marked foreground, else background.
  */
 CV_EXPORTS_W Ptr<BackgroundSubtractorGMG> createBackgroundSubtractorGMG(int initializationFrames=120,
-                                                                        double decisionThreshold=0.8);                                  
+                                                                        double decisionThreshold=0.8);
+
+/** @brief Runs the background subtraction of many video streams together.
+
+The manager owns the background models of all the streams. Frames can be pushed for any stream,
+from any thread, and are processed by process(): the pending frames of all the streams are split
+into tiles that are updated in parallel, so the load is balanced across the cores however many
+streams there are and whatever their sizes. The foreground masks are returned through a callback.
+
+A stream can be given one background model per horizontal tile of its frames. This is only valid
+for the models that process every pixel independently (e.g. BackgroundSubtractorMOG or
+BackgroundSubtractorMOG2 without shadow detection), and gives the same masks as a single model.
+The other models (e.g. BackgroundSubtractorGMG, which smooths its posterior) have to be given as
+a single model, the frames of a stream are then processed as a whole.
+ */
+class CV_EXPORTS_W BackgroundSubtractorMultiStream : public Algorithm
+{
+public:
+    /** @brief Receives the foreground masks computed by process().
+     */
+    class CV_EXPORTS MaskCallback
+    {
+    public:
+        virtual ~MaskCallback() {}
+        /** @brief Called once per processed frame, in the order the frames of a stream were pushed.
+        @param stream The stream the frame was pushed to.
+        @param fgmask The foreground mask of the frame, only valid during the call.
+         */
+        virtual void onMask(int stream, const Mat& fgmask) = 0;
+    };
+
+    /** @brief Adds a stream processed with one background model per horizontal tile of its frames.
+    @param tileModels The models of the tiles, from the top of the frames to the bottom.
+    @return The identifier of the new stream.
+     */
+    virtual int addStream(const std::vector<Ptr<BackgroundSubtractor> >& tileModels) = 0;
+
+    /** @brief Adds a stream processed as a whole with a single background model.
+    @param model The model of the stream.
+    @return The identifier of the new stream.
+     */
+    CV_WRAP virtual int addStream(const Ptr<BackgroundSubtractor>& model) = 0;
+
+    /** @brief Removes a stream and its pending frames.
+     */
+    CV_WRAP virtual void removeStream(int stream) = 0;
+
+    /** @brief Returns the number of streams.
+     */
+    CV_WRAP virtual int getNumStreams() const = 0;
+
+    /** @brief Queues a frame of a stream, the frame is copied.
+    @param stream The stream of the frame.
+    @param frame Next video frame of the stream.
+    @param learningRate The learning rate passed to BackgroundSubtractor::apply.
+     */
+    CV_WRAP virtual void pushFrame(int stream, InputArray frame, double learningRate=-1) = 0;
+
+    /** @brief Processes all the queued frames and sends their masks to the callback.
+
+    The frames pushed while process() runs are left for the next call.
+     */
+    CV_WRAP virtual void process() = 0;
+
+    /** @brief Returns the foreground mask of the last processed frame of a stream.
+     */
+    CV_WRAP virtual void getLastMask(int stream, OutputArray fgmask) const = 0;
+
+    /** @brief Sets the callback that receives the masks, may be empty.
+     */
+    virtual void setCallback(const Ptr<MaskCallback>& callback) = 0;
+};
+
+/** @brief Creates a multi-stream background subtraction manager.
+ */
+CV_EXPORTS_W Ptr<BackgroundSubtractorMultiStream> createBackgroundSubtractorMultiStream();
 
 //! @}
 
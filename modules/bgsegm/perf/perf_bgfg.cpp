@@ -0,0 +1,117 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::bgsegm;
+
+// A noisy static background with a square moving across it.
+static void makeFrames(Size sz, int type, int count, std::vector<Mat>& frames)
+{
+    RNG rng(0);
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    GaussianBlur(background, background, Size(9, 9), 0);
+    frames.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        Mat noise(sz, type);
+        rng.fill(noise, RNG::NORMAL, 0, 4);
+        add(background, noise, frames[i]);
+        int side = sz.height / 4;
+        Rect object((i * 16) % std::max(1, sz.width - side), sz.height / 2 - side / 2, side, side);
+        frames[i](object).setTo(Scalar::all(255));
+    }
+}
+
+CV_ENUM(FrameTypes, CV_8UC1, CV_8UC3);
+typedef tuple<FrameTypes, Size> BgFgParams;
+
+typedef TestBaseWithParam<BgFgParams> BackgroundSubtractorMOGPerfTest;
+
+PERF_TEST_P( BackgroundSubtractorMOGPerfTest, apply, Combine(FrameTypes::all(), Values(szVGA, sz720p, sz1080p)) )
+{
+    int type = get<0>(GetParam());
+    Size sz  = get<1>(GetParam());
+
+    std::vector<Mat> frames;
+    makeFrames(sz, type, 8, frames);
+    Mat fgmask;
+    Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+    for (size_t i = 0; i < frames.size(); i++)
+        mog->apply(frames[i], fgmask);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        mog->apply(frames[frame++ % frames.size()], fgmask);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam<BgFgParams> BackgroundSubtractorGMGPerfTest;
+
+PERF_TEST_P( BackgroundSubtractorGMGPerfTest, apply, Combine(FrameTypes::all(), Values(szVGA, sz720p)) )
+{
+    int type = get<0>(GetParam());
+    Size sz  = get<1>(GetParam());
+
+    std::vector<Mat> frames;
+    makeFrames(sz, type, 8, frames);
+    Mat fgmask;
+    Ptr<BackgroundSubtractorGMG> gmg = createBackgroundSubtractorGMG(4);
+    for (size_t i = 0; i < frames.size(); i++)
+        gmg->apply(frames[i], fgmask);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        gmg->apply(frames[frame++ % frames.size()], fgmask);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
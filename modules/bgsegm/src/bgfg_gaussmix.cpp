@@ -69,6 +69,20 @@ static const double defaultVarThreshold = 2.5*2.5;
 static const double defaultNoiseSigma = 30*0.5;
 static const double defaultInitialWeight = 0.05;
 
+// The mixtures of a pixel are stored as a structure of arrays: the sort keys,
+// the weights, the means and the variances (one array per channel for the last
+// two). Every array is padded to a multiple of 4 mixtures with zero weights, so
+// the mixtures of a pixel can be matched 4 at a time.
+static inline int mixtureStep(int nmixtures)
+{
+    return (nmixtures + 3) & -4;
+}
+
+static inline int mixtureFields(int nchannels)
+{
+    return 2 + 2*nchannels;
+}
+
 class BackgroundSubtractorMOGImpl : public BackgroundSubtractorMOG
 {
 public:
@@ -117,15 +131,14 @@ public:
         // for each gaussian mixture of each pixel bg model we store ...
         // the mixture sort key (w/sum_of_variances), the mixture weight (w),
         // the mean (nchannels values) and
-        // the diagonal covariance matrix (another nchannels values)
-        bgmodel.create( 1, frameSize.height*frameSize.width*nmixtures*(2 + 2*nchannels), CV_32F );
+        // the diagonal covariance matrix (another nchannels values),
+        // one row of the model per image row
+        bgmodel.create( frameSize.height, frameSize.width*mixtureStep(nmixtures)*mixtureFields(nchannels), CV_32F );
         bgmodel = Scalar::all(0);
     }
 
-    virtual void getBackgroundImage(OutputArray) const
-    {
-        CV_Error( Error::StsNotImplemented, "" );
-    }
+    //! computes a background image as the weighted mean of the background mixtures
+    virtual void getBackgroundImage(OutputArray backgroundImage) const;
 
     virtual int getHistory() const { return history; }
     virtual void setHistory(int _nframes) { history = _nframes; }
@@ -171,258 +184,220 @@ protected:
 };
 
 
-template<typename VT> struct MixData
+// Returns the first mixture that has a negligible weight or matches the pixel,
+// or K if there is none.
+template<int cn> static inline int
+findMixture( const float* weight, const float* mean, const float* var, const float* pix,
+             float vT, int K, int Kstep, bool useSIMD )
 {
-    float sortKey;
-    float weight;
-    VT mean;
-    VT var;
-};
-
-
-static void process8uC1( const Mat& image, Mat& fgmask, double learningRate,
-                         Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
-{
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
-    float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
-    int K = nmixtures;
-    MixData<float>* mptr = (MixData<float>*)bgmodel.data;
-
-    const float w0 = (float)defaultInitialWeight;
-    const float sk0 = (float)(w0/(defaultNoiseSigma*2));
-    const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
-    const float minVar = (float)(noiseSigma*noiseSigma);
-
-    for( y = 0; y < rows; y++ )
+    int k = 0;
+#if CV_SSE2
+    if( useSIMD )
     {
-        const uchar* src = image.ptr<uchar>(y);
-        uchar* dst = fgmask.ptr<uchar>(y);
-
-        if( alpha > 0 )
+        const __m128 eps = _mm_set1_ps(FLT_EPSILON), vT4 = _mm_set1_ps(vT);
+        for( ; k < Kstep; k += 4 )
         {
-            for( x = 0; x < cols; x++, mptr += K )
+            __m128 d2 = _mm_setzero_ps(), vsum = _mm_setzero_ps();
+            for( int c = 0; c < cn; c++ )
             {
-                float wsum = 0;
-                float pix = src[x];
-                int kHit = -1, kForeground = -1;
-
-                for( k = 0; k < K; k++ )
-                {
-                    float w = mptr[k].weight;
-                    wsum += w;
-                    if( w < FLT_EPSILON )
-                        break;
-                    float mu = mptr[k].mean;
-                    float var = mptr[k].var;
-                    float diff = pix - mu;
-                    float d2 = diff*diff;
-                    if( d2 < vT*var )
-                    {
-                        wsum -= w;
-                        float dw = alpha*(1.f - w);
-                        mptr[k].weight = w + dw;
-                        mptr[k].mean = mu + alpha*diff;
-                        var = std::max(var + alpha*(d2 - var), minVar);
-                        mptr[k].var = var;
-                        mptr[k].sortKey = w/std::sqrt(var);
-
-                        for( k1 = k-1; k1 >= 0; k1-- )
-                        {
-                            if( mptr[k1].sortKey >= mptr[k1+1].sortKey )
-                                break;
-                            std::swap( mptr[k1], mptr[k1+1] );
-                        }
-
-                        kHit = k1+1;
-                        break;
-                    }
-                }
-
-                if( kHit < 0 ) // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
-                {
-                    kHit = k = std::min(k, K-1);
-                    wsum += w0 - mptr[k].weight;
-                    mptr[k].weight = w0;
-                    mptr[k].mean = pix;
-                    mptr[k].var = var0;
-                    mptr[k].sortKey = sk0;
-                }
-                else
-                    for( ; k < K; k++ )
-                        wsum += mptr[k].weight;
-
-                float wscale = 1.f/wsum;
-                wsum = 0;
-                for( k = 0; k < K; k++ )
-                {
-                    wsum += mptr[k].weight *= wscale;
-                    mptr[k].sortKey *= wscale;
-                    if( wsum > T && kForeground < 0 )
-                        kForeground = k+1;
-                }
-
-                dst[x] = (uchar)(-(kHit >= kForeground));
+                __m128 diff = _mm_sub_ps(_mm_set1_ps(pix[c]), _mm_loadu_ps(mean + c*Kstep + k));
+                d2 = _mm_add_ps(d2, _mm_mul_ps(diff, diff));
+                vsum = _mm_add_ps(vsum, _mm_loadu_ps(var + c*Kstep + k));
             }
-        }
-        else
-        {
-            for( x = 0; x < cols; x++, mptr += K )
+            __m128 found = _mm_or_ps(_mm_cmplt_ps(_mm_loadu_ps(weight + k), eps),
+                                     _mm_cmplt_ps(d2, _mm_mul_ps(vT4, vsum)));
+            int mask = _mm_movemask_ps(found);
+            if( mask )
             {
-                float pix = src[x];
-                int kHit = -1, kForeground = -1;
-
-                for( k = 0; k < K; k++ )
+                while( !(mask & 1) )
                 {
-                    if( mptr[k].weight < FLT_EPSILON )
-                        break;
-                    float mu = mptr[k].mean;
-                    float var = mptr[k].var;
-                    float diff = pix - mu;
-                    float d2 = diff*diff;
-                    if( d2 < vT*var )
-                    {
-                        kHit = k;
-                        break;
-                    }
+                    mask >>= 1;
+                    k++;
                 }
-
-                if( kHit >= 0 )
-                {
-                    float wsum = 0;
-                    for( k = 0; k < K; k++ )
-                    {
-                        wsum += mptr[k].weight;
-                        if( wsum > T )
-                        {
-                            kForeground = k+1;
-                            break;
-                        }
-                    }
-                }
-
-                dst[x] = (uchar)(kHit < 0 || kHit >= kForeground ? 255 : 0);
+                return std::min(k, K);
             }
         }
+        return K;
     }
+#else
+    (void)useSIMD;
+#endif
+    for( ; k < K; k++ )
+    {
+        if( weight[k] < FLT_EPSILON )
+            break;
+        float d2 = 0, vsum = 0;
+        for( int c = 0; c < cn; c++ )
+        {
+            float diff = pix[c] - mean[c*Kstep + k];
+            d2 += diff*diff;
+            vsum += var[c*Kstep + k];
+        }
+        if( d2 < vT*vsum )
+            break;
+    }
+    return k;
 }
 
+// Multiplies the weights and the sort keys of the mixtures by scale.
+static inline void scaleMixtures( float* sortKey, float* weight, float scale, int Kstep, bool useSIMD )
+{
+    int k = 0;
+#if CV_SSE2
+    if( useSIMD )
+    {
+        __m128 s = _mm_set1_ps(scale);
+        for( ; k < Kstep; k += 4 )
+        {
+            _mm_storeu_ps(weight + k, _mm_mul_ps(_mm_loadu_ps(weight + k), s));
+            _mm_storeu_ps(sortKey + k, _mm_mul_ps(_mm_loadu_ps(sortKey + k), s));
+        }
+    }
+#else
+    (void)useSIMD;
+#endif
+    for( ; k < Kstep; k++ )
+    {
+        weight[k] *= scale;
+        sortKey[k] *= scale;
+    }
+}
 
-static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
-                         Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+// Updates the mixtures of a range of rows and computes their foreground mask,
+// the pixels are independent so the rows are processed in parallel.
+template<int cn> class MOG_LoopBody : public ParallelLoopBody
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
-    float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
-    int K = nmixtures;
+public:
+    MOG_LoopBody(const Mat& image, const Mat& fgmask, const Mat& bgmodel, double learningRate,
+                 int nmixtures, double backgroundRatio, double varThreshold, double noiseSigma) :
+        image_(image), fgmask_(fgmask), bgmodel_(bgmodel), nmixtures_(nmixtures)
+    {
+        alpha_ = (float)learningRate;
+        T_ = (float)backgroundRatio;
+        vT_ = (float)varThreshold;
+        w0_ = (float)defaultInitialWeight;
+        sk0_ = (float)(w0_/(defaultNoiseSigma*2*std::sqrt((double)cn)));
+        var0_ = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
+        minVar_ = (float)(noiseSigma*noiseSigma);
+#if CV_SSE2
+        useSIMD_ = checkHardwareSupport(CV_CPU_SSE2);
+#else
+        useSIMD_ = false;
+#endif
+    }
 
-    const float w0 = (float)defaultInitialWeight;
-    const float sk0 = (float)(w0/(defaultNoiseSigma*2*std::sqrt(3.)));
-    const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
-    const float minVar = (float)(noiseSigma*noiseSigma);
-    MixData<Vec3f>* mptr = (MixData<Vec3f>*)bgmodel.data;
+    void operator() (const Range& range) const;
 
-    for( y = 0; y < rows; y++ )
+private:
+    Mat image_;
+    mutable Mat fgmask_;
+    mutable Mat bgmodel_;
+    int nmixtures_;
+    float alpha_, T_, vT_;
+    float w0_, sk0_, var0_, minVar_;
+    bool useSIMD_;
+};
+
+template<int cn> void MOG_LoopBody<cn>::operator() (const Range& range) const
+{
+    const int K = nmixtures_, Kstep = mixtureStep(K), nfields = mixtureFields(cn);
+    const int pixstep = Kstep*nfields;
+    const float alpha = alpha_, T = T_, vT = vT_;
+    int x, k, k1, c, cols = image_.cols;
+
+    for( int y = range.start; y < range.end; y++ )
     {
-        const uchar* src = image.ptr<uchar>(y);
-        uchar* dst = fgmask.ptr<uchar>(y);
+        const uchar* src = image_.ptr<uchar>(y);
+        uchar* dst = fgmask_.ptr<uchar>(y);
+        float* mptr = bgmodel_.ptr<float>(y);
 
-        if( alpha > 0 )
+        for( x = 0; x < cols; x++, mptr += pixstep )
         {
-            for( x = 0; x < cols; x++, mptr += K )
+            float* sortKey = mptr;
+            float* weight = mptr + Kstep;
+            float* mean = mptr + Kstep*2;
+            float* var = mptr + Kstep*(2 + cn);
+            float pix[cn];
+            for( c = 0; c < cn; c++ )
+                pix[c] = src[x*cn + c];
+
+            int kFound = findMixture<cn>(weight, mean, var, pix, vT, K, Kstep, useSIMD_);
+            bool matched = kFound < K && weight[kFound] >= FLT_EPSILON;
+            int kHit = -1, kForeground = -1;
+
+            if( alpha > 0 )
             {
                 float wsum = 0;
-                Vec3f pix(src[x*3], src[x*3+1], src[x*3+2]);
-                int kHit = -1, kForeground = -1;
+                for( k = 0; k <= std::min(kFound, K-1); k++ )
+                    wsum += weight[k];
+                k = kFound;
 
-                for( k = 0; k < K; k++ )
+                if( matched )
                 {
-                    float w = mptr[k].weight;
-                    wsum += w;
-                    if( w < FLT_EPSILON )
-                        break;
-                    Vec3f mu = mptr[k].mean;
-                    Vec3f var = mptr[k].var;
-                    Vec3f diff = pix - mu;
-                    float d2 = diff.dot(diff);
-                    if( d2 < vT*(var[0] + var[1] + var[2]) )
+                    float w = weight[k];
+                    wsum -= w;
+                    float dw = alpha*(1.f - w);
+                    weight[k] = w + dw;
+                    float vsum = 0;
+                    for( c = 0; c < cn; c++ )
                     {
-                        wsum -= w;
-                        float dw = alpha*(1.f - w);
-                        mptr[k].weight = w + dw;
-                        mptr[k].mean = mu + alpha*diff;
-                        var = Vec3f(std::max(var[0] + alpha*(diff[0]*diff[0] - var[0]), minVar),
-                                    std::max(var[1] + alpha*(diff[1]*diff[1] - var[1]), minVar),
-                                    std::max(var[2] + alpha*(diff[2]*diff[2] - var[2]), minVar));
-                        mptr[k].var = var;
-                        mptr[k].sortKey = w/std::sqrt(var[0] + var[1] + var[2]);
-
-                        for( k1 = k-1; k1 >= 0; k1-- )
-                        {
-                            if( mptr[k1].sortKey >= mptr[k1+1].sortKey )
-                                break;
-                            std::swap( mptr[k1], mptr[k1+1] );
-                        }
+                        float diff = pix[c] - mean[c*Kstep + k];
+                        mean[c*Kstep + k] += alpha*diff;
+                        float v = var[c*Kstep + k];
+                        v = std::max(v + alpha*(diff*diff - v), minVar_);
+                        var[c*Kstep + k] = v;
+                        vsum += v;
+                    }
+                    sortKey[k] = w/std::sqrt(vsum);
 
-                        kHit = k1+1;
-                        break;
+                    for( k1 = k-1; k1 >= 0; k1-- )
+                    {
+                        if( sortKey[k1] >= sortKey[k1+1] )
+                            break;
+                        for( int f = 0; f < nfields; f++ )
+                            std::swap( mptr[f*Kstep + k1], mptr[f*Kstep + k1 + 1] );
                     }
-                }
 
-                if( kHit < 0 ) // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
+                    kHit = k1+1;
+                    for( ; k < K; k++ )
+                        wsum += weight[k];
+                }
+                else // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
                 {
                     kHit = k = std::min(k, K-1);
-                    wsum += w0 - mptr[k].weight;
-                    mptr[k].weight = w0;
-                    mptr[k].mean = pix;
-                    mptr[k].var = Vec3f(var0, var0, var0);
-                    mptr[k].sortKey = sk0;
+                    wsum += w0_ - weight[k];
+                    weight[k] = w0_;
+                    for( c = 0; c < cn; c++ )
+                    {
+                        mean[c*Kstep + k] = pix[c];
+                        var[c*Kstep + k] = var0_;
+                    }
+                    sortKey[k] = sk0_;
                 }
-                else
-                    for( ; k < K; k++ )
-                        wsum += mptr[k].weight;
 
-                float wscale = 1.f/wsum;
+                scaleMixtures(sortKey, weight, 1.f/wsum, Kstep, useSIMD_);
                 wsum = 0;
                 for( k = 0; k < K; k++ )
                 {
-                    wsum += mptr[k].weight *= wscale;
-                    mptr[k].sortKey *= wscale;
-                    if( wsum > T && kForeground < 0 )
+                    wsum += weight[k];
+                    if( wsum > T )
+                    {
                         kForeground = k+1;
+                        break;
+                    }
                 }
 
                 dst[x] = (uchar)(-(kHit >= kForeground));
             }
-        }
-        else
-        {
-            for( x = 0; x < cols; x++, mptr += K )
+            else
             {
-                Vec3f pix(src[x*3], src[x*3+1], src[x*3+2]);
-                int kHit = -1, kForeground = -1;
-
-                for( k = 0; k < K; k++ )
-                {
-                    if( mptr[k].weight < FLT_EPSILON )
-                        break;
-                    Vec3f mu = mptr[k].mean;
-                    Vec3f var = mptr[k].var;
-                    Vec3f diff = pix - mu;
-                    float d2 = diff.dot(diff);
-                    if( d2 < vT*(var[0] + var[1] + var[2]) )
-                    {
-                        kHit = k;
-                        break;
-                    }
-                }
-
-                if( kHit >= 0 )
+                if( matched )
                 {
+                    kHit = kFound;
                     float wsum = 0;
                     for( k = 0; k < K; k++ )
                     {
-                        wsum += mptr[k].weight;
+                        wsum += weight[k];
                         if( wsum > T )
                         {
                             kForeground = k+1;
@@ -453,14 +428,58 @@ void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask,
     learningRate = learningRate >= 0 && nframes > 1 ? learningRate : 1./std::min( nframes, history );
     CV_Assert(learningRate >= 0);
 
+    double nstripes = image.total()/(double)(1<<16);
     if( image.type() == CV_8UC1 )
-        process8uC1( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
+        parallel_for_(Range(0, image.rows),
+                      MOG_LoopBody<1>(image, fgmask, bgmodel, learningRate, nmixtures, backgroundRatio, varThreshold, noiseSigma),
+                      nstripes);
     else if( image.type() == CV_8UC3 )
-        process8uC3( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
+        parallel_for_(Range(0, image.rows),
+                      MOG_LoopBody<3>(image, fgmask, bgmodel, learningRate, nmixtures, backgroundRatio, varThreshold, noiseSigma),
+                      nstripes);
     else
         CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
 }
 
+void BackgroundSubtractorMOGImpl::getBackgroundImage(OutputArray backgroundImage) const
+{
+    int nchannels = CV_MAT_CN(frameType);
+    CV_Assert( nchannels == 1 || nchannels == 3 );
+    const int K = nmixtures, Kstep = mixtureStep(K), pixstep = Kstep*mixtureFields(nchannels);
+    const float T = (float)backgroundRatio;
+    Mat meanBackground(frameSize, CV_MAKETYPE(CV_8U, nchannels), Scalar::all(0));
+
+    for( int y = 0; y < frameSize.height; y++ )
+    {
+        const float* mptr = bgmodel.ptr<float>(y);
+        uchar* dst = meanBackground.ptr<uchar>(y);
+
+        for( int x = 0; x < frameSize.width; x++, mptr += pixstep )
+        {
+            const float* weight = mptr + Kstep;
+            const float* mean = mptr + Kstep*2;
+            float meanVal[3] = { 0.f, 0.f, 0.f };
+            float totalWeight = 0.f;
+
+            // the mixtures are sorted, the background ones come first like in apply()
+            for( int k = 0; k < K && weight[k] >= FLT_EPSILON; k++ )
+            {
+                totalWeight += weight[k];
+                for( int c = 0; c < nchannels; c++ )
+                    meanVal[c] += weight[k]*mean[c*Kstep + k];
+                if( totalWeight > T )
+                    break;
+            }
+
+            float invWeight = totalWeight > 0.f ? 1.f/totalWeight : 0.f;
+            for( int c = 0; c < nchannels; c++ )
+                dst[x*nchannels + c] = saturate_cast<uchar>(meanVal[c]*invWeight);
+        }
+    }
+
+    meanBackground.copyTo(backgroundImage);
+}
+
 Ptr<BackgroundSubtractorMOG> createBackgroundSubtractorMOG(int history, int nmixtures,
                                   double backgroundRatio, double noiseSigma)
 {
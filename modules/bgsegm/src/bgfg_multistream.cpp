@@ -0,0 +1,266 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                          License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2016, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+#include <deque>
+#include <map>
+
+namespace cv
+{
+namespace bgsegm
+{
+
+class BackgroundSubtractorMultiStreamImpl : public BackgroundSubtractorMultiStream
+{
+public:
+    BackgroundSubtractorMultiStreamImpl() : nextStream_(0) {}
+
+    virtual int addStream(const std::vector<Ptr<BackgroundSubtractor> >& tileModels);
+    virtual int addStream(const Ptr<BackgroundSubtractor>& model);
+    virtual void removeStream(int stream);
+    virtual int getNumStreams() const;
+    virtual void pushFrame(int stream, InputArray frame, double learningRate);
+    virtual void process();
+    virtual void getLastMask(int stream, OutputArray fgmask) const;
+    virtual void setCallback(const Ptr<MaskCallback>& callback);
+
+    struct Frame
+    {
+        Mat image;
+        double learningRate;
+    };
+
+    struct Stream
+    {
+        std::vector<Ptr<BackgroundSubtractor> > models;
+        std::deque<Frame> pending;
+        Mat lastMask;
+    };
+
+    // A frame taken from the queue of a stream and its mask.
+    struct Work
+    {
+        int id;
+        Ptr<Stream> stream;
+        Frame frame;
+        Mat fgmask;
+    };
+
+private:
+    Ptr<Stream> getStream(int stream) const;
+
+    // Guards the streams and their queues.
+    mutable Mutex mutex_;
+    // Serializes the calls of process(), the only place the models are used.
+    Mutex processMutex_;
+    std::map<int, Ptr<Stream> > streams_;
+    int nextStream_;
+    Ptr<MaskCallback> callback_;
+};
+
+// Updates the models of a set of tiles, every tile being a separate task so
+// that the scheduler balances the load across the streams.
+class MultiStream_LoopBody : public ParallelLoopBody
+{
+public:
+    MultiStream_LoopBody(std::vector<BackgroundSubtractorMultiStreamImpl::Work>& work,
+                         const std::vector<std::pair<int, int> >& tiles) :
+        work_(&work), tiles_(&tiles)
+    {
+    }
+
+    void operator() (const Range& range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            BackgroundSubtractorMultiStreamImpl::Work& w = (*work_)[(*tiles_)[i].first];
+            int tile = (*tiles_)[i].second, ntiles = (int)w.stream->models.size();
+            int rows = w.frame.image.rows;
+            int y0 = (int)((int64)rows * tile / ntiles), y1 = (int)((int64)rows * (tile + 1) / ntiles);
+            if (y0 == y1)
+                continue;
+            Mat fgmask = w.fgmask.rowRange(y0, y1);
+            w.stream->models[tile]->apply(w.frame.image.rowRange(y0, y1), fgmask, w.frame.learningRate);
+        }
+    }
+
+private:
+    std::vector<BackgroundSubtractorMultiStreamImpl::Work>* work_;
+    const std::vector<std::pair<int, int> >* tiles_;
+};
+
+int BackgroundSubtractorMultiStreamImpl::addStream(const std::vector<Ptr<BackgroundSubtractor> >& tileModels)
+{
+    CV_Assert( !tileModels.empty() );
+    for (size_t i = 0; i < tileModels.size(); i++)
+        CV_Assert( !tileModels[i].empty() );
+    Ptr<Stream> stream = makePtr<Stream>();
+    stream->models = tileModels;
+
+    AutoLock lock(mutex_);
+    int id = nextStream_++;
+    streams_[id] = stream;
+    return id;
+}
+
+int BackgroundSubtractorMultiStreamImpl::addStream(const Ptr<BackgroundSubtractor>& model)
+{
+    return addStream(std::vector<Ptr<BackgroundSubtractor> >(1, model));
+}
+
+void BackgroundSubtractorMultiStreamImpl::removeStream(int stream)
+{
+    AutoLock lock(mutex_);
+    streams_.erase(stream);
+}
+
+int BackgroundSubtractorMultiStreamImpl::getNumStreams() const
+{
+    AutoLock lock(mutex_);
+    return (int)streams_.size();
+}
+
+Ptr<BackgroundSubtractorMultiStreamImpl::Stream> BackgroundSubtractorMultiStreamImpl::getStream(int stream) const
+{
+    std::map<int, Ptr<Stream> >::const_iterator it = streams_.find(stream);
+    if (it == streams_.end())
+        CV_Error( Error::StsBadArg, format("Unknown stream %d", stream) );
+    return it->second;
+}
+
+void BackgroundSubtractorMultiStreamImpl::pushFrame(int stream, InputArray frame, double learningRate)
+{
+    Frame f;
+    frame.getMat().copyTo(f.image);
+    f.learningRate = learningRate;
+
+    AutoLock lock(mutex_);
+    getStream(stream)->pending.push_back(f);
+}
+
+void BackgroundSubtractorMultiStreamImpl::process()
+{
+    AutoLock processLock(processMutex_);
+
+    // only the frames queued so far are processed
+    std::vector<std::pair<Ptr<Stream>, int> > queued;
+    std::vector<int> ids;
+    {
+        AutoLock lock(mutex_);
+        for (std::map<int, Ptr<Stream> >::const_iterator it = streams_.begin(); it != streams_.end(); ++it)
+        {
+            if (!it->second->pending.empty())
+            {
+                queued.push_back(std::make_pair(it->second, (int)it->second->pending.size()));
+                ids.push_back(it->first);
+            }
+        }
+    }
+
+    // the frames of a stream depend on each other, so every round takes
+    // the next frame of all the streams that have one left
+    for (;;)
+    {
+        std::vector<Work> work;
+        {
+            AutoLock lock(mutex_);
+            for (size_t i = 0; i < queued.size(); i++)
+            {
+                Stream& stream = *queued[i].first;
+                if (queued[i].second == 0 || stream.pending.empty())
+                    continue;
+                Work w;
+                w.id = ids[i];
+                w.stream = queued[i].first;
+                w.frame = stream.pending.front();
+                stream.pending.pop_front();
+                queued[i].second--;
+                work.push_back(w);
+            }
+        }
+        if (work.empty())
+            break;
+
+        std::vector<std::pair<int, int> > tiles;
+        for (size_t i = 0; i < work.size(); i++)
+        {
+            work[i].fgmask.create(work[i].frame.image.size(), CV_8U);
+            for (size_t t = 0; t < work[i].stream->models.size(); t++)
+                tiles.push_back(std::make_pair((int)i, (int)t));
+        }
+        parallel_for_(Range(0, (int)tiles.size()), MultiStream_LoopBody(work, tiles), (double)tiles.size());
+
+        Ptr<MaskCallback> callback;
+        {
+            AutoLock lock(mutex_);
+            for (size_t i = 0; i < work.size(); i++)
+                work[i].stream->lastMask = work[i].fgmask;
+            callback = callback_;
+        }
+        if (callback)
+        {
+            for (size_t i = 0; i < work.size(); i++)
+                callback->onMask(work[i].id, work[i].fgmask);
+        }
+    }
+}
+
+void BackgroundSubtractorMultiStreamImpl::getLastMask(int stream, OutputArray fgmask) const
+{
+    AutoLock lock(mutex_);
+    getStream(stream)->lastMask.copyTo(fgmask);
+}
+
+void BackgroundSubtractorMultiStreamImpl::setCallback(const Ptr<MaskCallback>& callback)
+{
+    AutoLock lock(mutex_);
+    callback_ = callback;
+}
+
+Ptr<BackgroundSubtractorMultiStream> createBackgroundSubtractorMultiStream()
+{
+    return makePtr<BackgroundSubtractorMultiStreamImpl>();
+}
+
+}
+}
+
+/* End of file. */
@@ -0,0 +1,262 @@
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::bgsegm;
+
+namespace
+{
+
+// Straightforward MOG with one structure per mixture, used as the reference
+// of the optimized implementation. It uses the default parameters of
+// createBackgroundSubtractorMOG().
+class ReferenceMOG
+{
+public:
+    ReferenceMOG() : K(5), history(200), nframes(0), T(0.7f), vT(6.25f), noiseSigma(15.f) {}
+
+    void apply(const Mat& image, Mat& fgmask, double learningRate = -1)
+    {
+        const int cn = image.channels();
+        if (nframes == 0 || learningRate >= 1 || image.size() != size || cn != nchannels)
+        {
+            size = image.size();
+            nchannels = cn;
+            nframes = 0;
+            model.assign(size.area()*K, Mixture());
+        }
+        ++nframes;
+        learningRate = learningRate >= 0 && nframes > 1 ? learningRate : 1./std::min(nframes, history);
+        const float alpha = (float)learningRate;
+        const float w0 = 0.05f, var0 = 15.f*15.f*4, minVar = noiseSigma*noiseSigma;
+        const float sk0 = (float)(w0/(15.*2*std::sqrt((double)cn)));
+
+        fgmask.create(size, CV_8U);
+        for (int y = 0; y < size.height; y++)
+        for (int x = 0; x < size.width; x++)
+        {
+            Mixture* m = &model[(y*size.width + x)*K];
+            const uchar* src = image.ptr<uchar>(y) + x*cn;
+            float pix[3];
+            for (int c = 0; c < cn; c++)
+                pix[c] = src[c];
+            int k, k1, kHit = -1, kForeground = -1;
+
+            if (alpha > 0)
+            {
+                float wsum = 0;
+                for (k = 0; k < K; k++)
+                {
+                    float w = m[k].weight;
+                    wsum += w;
+                    if (w < FLT_EPSILON)
+                        break;
+                    float d2 = 0, vsum = 0, diff[3];
+                    for (int c = 0; c < cn; c++)
+                    {
+                        diff[c] = pix[c] - m[k].mean[c];
+                        d2 += diff[c]*diff[c];
+                        vsum += m[k].var[c];
+                    }
+                    if (d2 < vT*vsum)
+                    {
+                        wsum -= w;
+                        m[k].weight = w + alpha*(1.f - w);
+                        vsum = 0;
+                        for (int c = 0; c < cn; c++)
+                        {
+                            m[k].mean[c] += alpha*diff[c];
+                            m[k].var[c] = std::max(m[k].var[c] + alpha*(diff[c]*diff[c] - m[k].var[c]), minVar);
+                            vsum += m[k].var[c];
+                        }
+                        m[k].sortKey = w/std::sqrt(vsum);
+                        for (k1 = k-1; k1 >= 0; k1--)
+                        {
+                            if (m[k1].sortKey >= m[k1+1].sortKey)
+                                break;
+                            std::swap(m[k1], m[k1+1]);
+                        }
+                        kHit = k1+1;
+                        break;
+                    }
+                }
+                if (kHit < 0)
+                {
+                    kHit = k = std::min(k, K-1);
+                    wsum += w0 - m[k].weight;
+                    m[k].weight = w0;
+                    for (int c = 0; c < cn; c++)
+                    {
+                        m[k].mean[c] = pix[c];
+                        m[k].var[c] = var0;
+                    }
+                    m[k].sortKey = sk0;
+                }
+                else
+                    for (; k < K; k++)
+                        wsum += m[k].weight;
+
+                float wscale = 1.f/wsum;
+                wsum = 0;
+                for (k = 0; k < K; k++)
+                {
+                    wsum += m[k].weight *= wscale;
+                    m[k].sortKey *= wscale;
+                    if (wsum > T && kForeground < 0)
+                        kForeground = k+1;
+                }
+                fgmask.at<uchar>(y, x) = (uchar)(-(kHit >= kForeground));
+            }
+            else
+            {
+                for (k = 0; k < K; k++)
+                {
+                    if (m[k].weight < FLT_EPSILON)
+                        break;
+                    float d2 = 0, vsum = 0;
+                    for (int c = 0; c < cn; c++)
+                    {
+                        float diff = pix[c] - m[k].mean[c];
+                        d2 += diff*diff;
+                        vsum += m[k].var[c];
+                    }
+                    if (d2 < vT*vsum)
+                    {
+                        kHit = k;
+                        break;
+                    }
+                }
+                if (kHit >= 0)
+                {
+                    float wsum = 0;
+                    for (k = 0; k < K; k++)
+                    {
+                        wsum += m[k].weight;
+                        if (wsum > T)
+                        {
+                            kForeground = k+1;
+                            break;
+                        }
+                    }
+                }
+                fgmask.at<uchar>(y, x) = (uchar)(kHit < 0 || kHit >= kForeground ? 255 : 0);
+            }
+        }
+    }
+
+    // Weighted mean of the mixtures until their weight exceeds the background ratio.
+    void getBackgroundImage(Mat& background) const
+    {
+        background.create(size, CV_MAKETYPE(CV_8U, nchannels));
+        for (int y = 0; y < size.height; y++)
+        for (int x = 0; x < size.width; x++)
+        {
+            const Mixture* m = &model[(y*size.width + x)*K];
+            float meanVal[3] = { 0.f, 0.f, 0.f }, totalWeight = 0.f;
+            for (int k = 0; k < K && m[k].weight >= FLT_EPSILON; k++)
+            {
+                totalWeight += m[k].weight;
+                for (int c = 0; c < nchannels; c++)
+                    meanVal[c] += m[k].weight*m[k].mean[c];
+                if (totalWeight > T)
+                    break;
+            }
+            for (int c = 0; c < nchannels; c++)
+                background.ptr<uchar>(y)[x*nchannels + c] = saturate_cast<uchar>(totalWeight > 0.f ? meanVal[c]*(1.f/totalWeight) : 0.f);
+        }
+    }
+
+private:
+    struct Mixture
+    {
+        Mixture() : sortKey(0), weight(0)
+        {
+            for (int c = 0; c < 3; c++)
+                mean[c] = var[c] = 0;
+        }
+        float sortKey;
+        float weight;
+        float mean[3];
+        float var[3];
+    };
+
+    int K, history, nframes, nchannels;
+    float T, vT, noiseSigma;
+    Size size;
+    std::vector<Mixture> model;
+};
+
+// A noisy static background with a bright block moving over it, and a
+// lighting change halfway through.
+void makeSequence(Size sz, int type, int count, std::vector<Mat>& frames)
+{
+    RNG rng(0x4d4f47);
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    frames.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        Mat noise(sz, CV_MAKETYPE(CV_16S, CV_MAT_CN(type)));
+        rng.fill(noise, RNG::NORMAL, 0, 6);
+        Mat frame;
+        add(background, noise, frame, noArray(), CV_MAKETYPE(CV_16S, CV_MAT_CN(type)));
+        if (i >= count / 2)
+            add(frame, Scalar::all(40), frame);
+        frame.convertTo(frames[i], type);
+        frames[i](Rect((i * 5) % (sz.width - 20), sz.height / 4, 20, sz.height / 2)).setTo(Scalar::all(255));
+    }
+}
+
+void checkMatchesReference(int type)
+{
+    std::vector<Mat> frames;
+    makeSequence(Size(97, 61), type, 40, frames);
+    Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+    ReferenceMOG reference;
+
+    for (size_t i = 0; i < frames.size(); i++)
+    {
+        // the last frames are only classified, without updating the model
+        double learningRate = i + 5 < frames.size() ? -1 : 0;
+        Mat mask, expectedMask;
+        mog->apply(frames[i], mask, learningRate);
+        reference.apply(frames[i], expectedMask, learningRate);
+        ASSERT_EQ(0, cvtest::norm(expectedMask, mask, NORM_INF)) << "frame " << i;
+
+        Mat background, expectedBackground;
+        mog->getBackgroundImage(background);
+        reference.getBackgroundImage(expectedBackground);
+        ASSERT_EQ(expectedBackground.type(), background.type());
+        ASSERT_EQ(0, cvtest::norm(expectedBackground, background, NORM_INF)) << "frame " << i;
+    }
+}
+
+}
+
+TEST(BGSEGM_MOG, accuracy_gray)
+{
+    checkMatchesReference(CV_8UC1);
+}
+
+TEST(BGSEGM_MOG, accuracy_color)
+{
+    checkMatchesReference(CV_8UC3);
+}
+
+TEST(BGSEGM_MOG, background_follows_scene)
+{
+    std::vector<Mat> frames;
+    makeSequence(Size(64, 48), CV_8UC3, 30, frames);
+    Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+    Mat mask;
+    for (size_t i = 0; i < frames.size() / 2; i++)
+        mog->apply(frames[i], mask);
+
+    // the moving block is not part of the background, away from it the
+    // background is close to the static scene
+    Mat background;
+    mog->getBackgroundImage(background);
+    ASSERT_EQ(frames[0].size(), background.size());
+    ASSERT_EQ(CV_8UC3, background.type());
+    Rect still(0, 0, frames[0].cols, frames[0].rows / 4);
+    EXPECT_LE(cvtest::norm(background(still), frames[0](still), NORM_L1) / (double)(still.area() * 3), 8.);
+}
@@ -0,0 +1,79 @@
+#include "test_precomp.hpp"
+
+using namespace cv;
+using namespace cv::bgsegm;
+
+namespace
+{
+
+struct CollectMasks : public BackgroundSubtractorMultiStream::MaskCallback
+{
+    std::vector<int> streams;
+    std::vector<Mat> masks;
+
+    void onMask(int stream, const Mat& fgmask)
+    {
+        streams.push_back(stream);
+        masks.push_back(fgmask.clone());
+    }
+};
+
+void makeFrames(Size sz, int type, int count, std::vector<Mat>& frames)
+{
+    RNG rng(7);
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    frames.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        Mat noise(sz, type);
+        rng.fill(noise, RNG::UNIFORM, 0, 8);
+        add(background, noise, frames[i]);
+        frames[i](Rect(i * 4, sz.height / 3, sz.width / 4, sz.height / 3)).setTo(Scalar::all(255));
+    }
+}
+
+}
+
+TEST(BGSEGM_MultiStream, tiled_mog_matches_single_model)
+{
+    std::vector<Mat> frames1, frames2;
+    makeFrames(Size(64, 48), CV_8UC1, 10, frames1);
+    makeFrames(Size(80, 37), CV_8UC3, 10, frames2);
+
+    Ptr<BackgroundSubtractorMultiStream> manager = createBackgroundSubtractorMultiStream();
+    std::vector<Ptr<BackgroundSubtractor> > tiles;
+    for (int t = 0; t < 5; t++)
+        tiles.push_back(createBackgroundSubtractorMOG());
+    int s1 = manager->addStream(tiles);
+    int s2 = manager->addStream(createBackgroundSubtractorMOG());
+    ASSERT_EQ(2, manager->getNumStreams());
+
+    Ptr<CollectMasks> collector = makePtr<CollectMasks>();
+    manager->setCallback(collector);
+    for (size_t i = 0; i < frames1.size(); i++)
+    {
+        manager->pushFrame(s1, frames1[i]);
+        manager->pushFrame(s2, frames2[i]);
+    }
+    manager->process();
+    ASSERT_EQ(frames1.size() + frames2.size(), collector->masks.size());
+
+    Ptr<BackgroundSubtractor> ref1 = createBackgroundSubtractorMOG(), ref2 = createBackgroundSubtractorMOG();
+    size_t n1 = 0, n2 = 0;
+    for (size_t i = 0; i < collector->masks.size(); i++)
+    {
+        Mat expected;
+        if (collector->streams[i] == s1)
+            ref1->apply(frames1[n1++], expected);
+        else
+            ref2->apply(frames2[n2++], expected);
+        EXPECT_EQ(0, cvtest::norm(expected, collector->masks[i], NORM_INF));
+    }
+    EXPECT_EQ(frames1.size(), n1);
+    EXPECT_EQ(frames2.size(), n2);
+
+    Mat last;
+    manager->getLastMask(s1, last);
+    EXPECT_EQ(0, cvtest::norm(last, collector->masks[collector->masks.size() - 2], NORM_INF));
+}
@@ -66,6 +66,18 @@ void DPMCascade::loadCascadeModel(const string &modelPath)
     }
 
     model.initModel();
+
+    // the filters are convolved in single precision
+    convertToFloat(model.rootFilters);
+    convertToFloat(model.partFilters);
+    convertToFloat(model.rootPCAFilters);
+    convertToFloat(model.partPCAFilters);
+}
+
+void DPMCascade::convertToFloat(vector< Mat > &filters)
+{
+    for (size_t i = 0; i < filters.size(); i++)
+        filters[i].convertTo(filters[i], CV_32F);
 }
 
 void DPMCascade::initDPMCascade()
@@ -151,6 +163,11 @@ vector< vector<double> > DPMCascade::detect(Mat &image)
     // compute features
     computeFeatures(image);
 
+    return detectFromFeatures();
+}
+
+vector< vector<double> > DPMCascade::detectFromFeatures()
+{
     // pre-allocate storage
     initDPMCascade();
 
@@ -165,22 +182,67 @@ vector< vector<double> > DPMCascade::detect(Mat &image)
     return detections;
 }
 
-void DPMCascade::computeFeatures(const Mat &im)
+PyramidParameter DPMCascade::getPyramidParameters() const
 {
-    // initialize feature pyramid
     PyramidParameter params;
     params.padx = model.maxSizeX;
     params.pady = model.maxSizeY;
     params.interval = model.interval;
     params.binSize = model.sBin;
 
-    feature = Feature(params);
+    return params;
+}
+
+void DPMCascade::computeFeatures(const Mat &im)
+{
+    // initialize feature pyramid
+    feature = Feature(getPyramidParameters());
 
     // compute pyramid
     feature.computeFeaturePyramid(im, pyramid);
 
     // compute projected pyramid
     feature.projectFeaturePyramid(model.pcaCoeff, pyramid, pcaPyramid);
+
+    // the features are convolved in single precision
+    convertToFloat(pyramid);
+    convertToFloat(pcaPyramid);
+}
+
+void DPMCascade::setFeatures(const PyramidParameter &params,
+        const vector< Mat > &sharedPyramid,
+        const vector< Mat > &sharedPCAPyramid)
+{
+    PyramidParameter modelParams = getPyramidParameters();
+    CV_Assert(params.interval == modelParams.interval && params.binSize == modelParams.binSize);
+    CV_Assert(sharedPyramid.size() == sharedPCAPyramid.size());
+
+    // the padding cells only hold the truncation feature, so the pyramid
+    // of the model is the center of a pyramid with a larger padding
+    int dx = params.padx - modelParams.padx;
+    int dy = params.pady - modelParams.pady;
+    CV_Assert(dx >= 0 && dy >= 0);
+
+    modelParams.sfactor = params.sfactor;
+    modelParams.maxScale = params.maxScale;
+    modelParams.scales = params.scales;
+    feature = Feature(modelParams);
+
+    int nlevels = (int) sharedPyramid.size();
+    pyramid.resize(nlevels);
+    pcaPyramid.resize(nlevels);
+
+    for (int i = 0; i < nlevels; i++)
+    {
+        const Mat &level = sharedPyramid[i];
+        const Mat &pcaLevel = sharedPCAPyramid[i];
+        int dimPCA = pcaLevel.cols / (level.cols / Feature::dimHOG);
+
+        pyramid[i] = level(Rect(dx*Feature::dimHOG, dy,
+                    level.cols - 2*dx*Feature::dimHOG, level.rows - 2*dy));
+        pcaPyramid[i] = pcaLevel(Rect(dx*dimPCA, dy,
+                    pcaLevel.cols - 2*dx*dimPCA, pcaLevel.rows - 2*dy));
+    }
 }
 
 void DPMCascade::computeLocationScores(vector< vector< double > >  &locationScores)
@@ -109,6 +109,25 @@ class DPMCascade
         // compute feature pyramid and projected feature pyramid
         void computeFeatures(const Mat &im);
 
+        // returns the parameters of the feature pyramid needed by the model
+        PyramidParameter getPyramidParameters() const;
+
+        // returns the PCA coefficient matrix of the model
+        const Mat &getPCACoeff() const
+        {
+            return model.pcaCoeff;
+        }
+
+        // use a feature pyramid and its projection on the PCA basis of the
+        // model computed elsewhere, with the same interval and bin size as
+        // the model and a padding at least as large
+        void setFeatures(const PyramidParameter &params,
+                const std::vector< Mat > &sharedPyramid,
+                const std::vector< Mat > &sharedPCAPyramid);
+
+        // convert filters or feature maps to single precision
+        static void convertToFloat(std::vector< Mat > &filters);
+
         // compute root PCA scores
         void computeRootPCAScores(std::vector< std::vector< Mat > > &rootScores);
 
@@ -126,6 +145,9 @@ class DPMCascade
 
         // detect object from image
         std::vector< std::vector<double> > detect(Mat &image);
+
+        // detect object from the features set by computeFeatures() or setFeatures()
+        std::vector< std::vector<double> > detectFromFeatures();
 };
 
 #ifdef HAVE_TBB
@@ -65,10 +65,38 @@ public:
     string extractModelName( const string& filename );
 
 private:
+    // compute the features of all the models, sharing the feature
+    // pyramids and their projections between the models
+    void computeFeatures(const Mat &image);
+
     vector< Ptr<DPMCascade> > detectors;
     vector<string> classNames;
 };
 
+/** @brief This class runs the cascades of several models on
+ * their features in parallel
+ */
+class ParalDetectFromFeatures : public ParallelLoopBody
+{
+    public:
+        ParalDetectFromFeatures(const vector< Ptr<DPMCascade> > &_detectors,
+                vector< vector< vector<double> > > &_detections):
+            detectors(_detectors),
+            detections(_detections)
+        {
+        }
+
+        void operator() (const Range &range) const
+        {
+            for (int i = range.start; i < range.end; i++)
+                detections[i] = detectors[i]->detectFromFeatures();
+        }
+
+    private:
+        const vector< Ptr<DPMCascade> > &detectors;
+        vector< vector< vector<double> > > &detections;
+};
+
 Ptr<DPMDetector> DPMDetector::create(vector<string> const &filenames,
                                      vector<string> const &classNames)
 {
@@ -146,16 +174,91 @@ string DPMDetectorImpl::extractModelName( const string& filename )
     return filename.substr(startPos, substrLength);
 }
 
+void DPMDetectorImpl::computeFeatures( const Mat &image )
+{
+    vector<bool> done(detectors.size(), false);
+
+    for( size_t first = 0; first < detectors.size(); first++ )
+    {
+        if( done[first] )
+            continue;
+
+        // the models with the same interval and bin size share a pyramid
+        // padded for the largest of them
+        PyramidParameter params = detectors[first]->getPyramidParameters();
+        vector<size_t> group;
+        for( size_t i = first; i < detectors.size(); i++ )
+        {
+            PyramidParameter p = detectors[i]->getPyramidParameters();
+            if( p.interval != params.interval || p.binSize != params.binSize )
+                continue;
+
+            params.padx = max(params.padx, p.padx);
+            params.pady = max(params.pady, p.pady);
+            group.push_back(i);
+            done[i] = true;
+        }
+
+        Feature feature(params);
+        vector< Mat > pyramid;
+        feature.computeFeaturePyramid(image, pyramid);
+        params = feature.getPyramidParameters();
+
+        // project the pyramid once per distinct PCA basis
+        vector< Mat > bases;
+        vector< vector< Mat > > pcaPyramids;
+        vector<size_t> basisIndex(group.size());
+        for( size_t i = 0; i < group.size(); i++ )
+        {
+            const Mat &coeff = detectors[group[i]]->getPCACoeff();
+            size_t b = 0;
+            for( ; b < bases.size(); b++ )
+            {
+                if( bases[b].size() == coeff.size() && bases[b].type() == coeff.type() &&
+                        norm(bases[b], coeff, NORM_INF) == 0 )
+                    break;
+            }
+
+            if( b == bases.size() )
+            {
+                bases.push_back(coeff);
+                pcaPyramids.push_back(vector< Mat >());
+                feature.projectFeaturePyramid(coeff, pyramid, pcaPyramids[b]);
+                DPMCascade::convertToFloat(pcaPyramids[b]);
+            }
+            basisIndex[i] = b;
+        }
+
+        DPMCascade::convertToFloat(pyramid);
+        for( size_t i = 0; i < group.size(); i++ )
+            detectors[group[i]]->setFeatures(params, pyramid, pcaPyramids[basisIndex[i]]);
+    }
+}
+
 void DPMDetectorImpl::detect( Mat &image,
         vector<ObjectDetection> &objectDetections)
 {
     objectDetections.clear();
 
+    if( detectors.empty() )
+        return;
+
+    if (image.channels() == 1)
+        cvtColor(image, image, COLOR_GRAY2BGR);
+
+    if (image.depth() != CV_64F)
+        image.convertTo(image, CV_64FC3);
+
+    computeFeatures(image);
+
+    // score the classes in parallel
+    vector< vector< vector<double> > > classDetections(detectors.size());
+    parallel_for_(Range(0, (int)detectors.size()),
+            ParalDetectFromFeatures(detectors, classDetections));
+
     for( size_t classID = 0; classID < detectors.size(); classID++ )
     {
-        // detect objects
-        vector< vector<double> > detections;
-        detections = detectors[classID]->detect(image);
+        const vector< vector<double> > &detections = classDetections[classID];
 
         for (unsigned int i = 0; i < detections.size(); i++)
         {
@@ -41,51 +41,132 @@
 
 #include "dpm_convolution.hpp"
 
+#include "opencv2/core/utility.hpp"
+
+#include <cmath>
+
 namespace cv
 {
 namespace dpm
 {
+ConvolutionEngine::ConvolutionEngine()
+{
+#if CV_SSE2
+    useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+#else
+    useSIMD = false;
+#endif
+}
+
+float ConvolutionEngine::dot(const float *a, const float *b, int n) const
+{
+    int i = 0;
+    float val = 0;
+#if CV_SSE2
+    if (useSIMD)
+    {
+        __m128 s0 = _mm_setzero_ps(), s1 = _mm_setzero_ps();
+        for (; i <= n - 8; i += 8)
+        {
+            s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        float CV_DECL_ALIGNED(16) buf[4];
+        _mm_store_ps(buf, _mm_add_ps(s0, s1));
+        val = buf[0] + buf[1] + buf[2] + buf[3];
+    }
+#endif
+    for (; i < n; i++)
+        val += a[i] * b[i];
+
+    return val;
+}
+
 double ConvolutionEngine::convolve(const Mat &feat, const Mat &filter,
-        int dimHOG, int x, int y)
+        int dimHOG, int x, int y) const
 {
+    CV_DbgAssert(feat.type() == CV_32F && filter.type() == CV_32F);
     double val = 0;
     for (int yp = 0; yp < filter.rows; yp++)
     {
-        const double *pfeat = (double*)feat.ptr(y + yp) + x * dimHOG;
-        const double *pfilter = (double*)filter.ptr(yp);
+        const float *pfeat = feat.ptr<float>(y + yp) + x * dimHOG;
+        const float *pfilter = filter.ptr<float>(yp);
 
-        for (int xp = 0; xp < filter.cols; xp++)
-        {
-            val += pfeat[xp] * pfilter[xp];
-        }
+        val += dot(pfeat, pfilter, filter.cols);
     }
 
     return val;
 }
 
 void ConvolutionEngine::convolve(const Mat &feat, const Mat &filter,
-        int dimHOG, Mat &result)
+        int dimHOG, Mat &result) const
 {
+    CV_Assert(feat.type() == CV_32F && filter.type() == CV_32F && result.type() == CV_64F);
+
+    // the direct convolution costs a multiply-add per filter coefficient
+    // and location, the DFT costs a transform per feature channel and
+    // its cost hardly depends on the filter size
+    Size dftSize(getOptimalDFTSize(feat.cols / dimHOG), getOptimalDFTSize(feat.rows));
+    double directCost = (double)result.total() * filter.total() / 4;
+    double dftCost = (dimHOG + 1.0) * dftSize.area() * std::log((double)dftSize.area()) * 2;
+    if (dftCost < directCost)
+    {
+        convolveDFT(feat, filter, dimHOG, result);
+        return;
+    }
+
     for (int y = 0; y < result.rows; y++)
     {
-        double *presult = (double*)result.ptr(y);
+        double *presult = result.ptr<double>(y);
         for (int x = 0; x < result.cols; x++)
-        {
-            double val = 0;
-            for (int yp = 0; yp < filter.rows; yp++)
-            {
-                const double *pfeat = (double*)feat.ptr(y + yp) + x * dimHOG;
-                const double *pfilter = (double*)filter.ptr(yp);
-
-                for (int xp = 0; xp < filter.cols; xp++)
-                {
-                    val += pfeat[xp] * pfilter[xp];
-                }
-            } // yp
-
-            presult[x] = val;
-        } // x
+            presult[x] = convolve(feat, filter, dimHOG, x, y);
     } // y
 }
+
+void ConvolutionEngine::convolveDFT(const Mat &feat, const Mat &filter,
+        int dimHOG, Mat &result) const
+{
+    CV_Assert(feat.type() == CV_32F && filter.type() == CV_32F && result.type() == CV_64F);
+    CV_Assert(feat.cols % dimHOG == 0 && filter.cols % dimHOG == 0);
+
+    // the (circular) correlation of the padded maps equals the
+    // convolution at the locations where the filter fits in the map
+    const int featWidth = feat.cols / dimHOG;
+    const int filterWidth = filter.cols / dimHOG;
+    Size dftSize(getOptimalDFTSize(featWidth), getOptimalDFTSize(feat.rows));
+
+    Mat featPlane(dftSize, CV_32F), filterPlane(dftSize, CV_32F);
+    Mat featSpectrum, filterSpectrum, product;
+    Mat spectrum = Mat::zeros(dftSize, CV_32F);
+    for (int d = 0; d < dimHOG; d++)
+    {
+        featPlane.setTo(Scalar::all(0));
+        for (int y = 0; y < feat.rows; y++)
+        {
+            const float *pfeat = feat.ptr<float>(y) + d;
+            float *pplane = featPlane.ptr<float>(y);
+            for (int x = 0; x < featWidth; x++)
+                pplane[x] = pfeat[x * dimHOG];
+        }
+
+        filterPlane.setTo(Scalar::all(0));
+        for (int y = 0; y < filter.rows; y++)
+        {
+            const float *pfilter = filter.ptr<float>(y) + d;
+            float *pplane = filterPlane.ptr<float>(y);
+            for (int x = 0; x < filterWidth; x++)
+                pplane[x] = pfilter[x * dimHOG];
+        }
+
+        dft(featPlane, featSpectrum, 0, feat.rows);
+        dft(filterPlane, filterSpectrum, 0, filter.rows);
+        mulSpectrums(featSpectrum, filterSpectrum, product, 0, true);
+        spectrum += product;
+    }
+
+    Mat response;
+    dft(spectrum, response, DFT_INVERSE + DFT_SCALE + DFT_REAL_OUTPUT, result.rows);
+    response(Rect(0, 0, result.cols, result.rows)).convertTo(result, CV_64F);
+}
 } // namespace cv
 } // namespace dpm
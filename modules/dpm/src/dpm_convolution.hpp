@@ -49,25 +49,37 @@ namespace cv
 {
 namespace dpm
 {
-/** @brief This class contains DPM model parameters
+/** @brief This class convolves single precision feature maps and filters
  */
 class ConvolutionEngine
 {
     public:
         // constructor
-        ConvolutionEngine() {}
+        ConvolutionEngine();
 
         // destructor
         ~ConvolutionEngine() {}
 
         // compute convolution value at a fixed location
         double convolve(const Mat &feat, const Mat &filter,
-                int dimHOG, int x, int y);
+                int dimHOG, int x, int y) const;
 
         // compute convolution of a feature map and multiple filters
         // sum the filter convolution values into results
+        // (uses the DFT when it is faster than the direct convolution)
         void convolve(const Mat &feat, const Mat &filter,
-                int dimHOG, Mat &result);
+                int dimHOG, Mat &result) const;
+
+        // compute the convolution of a feature map and a filter at all
+        // the locations with the discrete Fourier transform
+        void convolveDFT(const Mat &feat, const Mat &filter,
+                int dimHOG, Mat &result) const;
+
+    private:
+        // dot product of two float vectors
+        float dot(const float *a, const float *b, int n) const;
+
+        bool useSIMD;
 };
 } // namespace dpm
 } // namespace cv
@@ -0,0 +1,125 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::dpm;
+
+// convolution of a feature map and a filter in double precision, at every
+// location where the filter fits in the map
+static Mat referenceConvolution(const Mat &feat, const Mat &filter, int dimHOG)
+{
+    Mat result(feat.rows - filter.rows + 1, (feat.cols - filter.cols) / dimHOG + 1, CV_64F);
+    for (int y = 0; y < result.rows; y++)
+        for (int x = 0; x < result.cols; x++)
+        {
+            double val = 0;
+            for (int yp = 0; yp < filter.rows; yp++)
+            {
+                const float *pfeat = feat.ptr<float>(y + yp) + x * dimHOG;
+                const float *pfilter = filter.ptr<float>(yp);
+                for (int i = 0; i < filter.cols; i++)
+                    val += (double)pfeat[i] * pfilter[i];
+            }
+            result.at<double>(y, x) = val;
+        }
+
+    return result;
+}
+
+static double maxAbs(const Mat &m)
+{
+    return cvtest::norm(m, NORM_INF);
+}
+
+TEST(DPM_ConvolutionEngine, dft_matches_direct)
+{
+    RNG rng(0x1234);
+    const int dimHOG = Feature::dimHOG;
+    // (map rows, map cells, filter rows, filter cells), including sizes
+    // that are not optimal DFT sizes
+    const int sizes[][4] = { {37, 45, 7, 5}, {64, 64, 6, 11}, {23, 101, 23, 3}, {10, 10, 1, 1} };
+
+    ConvolutionEngine engine;
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        Mat feat(sizes[i][0], sizes[i][1] * dimHOG, CV_32F);
+        Mat filter(sizes[i][2], sizes[i][3] * dimHOG, CV_32F);
+        rng.fill(feat, RNG::UNIFORM, 0, 0.5);
+        rng.fill(filter, RNG::UNIFORM, -0.5, 0.5);
+
+        Mat expected = referenceConvolution(feat, filter, dimHOG);
+        double tolerance = 1e-4 * (1 + maxAbs(expected));
+
+        Mat dftResult = Mat::zeros(expected.size(), CV_64F);
+        engine.convolveDFT(feat, filter, dimHOG, dftResult);
+        EXPECT_LE(cvtest::norm(expected, dftResult, NORM_INF), tolerance) << "size " << i;
+
+        Mat result = Mat::zeros(expected.size(), CV_64F);
+        engine.convolve(feat, filter, dimHOG, result);
+        EXPECT_LE(cvtest::norm(expected, result, NORM_INF), tolerance) << "size " << i;
+
+        for (int y = 0; y < expected.rows; y += 3)
+            for (int x = 0; x < expected.cols; x += 3)
+                EXPECT_NEAR(expected.at<double>(y, x),
+                        engine.convolve(feat, filter, dimHOG, x, y), tolerance);
+    }
+}
+
+TEST(DPM_ConvolutionEngine, hog_detections_regression)
+{
+    RNG rng(0x4321);
+    const int dimHOG = Feature::dimHOG;
+
+    Mat image(480, 640, CV_8UC3, Scalar::all(128));
+    for (int i = 0; i < 60; i++)
+    {
+        Point center(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2)
+            circle(image, center, rng.uniform(5, 60), color, -1);
+        else
+            rectangle(image, center, center + Point(rng.uniform(-80, 80), rng.uniform(-80, 80)), color, -1);
+    }
+
+    Mat image64, hog, feat;
+    image.convertTo(image64, CV_64F);
+    Feature::computeHOG32D(image64, hog, 8, 2, 2);
+    hog.convertTo(feat, CV_32F);
+    ASSERT_EQ(0, feat.cols % dimHOG);
+
+    // a root filter of the size of the person model
+    Mat filter(15, 6 * dimHOG, CV_32F);
+    rng.fill(filter, RNG::UNIFORM, -0.1, 0.1);
+
+    Mat expected = referenceConvolution(feat, filter, dimHOG);
+    Mat dftResult = Mat::zeros(expected.size(), CV_64F);
+    ConvolutionEngine().convolveDFT(feat, filter, dimHOG, dftResult);
+
+    // the locations scoring above the threshold of the best 5% of the
+    // locations are the same, up to the float rounding of the DFT
+    std::vector<double> scores(expected.begin<double>(), expected.end<double>());
+    std::sort(scores.begin(), scores.end());
+    double threshold = scores[scores.size() * 95 / 100];
+    double tolerance = 1e-4 * (1 + maxAbs(expected));
+
+    int changed = 0;
+    for (int y = 0; y < expected.rows; y++)
+        for (int x = 0; x < expected.cols; x++)
+        {
+            double e = expected.at<double>(y, x), d = dftResult.at<double>(y, x);
+            if ((e > threshold) != (d > threshold) && std::abs(e - threshold) > tolerance)
+                changed++;
+        }
+    EXPECT_EQ(0, changed);
+
+    Point expectedMax, dftMax;
+    double expectedMaxVal;
+    minMaxLoc(expected, 0, &expectedMaxVal, 0, &expectedMax);
+    minMaxLoc(dftResult, 0, 0, 0, &dftMax);
+    EXPECT_NEAR(expectedMaxVal, dftResult.at<double>(expectedMax), tolerance);
+    EXPECT_NEAR(expectedMaxVal, expected.at<double>(dftMax), 2 * tolerance);
+}
+
+}
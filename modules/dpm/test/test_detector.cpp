@@ -0,0 +1,130 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::dpm;
+
+static Mat randomFilter(RNG &rng, int rows, int cols, int dim)
+{
+    Mat filter(rows, cols * dim, CV_64F);
+    rng.fill(filter, RNG::UNIFORM, -0.5, 0.5);
+    return filter;
+}
+
+// writes a cascade model with one component and one part, whose pruning
+// and score thresholds let every location through to the non-maximum
+// suppression
+static std::string writeModel(RNG &rng, int binSize, int padding,
+        const Mat &pcaCoeff)
+{
+    const int numFeatures = Feature::dimHOG;
+    const int pcaDim = pcaCoeff.cols;
+
+    CascadeModel model;
+    model.sBin = binSize;
+    model.interval = 4;
+    model.maxSizeX = padding;
+    model.maxSizeY = padding;
+    model.numComponents = 1;
+    model.numFeatures = numFeatures;
+    model.pcaDim = pcaDim;
+    model.scoreThresh = -1e10f;
+    model.pcaCoeff = pcaCoeff;
+    model.bias.push_back((float)rng.uniform(-1., 1.));
+
+    model.rootFilters.push_back(randomFilter(rng, 5, 4, numFeatures));
+    model.rootPCAFilters.push_back(randomFilter(rng, 5, 4, pcaDim));
+    model.partFilters.push_back(randomFilter(rng, 3, 3, numFeatures));
+    model.partPCAFilters.push_back(randomFilter(rng, 3, 3, pcaDim));
+
+    model.prunThreshold.push_back(std::vector<double>(8, -1e10));
+    model.anchors.push_back(std::vector<double>());
+    model.anchors[0].push_back(1);
+    model.anchors[0].push_back(2);
+    model.defs.push_back(std::vector<double>());
+    model.defs[0].push_back(0.1);
+    model.defs[0].push_back(0.01);
+    model.defs[0].push_back(0.1);
+    model.defs[0].push_back(-0.01);
+    model.numParts.push_back(1);
+
+    // root PCA, part PCA, root, part
+    model.partOrder.push_back(std::vector<int>());
+    model.partOrder[0].push_back(0);
+    model.partOrder[0].push_back(1);
+    model.partOrder[0].push_back(0);
+    model.partOrder[0].push_back(1);
+
+    model.locationWeight.push_back(std::vector<double>());
+    for (int i = 0; i < 3; i++)
+        model.locationWeight[0].push_back(rng.uniform(-0.1, 0.1));
+
+    std::string filename = tempfile(".xml");
+    model.serialize(filename);
+    return filename;
+}
+
+TEST(DPM_Detector, shared_features_match_single_cascades)
+{
+    RNG rng(0x2015);
+    const int dimPCA = 6;
+    Mat basis1(Feature::dimHOG, dimPCA, CV_64F), basis2(Feature::dimHOG, dimPCA, CV_64F);
+    rng.fill(basis1, RNG::UNIFORM, -0.5, 0.5);
+    rng.fill(basis2, RNG::UNIFORM, -0.5, 0.5);
+
+    // models with different paddings and PCA bases share the pyramids of
+    // their bin size, the one with the smaller bin size has its own
+    std::vector<std::string> filenames;
+    filenames.push_back(writeModel(rng, 8, 3, basis1));
+    filenames.push_back(writeModel(rng, 8, 5, basis2));
+    filenames.push_back(writeModel(rng, 8, 4, basis1));
+    filenames.push_back(writeModel(rng, 4, 3, basis2));
+
+    Mat image(96, 128, CV_8UC3);
+    rng.fill(image, RNG::UNIFORM, 0, 64);
+    for (int i = 0; i < 12; i++)
+    {
+        Point center(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2)
+            circle(image, center, rng.uniform(5, 30), color, -1);
+        else
+            rectangle(image, center, center + Point(rng.uniform(5, 40), rng.uniform(5, 40)), color, -1);
+    }
+
+    Ptr<DPMDetector> detector = DPMDetector::create(filenames);
+    ASSERT_EQ(filenames.size(), detector->getClassCount());
+
+    Mat detectorImage = image.clone();
+    std::vector<DPMDetector::ObjectDetection> objects;
+    detector->detect(detectorImage, objects);
+
+    size_t next = 0;
+    for (size_t classID = 0; classID < filenames.size(); classID++)
+    {
+        DPMCascade cascade;
+        cascade.loadCascadeModel(filenames[classID]);
+        Mat cascadeImage = image.clone();
+        std::vector< std::vector<double> > detections = cascade.detect(cascadeImage);
+        ASSERT_FALSE(detections.empty()) << "model " << classID;
+
+        for (size_t i = 0; i < detections.size(); i++, next++)
+        {
+            ASSERT_LT(next, objects.size()) << "model " << classID;
+            const std::vector<double> &d = detections[i];
+            Rect rect((int)d[0], (int)d[1], (int)d[2] - (int)d[0] + 1, (int)d[3] - (int)d[1] + 1);
+
+            EXPECT_EQ((int)classID, objects[next].classID);
+            EXPECT_EQ(rect, objects[next].rect) << "model " << classID << ", detection " << i;
+            EXPECT_EQ((float)d.back(), objects[next].score) << "model " << classID << ", detection " << i;
+        }
+    }
+    EXPECT_EQ(next, objects.size());
+
+    for (size_t i = 0; i < filenames.size(); i++)
+        remove(filenames[i].c_str());
+}
+
+}
@@ -0,0 +1,9 @@
+#include "test_precomp.hpp"
+
+// The classes tested here are internal to the module and are not exported
+// from the library, so their implementation is built into the test binary.
+#include "../src/dpm_convolution.cpp"
+#include "../src/dpm_feature.cpp"
+#include "../src/dpm_model.cpp"
+#include "../src/dpm_nms.cpp"
+#include "../src/dpm_cascade.cpp"
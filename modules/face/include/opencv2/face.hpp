@@ -306,6 +306,23 @@ public:
     */
     CV_WRAP_AS(predict_collect) virtual void predict(InputArray src, Ptr<PredictCollector> collector) const = 0;
 
+    /** @brief Predicts a batch of samples.
+    @param src The samples to get a prediction for, given as a vector\<Mat\>.
+    @param collectors One collector per sample, the results of src[i] are sent to collectors[i].
+
+    The default implementation calls predict(InputArray src, Ptr<PredictCollector> collector) for every
+    sample. Recognizers with a batched implementation may process the samples in parallel, so the
+    collectors have to be distinct objects.
+    */
+    virtual void predictBatch(InputArrayOfArrays src, const std::vector<Ptr<PredictCollector> >& collectors) const;
+
+    /** @overload
+    @param src The samples to get a prediction for, given as a vector\<Mat\>.
+    @param labels The predicted label of every sample.
+    @param confidences The associated confidence (e.g. distance) of every sample.
+    */
+    CV_WRAP void predictBatch(InputArrayOfArrays src, CV_OUT std::vector<int>& labels, CV_OUT std::vector<double>& confidences) const;
+
     /** @brief Saves a FaceRecognizer and its model state.
 
     Saves this model to a given filename, either as XML or YAML.
@@ -123,6 +123,27 @@ public:
     CV_WRAP virtual void setThreshold(double val) = 0;
     CV_WRAP virtual std::vector<cv::Mat> getHistograms() const = 0;
     CV_WRAP virtual cv::Mat getLabels() const = 0;
+    /** @brief Number of inverted lists of the approximate nearest neighbor index.
+
+    If it is positive, the gallery histograms are clustered into this number of lists, and a prediction
+    compares the query only with the histograms of the getIndexProbes() lists with the closest centers.
+    The default value 0 compares the query with the whole gallery.
+    @see setIndexLists */
+    CV_WRAP virtual int getIndexLists() const = 0;
+    /** @copybrief getIndexLists @see getIndexLists */
+    CV_WRAP virtual void setIndexLists(int val) = 0;
+    /** @brief Number of inverted lists searched by a prediction when the index is used.
+    @see setIndexProbes */
+    CV_WRAP virtual int getIndexProbes() const = 0;
+    /** @copybrief getIndexProbes @see getIndexProbes */
+    CV_WRAP virtual void setIndexProbes(int val) = 0;
+    /** @brief Saves the model in a binary file, which is much smaller and faster to read than the
+    XML/YAML file written by FaceRecognizer::save for large galleries.
+    */
+    CV_WRAP virtual void saveBinary(const String& filename) const = 0;
+    /** @brief Loads a model saved with saveBinary.
+    */
+    CV_WRAP virtual void loadBinary(const String& filename) = 0;
 };
 
 /**
@@ -145,6 +166,10 @@ is larger than the threshold, this method returns -1.
 -   The Circular Local Binary Patterns (used in training and prediction) expect the data given as
     grayscale images, use cvtColor to convert between the color spaces.
 -   This model supports updating.
+-   The histograms are stored in one contiguous matrix and compared with a vectorized chi-square
+    distance on several threads. FaceRecognizer::predictBatch predicts the samples in parallel.
+-   The histograms of the training images are extracted in parallel. update may be called from
+    another thread while predicting, the predictions use the gallery as it was when they started.
 
 ### Model internal data:
 
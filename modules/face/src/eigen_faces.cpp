@@ -80,6 +80,7 @@ void Eigenfaces::train(InputArrayOfArrays _src, InputArray _local_labels) {
     // clear existing model data
     _labels.release();
     _projections.clear();
+    invalidateBatchCache();
     // clip number of components to be valid
     if((_num_components <= 0) || (_num_components > n))
         _num_components = n;
@@ -7,6 +7,8 @@
 #include <set>
 #include <limits>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
 
 using namespace cv;
 
@@ -107,6 +109,43 @@ inline void read(const cv::FileNode& node, LabelInfo& x, const LabelInfo& defaul
 }
 
 
+// Scores a range of the queries of a batch against the whole gallery, given
+// the products of the projected queries with the gallery projections.
+class BasicPredictInvoker : public ParallelLoopBody
+{
+public:
+    BasicPredictInvoker(const Mat& _cross, const Mat& _queryNorms, const Mat& _galleryNorms,
+                        const Mat& _labels, const std::vector<Ptr<cv::face::PredictCollector> >& _collectors) :
+        cross(&_cross), queryNorms(&_queryNorms), galleryNorms(&_galleryNorms),
+        labels(&_labels), collectors(&_collectors) {}
+
+    void operator()(const Range& range) const
+    {
+        const double* gn = galleryNorms->ptr<double>();
+        for (int i = range.start; i < range.end; i++)
+        {
+            const Ptr<cv::face::PredictCollector>& collector = (*collectors)[i];
+            const double* c = cross->ptr<double>(i);
+            double qn = queryNorms->at<double>(i);
+            collector->init(cross->cols);
+            for (int sampleIdx = 0; sampleIdx < cross->cols; sampleIdx++)
+            {
+                // ||q - p||^2 = ||q||^2 + ||p||^2 - 2 q.p, clamped against rounding
+                double dist = std::sqrt(std::max(qn + gn[sampleIdx] + c[sampleIdx], 0.));
+                if (!collector->collect(labels->at<int>(sampleIdx), dist))
+                    break;
+            }
+        }
+    }
+
+private:
+    const Mat* cross;
+    const Mat* queryNorms;
+    const Mat* galleryNorms;
+    const Mat* labels;
+    const std::vector<Ptr<cv::face::PredictCollector> >* collectors;
+};
+
 class BasicFaceRecognizerImpl : public cv::face::BasicFaceRecognizer
 {
 public:
@@ -116,6 +155,7 @@ public:
 
     void load(const FileStorage& fs)
     {
+        invalidateBatchCache();
         //read matrices
         fs["num_components"] >> _num_components;
         fs["mean"] >> _mean;
@@ -153,6 +193,40 @@ public:
         fs << "]";
     }
 
+    using cv::face::FaceRecognizer::predictBatch;
+
+    // Projects all queries with a single matrix product and gets the distances
+    // to every gallery sample from a second one, the collectors are fed in parallel.
+    void predictBatch(InputArrayOfArrays _src, const std::vector<Ptr<cv::face::PredictCollector> >& collectors) const
+    {
+        if (_projections.empty()) {
+            String error_message = "This model is not computed yet. Did you call the train method?";
+            CV_Error(Error::StsError, error_message);
+        }
+        if (_src.total() != collectors.size()) {
+            String error_message = format("The number of samples (src) must equal the number of collectors. Was len(samples)=%d, len(collectors)=%d.", (int)_src.total(), (int)collectors.size());
+            CV_Error(Error::StsBadArg, error_message);
+        }
+        if (collectors.empty())
+            return;
+        Mat queries = asRowMatrix(_src, CV_64FC1);
+        if (queries.cols != _eigenvectors.rows) {
+            String error_message = format("Wrong input image size. Reason: Training and Test images must be of equal size! Expected an image with %d elements, but got %d.", _eigenvectors.rows, queries.cols);
+            CV_Error(Error::StsBadArg, error_message);
+        }
+        Ptr<BatchCache> cache = batchCache();
+        // project into the subspace, Y = (X - mean) * W
+        for (int i = 0; i < queries.rows; i++)
+            subtract(queries.row(i), cache->mean, queries.row(i));
+        Mat projected;
+        gemm(queries, cache->W, 1, noArray(), 0, projected);
+        Mat cross, queryNorms;
+        gemm(projected, cache->gallery, -2, noArray(), 0, cross, GEMM_2_T);
+        reduce(projected.mul(projected), queryNorms, 1, REDUCE_SUM);
+        parallel_for_(Range(0, queries.rows),
+                      BasicPredictInvoker(cross, queryNorms, cache->galleryNorms, cache->labels, collectors));
+    }
+
     CV_IMPL_PROPERTY(int, NumComponents, _num_components)
     CV_IMPL_PROPERTY(double, Threshold, _threshold)
     CV_IMPL_PROPERTY_RO(std::vector<cv::Mat>, Projections, _projections)
@@ -162,6 +236,42 @@ public:
     CV_IMPL_PROPERTY_RO(cv::Mat, Mean, _mean)
 
 protected:
+    // The model converted for predictBatch, built by the first batch after
+    // the model changed.
+    struct BatchCache
+    {
+        Mat W;            // eigenvectors in double precision
+        Mat mean;         // mean as a double row
+        Mat gallery;      // projections stacked as double rows
+        Mat galleryNorms; // squared norms of the projections, one column per sample
+        Mat labels;
+    };
+
+    Ptr<BatchCache> batchCache() const
+    {
+        AutoLock lock(_batchCacheMutex);
+        if (!_batchCache) {
+            Ptr<BatchCache> cache = makePtr<BatchCache>();
+            _eigenvectors.convertTo(cache->W, CV_64F);
+            _mean.reshape(1, 1).convertTo(cache->mean, CV_64F);
+            cache->gallery.create((int)_projections.size(), cache->W.cols, CV_64FC1);
+            for (int sampleIdx = 0; sampleIdx < cache->gallery.rows; sampleIdx++)
+                _projections[sampleIdx].reshape(1, 1).convertTo(cache->gallery.row(sampleIdx), CV_64F);
+            reduce(cache->gallery.mul(cache->gallery), cache->galleryNorms, 1, REDUCE_SUM);
+            cache->galleryNorms = cache->galleryNorms.reshape(1, 1);
+            cache->labels = _labels;
+            _batchCache = cache;
+        }
+        return _batchCache;
+    }
+
+    // Drops the predictBatch cache, to be called whenever the model changes.
+    void invalidateBatchCache()
+    {
+        AutoLock lock(_batchCacheMutex);
+        _batchCache.release();
+    }
+
     int _num_components;
     double _threshold;
     std::vector<Mat> _projections;
@@ -169,6 +279,9 @@ protected:
     Mat _eigenvectors;
     Mat _eigenvalues;
     Mat _mean;
+
+    mutable Mutex _batchCacheMutex;
+    mutable Ptr<BatchCache> _batchCache;
 };
 
 #endif // __OPENCV_FACE_BASIC_HPP
@@ -86,6 +86,30 @@ void FaceRecognizer::predict(InputArray src, CV_OUT int &label, CV_OUT double &c
     confidence = collector->getMinDist();
 }
 
+void FaceRecognizer::predictBatch(InputArrayOfArrays src, const std::vector<Ptr<PredictCollector> >& collectors) const {
+    if (src.total() != collectors.size()) {
+        String error_message = format("The number of samples (src) must equal the number of collectors. Was len(samples)=%d, len(collectors)=%d.", (int)src.total(), (int)collectors.size());
+        CV_Error(Error::StsBadArg, error_message);
+    }
+    for (size_t i = 0; i < collectors.size(); i++)
+        predict(src.getMat((int)i), collectors[i]);
+}
+
+void FaceRecognizer::predictBatch(InputArrayOfArrays src, CV_OUT std::vector<int> &labels, CV_OUT std::vector<double> &confidences) const {
+    size_t n = src.total();
+    std::vector<Ptr<PredictCollector> > collectors(n);
+    for (size_t i = 0; i < n; i++)
+        collectors[i] = StandardCollector::create(getThreshold());
+    predictBatch(src, collectors);
+    labels.resize(n);
+    confidences.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        const StandardCollector* collector = static_cast<const StandardCollector*>(collectors[i].get());
+        labels[i] = collector->getMinLabel();
+        confidences[i] = collector->getMinDist();
+    }
+}
+
 }
 }
 
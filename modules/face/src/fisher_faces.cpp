@@ -90,6 +90,7 @@ void Fisherfaces::train(InputArrayOfArrays src, InputArray _lbls) {
     // clear existing model data
     _labels.release();
     _projections.clear();
+    invalidateBatchCache();
     // safely copy from cv::Mat to std::vector
     std::vector<int> ll;
     for(unsigned int i = 0; i < labels.total(); i++) {
@@ -18,9 +18,45 @@
 #include "precomp.hpp"
 #include "opencv2/face.hpp"
 #include "face_basic.hpp"
+#include <fstream>
 
 namespace cv { namespace face {
 
+class LBPHPredictInvoker;
+class HistogramInvoker;
+
+// The inverted lists of the approximate nearest neighbor index.
+struct LBPHIndex
+{
+    Mat centers;
+    std::vector<std::vector<int> > members;
+};
+
+// The parameters the spatial histograms are computed with.
+struct LBPHParams
+{
+    int radius;
+    int neighbors;
+    int grid_x;
+    int grid_y;
+
+    bool operator==(const LBPHParams& other) const {
+        return radius == other.radius && neighbors == other.neighbors &&
+               grid_x == other.grid_x && grid_y == other.grid_y;
+    }
+};
+
+// A consistent view of the gallery and the parameters. The gallery
+// matrices only grow at their end and the index is replaced rather than
+// modified, so a view stays valid while new samples are enrolled.
+struct LBPHGallery
+{
+    Mat histograms;
+    Mat labels;
+    Ptr<LBPHIndex> index;
+    LBPHParams params;
+};
+
 // Face Recognition based on Local Binary Patterns.
 //
 //  Ahonen T, Hadid A. and Pietikäinen M. "Face description with local binary
@@ -29,21 +65,71 @@ namespace cv { namespace face {
 //
 class LBPH : public LBPHFaceRecognizer
 {
+    friend class LBPHPredictInvoker;
+    friend class HistogramInvoker;
 private:
     int _grid_x;
     int _grid_y;
     int _radius;
     int _neighbors;
     double _threshold;
+    int _index_lists;
+    int _index_probes;
 
-    std::vector<Mat> _histograms;
+    // The spatial histograms of the gallery, one row per sample. The
+    // matrix is grown in place by the updates.
+    Mat _histograms;
     Mat _labels;
 
+    // The approximate nearest neighbor index, empty if not used.
+    Ptr<LBPHIndex> _index;
+
+    // Guards the gallery members above and the histogram parameters,
+    // predictions only hold it while taking a view of the gallery.
+    mutable Mutex _galleryMutex;
+    // Serializes the modifications of the model.
+    Mutex _trainMutex;
+
+    // Returns a view of the current gallery.
+    LBPHGallery gallery() const;
+
+    // Returns the histogram parameters, the caller holds one of the mutexes.
+    LBPHParams currentParams() const;
+
+    // Sets a histogram parameter, serialized with the modifications of the model.
+    void setParam(int& param, int val);
+
     // Computes a LBPH model with images in src and
     // corresponding labels in labels, possibly preserving
     // old model data.
     void train(InputArrayOfArrays src, InputArray labels, bool preserveData);
 
+    // Computes the spatial histogram of an image.
+    static Mat computeHistogram(InputArray src, const LBPHParams& params);
+
+    // Computes the spatial histograms of the images in parallel,
+    // one row per image.
+    static Mat computeHistograms(const std::vector<Mat>& src, const LBPHParams& params);
+
+    // Clusters the histograms into _index_lists inverted lists, returns
+    // an empty index if the index is disabled or there are too few samples.
+    Ptr<LBPHIndex> buildIndex(const Mat& histograms) const;
+
+    // Adds the histograms to the inverted lists of their closest centers,
+    // numbering them from firstSample.
+    static void addToIndex(LBPHIndex& index, const Mat& histograms, int firstSample);
+
+    // Finds the count index centers closest to a histogram.
+    static void closestCenters(const LBPHIndex& index, const float* hist, int count, std::vector<int>& centers);
+
+    // Compares a query histogram with the gallery (or the probed
+    // inverted lists) and sends the results to the collector.
+    void predictHistogram(const LBPHGallery& gallery, const Mat& query, Ptr<PredictCollector> collector, bool parallel) const;
+
+    // Replaces the whole gallery and the parameters it was computed with
+    // and rebuilds the index, the caller holds _trainMutex.
+    void resetGallery(const Mat& histograms, const Mat& labels, const LBPHParams& params);
+
 
 public:
     using FaceRecognizer::save;
@@ -61,7 +147,9 @@ public:
         _grid_y(gridy),
         _radius(radius_),
         _neighbors(neighbors_),
-        _threshold(threshold) {}
+        _threshold(threshold),
+        _index_lists(0),
+        _index_probes(1) {}
 
     // Initializes and computes this LBPH Model. The current implementation is
     // rather fixed as it uses the Extended Local Binary Patterns per default.
@@ -77,7 +165,9 @@ public:
                 _grid_y(gridy),
                 _radius(radius_),
                 _neighbors(neighbors_),
-                _threshold(threshold) {
+                _threshold(threshold),
+                _index_lists(0),
+                _index_probes(1) {
         train(src, labels);
     }
 
@@ -94,30 +184,74 @@ public:
     // Send all predict results to caller side for custom result handling
     void predict(InputArray src, Ptr<PredictCollector> collector) const;
 
+    // Predicts the samples in parallel, see FaceRecognizer::predictBatch.
+    using FaceRecognizer::predictBatch;
+    void predictBatch(InputArrayOfArrays src, const std::vector<Ptr<PredictCollector> >& collectors) const;
+
     // See FaceRecognizer::load.
     void load(const FileStorage& fs);
 
     // See FaceRecognizer::save.
     void save(FileStorage& fs) const;
 
-    CV_IMPL_PROPERTY(int, GridX, _grid_x)
-    CV_IMPL_PROPERTY(int, GridY, _grid_y)
-    CV_IMPL_PROPERTY(int, Radius, _radius)
-    CV_IMPL_PROPERTY(int, Neighbors, _neighbors)
+    // See LBPHFaceRecognizer::saveBinary.
+    void saveBinary(const String& filename) const;
+
+    // See LBPHFaceRecognizer::loadBinary.
+    void loadBinary(const String& filename);
+
+    int getGridX() const { return gallery().params.grid_x; }
+    void setGridX(int val) { setParam(_grid_x, val); }
+    int getGridY() const { return gallery().params.grid_y; }
+    void setGridY(int val) { setParam(_grid_y, val); }
+    int getRadius() const { return gallery().params.radius; }
+    void setRadius(int val) { setParam(_radius, val); }
+    int getNeighbors() const { return gallery().params.neighbors; }
+    void setNeighbors(int val) { setParam(_neighbors, val); }
     CV_IMPL_PROPERTY(double, Threshold, _threshold)
-    CV_IMPL_PROPERTY_RO(std::vector<cv::Mat>, Histograms, _histograms)
-    CV_IMPL_PROPERTY_RO(cv::Mat, Labels, _labels)
+
+    cv::Mat getLabels() const { return gallery().labels; }
+
+    std::vector<cv::Mat> getHistograms() const {
+        Mat gallery_histograms = gallery().histograms;
+        std::vector<Mat> histograms(gallery_histograms.rows);
+        for (int i = 0; i < gallery_histograms.rows; i++)
+            histograms[i] = gallery_histograms.row(i);
+        return histograms;
+    }
+
+    int getIndexLists() const { return _index_lists; }
+    void setIndexLists(int val) {
+        CV_Assert(val >= 0);
+        AutoLock trainLock(_trainMutex);
+        _index_lists = val;
+        Ptr<LBPHIndex> index = buildIndex(_histograms);
+        AutoLock lock(_galleryMutex);
+        _index = index;
+    }
+
+    int getIndexProbes() const { return _index_probes; }
+    void setIndexProbes(int val) {
+        CV_Assert(val > 0);
+        _index_probes = val;
+    }
 };
 
 
 void LBPH::load(const FileStorage& fs) {
-    fs["radius"] >> _radius;
-    fs["neighbors"] >> _neighbors;
-    fs["grid_x"] >> _grid_x;
-    fs["grid_y"] >> _grid_y;
+    AutoLock trainLock(_trainMutex);
+    LBPHParams params;
+    fs["radius"] >> params.radius;
+    fs["neighbors"] >> params.neighbors;
+    fs["grid_x"] >> params.grid_x;
+    fs["grid_y"] >> params.grid_y;
     //read matrices
-    readFileNodeList(fs["histograms"], _histograms);
-    fs["labels"] >> _labels;
+    std::vector<Mat> histogramList;
+    readFileNodeList(fs["histograms"], histogramList);
+    Mat histograms, labels;
+    for (size_t sampleIdx = 0; sampleIdx < histogramList.size(); sampleIdx++)
+        histograms.push_back(histogramList[sampleIdx].reshape(1, 1));
+    fs["labels"] >> labels;
     const FileNode& fn = fs["labelsInfo"];
     if (fn.type() == FileNode::SEQ)
     {
@@ -129,23 +263,129 @@ void LBPH::load(const FileStorage& fs) {
             _labelsInfo.insert(std::make_pair(item.label, item.value));
         }
     }
+    resetGallery(histograms, labels, params);
 }
 
 // See FaceRecognizer::save.
 void LBPH::save(FileStorage& fs) const {
-    fs << "radius" << _radius;
-    fs << "neighbors" << _neighbors;
-    fs << "grid_x" << _grid_x;
-    fs << "grid_y" << _grid_y;
+    LBPHGallery view = gallery();
+    fs << "radius" << view.params.radius;
+    fs << "neighbors" << view.params.neighbors;
+    fs << "grid_x" << view.params.grid_x;
+    fs << "grid_y" << view.params.grid_y;
     // write matrices
-    writeFileNodeList(fs, "histograms", _histograms);
-    fs << "labels" << _labels;
+    std::vector<Mat> histograms(view.histograms.rows);
+    for (int i = 0; i < view.histograms.rows; i++)
+        histograms[i] = view.histograms.row(i);
+    writeFileNodeList(fs, "histograms", histograms);
+    fs << "labels" << view.labels;
     fs << "labelsInfo" << "[";
     for (std::map<int, String>::const_iterator it = _labelsInfo.begin(); it != _labelsInfo.end(); it++)
         fs << LabelInfo(it->first, it->second);
     fs << "]";
 }
 
+// The binary model file starts with this tag and version, followed by
+// the parameters, the histogram matrix, the labels and the label infos.
+static const char LBPH_BINARY_TAG[4] = { 'L', 'B', 'P', 'H' };
+static const int LBPH_BINARY_VERSION = 1;
+
+template <typename _Tp> static
+inline void writeBinary(std::ofstream& file, const _Tp& value) {
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename _Tp> static
+inline void readBinary(std::ifstream& file, _Tp& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+void LBPH::saveBinary(const String& filename) const {
+    LBPHGallery view = gallery();
+    std::ofstream file(filename.c_str(), std::ios_base::binary);
+    if (!file.good())
+        CV_Error(Error::StsError, "File can't be opened for writing!");
+    file.write(LBPH_BINARY_TAG, sizeof(LBPH_BINARY_TAG));
+    writeBinary(file, LBPH_BINARY_VERSION);
+    writeBinary(file, view.params.radius);
+    writeBinary(file, view.params.neighbors);
+    writeBinary(file, view.params.grid_x);
+    writeBinary(file, view.params.grid_y);
+    int rows = view.histograms.rows, cols = view.histograms.cols;
+    writeBinary(file, rows);
+    writeBinary(file, cols);
+    for (int i = 0; i < rows; i++)
+        file.write(view.histograms.ptr<char>(i), cols * sizeof(float));
+    for (int i = 0; i < rows; i++)
+        writeBinary(file, view.labels.at<int>(i));
+    int infoCount = (int)_labelsInfo.size();
+    writeBinary(file, infoCount);
+    for (std::map<int, String>::const_iterator it = _labelsInfo.begin(); it != _labelsInfo.end(); it++) {
+        int length = (int)it->second.size();
+        writeBinary(file, it->first);
+        writeBinary(file, length);
+        file.write(it->second.c_str(), length);
+    }
+    if (!file.good())
+        CV_Error(Error::StsError, "Failed to write the LBPH model!");
+}
+
+void LBPH::loadBinary(const String& filename) {
+    std::ifstream file(filename.c_str(), std::ios_base::binary);
+    if (!file.good())
+        CV_Error(Error::StsError, "File can't be opened for reading!");
+    file.seekg(0, std::ios_base::end);
+    std::streamoff file_size = file.tellg();
+    file.seekg(0, std::ios_base::beg);
+    char tag[sizeof(LBPH_BINARY_TAG)];
+    int version = 0;
+    file.read(tag, sizeof(tag));
+    readBinary(file, version);
+    if (!file.good() || memcmp(tag, LBPH_BINARY_TAG, sizeof(tag)) != 0 || version != LBPH_BINARY_VERSION)
+        CV_Error(Error::StsParseError, "The file is not a binary LBPH model!");
+    AutoLock trainLock(_trainMutex);
+    LBPHParams params;
+    int rows = 0, cols = 0;
+    readBinary(file, params.radius);
+    readBinary(file, params.neighbors);
+    readBinary(file, params.grid_x);
+    readBinary(file, params.grid_y);
+    readBinary(file, rows);
+    readBinary(file, cols);
+    if (!file.good() || rows < 0 || params.neighbors <= 0 || params.neighbors > 30
+            || params.grid_x <= 0 || params.grid_y <= 0)
+        CV_Error(Error::StsParseError, "The binary LBPH model is corrupted!");
+    // the histograms must have the size given by the parameters (none for an
+    // empty model) and, with their labels, fit in the rest of the file
+    int64 expected_cols = (int64)(1 << params.neighbors) * params.grid_x * params.grid_y;
+    std::streamoff remaining = file_size - (std::streamoff)file.tellg();
+    if ((cols != expected_cols && (rows != 0 || cols != 0))
+            || (int64)rows * ((int64)cols * (int64)sizeof(float) + (int64)sizeof(int)) > (int64)remaining)
+        CV_Error(Error::StsParseError, "The binary LBPH model is corrupted!");
+    Mat histograms(rows, cols, CV_32FC1), labels(rows, 1, CV_32SC1);
+    for (int i = 0; i < rows; i++)
+        file.read(histograms.ptr<char>(i), cols * sizeof(float));
+    for (int i = 0; i < rows; i++)
+        readBinary(file, labels.at<int>(i));
+    int infoCount = 0;
+    readBinary(file, infoCount);
+    _labelsInfo.clear();
+    for (int i = 0; i < infoCount && file.good(); i++) {
+        int label = 0, length = 0;
+        readBinary(file, label);
+        readBinary(file, length);
+        if (!file.good() || length < 0 || length > file_size - (std::streamoff)file.tellg())
+            break;
+        std::vector<char> value(length);
+        if (length > 0)
+            file.read(&value[0], length);
+        _labelsInfo.insert(std::make_pair(label, String(value.begin(), value.end())));
+    }
+    if (!file.good())
+        CV_Error(Error::StsParseError, "The binary LBPH model is corrupted!");
+    resetGallery(histograms, labels, params);
+}
+
 void LBPH::train(InputArrayOfArrays _in_src, InputArray _in_labels) {
     this->train(_in_src, _in_labels, false);
 }
@@ -358,53 +598,324 @@ void LBPH::train(InputArrayOfArrays _in_src, InputArray _in_labels, bool preserv
         String error_message = format("The number of samples (src) must equal the number of labels (labels). Was len(samples)=%d, len(labels)=%d.", src.size(), _labels.total());
         CV_Error(Error::StsBadArg, error_message);
     }
-    // if this model should be trained without preserving old data, delete old model data
-    if(!preserveData) {
-        _labels.release();
-        _histograms.clear();
-    }
-    // append labels to _labels matrix
+    Mat newLabels((int)labels.total(), 1, CV_32SC1);
     for(size_t labelIdx = 0; labelIdx < labels.total(); labelIdx++) {
-        _labels.push_back(labels.at<int>((int)labelIdx));
+        newLabels.at<int>((int)labelIdx) = labels.at<int>((int)labelIdx);
+    }
+    for (;;) {
+        // the spatial histograms are computed without holding the lock, so
+        // they neither block the predictions nor the other modifications
+        LBPHParams params;
+        {
+            AutoLock trainLock(_trainMutex);
+            params = currentParams();
+        }
+        Mat histograms = computeHistograms(src, params);
+        AutoLock trainLock(_trainMutex);
+        // the parameters were changed meanwhile, the histograms are stale
+        if (!(currentParams() == params))
+            continue;
+        // if this model should be trained without preserving old data, replace the old model data
+        if(!preserveData || _histograms.empty()) {
+            resetGallery(histograms, newLabels, params);
+            return;
+        }
+        // new samples go to a copy of the existing inverted lists, published
+        // together with the samples
+        Ptr<LBPHIndex> index = _index;
+        if(index) {
+            index = makePtr<LBPHIndex>(*_index);
+            addToIndex(*index, histograms, _histograms.rows);
+        }
+        AutoLock lock(_galleryMutex);
+        _histograms.push_back(histograms);
+        _labels.push_back(newLabels);
+        _index = index;
+        return;
+    }
+}
+
+void LBPH::resetGallery(const Mat& histograms, const Mat& labels, const LBPHParams& params) {
+    Ptr<LBPHIndex> index = buildIndex(histograms);
+    AutoLock lock(_galleryMutex);
+    _histograms = histograms;
+    _labels = labels;
+    _index = index;
+    _radius = params.radius;
+    _neighbors = params.neighbors;
+    _grid_x = params.grid_x;
+    _grid_y = params.grid_y;
+}
+
+LBPHParams LBPH::currentParams() const {
+    LBPHParams params;
+    params.radius = _radius;
+    params.neighbors = _neighbors;
+    params.grid_x = _grid_x;
+    params.grid_y = _grid_y;
+    return params;
+}
+
+void LBPH::setParam(int& param, int val) {
+    AutoLock trainLock(_trainMutex);
+    AutoLock lock(_galleryMutex);
+    param = val;
+}
+
+LBPHGallery LBPH::gallery() const {
+    AutoLock lock(_galleryMutex);
+    LBPHGallery view;
+    view.histograms = _histograms;
+    view.labels = _labels;
+    view.index = _index;
+    view.params = currentParams();
+    return view;
+}
+
+Mat LBPH::computeHistogram(InputArray src, const LBPHParams& params) {
+    // calculate lbp image
+    Mat lbp_image = elbp(src, params.radius, params.neighbors);
+    // get spatial histogram from this lbp image
+    return spatial_histogram(
+            lbp_image, /* lbp_image */
+            static_cast<int>(std::pow(2.0, static_cast<double>(params.neighbors))), /* number of possible patterns */
+            params.grid_x, /* grid size x */
+            params.grid_y, /* grid size y */
+            true /* normed histograms */);
+}
+
+// Computes the spatial histograms of a range of images.
+class HistogramInvoker : public ParallelLoopBody {
+public:
+    HistogramInvoker(const LBPHParams& _params, const std::vector<Mat>& _src, Mat& _histograms) :
+        params(&_params), src(&_src), histograms(&_histograms) {}
+
+    void operator()(const Range& range) const {
+        for (int i = range.start; i < range.end; i++)
+            LBPH::computeHistogram((*src)[i], *params).reshape(1, 1).copyTo(histograms->row(i));
     }
-    // store the spatial histograms of the original data
-    for(size_t sampleIdx = 0; sampleIdx < src.size(); sampleIdx++) {
-        // calculate lbp image
-        Mat lbp_image = elbp(src[sampleIdx], _radius, _neighbors);
-        // get spatial histogram from this lbp image
-        Mat p = spatial_histogram(
-                lbp_image, /* lbp_image */
-                static_cast<int>(std::pow(2.0, static_cast<double>(_neighbors))), /* number of possible patterns */
-                _grid_x, /* grid size x */
-                _grid_y, /* grid size y */
-                true);
-        // add to templates
-        _histograms.push_back(p);
+private:
+    const LBPHParams* params;
+    const std::vector<Mat>* src;
+    Mat* histograms;
+};
+
+Mat LBPH::computeHistograms(const std::vector<Mat>& src, const LBPHParams& params) {
+    Mat histograms;
+    if (src.empty())
+        return histograms;
+    // the size of the histograms only depends on the parameters
+    Mat first = computeHistogram(src[0], params).reshape(1, 1);
+    histograms.create((int)src.size(), first.cols, CV_32FC1);
+    first.copyTo(histograms.row(0));
+    parallel_for_(Range(1, (int)src.size()), HistogramInvoker(params, src, histograms));
+    return histograms;
+}
+
+#if CV_SSE2
+// The chi-square terms of two bins, d*d/s for |s| > DBL_EPSILON and 0 otherwise.
+static inline __m128d chiSquareTerms(__m128d d, __m128d s) {
+    const __m128d absMask = _mm_castsi128_pd(_mm_set_epi32(0x7fffffff, -1, 0x7fffffff, -1));
+    const __m128d eps = _mm_set1_pd(DBL_EPSILON), one = _mm_set1_pd(1.);
+    __m128d mask = _mm_cmpgt_pd(_mm_and_pd(s, absMask), eps);
+    s = _mm_or_pd(_mm_and_pd(mask, s), _mm_andnot_pd(mask, one));
+    return _mm_and_pd(mask, _mm_div_pd(_mm_mul_pd(d, d), s));
+}
+#endif
+
+// Chi-square distance between two float histograms, computed like
+// compareHist(HISTCMP_CHISQR_ALT): the bin differences and sums are
+// rounded to float and the distance is accumulated in double.
+static double chiSquareAlt(const float* h1, const float* h2, int len) {
+    double result = 0;
+    int j = 0;
+#if CV_SSE2
+    if (checkHardwareSupport(CV_CPU_SSE2)) {
+        __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+        for (; j <= len - 4; j += 4) {
+            __m128 a = _mm_loadu_ps(h1 + j), b = _mm_loadu_ps(h2 + j);
+            __m128 d = _mm_sub_ps(a, b), s = _mm_add_ps(a, b);
+            acc0 = _mm_add_pd(acc0, chiSquareTerms(_mm_cvtps_pd(d), _mm_cvtps_pd(s)));
+            acc1 = _mm_add_pd(acc1, chiSquareTerms(_mm_cvtps_pd(_mm_movehl_ps(d, d)),
+                                                   _mm_cvtps_pd(_mm_movehl_ps(s, s))));
+        }
+        double buf[2];
+        _mm_storeu_pd(buf, _mm_add_pd(acc0, acc1));
+        result = buf[0] + buf[1];
+    }
+#endif
+    for (; j < len; j++) {
+        double a = h1[j] - h2[j];
+        double b = h1[j] + h2[j];
+        if (fabs(b) > DBL_EPSILON)
+            result += a*a/b;
+    }
+    return result*2;
+}
+
+// Computes the distances of a query to a set of gallery samples.
+class ChiSquareInvoker : public ParallelLoopBody {
+public:
+    ChiSquareInvoker(const Mat& _gallery, const Mat& _query, const std::vector<int>* _samples, std::vector<double>& _dists) :
+        gallery(&_gallery), query(&_query), samples(_samples), dists(&_dists) {}
+
+    void operator()(const Range& range) const {
+        const float* q = query->ptr<float>();
+        for (int k = range.start; k < range.end; k++) {
+            int sampleIdx = samples ? (*samples)[k] : k;
+            (*dists)[k] = chiSquareAlt(gallery->ptr<float>(sampleIdx), q, gallery->cols);
+        }
+    }
+private:
+    const Mat* gallery;
+    const Mat* query;
+    const std::vector<int>* samples;
+    std::vector<double>* dists;
+};
+
+Ptr<LBPHIndex> LBPH::buildIndex(const Mat& histograms) const {
+    int numSamples = histograms.rows;
+    if (_index_lists <= 0 || numSamples < _index_lists)
+        return Ptr<LBPHIndex>();
+    // the centers are learned on a random subset of the gallery
+    const int samplesPerList = 64;
+    Mat trainSet = histograms;
+    if (numSamples > samplesPerList * _index_lists) {
+        std::vector<int> order(numSamples);
+        for (int i = 0; i < numSamples; i++)
+            order[i] = i;
+        RNG rng((uint64)-1);
+        randShuffle(order, 1., &rng);
+        trainSet.create(samplesPerList * _index_lists, histograms.cols, CV_32FC1);
+        for (int i = 0; i < trainSet.rows; i++)
+            histograms.row(order[i]).copyTo(trainSet.row(i));
+    }
+    Ptr<LBPHIndex> index = makePtr<LBPHIndex>();
+    Mat bestLabels;
+    kmeans(trainSet, _index_lists, bestLabels,
+           TermCriteria(TermCriteria::COUNT + TermCriteria::EPS, 10, 1e-4),
+           1, KMEANS_PP_CENTERS, index->centers);
+    index->members.resize(_index_lists);
+    addToIndex(*index, histograms, 0);
+    return index;
+}
+
+void LBPH::closestCenters(const LBPHIndex& index, const float* hist, int count, std::vector<int>& centers) {
+    std::vector<std::pair<double, int> > dists(index.centers.rows);
+    Mat h(1, index.centers.cols, CV_32FC1, const_cast<float*>(hist));
+    for (int c = 0; c < index.centers.rows; c++)
+        dists[c] = std::make_pair(norm(h, index.centers.row(c), NORM_L2SQR), c);
+    count = std::min(count, (int)dists.size());
+    std::partial_sort(dists.begin(), dists.begin() + count, dists.end());
+    centers.resize(count);
+    for (int c = 0; c < count; c++)
+        centers[c] = dists[c].second;
+}
+
+// Finds the closest index center of every sample of a range.
+class ClosestCenterInvoker : public ParallelLoopBody {
+public:
+    ClosestCenterInvoker(const Mat& _histograms, const Mat& _centers, std::vector<int>& _assignment) :
+        histograms(&_histograms), centers(&_centers), assignment(&_assignment) {}
+
+    void operator()(const Range& range) const {
+        for (int i = range.start; i < range.end; i++) {
+            double minDist = DBL_MAX;
+            for (int c = 0; c < centers->rows; c++) {
+                double dist = norm(histograms->row(i), centers->row(c), NORM_L2SQR);
+                if (dist < minDist) {
+                    minDist = dist;
+                    (*assignment)[i] = c;
+                }
+            }
+        }
+    }
+private:
+    const Mat* histograms;
+    const Mat* centers;
+    std::vector<int>* assignment;
+};
+
+void LBPH::addToIndex(LBPHIndex& index, const Mat& histograms, int firstSample) {
+    std::vector<int> assignment(histograms.rows, 0);
+    parallel_for_(Range(0, histograms.rows), ClosestCenterInvoker(histograms, index.centers, assignment));
+    for (int i = 0; i < histograms.rows; i++)
+        index.members[assignment[i]].push_back(firstSample + i);
+}
+
+void LBPH::predictHistogram(const LBPHGallery& gallery, const Mat& query, Ptr<PredictCollector> collector, bool parallel) const {
+    // gather the samples of the probed inverted lists, or compare with the whole gallery
+    std::vector<int> samples;
+    bool useIndex = !gallery.index.empty();
+    if (useIndex) {
+        std::vector<int> centers;
+        closestCenters(*gallery.index, query.ptr<float>(), _index_probes, centers);
+        for (size_t c = 0; c < centers.size(); c++) {
+            const std::vector<int>& members = gallery.index->members[centers[c]];
+            samples.insert(samples.end(), members.begin(), members.end());
+        }
+    }
+    int count = useIndex ? (int)samples.size() : gallery.histograms.rows;
+    std::vector<double> dists(count);
+    ChiSquareInvoker invoker(gallery.histograms, query, useIndex ? &samples : 0, dists);
+    if (parallel)
+        parallel_for_(Range(0, count), invoker);
+    else
+        invoker(Range(0, count));
+    // find 1-nearest neighbor
+    collector->init(count);
+    for (int k = 0; k < count; k++) {
+        int label = gallery.labels.at<int>(useIndex ? samples[k] : k);
+        if (!collector->collect(label, dists[k]))return;
     }
 }
 
 void LBPH::predict(InputArray _src, Ptr<PredictCollector> collector) const {
-    if(_histograms.empty()) {
+    LBPHGallery view = gallery();
+    if(view.histograms.empty()) {
         // throw error if no data (or simply return -1?)
         String error_message = "This LBPH model is not computed yet. Did you call the train method?";
         CV_Error(Error::StsBadArg, error_message);
     }
-    Mat src = _src.getMat();
     // get the spatial histogram from input image
-    Mat lbp_image = elbp(src, _radius, _neighbors);
-    Mat query = spatial_histogram(
-            lbp_image, /* lbp_image */
-            static_cast<int>(std::pow(2.0, static_cast<double>(_neighbors))), /* number of possible patterns */
-            _grid_x, /* grid size x */
-            _grid_y, /* grid size y */
-            true /* normed histograms */);
-    // find 1-nearest neighbor
-    collector->init((int)_histograms.size());
-    for (size_t sampleIdx = 0; sampleIdx < _histograms.size(); sampleIdx++) {
-        double dist = compareHist(_histograms[sampleIdx], query, HISTCMP_CHISQR_ALT);
-        int label = _labels.at<int>((int)sampleIdx);
-        if (!collector->collect(label, dist))return;
+    Mat query = computeHistogram(_src, view.params);
+    predictHistogram(view, query, collector, true);
+}
+
+// Predicts a range of the samples of a batch, every sample compared
+// with the gallery on one thread.
+class LBPHPredictInvoker : public ParallelLoopBody {
+public:
+    LBPHPredictInvoker(const LBPH& _model, const LBPHGallery& _gallery, const std::vector<Mat>& _src,
+                       const std::vector<Ptr<PredictCollector> >& _collectors) :
+        model(&_model), gallery(&_gallery), src(&_src), collectors(&_collectors) {}
+
+    void operator()(const Range& range) const {
+        for (int i = range.start; i < range.end; i++) {
+            Mat query = LBPH::computeHistogram((*src)[i], gallery->params);
+            model->predictHistogram(*gallery, query, (*collectors)[i], false);
+        }
     }
+private:
+    const LBPH* model;
+    const LBPHGallery* gallery;
+    const std::vector<Mat>* src;
+    const std::vector<Ptr<PredictCollector> >* collectors;
+};
+
+void LBPH::predictBatch(InputArrayOfArrays _src, const std::vector<Ptr<PredictCollector> >& collectors) const {
+    LBPHGallery view = gallery();
+    if(view.histograms.empty()) {
+        String error_message = "This LBPH model is not computed yet. Did you call the train method?";
+        CV_Error(Error::StsBadArg, error_message);
+    }
+    if (_src.total() != collectors.size()) {
+        String error_message = format("The number of samples (src) must equal the number of collectors. Was len(samples)=%d, len(collectors)=%d.", (int)_src.total(), (int)collectors.size());
+        CV_Error(Error::StsBadArg, error_message);
+    }
+    std::vector<Mat> src;
+    _src.getMatVector(src);
+    parallel_for_(Range(0, (int)src.size()), LBPHPredictInvoker(*this, view, src, collectors));
 }
 
 Ptr<LBPHFaceRecognizer> createLBPHFaceRecognizer(int radius, int neighbors,
@@ -0,0 +1,119 @@
+/*
+By downloading, copying, installing or using the software you agree to this
+license. If you do not agree to this license, do not download, install,
+copy or use the software.
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2016, OpenCV Foundation, all rights reserved.
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are
+disclaimed. In no event shall copyright holders or contributors be liable for
+any direct, indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "test_precomp.hpp"
+
+
+static void makeClasses(std::vector<cv::Mat>& images, std::vector<int>& labels) {
+    cv::RNG rng(4321);
+    images.clear();
+    labels.clear();
+    for (int label = 0; label < 5; label++) {
+        cv::Mat base(24, 24, CV_8UC1);
+        rng.fill(base, cv::RNG::UNIFORM, 0, 256);
+        for (int i = 0; i < 4; i++) {
+            cv::Mat noise(base.size(), CV_8UC1), image;
+            rng.fill(noise, cv::RNG::UNIFORM, 0, 16);
+            cv::add(base, noise, image);
+            images.push_back(image);
+            labels.push_back(label);
+        }
+    }
+}
+
+// Compares predictBatch with predict, both must give the expected labels.
+static void checkBatchMatchesPredict(const cv::Ptr<cv::face::BasicFaceRecognizer>& model,
+                                     const std::vector<cv::Mat>& images, const std::vector<int>& expected) {
+    std::vector<int> batchLabels;
+    std::vector<double> batchDists;
+    model->predictBatch(images, batchLabels, batchDists);
+    ASSERT_EQ(images.size(), batchLabels.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        int label = -1;
+        double dist = 0;
+        model->predict(images[i], label, dist);
+        EXPECT_EQ(expected[i], label);
+        EXPECT_EQ(label, batchLabels[i]);
+        EXPECT_NEAR(dist, batchDists[i], 1e-3);
+    }
+}
+
+static void checkBatchPredict(const cv::Ptr<cv::face::BasicFaceRecognizer>& model) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeClasses(images, labels);
+    model->train(images, labels);
+    checkBatchMatchesPredict(model, images, labels);
+}
+
+TEST(CV_Face_Eigenfaces, batch_predict_matches_predict) {
+    checkBatchPredict(cv::face::createEigenFaceRecognizer());
+}
+
+TEST(CV_Face_Fisherfaces, batch_predict_matches_predict) {
+    checkBatchPredict(cv::face::createFisherFaceRecognizer());
+}
+
+// predictBatch caches the converted model, retraining and loading must refresh it.
+static void checkBatchCacheInvalidation(const cv::Ptr<cv::face::BasicFaceRecognizer>& model) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeClasses(images, labels);
+    model->train(images, labels);
+    checkBatchMatchesPredict(model, images, labels);
+    std::string filename = cv::tempfile(".yml");
+    model->save(filename);
+
+    std::vector<int> relabeled(labels.size());
+    for (size_t i = 0; i < labels.size(); i++)
+        relabeled[i] = 10 + labels[i];
+    model->train(images, relabeled);
+    checkBatchMatchesPredict(model, images, relabeled);
+
+    model->load(filename);
+    remove(filename.c_str());
+    checkBatchMatchesPredict(model, images, labels);
+}
+
+TEST(CV_Face_Eigenfaces, batch_predict_follows_model_changes) {
+    checkBatchCacheInvalidation(cv::face::createEigenFaceRecognizer());
+}
+
+TEST(CV_Face_Fisherfaces, batch_predict_follows_model_changes) {
+    checkBatchCacheInvalidation(cv::face::createFisherFaceRecognizer());
+}
@@ -0,0 +1,241 @@
+/*
+By downloading, copying, installing or using the software you agree to this
+license. If you do not agree to this license, do not download, install,
+copy or use the software.
+
+                          License Agreement
+               For Open Source Computer Vision Library
+                       (3-clause BSD License)
+
+Copyright (C) 2016, OpenCV Foundation, all rights reserved.
+Third party copyrights are property of their respective owners.
+
+Redistribution and use in source and binary forms, with or without modification,
+are permitted provided that the following conditions are met:
+
+  * Redistributions of source code must retain the above copyright notice,
+    this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright notice,
+    this list of conditions and the following disclaimer in the documentation
+    and/or other materials provided with the distribution.
+
+  * Neither the names of the copyright holders nor the names of the contributors
+    may be used to endorse or promote products derived from this software
+    without specific prior written permission.
+
+This software is provided by the copyright holders and contributors "as is" and
+any express or implied warranties, including, but not limited to, the implied
+warranties of merchantability and fitness for a particular purpose are
+disclaimed. In no event shall copyright holders or contributors be liable for
+any direct, indirect, incidental, special, exemplary, or consequential damages
+(including, but not limited to, procurement of substitute goods or services;
+loss of use, data, or profits; or business interruption) however caused
+and on any theory of liability, whether in contract, strict liability,
+or tort (including negligence or otherwise) arising in any way out of
+the use of this software, even if advised of the possibility of such damage.
+*/
+
+#include "test_precomp.hpp"
+
+#include <fstream>
+
+static void makeGallery(std::vector<cv::Mat>& images, std::vector<int>& labels, int count) {
+    cv::RNG rng(12345);
+    images.clear();
+    labels.clear();
+    for (int i = 0; i < count; i++) {
+        cv::Mat image(40, 40, CV_8UC1);
+        rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+        images.push_back(image);
+        labels.push_back(i);
+    }
+}
+
+TEST(CV_Face_LBPH, batch_predict_matches_predict) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeGallery(images, labels, 20);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> model = cv::face::createLBPHFaceRecognizer();
+    model->train(images, labels);
+
+    std::vector<int> batchLabels;
+    std::vector<double> batchDists;
+    model->predictBatch(images, batchLabels, batchDists);
+    ASSERT_EQ(images.size(), batchLabels.size());
+    for (size_t i = 0; i < images.size(); i++) {
+        int label = -1;
+        double dist = 0;
+        model->predict(images[i], label, dist);
+        EXPECT_EQ(labels[i], label);
+        EXPECT_EQ(label, batchLabels[i]);
+        EXPECT_DOUBLE_EQ(dist, batchDists[i]);
+    }
+}
+
+TEST(CV_Face_LBPH, binary_save_load) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeGallery(images, labels, 10);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> model = cv::face::createLBPHFaceRecognizer();
+    model->train(images, labels);
+    model->setLabelInfo(3, "three");
+
+    std::string filename = cv::tempfile(".bin");
+    model->saveBinary(filename);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> loaded = cv::face::createLBPHFaceRecognizer();
+    loaded->loadBinary(filename);
+    remove(filename.c_str());
+
+    EXPECT_EQ(cv::String("three"), loaded->getLabelInfo(3));
+    std::vector<cv::Mat> h1 = model->getHistograms(), h2 = loaded->getHistograms();
+    ASSERT_EQ(h1.size(), h2.size());
+    for (size_t i = 0; i < h1.size(); i++)
+        EXPECT_EQ(0, cvtest::norm(h1[i], h2[i], cv::NORM_INF));
+    for (size_t i = 0; i < images.size(); i++)
+        EXPECT_EQ(labels[i], loaded->predict(images[i]));
+}
+
+static void patchInt(const std::string& filename, std::streamoff offset, int value) {
+    std::fstream file(filename.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    file.seekp(offset);
+    file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+TEST(CV_Face_LBPH, binary_load_rejects_corrupted_sizes) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeGallery(images, labels, 4);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> model = cv::face::createLBPHFaceRecognizer();
+    model->train(images, labels);
+    std::string filename = cv::tempfile(".bin");
+
+    // the tag, the version and the 4 parameters come before the rows and the columns
+    const std::streamoff rowsOffset = 4 + 5 * sizeof(int), colsOffset = rowsOffset + sizeof(int);
+    const int badValues[][2] = {
+        { 1 << 28, -1 },   // more histograms than the file holds
+        { -1, 100 },       // columns that do not match the parameters
+        { -1, 1 << 30 },
+    };
+    for (size_t k = 0; k < sizeof(badValues) / sizeof(badValues[0]); k++) {
+        model->saveBinary(filename);
+        if (badValues[k][0] >= 0)
+            patchInt(filename, rowsOffset, badValues[k][0]);
+        if (badValues[k][1] >= 0)
+            patchInt(filename, colsOffset, badValues[k][1]);
+
+        cv::Ptr<cv::face::LBPHFaceRecognizer> loaded = cv::face::createLBPHFaceRecognizer();
+        EXPECT_THROW(loaded->loadBinary(filename), cv::Exception) << "case " << k;
+        EXPECT_TRUE(loaded->getHistograms().empty()) << "case " << k;
+    }
+    remove(filename.c_str());
+}
+
+TEST(CV_Face_LBPH, index_probing_all_lists_is_exact) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeGallery(images, labels, 32);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> model = cv::face::createLBPHFaceRecognizer();
+    model->train(images, labels);
+    model->setIndexLists(4);
+    model->setIndexProbes(4);
+    for (size_t i = 0; i < images.size(); i++)
+        EXPECT_EQ(labels[i], model->predict(images[i]));
+}
+
+TEST(CV_Face_LBPH, update_matches_train) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeGallery(images, labels, 24);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> full = cv::face::createLBPHFaceRecognizer();
+    full->train(images, labels);
+
+    cv::Ptr<cv::face::LBPHFaceRecognizer> incremental = cv::face::createLBPHFaceRecognizer();
+    incremental->setIndexLists(2);
+    std::vector<cv::Mat> first(images.begin(), images.begin() + 8), second(images.begin() + 8, images.end());
+    std::vector<int> firstLabels(labels.begin(), labels.begin() + 8), secondLabels(labels.begin() + 8, labels.end());
+    incremental->train(first, firstLabels);
+    incremental->update(second, secondLabels);
+    incremental->setIndexProbes(2);
+
+    std::vector<cv::Mat> h1 = full->getHistograms(), h2 = incremental->getHistograms();
+    ASSERT_EQ(h1.size(), h2.size());
+    for (size_t i = 0; i < h1.size(); i++)
+        EXPECT_EQ(0, cvtest::norm(h1[i], h2[i], cv::NORM_INF));
+    for (size_t i = 0; i < images.size(); i++)
+        EXPECT_EQ(labels[i], incremental->predict(images[i]));
+}
+
+// Enrolls one sample every fourth task and predicts the initial gallery
+// in the others.
+class UpdatePredictInvoker : public cv::ParallelLoopBody {
+public:
+    UpdatePredictInvoker(cv::face::LBPHFaceRecognizer& _model, const std::vector<cv::Mat>& _images,
+                         int _trained, std::vector<int>& _predicted) :
+        model(&_model), images(&_images), trained(_trained), predicted(&_predicted) {}
+
+    void operator()(const cv::Range& range) const {
+        for (int i = range.start; i < range.end; i++) {
+            if (i % 4 == 0) {
+                int sample = trained + i / 4;
+                model->update(std::vector<cv::Mat>(1, (*images)[sample]), std::vector<int>(1, sample));
+            } else {
+                (*predicted)[i] = model->predict((*images)[i % trained]);
+            }
+        }
+    }
+private:
+    cv::face::LBPHFaceRecognizer* model;
+    const std::vector<cv::Mat>* images;
+    int trained;
+    std::vector<int>* predicted;
+};
+
+TEST(CV_Face_LBPH, concurrent_update_and_predict) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    const int trained = 16, tasks = 64;
+    makeGallery(images, labels, trained + tasks / 4);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> model = cv::face::createLBPHFaceRecognizer();
+    model->train(std::vector<cv::Mat>(images.begin(), images.begin() + trained),
+                 std::vector<int>(labels.begin(), labels.begin() + trained));
+
+    std::vector<int> predicted(tasks, -1);
+    cv::parallel_for_(cv::Range(0, tasks), UpdatePredictInvoker(*model, images, trained, predicted), tasks);
+    for (int i = 0; i < tasks; i++) {
+        if (i % 4 != 0)
+            EXPECT_EQ(labels[i % trained], predicted[i]);
+    }
+
+    // every update was enrolled with histograms of the model parameters
+    std::vector<cv::Mat> histograms = model->getHistograms();
+    ASSERT_EQ(images.size(), histograms.size());
+    for (size_t i = 0; i < images.size(); i++)
+        EXPECT_EQ(labels[i], model->predict(images[i]));
+}
+
+TEST(CV_Face_LBPH, distances_match_compareHist) {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    makeGallery(images, labels, 12);
+    cv::Ptr<cv::face::LBPHFaceRecognizer> model = cv::face::createLBPHFaceRecognizer();
+    model->train(std::vector<cv::Mat>(images.begin(), images.begin() + 10),
+                 std::vector<int>(labels.begin(), labels.begin() + 10));
+    std::vector<cv::Mat> gallery = model->getHistograms();
+
+    for (size_t q = 9; q < images.size(); q++) {
+        // the query histogram is the one a model trained on the query alone holds
+        cv::Ptr<cv::face::LBPHFaceRecognizer> single = cv::face::createLBPHFaceRecognizer();
+        single->train(std::vector<cv::Mat>(1, images[q]), std::vector<int>(1, labels[q]));
+        cv::Mat query = single->getHistograms()[0];
+
+        cv::Ptr<cv::face::StandardCollector> collector = cv::face::StandardCollector::create();
+        model->predict(images[q], collector);
+        std::map<int, double> dists = collector->getResultsMap();
+        ASSERT_EQ(gallery.size(), dists.size());
+        for (size_t i = 0; i < gallery.size(); i++) {
+            double expected = cv::compareHist(gallery[i], query, cv::HISTCMP_CHISQR_ALT);
+            EXPECT_NEAR(expected, dists[labels[i]], 1e-12 * std::max(1., expected));
+        }
+    }
+}
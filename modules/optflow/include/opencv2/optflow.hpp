@@ -243,6 +243,16 @@ Relaxation factor in SOR
  */
 CV_EXPORTS_W Ptr<DenseOpticalFlow> createOptFlow_DeepFlow();
 
+/** @brief Creates an instance of DeepFlow for the consecutive frames of a video.
+
+The algorithm and its parameters are the ones of createOptFlow_DeepFlow(), and the flow of the first
+pair of frames is the same. When the first frame of a pair is the second frame of the previous pair,
+its pyramid is reused and the flow is initialized with the previous flow instead of zeros. The
+pyramids and the buffers of the refinement are kept between the calls, collectGarbage() releases
+them.
+ */
+CV_EXPORTS_W Ptr<DenseOpticalFlow> createOptFlow_DeepFlowVideo();
+
 //! Additional interface to the SimpleFlow algorithm - calcOpticalFlowSF()
 CV_EXPORTS_W Ptr<DenseOpticalFlow> createOptFlow_SimpleFlow();
 
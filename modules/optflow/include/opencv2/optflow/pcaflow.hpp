@@ -101,7 +101,6 @@ protected:
   const float occlusionsThreshold;
   const float dampingFactor;
   const float claheClip;
-  bool useOpenCL;
 
 public:
   /** @brief Creates an instance of PCAFlow algorithm.
@@ -118,21 +117,35 @@ public:
                       float _occlusionsThreshold = 0.0003, float _dampingFactor = 0.00002, float _claheClip = 14 );
 
   void calc( InputArray I0, InputArray I1, InputOutputArray flow );
+
+  /** @brief Calculates optical flows for a batch of frame pairs.
+   * The pairs are processed concurrently on the CPU, the result for each pair is the same as the one of calc() with
+   * Mat output. calc() only takes the OpenCL path for UMat output.
+   * @param I0 First frames of the pairs.
+   * @param I1 Second frames of the pairs, sizes must match the first frames.
+   * @param flows Output CV_32FC2 flows, one for each pair.
+   */
+  void calcBatch( InputArrayOfArrays I0, InputArrayOfArrays I1, OutputArrayOfArrays flows ) const;
+
   void collectGarbage();
 
 private:
-  void findSparseFeatures( UMat &from, UMat &to, std::vector<Point2f> &features,
+  Mat priorA[2];  //!< Constraints of the prior for both flow components, filled once on construction.
+  Mat priorAT[2]; //!< Transposed constraints of the prior.
+  Mat priorB[2];  //!< Right-hand sides of the prior constraints.
+
+  class ParallelCalcBatch;
+
+  void calcFlow( InputArray I0, InputArray I1, Mat &flow, bool useOpenCL ) const;
+
+  void findSparseFeatures( const UMat &from, InputArray fromPyr, InputArray toPyr, std::vector<Point2f> &features,
                            std::vector<Point2f> &predictedFeatures ) const;
 
-  void removeOcclusions( UMat &from, UMat &to, std::vector<Point2f> &features,
+  void removeOcclusions( InputArray fromPyr, InputArray toPyr, const Size size, std::vector<Point2f> &features,
                          std::vector<Point2f> &predictedFeatures ) const;
 
   void getSystem( OutputArray AOut, OutputArray b1Out, OutputArray b2Out, const std::vector<Point2f> &features,
-                  const std::vector<Point2f> &predictedFeatures, const Size size );
-
-  void getSystem( OutputArray A1Out, OutputArray A2Out, OutputArray b1Out, OutputArray b2Out,
-                  const std::vector<Point2f> &features, const std::vector<Point2f> &predictedFeatures,
-                  const Size size );
+                  const std::vector<Point2f> &predictedFeatures, const Size size, bool useOpenCL ) const;
 
   OpticalFlowPCAFlow& operator=( const OpticalFlowPCAFlow& ); // make it non-assignable
 };
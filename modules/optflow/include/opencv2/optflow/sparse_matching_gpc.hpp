@@ -127,18 +127,20 @@ struct GPCTrainingParams
   int minNumberOfSamples; //!< Minimum number of samples in the node to stop partitioning.
   int descriptorType;     //!< Type of descriptors to use.
   bool printProgress;     //!< Print progress to stdout.
+  int maxConcurrentTrees; //!< Maximum number of forest trees trained at once, every one of them keeps its own sample set in memory.
+                          //!< Non-positive value means the number of threads. Set to 1 for the lowest memory usage.
 
   GPCTrainingParams( unsigned _maxTreeDepth = 20, int _minNumberOfSamples = 3, GPCDescType _descriptorType = GPC_DESCRIPTOR_DCT,
-                     bool _printProgress = true )
+                     bool _printProgress = true, int _maxConcurrentTrees = 0 )
       : maxTreeDepth( _maxTreeDepth ), minNumberOfSamples( _minNumberOfSamples ), descriptorType( _descriptorType ),
-        printProgress( _printProgress )
+        printProgress( _printProgress ), maxConcurrentTrees( _maxConcurrentTrees )
   {
     CV_Assert( check() );
   }
 
   GPCTrainingParams( const GPCTrainingParams &params )
       : maxTreeDepth( params.maxTreeDepth ), minNumberOfSamples( params.minNumberOfSamples ), descriptorType( params.descriptorType ),
-        printProgress( params.printProgress )
+        printProgress( params.printProgress ), maxConcurrentTrees( params.maxConcurrentTrees )
   {
     CV_Assert( check() );
   }
@@ -175,18 +177,35 @@ public:
 private:
   typedef GPCSamplesVector::iterator SIter;
 
-  std::vector< Node > nodes;
+  std::vector< Node > nodes; //!< Nodes in depth-first order, the left child of a node immediately follows it.
   GPCTrainingParams params;
 
-  bool trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth );
+  unsigned trainNode( SIter begin, SIter end, unsigned depth, RNG &rng );
 
 public:
+  /** @brief Train the tree. Samples are reordered and modified during the training.
+   * The random number generator is seeded from cv::theRNG().
+   */
   void train( GPCTrainingSamples &samples, const GPCTrainingParams params = GPCTrainingParams() );
 
+  /** @brief Train the tree using the given seed for the random number generator.
+   * The resulting tree depends only on the samples, the parameters and the seed.
+   */
+  void train( GPCTrainingSamples &samples, const GPCTrainingParams params, uint64 seed );
+
   void write( FileStorage &fs ) const;
 
   void read( const FileNode &fn );
 
+  /** @brief Store the tree to a binary stream. Much faster to load than FileStorage,
+   * but the format depends on the byte order of the platform.
+   */
+  void writeBinary( std::ostream &os ) const;
+
+  /** @brief Load the tree stored with writeBinary.
+   */
+  void readBinary( std::istream &is );
+
   unsigned findLeafForPatch( const GPCPatchDescriptor &descr ) const;
 
   static Ptr< GPCTree > create() { return makePtr< GPCTree >(); }
@@ -236,16 +255,93 @@ private:
     }
   };
 
+  class ParallelTreesTraining : public ParallelLoopBody
+  {
+  private:
+    GPCForest *forest;
+    GPCTrainingSamples *const *samples;
+    bool shared;
+    const uint64 *seeds;
+    const GPCTrainingParams *params;
+
+    ParallelTreesTraining &operator=( const ParallelTreesTraining & );
+
+  public:
+    ParallelTreesTraining( GPCForest *_forest, GPCTrainingSamples *const *_samples, bool _shared, const uint64 *_seeds,
+                           const GPCTrainingParams *_params )
+        : forest( _forest ), samples( _samples ), shared( _shared ), seeds( _seeds ), params( _params ){};
+
+    void operator()( const Range &range ) const
+    {
+      for ( int t = range.start; t < range.end; ++t )
+      {
+        if ( shared )
+        { // Training reorders and modifies the samples, so every tree gets its own copy of a shared set.
+          GPCTrainingSamples trainingSet( *samples[t] );
+          forest->tree[t].train( trainingSet, *params, seeds[t] );
+        }
+        else
+          forest->tree[t].train( *samples[t], *params, seeds[t] );
+      }
+    }
+  };
+
   GPCTree tree[T];
 
+  /* Seeds are drawn from cv::theRNG() before the training, so the forest does not depend on the number of threads. */
+  static void drawSeeds( uint64 *seeds )
+  {
+    for ( int i = 0; i < T; ++i )
+      seeds[i] = theRNG().next();
+  }
+
+  /* Trees are trained concurrently in groups of this size, it bounds the number of sample sets in memory. */
+  static int concurrentTrees( const GPCTrainingParams &params )
+  {
+    const int n = params.maxConcurrentTrees > 0 ? params.maxConcurrentTrees : getNumThreads();
+    return std::max( 1, std::min( n, T ) );
+  }
+
+  void trainTrees( const Range &range, GPCTrainingSamples *const *samples, bool shared, const uint64 *seeds,
+                   const GPCTrainingParams &params )
+  {
+    parallel_for_( range, ParallelTreesTraining( this, samples, shared, seeds, &params ) );
+  }
+
+  template < typename ImagesArray >
+  void trainOnImages( const ImagesArray &imagesFrom, const ImagesArray &imagesTo, const ImagesArray &gt, const GPCTrainingParams &params )
+  {
+    uint64 seeds[T];
+    drawSeeds( seeds );
+    const int group = concurrentTrees( params );
+    for ( int begin = 0; begin < T; begin += group )
+    {
+      const int end = std::min( begin + group, T );
+      Ptr< GPCTrainingSamples > samples[T];
+      GPCTrainingSamples *trainingSets[T];
+      for ( int i = begin; i < end; ++i )
+      {
+        samples[i] = GPCTrainingSamples::create( imagesFrom, imagesTo, gt, params.descriptorType ); // Create training set for the tree
+        trainingSets[i] = samples[i];
+      }
+      trainTrees( Range( begin, end ), trainingSets, false, seeds, params );
+    }
+  }
+
 public:
   /** @brief Train the forest using one sample set for every tree.
    * Please, consider using the next method instead of this one for better quality.
    */
   void train( GPCTrainingSamples &samples, const GPCTrainingParams params = GPCTrainingParams() )
   {
+    uint64 seeds[T];
+    drawSeeds( seeds );
+    GPCTrainingSamples *trainingSets[T];
     for ( int i = 0; i < T; ++i )
-      tree[i].train( samples, params );
+      trainingSets[i] = &samples;
+    const int group = concurrentTrees( params );
+    for ( int begin = 0; begin < T; begin += group )
+      trainTrees( Range( begin, std::min( begin + group, T ) ), trainingSets, true, seeds, params );
   }
 
   /** @brief Train the forest using individual samples for each tree.
@@ -254,23 +350,13 @@ public:
   void train( const std::vector< String > &imagesFrom, const std::vector< String > &imagesTo, const std::vector< String > &gt,
               const GPCTrainingParams params = GPCTrainingParams() )
   {
-    for ( int i = 0; i < T; ++i )
-    {
-      Ptr< GPCTrainingSamples > samples =
-        GPCTrainingSamples::create( imagesFrom, imagesTo, gt, params.descriptorType ); // Create training set for the tree
-      tree[i].train( *samples, params );
-    }
+    trainOnImages( imagesFrom, imagesTo, gt, params );
   }
 
   void train( InputArrayOfArrays imagesFrom, InputArrayOfArrays imagesTo, InputArrayOfArrays gt,
               const GPCTrainingParams params = GPCTrainingParams() )
   {
-    for ( int i = 0; i < T; ++i )
-    {
-      Ptr< GPCTrainingSamples > samples =
-        GPCTrainingSamples::create( imagesFrom, imagesTo, gt, params.descriptorType ); // Create training set for the tree
-      tree[i].train( *samples, params );
-    }
+    trainOnImages( imagesFrom, imagesTo, gt, params );
   }
 
   void write( FileStorage &fs ) const
@@ -294,6 +380,15 @@ public:
       tree[i].read( *it );
   }
 
+  /** @brief Store the forest to a binary file.
+   * Loading it with loadBinary is much faster than reading the FileStorage representation.
+   */
+  void saveBinary( const String &filename ) const;
+
+  /** @brief Load the forest stored with saveBinary. The file must contain at least T trees.
+   */
+  void loadBinary( const String &filename );
+
   /** @brief Find correspondences between two images.
    * @param[in] imgFrom First image in a sequence.
    * @param[in] imgTo Second image in a sequence.
@@ -315,8 +410,22 @@ public:
                                          int type );
 
   static void getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y );
+
+  static void saveTreesBinary( const String &filename, const GPCTree *trees, int nTrees );
+
+  static void loadTreesBinary( const String &filename, GPCTree *trees, int nTrees );
 };
 
+template < int T > void GPCForest< T >::saveBinary( const String &filename ) const
+{
+  GPCDetails::saveTreesBinary( filename, tree, T );
+}
+
+template < int T > void GPCForest< T >::loadBinary( const String &filename )
+{
+  GPCDetails::loadTreesBinary( filename, tree, T );
+}
+
 template < int T >
 void GPCForest< T >::findCorrespondences( InputArray imgFrom, InputArray imgTo, std::vector< std::pair< Point2i, Point2i > > &corr,
                                           const GPCMatchingParams params ) const
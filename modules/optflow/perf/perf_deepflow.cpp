@@ -67,3 +67,28 @@ PERF_TEST_P(DenseOpticalFlow_DeepFlow, perf, Values(szVGA, sz720p))
 
     SANITY_CHECK_NOTHING();
 }
+
+PERF_TEST_P(DenseOpticalFlow_DeepFlow, video, Values(szVGA, sz720p))
+{
+    DFParams params = GetParam();
+    Size sz = get<0>(params);
+
+    // a few frames of a translated texture
+    Mat texture(sz.height + 8, sz.width + 8, CV_8U);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 0);
+    std::vector<Mat> frames(4);
+    for (int i = 0; i < (int)frames.size(); i++)
+        frames[i] = texture(Rect(2 * i, i, sz.width, sz.height)).clone();
+    Mat flow;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    TEST_CYCLE_N(1)
+    {
+        Ptr<DenseOpticalFlow> algo = createOptFlow_DeepFlowVideo();
+        for (int i = 1; i < (int)frames.size(); i++)
+            algo->calc(frames[i - 1], frames[i], flow);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
@@ -0,0 +1,100 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#include "perf_precomp.hpp"
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::optflow;
+
+typedef tuple<Size> GPCParams;
+typedef TestBaseWithParam<GPCParams> GlobalPatchCollider;
+
+// two frames of a translated texture, the ground truth flow is constant
+static void makeTranslatedFrames(Size sz, std::vector<Mat> &from, std::vector<Mat> &to, std::vector<Mat> &gt)
+{
+    Mat texture(sz.height + 1, sz.width + 2, CV_8UC3);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 0);
+    from.push_back(texture(Rect(0, 0, sz.width, sz.height)).clone());
+    to.push_back(texture(Rect(2, 1, sz.width, sz.height)).clone());
+    gt.push_back(Mat(sz, CV_32FC2, Scalar(-2, -1)));
+}
+
+PERF_TEST_P(GlobalPatchCollider, train, Values(szQVGA, szVGA))
+{
+    GPCParams params = GetParam();
+    Size sz = get<0>(params);
+
+    std::vector<Mat> from, to, gt;
+    makeTranslatedFrames(sz, from, to, gt);
+    Ptr<GPCTrainingSamples> samples = GPCTrainingSamples::create(from, to, gt, GPC_DESCRIPTOR_WHT);
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    declare.tbb_threads(cv::getNumberOfCPUs());
+    TEST_CYCLE_N(1)
+    {
+        Ptr< GPCForest<5> > forest = GPCForest<5>::create();
+        forest->train(*samples, GPCTrainingParams(12, 3, GPC_DESCRIPTOR_WHT, false));
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(GlobalPatchCollider, loadBinary, Values(szVGA))
+{
+    GPCParams params = GetParam();
+    Size sz = get<0>(params);
+
+    std::vector<Mat> from, to, gt;
+    makeTranslatedFrames(sz, from, to, gt);
+    Ptr< GPCForest<5> > forest = GPCForest<5>::create();
+    forest->train(from, to, gt, GPCTrainingParams(12, 3, GPC_DESCRIPTOR_WHT, false));
+    const String filename = cv::tempfile(".bin");
+    forest->saveBinary(filename);
+
+    Ptr< GPCForest<5> > loaded = GPCForest<5>::create();
+    TEST_CYCLE_N(10)
+    {
+        loaded->loadBinary(filename);
+    }
+    remove(filename.c_str());
+
+    SANITY_CHECK_NOTHING();
+}
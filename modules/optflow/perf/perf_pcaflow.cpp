@@ -0,0 +1,97 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#include "perf_precomp.hpp"
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::optflow;
+
+typedef tuple<Size> PCAFlowParams;
+typedef TestBaseWithParam<PCAFlowParams> DenseOpticalFlow_PCAFlow;
+
+PERF_TEST_P(DenseOpticalFlow_PCAFlow, perf, Values(szVGA, sz720p))
+{
+    PCAFlowParams params = GetParam();
+    Size sz = get<0>(params);
+
+    // a translated texture
+    Mat texture(sz.height + 1, sz.width + 2, CV_8U);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 0);
+    Mat frame1 = texture(Rect(0, 0, sz.width, sz.height)).clone();
+    Mat frame2 = texture(Rect(2, 1, sz.width, sz.height)).clone();
+    Mat flow;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    Ptr<DenseOpticalFlow> algo = createOptFlow_PCAFlow();
+    TEST_CYCLE_N(10)
+    {
+        algo->calc(frame1, frame2, flow);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(DenseOpticalFlow_PCAFlow, batch, Values(szVGA, sz720p))
+{
+    PCAFlowParams params = GetParam();
+    Size sz = get<0>(params);
+
+    // consecutive frames of a translated texture
+    Mat texture(sz.height + 16, sz.width + 32, CV_8U);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 0);
+    std::vector<Mat> from, to, flows;
+    for (int i = 0; i < 16; i++)
+    {
+        from.push_back(texture(Rect(2 * i, i, sz.width, sz.height)).clone());
+        to.push_back(texture(Rect(2 * i + 2, i + 1, sz.width, sz.height)).clone());
+    }
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    declare.tbb_threads(cv::getNumberOfCPUs());
+    OpticalFlowPCAFlow algo;
+    TEST_CYCLE_N(3)
+    {
+        algo.calcBatch(from, to, flows);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
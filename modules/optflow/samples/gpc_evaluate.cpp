@@ -24,7 +24,7 @@ const String keys = "{help h ?     |             | print this message}"
                     "{@groundtruth |<none>       | path to the .flo file}"
                     "{@output      |             | output to a file instead of displaying, output image path}"
                     "{g gpu        |             | use OpenCL}"
-                    "{f forest     |forest.yml.gz| path to the forest.yml.gz}";
+                    "{f forest     |forest.yml.gz| path to the forest.yml.gz, or to a binary forest with .bin extension}";
 
 const int nTrees = 5;
 
@@ -97,7 +97,14 @@ int main( int argc, const char **argv )
 
   ocl::setUseOpenCL( useOpenCL );
 
-  Ptr< optflow::GPCForest< nTrees > > forest = Algorithm::load< optflow::GPCForest< nTrees > >( forestDumpPath );
+  Ptr< optflow::GPCForest< nTrees > > forest;
+  if ( forestDumpPath.size() > 4 && forestDumpPath.substr( forestDumpPath.size() - 4 ) == ".bin" )
+  {
+    forest = optflow::GPCForest< nTrees >::create();
+    forest->loadBinary( forestDumpPath );
+  }
+  else
+    forest = Algorithm::load< optflow::GPCForest< nTrees > >( forestDumpPath );
 
   Mat from = imread( fromPath );
   Mat to = imread( toPath );
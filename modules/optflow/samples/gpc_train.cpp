@@ -11,7 +11,7 @@ const String keys = "{help h ?       |             | print this message}"
                     "{min-samples    |             | Minimum number of samples in the node to stop partitioning}"
                     "{descriptor-type|0            | Descriptor type. Set to 0 for quality, 1 for speed.}"
                     "{print-progress |             | Set to 0 to enable quiet mode, set to 1 to print progress}"
-                    "{f forest       |forest.yml.gz| Path where to store resulting forest. It is recommended to use .yml.gz extension.}";
+                    "{f forest       |forest.yml.gz| Path where to store resulting forest. It is recommended to use .yml.gz extension, or .bin for a faster loading binary format.}";
 
 const int nTrees = 5;
 
@@ -60,7 +60,11 @@ int main( int argc, const char **argv )
 
   Ptr< optflow::GPCForest< nTrees > > forest = optflow::GPCForest< nTrees >::create();
   forest->train( img1, img2, gt, params );
-  forest->save( parser.get< String >( "forest" ) );
+  const String forestPath = parser.get< String >( "forest" );
+  if ( forestPath.size() > 4 && forestPath.substr( forestPath.size() - 4 ) == ".bin" )
+    forest->saveBinary( forestPath );
+  else
+    forest->save( forestPath );
 
   return 0;
 }
@@ -51,7 +51,7 @@ namespace optflow
 class OpticalFlowDeepFlow: public DenseOpticalFlow
 {
 public:
-    OpticalFlowDeepFlow();
+    OpticalFlowDeepFlow( bool _videoMode = false );
 
     void calc( InputArray I0, InputArray I1, InputOutputArray flow );
     void collectGarbage();
@@ -70,12 +70,22 @@ protected:
     int maxLayers; // max amount of layers in the pyramid
     int interpolationType;
 
+    bool videoMode; // consecutive calls are given consecutive frame pairs
+
 private:
-    std::vector<Mat> buildPyramid( const Mat& src );
+    void buildPyramid( const Mat& src, std::vector<Mat>& pyramid );
+
+    // the refinement of each level, its buffers are kept between calls
+    std::vector<Ptr<VariationalRefinement> > refinements;
 
+    // video mode: the pyramids of the two last frames, the last frame and flow
+    std::vector<Mat> pyramids[2];
+    int lastPyramid;
+    Mat lastFrame;
+    Mat lastFlow;
 };
 
-OpticalFlowDeepFlow::OpticalFlowDeepFlow()
+OpticalFlowDeepFlow::OpticalFlowDeepFlow( bool _videoMode )
 {
     // parameters
     sigma = 0.6f;
@@ -91,28 +101,35 @@ OpticalFlowDeepFlow::OpticalFlowDeepFlow()
     //consts
     interpolationType = INTER_LINEAR;
     maxLayers = 200;
+
+    videoMode = _videoMode;
+    lastPyramid = 0;
 }
 
-std::vector<Mat> OpticalFlowDeepFlow::buildPyramid( const Mat& src )
+// converts, pre-smoothes and downsizes an image, the buffers of the pyramid are reused
+void OpticalFlowDeepFlow::buildPyramid( const Mat& src, std::vector<Mat>& pyramid )
 {
-    std::vector<Mat> pyramid;
-    pyramid.push_back(src);
-    Mat prev = pyramid[0];
-    int i = 0;
-    while ( i < this->maxLayers )
+    int kernelLen = ((int)floor(3 * sigma) * 2) + 1;
+    Size kernelSize(kernelLen, kernelLen);
+
+    pyramid.resize(1);
+    src.convertTo(pyramid[0], CV_32F);
+    GaussianBlur(pyramid[0], pyramid[0], kernelSize, sigma);
+
+    size_t i = 0;
+    while ( (int)i < this->maxLayers )
     {
-        Mat next; //TODO: filtering at each level?
-        Size nextSize((int) (prev.cols * downscaleFactor + 0.5f),
-                        (int) (prev.rows * downscaleFactor + 0.5f));
+        //TODO: filtering at each level?
+        Size nextSize((int) (pyramid[i].cols * downscaleFactor + 0.5f),
+                        (int) (pyramid[i].rows * downscaleFactor + 0.5f));
         if( nextSize.height <= minSize || nextSize.width <= minSize)
             break;
-        resize(prev, next,
+        pyramid.resize(i + 2);
+        resize(pyramid[i], pyramid[i + 1],
                 nextSize, 0, 0,
                 interpolationType);
-        pyramid.push_back(next);
-        prev = next;
+        ++i;
     }
-    return pyramid;
 }
 
 void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray _flow )
@@ -125,31 +142,40 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
     CV_Assert(I0temp.channels() == 1);
     // TODO: currently only grayscale - data term could be computed in color version as well...
 
-    Mat I0, I1;
-
-    I0temp.convertTo(I0, CV_32F);
-    I1temp.convertTo(I1, CV_32F);
-
-    _flow.create(I0.size(), CV_32FC2);
+    _flow.create(I0temp.size(), CV_32FC2);
     Mat W = _flow.getMat(); // if any data present - will be discarded
 
-    // pre-smooth images
-    int kernelLen = ((int)floor(3 * sigma) * 2) + 1;
-    Size kernelSize(kernelLen, kernelLen);
-    GaussianBlur(I0, I0, kernelSize, sigma);
-    GaussianBlur(I1, I1, kernelSize, sigma);
-    // build down-sized pyramids
-    std::vector<Mat> pyramid_I0 = buildPyramid(I0);
-    std::vector<Mat> pyramid_I1 = buildPyramid(I1);
+    // in video mode, the first frame is usually the second one of the last call
+    bool consecutive = videoMode && !lastFrame.empty() &&
+            lastFrame.size() == I0temp.size() && lastFrame.type() == I0temp.type() &&
+            norm(I0temp, lastFrame, NORM_INF) == 0;
+
+    // build down-sized pyramids of the pre-smoothed images
+    std::vector<Mat> localPyramids[2];
+    std::vector<Mat>& pyramid_I0 = videoMode ? pyramids[lastPyramid] : localPyramids[0];
+    std::vector<Mat>& pyramid_I1 = videoMode ? pyramids[1 - lastPyramid] : localPyramids[1];
+    if( !consecutive )
+        buildPyramid(I0temp, pyramid_I0);
+    buildPyramid(I1temp, pyramid_I1);
     int levelCount = (int) pyramid_I0.size();
 
-    // initialize the first version of flow estimate to zeros
+    // initialize the first version of flow estimate to zeros, or to the last flow
     Size smallestSize = pyramid_I0[levelCount - 1].size();
-    W = Mat::zeros(smallestSize, CV_32FC2);
+    if( consecutive && lastFlow.size() == I0temp.size() )
+    {
+        resize(lastFlow, W, smallestSize, 0, 0, interpolationType);
+        W *= std::pow(downscaleFactor, (float)(levelCount - 1));
+    }
+    else
+        W = Mat::zeros(smallestSize, CV_32FC2);
 
+    if( (int)refinements.size() < levelCount )
+        refinements.resize(levelCount);
     for ( int level = levelCount - 1; level >= 0; --level )
     { //iterate through  all levels, beginning with the most coarse
-        Ptr<VariationalRefinement> var = createVariationalFlowRefinement();
+        Ptr<VariationalRefinement>& var = refinements[level];
+        if( var.empty() )
+            var = createVariationalFlowRefinement();
 
         var->setAlpha(4 * alpha);
         var->setDelta(delta / 3);
@@ -168,11 +194,27 @@ void OpticalFlowDeepFlow::calc( InputArray _I0, InputArray _I1, InputOutputArray
         }
     }
     W.copyTo(_flow);
+
+    if( videoMode )
+    {
+        lastPyramid = 1 - lastPyramid;
+        I1temp.copyTo(lastFrame);
+        W.copyTo(lastFlow);
+    }
 }
 
-void OpticalFlowDeepFlow::collectGarbage() {}
+void OpticalFlowDeepFlow::collectGarbage()
+{
+    refinements.clear();
+    pyramids[0].clear();
+    pyramids[1].clear();
+    lastFrame.release();
+    lastFlow.release();
+}
 
 Ptr<DenseOpticalFlow> createOptFlow_DeepFlow() { return makePtr<OpticalFlowDeepFlow>(); }
 
+Ptr<DenseOpticalFlow> createOptFlow_DeepFlowVideo() { return makePtr<OpticalFlowDeepFlow>(true); }
+
 }//optflow
 }//cv
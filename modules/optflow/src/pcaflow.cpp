@@ -116,30 +116,42 @@ inline void symOrtho( double a, double b, double &c, double &s, double &r )
  * Solves the following problem:
  *   argmin_x ||Ax - b|| + damp||x||
  *
+ * The matrix may have the second block of rows C with the right-hand side d, i.e. the system is [A; C]x = [b; d].
+ * The blocks are never stacked, so the constant block of the prior is not copied on every call.
+ * AT and CT are the transposed blocks, C may be empty.
+ *
  * Output:
  *   x -- approximate solution
  */
-void solveLSQR( const Mat &A, const Mat &b, OutputArray xOut, const double damp = 0.0, const unsigned iter_lim = 10 )
+void solveLSQR( const Mat &A, const Mat &AT, const Mat &b, const Mat &C, const Mat &CT, const Mat &d, OutputArray xOut,
+                const double damp = 0.0, const unsigned iter_lim = 10 )
 {
   const int n = A.size().width;
+  const bool hasC = !C.empty();
   CV_Assert( A.size().height == b.size().height );
   CV_Assert( A.type() == CV_32F );
   CV_Assert( b.type() == CV_32F );
+  CV_Assert( !hasC || ( C.size().width == n && C.size().height == d.size().height ) );
   xOut.create( n, 1, CV_32F );
 
   Mat v( n, 1, CV_32F, 0.0f );
-  Mat u = b;
+  Mat u = b.clone();
+  Mat uc = hasC ? d.clone() : Mat();
   Mat x = xOut.getMat();
   x = Mat::zeros( x.size(), x.type() );
   double alfa = 0;
-  double beta = cv::norm( u, NORM_L2 );
+  double beta = hasC ? std::sqrt( cv::norm( u, NORM_L2SQR ) + cv::norm( uc, NORM_L2SQR ) ) : cv::norm( u, NORM_L2 );
   Mat w( n, 1, CV_32F, 0.0f );
-  const Mat AT = A.t();
 
   if ( beta > 0 )
   {
     u *= 1 / beta;
     v = AT * u;
+    if ( hasC )
+    {
+      uc *= 1 / beta;
+      v += CT * uc;
+    }
     alfa = cv::norm( v, NORM_L2 );
   }
 
@@ -158,13 +170,25 @@ void solveLSQR( const Mat &A, const Mat &b, OutputArray xOut, const double damp
   {
     u *= -alfa;
     u += A * v;
-    beta = cv::norm( u, NORM_L2 );
+    if ( hasC )
+    {
+      uc *= -alfa;
+      uc += C * v;
+      beta = std::sqrt( cv::norm( u, NORM_L2SQR ) + cv::norm( uc, NORM_L2SQR ) );
+    }
+    else
+      beta = cv::norm( u, NORM_L2 );
 
     if ( beta > 0 )
     {
       u *= 1 / beta;
       v *= -beta;
       v += AT * u;
+      if ( hasC )
+      {
+        uc *= 1 / beta;
+        v += CT * uc;
+      }
       alfa = cv::norm( v, NORM_L2 );
       if ( alfa > 0 )
         v *= 1 / alfa;
@@ -191,14 +215,69 @@ void solveLSQR( const Mat &A, const Mat &b, OutputArray xOut, const double damp
   }
 }
 
-inline void _cpu_fillDCTSampledPoints( float *row, const Point2f &p, const Size &basisSize, const Size &size )
+/* Solves the systems for both flow components concurrently. */
+class ParallelLSQR : public ParallelLoopBody
 {
+private:
+  const Mat &A;
+  const Mat &AT;
+  const Mat *b;
+  const Mat *C;
+  const Mat *CT;
+  const Mat *d;
+  Mat *x;
+  double damp;
+
+  ParallelLSQR &operator=( const ParallelLSQR & );
+
+public:
+  ParallelLSQR( const Mat &_A, const Mat &_AT, const Mat *_b, const Mat *_C, const Mat *_CT, const Mat *_d, Mat *_x,
+                double _damp )
+      : A( _A ), AT( _AT ), b( _b ), C( _C ), CT( _CT ), d( _d ), x( _x ), damp( _damp ){};
+
+  void operator()( const Range &range ) const
+  {
+    for ( int i = range.start; i < range.end; ++i )
+      solveLSQR( A, AT, b[i], C[i], CT[i], d[i], x[i], damp );
+  }
+};
+
+/* The basis is separable, so only basisSize.width + basisSize.height cosines are computed for a point.
+ * cosY is a buffer for basisSize.height values. */
+inline void _cpu_fillDCTSampledPoints( float *row, const Point2f &p, const Size &basisSize, const Size &size, float *cosY )
+{
+  for ( int n2 = 0; n2 < basisSize.height; ++n2 )
+    cosY[n2] = cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
   for ( int n1 = 0; n1 < basisSize.width; ++n1 )
+  {
+    const float cosX = cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) );
     for ( int n2 = 0; n2 < basisSize.height; ++n2 )
-      row[n1 * basisSize.height + n2] =
-        cosf( ( n1 * CV_PI / size.width ) * ( p.x + 0.5 ) ) * cosf( ( n2 * CV_PI / size.height ) * ( p.y + 0.5 ) );
+      row[n1 * basisSize.height + n2] = cosX * cosY[n2];
+  }
 }
 
+class ParallelDCTSampledPointsFiller : public ParallelLoopBody
+{
+private:
+  const std::vector<Point2f> &features;
+  const Size basisSize;
+  const Size size;
+  Mat &A;
+
+  ParallelDCTSampledPointsFiller &operator=( const ParallelDCTSampledPointsFiller & );
+
+public:
+  ParallelDCTSampledPointsFiller( const std::vector<Point2f> &_features, const Size &_basisSize, const Size &_size, Mat &_A )
+      : features( _features ), basisSize( _basisSize ), size( _size ), A( _A ){};
+
+  void operator()( const Range &range ) const
+  {
+    AutoBuffer<float> cosY( basisSize.height );
+    for ( int i = range.start; i < range.end; ++i )
+      _cpu_fillDCTSampledPoints( A.ptr<float>( i ), features[i], basisSize, size, cosY );
+  }
+};
+
 ocl::ProgramSource _ocl_fillDCTSampledPointsSource(
   "__kernel void fillDCTSampledPoints(__global const uchar* features, int fstep, int foff, __global "
   "uchar* A, int Astep, int Aoff, int fs, int bsw, int bsh, int sw, int sh) {"
@@ -220,6 +299,27 @@ void applyCLAHE( UMat &img, float claheClip )
   clahe->apply( img, img );
 }
 
+// Disables OpenCL for the current thread while the CPU path runs, the UMat operations
+// would otherwise follow the OpenCL flag of the thread they run on
+class OpenCLDisabler
+{
+private:
+  const bool wasUsed;
+
+public:
+  OpenCLDisabler( bool disable ) : wasUsed( disable && ocl::useOpenCL() )
+  {
+    if ( wasUsed )
+      ocl::setUseOpenCL( false );
+  }
+
+  ~OpenCLDisabler()
+  {
+    if ( wasUsed )
+      ocl::setUseOpenCL( true );
+  }
+};
+
 void reduceToFlow( const Mat &w1, const Mat &w2, Mat &flow, const Size &basisSize )
 {
   const Size size = flow.size();
@@ -253,8 +353,8 @@ void reduceToFlow( const Mat &w1, const Mat &w2, Mat &flow, const Size &basisSiz
 }
 }
 
-void OpticalFlowPCAFlow::findSparseFeatures( UMat &from, UMat &to, std::vector<Point2f> &features,
-                                             std::vector<Point2f> &predictedFeatures ) const
+void OpticalFlowPCAFlow::findSparseFeatures( const UMat &from, InputArray fromPyr, InputArray toPyr,
+                                             std::vector<Point2f> &features, std::vector<Point2f> &predictedFeatures ) const
 {
   Size size = from.size();
   const unsigned maxFeatures = size.area() * sparseRate;
@@ -271,7 +371,7 @@ void OpticalFlowPCAFlow::findSparseFeatures( UMat &from, UMat &to, std::vector<P
   }
   std::vector<uchar> predictedStatus;
   std::vector<float> predictedError;
-  calcOpticalFlowPyrLK( from, to, features, predictedFeatures, predictedStatus, predictedError );
+  calcOpticalFlowPyrLK( fromPyr, toPyr, features, predictedFeatures, predictedStatus, predictedError );
 
   size_t j = 0;
   for ( size_t i = 0; i < features.size(); ++i )
@@ -287,16 +387,16 @@ void OpticalFlowPCAFlow::findSparseFeatures( UMat &from, UMat &to, std::vector<P
   predictedFeatures.resize( j );
 }
 
-void OpticalFlowPCAFlow::removeOcclusions( UMat &from, UMat &to, std::vector<Point2f> &features,
-                                           std::vector<Point2f> &predictedFeatures ) const
+void OpticalFlowPCAFlow::removeOcclusions( InputArray fromPyr, InputArray toPyr, const Size size,
+                                           std::vector<Point2f> &features, std::vector<Point2f> &predictedFeatures ) const
 {
   std::vector<uchar> predictedStatus;
   std::vector<float> predictedError;
   std::vector<Point2f> backwardFeatures;
-  calcOpticalFlowPyrLK( to, from, predictedFeatures, backwardFeatures, predictedStatus, predictedError );
+  calcOpticalFlowPyrLK( toPyr, fromPyr, predictedFeatures, backwardFeatures, predictedStatus, predictedError );
 
   size_t j = 0;
-  const float threshold = occlusionsThreshold * sqrt( static_cast<float>(from.size().area()) );
+  const float threshold = occlusionsThreshold * sqrt( static_cast<float>(size.area()) );
   for ( size_t i = 0; i < predictedFeatures.size(); ++i )
   {
     if ( predictedStatus[i] )
@@ -316,7 +416,7 @@ void OpticalFlowPCAFlow::removeOcclusions( UMat &from, UMat &to, std::vector<Poi
 
 void OpticalFlowPCAFlow::getSystem( OutputArray AOut, OutputArray b1Out, OutputArray b2Out,
                                     const std::vector<Point2f> &features, const std::vector<Point2f> &predictedFeatures,
-                                    const Size size )
+                                    const Size size, bool useOpenCL ) const
 {
   AOut.create( features.size(), basisSize.area(), CV_32F );
   b1Out.create( features.size(), 1, CV_32F );
@@ -324,8 +424,6 @@ void OpticalFlowPCAFlow::getSystem( OutputArray AOut, OutputArray b1Out, OutputA
   if ( useOpenCL )
   {
     UMat A = AOut.getUMat();
-    Mat b1 = b1Out.getMat();
-    Mat b2 = b2Out.getMat();
 
     ocl::Kernel kernel( "fillDCTSampledPoints", _ocl_fillDCTSampledPointsSource );
     size_t globSize[] = {features.size(), basisSize.width, basisSize.height};
@@ -334,85 +432,21 @@ void OpticalFlowPCAFlow::getSystem( OutputArray AOut, OutputArray b1Out, OutputA
              cv::ocl::KernelArg::WriteOnlyNoSize( A ), (int)features.size(), (int)basisSize.width,
              (int)basisSize.height, (int)size.width, (int)size.height )
       .run( 3, globSize, 0, true );
-
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
   }
   else
   {
     Mat A = AOut.getMat();
-    Mat b1 = b1Out.getMat();
-    Mat b2 = b2Out.getMat();
-
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      _cpu_fillDCTSampledPoints( A.ptr<float>( i ), features[i], basisSize, size );
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
+    parallel_for_( Range( 0, (int)features.size() ), ParallelDCTSampledPointsFiller( features, basisSize, size, A ) );
   }
-}
-
-void OpticalFlowPCAFlow::getSystem( OutputArray A1Out, OutputArray A2Out, OutputArray b1Out, OutputArray b2Out,
-                                    const std::vector<Point2f> &features, const std::vector<Point2f> &predictedFeatures,
-                                    const Size size )
-{
-  CV_Assert( prior->getBasisSize() == basisSize.area() );
-
-  A1Out.create( features.size() + prior->getPadding(), basisSize.area(), CV_32F );
-  A2Out.create( features.size() + prior->getPadding(), basisSize.area(), CV_32F );
-  b1Out.create( features.size() + prior->getPadding(), 1, CV_32F );
-  b2Out.create( features.size() + prior->getPadding(), 1, CV_32F );
-
-  if ( useOpenCL )
-  {
-    UMat A = A1Out.getUMat();
-    Mat b1 = b1Out.getMat();
-    Mat b2 = b2Out.getMat();
-
-    ocl::Kernel kernel( "fillDCTSampledPoints", _ocl_fillDCTSampledPointsSource );
-    size_t globSize[] = {features.size(), basisSize.width, basisSize.height};
-    kernel
-      .args( cv::ocl::KernelArg::ReadOnlyNoSize( Mat( features ).getUMat( ACCESS_READ ) ),
-             cv::ocl::KernelArg::WriteOnlyNoSize( A ), (int)features.size(), (int)basisSize.width,
-             (int)basisSize.height, (int)size.width, (int)size.height )
-      .run( 3, globSize, 0, true );
 
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
-  }
-  else
-  {
-    Mat A1 = A1Out.getMat();
-    Mat b1 = b1Out.getMat();
-    Mat b2 = b2Out.getMat();
-
-    for ( size_t i = 0; i < features.size(); ++i )
-    {
-      _cpu_fillDCTSampledPoints( A1.ptr<float>( i ), features[i], basisSize, size );
-      const Point2f flow = predictedFeatures[i] - features[i];
-      b1.at<float>( i ) = flow.x;
-      b2.at<float>( i ) = flow.y;
-    }
-  }
-
-  Mat A1 = A1Out.getMat();
-  Mat A2 = A2Out.getMat();
   Mat b1 = b1Out.getMat();
   Mat b2 = b2Out.getMat();
-
-  memcpy( A2.ptr<float>(), A1.ptr<float>(), features.size() * basisSize.area() * sizeof( float ) );
-  prior->fillConstraints( A1.ptr<float>( features.size(), 0 ), A2.ptr<float>( features.size(), 0 ),
-                          b1.ptr<float>( features.size(), 0 ), b2.ptr<float>( features.size(), 0 ) );
+  for ( size_t i = 0; i < features.size(); ++i )
+  {
+    const Point2f flow = predictedFeatures[i] - features[i];
+    b1.at<float>( i ) = flow.x;
+    b2.at<float>( i ) = flow.y;
+  }
 }
 
 void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray flowOut )
@@ -420,6 +454,18 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   const Size size = I0.size();
   CV_Assert( size == I1.size() );
 
+  flowOut.create( size, CV_32FC2 );
+  Mat flow = flowOut.getMat();
+  // ocl::useOpenCL() is per thread, so the path is chosen here and not by calcFlow, which also runs
+  // on the worker threads of calcBatch
+  calcFlow( I0, I1, flow, flowOut.isUMat() && ocl::useOpenCL() );
+}
+
+void OpticalFlowPCAFlow::calcFlow( InputArray I0, InputArray I1, Mat &flow, bool useOpenCL ) const
+{
+  const Size size = I0.size();
+  OpenCLDisabler cpuOnly( !useOpenCL );
+
   UMat from, to;
   if ( I0.channels() == 3 )
   {
@@ -444,49 +490,103 @@ void OpticalFlowPCAFlow::calc( InputArray I0, InputArray I1, InputOutputArray fl
   CV_Assert( to.channels() == 1 );
 
   const Mat fromOrig = from.getMat( ACCESS_READ ).clone();
-  useOpenCL = flowOut.isUMat() && ocl::useOpenCL();
 
   applyCLAHE( from, claheClip );
   applyCLAHE( to, claheClip );
 
   std::vector<Point2f> features, predictedFeatures;
-  findSparseFeatures( from, to, features, predictedFeatures );
-  removeOcclusions( from, to, features, predictedFeatures );
-
-  flowOut.create( size, CV_32FC2 );
-  Mat flow = flowOut.getMat();
-
-  Mat w1, w2;
-  if ( prior.get() )
+  if ( useOpenCL )
   {
-    Mat A1, A2, b1, b2;
-    getSystem( A1, A2, b1, b2, features, predictedFeatures, size );
-    solveLSQR( A1, b1, w1, dampingFactor * size.area() );
-    solveLSQR( A2, b2, w2, dampingFactor * size.area() );
+    findSparseFeatures( from, from, to, features, predictedFeatures );
+    removeOcclusions( from, to, size, features, predictedFeatures );
   }
   else
-  {
-    Mat A, b1, b2;
-    getSystem( A, b1, b2, features, predictedFeatures, size );
-    solveLSQR( A, b1, w1, dampingFactor * size.area() );
-    solveLSQR( A, b2, w2, dampingFactor * size.area() );
+  { // Forward and backward matching share the pyramids, with the same parameters calcOpticalFlowPyrLK would use.
+    std::vector<Mat> fromPyr, toPyr;
+    buildOpticalFlowPyramid( from, fromPyr, Size( 21, 21 ), 3 );
+    buildOpticalFlowPyramid( to, toPyr, Size( 21, 21 ), 3 );
+    findSparseFeatures( from, fromPyr, toPyr, features, predictedFeatures );
+    removeOcclusions( fromPyr, toPyr, size, features, predictedFeatures );
   }
+
+  Mat A, AT, b[2], w[2];
+  getSystem( A, b[0], b[1], features, predictedFeatures, size, useOpenCL );
+  transpose( A, AT );
+  parallel_for_( Range( 0, 2 ), ParallelLSQR( A, AT, b, priorA, priorAT, priorB, w, dampingFactor * size.area() ) );
+
   Mat flowSmall( ( size / 8 ) * 2, CV_32FC2 );
-  reduceToFlow( w1, w2, flowSmall, basisSize );
+  reduceToFlow( w[0], w[1], flowSmall, basisSize );
   resize( flowSmall, flow, size, 0, 0, INTER_LINEAR );
   ximgproc::fastGlobalSmootherFilter( fromOrig, flow, flow, 500, 2 );
 }
 
+class OpticalFlowPCAFlow::ParallelCalcBatch : public ParallelLoopBody
+{
+private:
+  const OpticalFlowPCAFlow &algo;
+  const std::vector<Mat> &I0;
+  const std::vector<Mat> &I1;
+  std::vector<Mat> &flows;
+
+  ParallelCalcBatch &operator=( const ParallelCalcBatch & );
+
+public:
+  ParallelCalcBatch( const OpticalFlowPCAFlow &_algo, const std::vector<Mat> &_I0, const std::vector<Mat> &_I1,
+                     std::vector<Mat> &_flows )
+      : algo( _algo ), I0( _I0 ), I1( _I1 ), flows( _flows ){};
+
+  void operator()( const Range &range ) const
+  {
+    // the workers always take the CPU path with shared pyramids, whatever their OpenCL flag
+    for ( int i = range.start; i < range.end; ++i )
+      algo.calcFlow( I0[i], I1[i], flows[i], false );
+  }
+};
+
+void OpticalFlowPCAFlow::calcBatch( InputArrayOfArrays I0, InputArrayOfArrays I1, OutputArrayOfArrays flowsOut ) const
+{
+  std::vector<Mat> from, to;
+  I0.getMatVector( from );
+  I1.getMatVector( to );
+  CV_Assert( from.size() == to.size() );
+
+  const int n = (int)from.size();
+  flowsOut.create( n, 1, 0, -1, true );
+  std::vector<Mat> flows( n );
+  for ( int i = 0; i < n; ++i )
+  {
+    CV_Assert( from[i].size() == to[i].size() );
+    flowsOut.create( from[i].size(), CV_32FC2, i, true );
+    flows[i] = flowsOut.getMat( i );
+  }
+
+  parallel_for_( Range( 0, n ), ParallelCalcBatch( *this, from, to, flows ) );
+}
+
 OpticalFlowPCAFlow::OpticalFlowPCAFlow( Ptr<const PCAPrior> _prior, const Size _basisSize, float _sparseRate,
                                         float _retainedCornersFraction, float _occlusionsThreshold,
                                         float _dampingFactor, float _claheClip )
     : prior( _prior ), basisSize( _basisSize ), sparseRate( _sparseRate ),
       retainedCornersFraction( _retainedCornersFraction ), occlusionsThreshold( _occlusionsThreshold ),
-      dampingFactor( _dampingFactor ), claheClip( _claheClip ), useOpenCL( false )
+      dampingFactor( _dampingFactor ), claheClip( _claheClip )
 {
   CV_Assert( sparseRate > 0 && sparseRate <= 0.1 );
   CV_Assert( retainedCornersFraction >= 0 && retainedCornersFraction <= 1.0 );
   CV_Assert( occlusionsThreshold > 0 );
+
+  // The constraints of the prior don't depend on the frames, they are filled and transposed once.
+  if ( prior.get() )
+  {
+    CV_Assert( prior->getBasisSize() == basisSize.area() );
+    for ( int i = 0; i < 2; ++i )
+    {
+      priorA[i].create( prior->getPadding(), basisSize.area(), CV_32F );
+      priorB[i].create( prior->getPadding(), 1, CV_32F );
+    }
+    prior->fillConstraints( priorA[0].ptr<float>(), priorA[1].ptr<float>(), priorB[0].ptr<float>(), priorB[1].ptr<float>() );
+    transpose( priorA[0], priorAT[0] );
+    transpose( priorA[1], priorAT[1] );
+  }
 }
 
 void OpticalFlowPCAFlow::collectGarbage() {}
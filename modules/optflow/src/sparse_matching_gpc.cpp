@@ -41,6 +41,7 @@
  //M*/
 
 #include "opencv2/core/core_c.h"
+#include <fstream>
 #include "opencv2/core/private.hpp"
 #include "opencv2/flann/miniflann.hpp"
 #include "opencv2/highgui.hpp"
@@ -80,8 +81,10 @@ const unsigned scoreGainNeg = 1;
 const unsigned negSearchKNN = 5;
 const double simulatedAnnealingTemperatureCoef = 200.0;
 const double sigmaGrowthRate = 0.2;
-
-RNG rng;
+const int parallelSplitMinSamples = 8192; // Sample loops of the hyperplane search run in parallel starting from this node size.
+const int samplesPerStripe = 2048;
+const char binaryForestTag[] = "GPCF";
+const int binaryForestVersion = 1;
 
 struct Magnitude
 {
@@ -442,7 +445,7 @@ void getTrainingSamples( const Mat &from, const Mat &to, const Mat &gt, GPCSampl
 }
 
 /* Sample random number from Cauchy distribution. */
-double getRandomCauchyScalar()
+double getRandomCauchyScalar( RNG &rng )
 {
   return tan( rng.uniform( -1.54, 1.54 ) ); // I intentionally used the value slightly less than PI/2 to enforce strictly
                                             // zero probability for large numbers. Resulting PDF for Cauchy has
@@ -451,13 +454,83 @@ double getRandomCauchyScalar()
 
 /* Sample random vector from Cauchy distribution (pointwise, i.e. vector whose components are independent random
  * variables from Cauchy distribution) */
-void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v )
+void getRandomCauchyVector( Vec< double, GPCPatchDescriptor::nFeatures > &v, RNG &rng )
 {
   for ( unsigned i = 0; i < GPCPatchDescriptor::nFeatures; ++i )
-    v[i] = getRandomCauchyScalar();
+    v[i] = getRandomCauchyScalar( rng );
 }
 
 double getRobustMedian( double m ) { return m < 0 ? m * ( 1.0 + epsTolerance ) : m * ( 1.0 - epsTolerance ); }
+
+/* Projects reference descriptors of the samples onto the hyperplane normal. */
+class ParallelProjection : public ParallelLoopBody
+{
+private:
+  const GPCPatchSample *samples;
+  const Vec< double, GPCPatchDescriptor::nFeatures > &coef;
+  double *values;
+
+  ParallelProjection &operator=( const ParallelProjection & );
+
+public:
+  ParallelProjection( const GPCPatchSample *_samples, const Vec< double, GPCPatchDescriptor::nFeatures > &_coef, double *_values )
+      : samples( _samples ), coef( _coef ), values( _values ){};
+
+  void operator()( const Range &range ) const
+  {
+    for ( int i = range.start; i < range.end; ++i )
+      values[i] = samples[i].ref.dot( coef );
+  }
+};
+
+/* Scores the hyperplane. Every stripe of samplesPerStripe samples has its own partial score,
+ * so the sum doesn't depend on the way stripes are distributed among threads. */
+class ParallelScoring : public ParallelLoopBody
+{
+private:
+  const GPCPatchSample *samples;
+  const double *refValues;
+  int nSamples;
+  const Vec< double, GPCPatchDescriptor::nFeatures > &coef;
+  double rhs;
+  unsigned *scores;
+
+  ParallelScoring &operator=( const ParallelScoring & );
+
+public:
+  ParallelScoring( const GPCPatchSample *_samples, const double *_refValues, int _nSamples,
+                   const Vec< double, GPCPatchDescriptor::nFeatures > &_coef, double _rhs, unsigned *_scores )
+      : samples( _samples ), refValues( _refValues ), nSamples( _nSamples ), coef( _coef ), rhs( _rhs ), scores( _scores ){};
+
+  void operator()( const Range &range ) const
+  {
+    for ( int stripe = range.start; stripe < range.end; ++stripe )
+    {
+      const int end = std::min( ( stripe + 1 ) * samplesPerStripe, nSamples );
+      unsigned score = 0;
+      for ( int i = stripe * samplesPerStripe; i < end; ++i )
+      {
+        // Same as GPCPatchSample::getDirections, but the reference projection is already known.
+        const bool refdir = ( refValues[i] < rhs );
+        const bool posdir = samples[i].pos.isSeparated() ? ( !refdir ) : ( samples[i].pos.dot( coef ) < rhs );
+        const bool negdir = samples[i].neg.isSeparated() ? ( !refdir ) : ( samples[i].neg.dot( coef ) < rhs );
+        if ( refdir == posdir )
+          score += scoreGainPos;
+        if ( refdir != negdir )
+          score += scoreGainNeg;
+      }
+      scores[stripe] = score;
+    }
+  }
+};
+
+template < typename Body > void runSampleLoop( const Range &range, const Body &body, int nSamples )
+{
+  if ( nSamples >= parallelSplitMinSamples )
+    parallel_for_( range, body );
+  else
+    body( range );
+}
 }
 
 double GPCPatchDescriptor::dot( const Vec< double, nFeatures > &coef ) const
@@ -510,38 +583,37 @@ void GPCDetails::getCoordinatesFromIndex( size_t index, Size sz, int &x, int &y
   y += patchRadius;
 }
 
-bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
+unsigned GPCTree::trainNode( SIter begin, SIter end, unsigned depth, RNG &rng )
 {
   const int nSamples = (int)std::distance( begin, end );
 
   if ( nSamples < params.minNumberOfSamples || depth >= params.maxTreeDepth )
-    return false;
+    return 0;
 
-  if ( nodeId >= nodes.size() )
-    nodes.resize( nodeId + 1 );
-
-  Node &node = nodes[nodeId];
+  Node node;
 
   // Select the best hyperplane
   unsigned globalBestScore = 0;
-  std::vector< double > values;
-  values.reserve( nSamples * 2 );
+  const GPCPatchSample *samples = &*begin;
+  const int nStripes = ( nSamples + samplesPerStripe - 1 ) / samplesPerStripe;
+  std::vector< double > refValues( nSamples ), values;
+  std::vector< unsigned > scores( nStripes );
+  values.reserve( nSamples );
 
   for ( int j = 0; j < globalIters; ++j )
   { // Global search step
     Vec< double, GPCPatchDescriptor::nFeatures > coef;
     unsigned localBestScore = 0;
-    getRandomCauchyVector( coef );
+    getRandomCauchyVector( coef, rng );
 
     for ( int i = 0; i < localIters; ++i )
     { // Local search step
-      double randomModification = getRandomCauchyScalar() * ( 1.0 + sigmaGrowthRate * int( i / GPCPatchDescriptor::nFeatures ) );
+      double randomModification = getRandomCauchyScalar( rng ) * ( 1.0 + sigmaGrowthRate * int( i / GPCPatchDescriptor::nFeatures ) );
       const int pos = i % GPCPatchDescriptor::nFeatures;
       std::swap( coef[pos], randomModification );
-      values.clear();
 
-      for ( SIter iter = begin; iter != end; ++iter )
-        values.push_back( iter->ref.dot( coef ) );
+      runSampleLoop( Range( 0, nSamples ), ParallelProjection( samples, coef, &refValues[0] ), nSamples );
+      values.assign( refValues.begin(), refValues.end() );
 
       std::nth_element( values.begin(), values.begin() + nSamples / 2, values.end() );
       double median = values[nSamples / 2];
@@ -554,16 +626,10 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
 
       median = getRobustMedian( median );
 
+      runSampleLoop( Range( 0, nStripes ), ParallelScoring( samples, &refValues[0], nSamples, coef, median, &scores[0] ), nSamples );
       unsigned score = 0;
-      for ( SIter iter = begin; iter != end; ++iter )
-      {
-        bool refdir, posdir, negdir;
-        iter->getDirections( refdir, posdir, negdir, coef, median );
-        if ( refdir == posdir )
-          score += scoreGainPos;
-        if ( refdir != negdir )
-          score += scoreGainNeg;
-      }
+      for ( int k = 0; k < nStripes; ++k )
+        score += scores[k];
 
       if ( score > localBestScore )
         localBestScore = score;
@@ -584,16 +650,16 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
   }
 
   if ( globalBestScore == 0 )
-    return false;
+    return 0;
 
   if ( params.printProgress )
-  {
+  { // Trees may be trained concurrently, so the report is printed at once.
     const int maxScore = nSamples * ( scoreGainPos + scoreGainNeg );
     const double correctRatio = double( globalBestScore ) / maxScore;
-    printf( "[%u] Correct %.2f (%u/%d)\nWeights:", depth, correctRatio, globalBestScore, maxScore );
+    String report = format( "[%u] Correct %.2f (%u/%d)\nWeights:", depth, correctRatio, globalBestScore, maxScore );
     for ( unsigned k = 0; k < GPCPatchDescriptor::nFeatures; ++k )
-      printf( " %.3f", node.coef[k] );
-    printf( "\n" );
+      report += format( " %.3f", node.coef[k] );
+    printf( "%s\n", report.c_str() );
   }
 
   for ( SIter iter = begin; iter != end; ++iter )
@@ -617,21 +683,44 @@ bool GPCTree::trainNode( size_t nodeId, SIter begin, SIter end, unsigned depth )
   SIter rightBegin =
     std::partition( leftEnd, end, PartitionPredicate2( node.coef, node.rhs ) ); // Separate undefined samples from right subtree samples.
 
-  node.left = ( trainNode( nodeId * 2 + 1, begin, leftEnd, depth + 1 ) ) ? unsigned( nodeId * 2 + 1 ) : 0;
-  node.right = ( trainNode( nodeId * 2 + 2, rightBegin, end, depth + 1 ) ) ? unsigned( nodeId * 2 + 2 ) : 0;
+  // Release the buffers before going deeper, the recursion may be up to maxTreeDepth levels.
+  std::vector< double >().swap( refValues );
+  std::vector< double >().swap( values );
 
-  return true;
+  // Nodes are stored in depth-first order. The root has index 0, so 0 also means "no child".
+  const unsigned nodeId = unsigned( nodes.size() );
+  nodes.push_back( node );
+  const unsigned left = trainNode( begin, leftEnd, depth + 1, rng );
+  const unsigned right = trainNode( rightBegin, end, depth + 1, rng );
+  nodes[nodeId].left = left;
+  nodes[nodeId].right = right;
+
+  return nodeId;
 }
 
 void GPCTree::train( GPCTrainingSamples &samples, const GPCTrainingParams _params )
+{
+  train( samples, _params, theRNG().next() );
+}
+
+void GPCTree::train( GPCTrainingSamples &samples, const GPCTrainingParams _params, uint64 seed )
 {
   if ( _params.descriptorType != samples.type() )
     CV_Error( CV_StsBadArg, "Descriptor type mismatch! Check that samples are collected with the same descriptor type." );
   nodes.clear();
-  nodes.reserve( samples.size() * 2 - 1 ); // set upper bound for the possible number of nodes so all subsequent resize() will be no-op
   params = _params;
+  RNG rng( seed );
   GPCSamplesVector &sv = samples;
-  trainNode( 0, sv.begin(), sv.end(), 0 );
+  if ( !sv.empty() )
+    trainNode( sv.begin(), sv.end(), 0, rng );
+  if ( nodes.empty() )
+  { // The root could not be split, all patches fall into the same leaf.
+    Node root;
+    root.coef = Vec< double, GPCPatchDescriptor::nFeatures >::all( 0 );
+    root.rhs = 0;
+    root.left = root.right = 0;
+    nodes.push_back( root );
+  }
 }
 
 void GPCTree::write( FileStorage &fs ) const
@@ -648,6 +737,35 @@ void GPCTree::read( const FileNode &fn )
   fn["dtype"] >> (int &)params.descriptorType;
 }
 
+void GPCTree::writeBinary( std::ostream &os ) const
+{
+  if ( nodes.empty() )
+    CV_Error( CV_StsBadArg, "Tree have not been trained" );
+  const int header[3] = {(int)params.descriptorType, (int)sizeof( Node ), (int)nodes.size()};
+  os.write( (const char *)header, sizeof( header ) );
+  os.write( (const char *)&nodes[0], nodes.size() * sizeof( Node ) );
+  if ( !os.good() )
+    CV_Error( CV_StsError, "Failed to write the tree" );
+}
+
+void GPCTree::readBinary( std::istream &is )
+{
+  int header[3];
+  is.read( (char *)header, sizeof( header ) );
+  if ( !is.good() || header[1] != (int)sizeof( Node ) || header[2] <= 0 )
+    CV_Error( CV_StsParseError, "Invalid binary tree format" );
+  nodes.resize( header[2] );
+  is.read( (char *)&nodes[0], nodes.size() * sizeof( Node ) );
+  if ( !is.good() )
+    CV_Error( CV_StsParseError, "Unexpected end of the binary tree" );
+  // Children follow their parent in depth-first order, so a valid index never points back to the node or an ancestor.
+  for ( size_t i = 0; i < nodes.size(); ++i )
+    if ( nodes[i].left >= nodes.size() || nodes[i].right >= nodes.size() || ( nodes[i].left != 0 && nodes[i].left <= i ) ||
+         ( nodes[i].right != 0 && nodes[i].right <= i ) )
+      CV_Error( CV_StsParseError, "Invalid node index in the binary tree" );
+  params.descriptorType = header[0];
+}
+
 unsigned GPCTree::findLeafForPatch( const GPCPatchDescriptor &descr ) const
 {
   unsigned id = 0, prevId;
@@ -726,6 +844,34 @@ Ptr< GPCTrainingSamples > GPCTrainingSamples::create( InputArrayOfArrays imagesF
   return ts;
 }
 
+void GPCDetails::saveTreesBinary( const String &filename, const GPCTree *trees, int nTrees )
+{
+  std::ofstream file( filename.c_str(), std::ofstream::binary );
+  if ( !file.good() )
+    CV_Error( CV_StsError, "Can't open the file for writing: " + filename );
+  const int header[2] = {binaryForestVersion, nTrees};
+  file.write( binaryForestTag, 4 );
+  file.write( (const char *)header, sizeof( header ) );
+  for ( int i = 0; i < nTrees; ++i )
+    trees[i].writeBinary( file );
+}
+
+void GPCDetails::loadTreesBinary( const String &filename, GPCTree *trees, int nTrees )
+{
+  std::ifstream file( filename.c_str(), std::ifstream::binary );
+  if ( !file.good() )
+    CV_Error( CV_StsError, "Can't open the file for reading: " + filename );
+  char tag[4];
+  int header[2];
+  file.read( tag, 4 );
+  file.read( (char *)header, sizeof( header ) );
+  if ( !file.good() || memcmp( tag, binaryForestTag, 4 ) != 0 || header[0] != binaryForestVersion )
+    CV_Error( CV_StsParseError, "Not a binary GPC forest: " + filename );
+  CV_Assert( nTrees <= header[1] );
+  for ( int i = 0; i < nTrees; ++i )
+    trees[i].readBinary( file );
+}
+
 void GPCDetails::dropOutliers( std::vector< std::pair< Point2i, Point2i > > &corr )
 {
   std::vector< float > mag( corr.size() );
@@ -161,6 +161,62 @@ TEST(DenseOpticalFlow_DeepFlow, ReferenceAccuracy)
     EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
 }
 
+TEST(DenseOpticalFlow_DeepFlowVideo, ReferenceAccuracy)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    float target_RMSE = 0.35f;
+    cvtColor(frame1, frame1, COLOR_BGR2GRAY);
+    cvtColor(frame2, frame2, COLOR_BGR2GRAY);
+
+    Mat ref_flow;
+    createOptFlow_DeepFlow()->calc(frame1, frame2, ref_flow);
+
+    // the first pair has no previous frame, the flow is the one of DeepFlow
+    Mat flow;
+    Ptr<DenseOpticalFlow> algo;
+    algo = createOptFlow_DeepFlowVideo();
+    algo->calc(frame1, frame2, flow);
+    ASSERT_EQ(GT.rows, flow.rows);
+    ASSERT_EQ(GT.cols, flow.cols);
+    EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
+    EXPECT_EQ(0, cvtest::norm(ref_flow, flow, NORM_INF));
+}
+
+TEST(DenseOpticalFlow_DeepFlowVideo, ConsecutiveFrames)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    cvtColor(frame1, frame1, COLOR_BGR2GRAY);
+
+    // frames of a translated texture, the flow between consecutive frames is (-2, -1)
+    const Size sz(frame1.cols - 8, frame1.rows - 4);
+    Mat frames[3];
+    for (int i = 0; i < 3; i++)
+        frames[i] = frame1(Rect(2 * i, i, sz.width, sz.height)).clone();
+    const Mat gt(sz, CV_32FC2, Scalar(-2, -1));
+
+    Mat ref_flow01, ref_flow12;
+    createOptFlow_DeepFlow()->calc(frames[0], frames[1], ref_flow01);
+    createOptFlow_DeepFlow()->calc(frames[1], frames[2], ref_flow12);
+
+    Mat flow;
+    Ptr<DenseOpticalFlow> algo = createOptFlow_DeepFlowVideo();
+    algo->calc(frames[0], frames[1], flow);
+    EXPECT_EQ(0, cvtest::norm(ref_flow01, flow, NORM_INF));
+
+    // the second pair reuses the pyramid of frames[1] and starts from the last flow
+    algo->calc(frames[1], frames[2], flow);
+    ASSERT_EQ(sz, flow.size());
+    EXPECT_LE(calcRMSE(gt, flow), calcRMSE(gt, ref_flow12) + 0.05f);
+    EXPECT_LE(cvtest::norm(ref_flow12, flow, NORM_L1) / flow.total(), 0.15);
+
+    // without the cached frame the pair is not consecutive any more, the flow is the one of DeepFlow
+    algo->collectGarbage();
+    algo->calc(frames[1], frames[2], flow);
+    EXPECT_EQ(0, cvtest::norm(ref_flow12, flow, NORM_INF));
+}
+
 TEST(DenseOpticalFlow_SparseToDenseFlow, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -236,6 +292,35 @@ TEST(DenseOpticalFlow_PCAFlow, ReferenceAccuracy)
     EXPECT_LE(calcRMSE(GT, flow), target_RMSE);
 }
 
+TEST(DenseOpticalFlow_PCAFlow, Batch)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+    const float target_RMSE = 0.55f;
+
+    const Rect roi(0, 0, frame1.cols / 2, frame1.rows / 2);
+    vector<Mat> from, to, flows;
+    from.push_back(frame1);
+    to.push_back(frame2);
+    from.push_back(frame2);
+    to.push_back(frame1);
+    from.push_back(frame1(roi));
+    to.push_back(frame2(roi));
+
+    OpticalFlowPCAFlow algo;
+    algo.calcBatch(from, to, flows);
+    ASSERT_EQ(from.size(), flows.size());
+    EXPECT_LE(calcRMSE(GT, flows[0]), target_RMSE);
+
+    for (size_t i = 0; i < from.size(); ++i)
+    {
+        Mat flow;
+        algo.calc(from[i], to[i], flow);
+        ASSERT_EQ(flow.size(), flows[i].size());
+        EXPECT_EQ(0, cv::norm(flow, flows[i], NORM_INF));
+    }
+}
+
 TEST(DenseOpticalFlow_GlobalPatchColliderDCT, ReferenceAccuracy)
 {
     Mat frame1, frame2, GT;
@@ -283,3 +368,34 @@ TEST(DenseOpticalFlow_GlobalPatchColliderWHT, ReferenceAccuracy)
     ASSERT_LE(7000U, corr.size());
     ASSERT_LE(calcAvgEPE(corr, GT), 0.5f);
 }
+
+TEST(DenseOpticalFlow_GlobalPatchCollider, BinarySerialization)
+{
+    Mat frame1, frame2, GT;
+    ASSERT_TRUE(readRubberWhale(frame1, frame2, GT));
+
+    const Size sz = frame1.size() / 2;
+    frame1 = frame1(Rect(0, 0, sz.width, sz.height));
+    frame2 = frame2(Rect(0, 0, sz.width, sz.height));
+    GT = GT(Rect(0, 0, sz.width, sz.height));
+
+    vector<Mat> img1, img2, gt;
+    vector< pair<Point2i, Point2i> > corr, corrLoaded;
+    img1.push_back(frame1);
+    img2.push_back(frame2);
+    gt.push_back(GT);
+
+    Ptr< GPCForest<3> > forest = GPCForest<3>::create();
+    forest->train(img1, img2, gt, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_WHT, false));
+    forest->findCorrespondences(frame1, frame2, corr);
+
+    const string filename = tempfile(".bin");
+    forest->saveBinary(filename);
+    Ptr< GPCForest<3> > loaded = GPCForest<3>::create();
+    loaded->loadBinary(filename);
+    remove(filename.c_str());
+    loaded->findCorrespondences(frame1, frame2, corrLoaded);
+
+    ASSERT_FALSE(corr.empty());
+    EXPECT_TRUE(corr == corrLoaded);
+}
@@ -157,3 +157,43 @@ TEST_P(DenseOpticalFlow_VariationalRefinement, MultithreadReproducibility)
 }
 
 INSTANTIATE_TEST_CASE_P(FullSet, DenseOpticalFlow_VariationalRefinement, Values(szODD, szQVGA));
+
+TEST(GlobalPatchCollider, MultithreadReproducibility)
+{
+    // two frames of a translated texture, the ground truth flow is constant
+    Mat texture(szQVGA.height + 1, szQVGA.width + 2, CV_8UC3);
+    randu(texture, 0, 255);
+    GaussianBlur(texture, texture, Size(5, 5), 0);
+    Mat frame1 = texture(Rect(0, 0, szQVGA.width, szQVGA.height)).clone();
+    Mat frame2 = texture(Rect(2, 1, szQVGA.width, szQVGA.height)).clone();
+
+    vector<Mat> img1(1, frame1), img2(1, frame2), gt(1, Mat(szQVGA, CV_32FC2, Scalar(-2, -1)));
+    Ptr<GPCTrainingSamples> samples = GPCTrainingSamples::create(img1, img2, gt, GPC_DESCRIPTOR_WHT);
+    const GPCTrainingParams params(8, 3, GPC_DESCRIPTOR_WHT, false);
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    theRNG().state = 0x12345678;
+    Ptr< GPCForest<3> > forestMultiThread = GPCForest<3>::create();
+    forestMultiThread->train(*samples, params);
+    vector< pair<Point2i, Point2i> > corrMultiThread;
+    forestMultiThread->findCorrespondences(frame1, frame2, corrMultiThread);
+
+    cv::setNumThreads(1);
+    theRNG().state = 0x12345678;
+    Ptr< GPCForest<3> > forestSingleThread = GPCForest<3>::create();
+    forestSingleThread->train(*samples, params);
+    vector< pair<Point2i, Point2i> > corrSingleThread;
+    forestSingleThread->findCorrespondences(frame1, frame2, corrSingleThread);
+
+    // one tree at a time, with the lowest memory usage
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    theRNG().state = 0x12345678;
+    Ptr< GPCForest<3> > forestSequential = GPCForest<3>::create();
+    forestSequential->train(*samples, GPCTrainingParams(8, 3, GPC_DESCRIPTOR_WHT, false, 1));
+    vector< pair<Point2i, Point2i> > corrSequential;
+    forestSequential->findCorrespondences(frame1, frame2, corrSequential);
+
+    ASSERT_FALSE(corrSingleThread.empty());
+    EXPECT_TRUE(corrSingleThread == corrMultiThread);
+    EXPECT_TRUE(corrSingleThread == corrSequential);
+}
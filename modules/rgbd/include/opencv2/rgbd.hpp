@@ -1013,6 +1013,150 @@ namespace rgbd
     mutable Ptr<RgbdNormals> normalsComputer;
   };
 
+  /** Streaming front-end of the Odometry for a sequence of frames.
+   * Each incoming frame is the source frame of the current compute call and the destination frame of the next one,
+   * so its cache (pyramids, normals, masks) is prepared once with CACHE_ALL and then reused by both calls.
+   * The object keeps a ring of the last frames and the chained camera pose.
+   */
+  class CV_EXPORTS OdometryStream
+  {
+  public:
+    /** Constructor.
+     * @param odometry The odometry used to compute transformations between consecutive frames.
+     * @param historySize Count of the last frames kept in the ring (at least 2).
+     */
+    OdometryStream(const Ptr<Odometry>& odometry, int historySize = 2);
+
+    /** Add the next frame of the sequence and compute its transformation to the previous frame.
+     * The method returns the result of Odometry::compute, or true for the first frame. If the odometry fails,
+     * the identity is used and the chained pose is not changed.
+     * @param image Image data of the frame (CV_8UC1)
+     * @param depth Depth data of the frame (CV_32FC1, in meters)
+     * @param mask Mask that sets which pixels have to be used from the frame (CV_8UC1)
+     * @param Rt Resulting transformation from the new frame to the previous one:
+     dst_p = Rt * src_p, where src_p is a point in the new frame and dst_p is the point in the previous frame,
+     Rt is 4x4 matrix of CV_64FC1 type.
+     */
+    bool
+    process(const Mat& image, const Mat& depth, const Mat& mask, Mat& Rt);
+
+    /** The same as above but the frame may contain precomputed data (image pyramids, normals, etc.).
+     * The frame is owned by the stream after the call and must not be modified by the caller.
+     */
+    bool
+    process(Ptr<OdometryFrame>& frame, Mat& Rt);
+
+    /** Forget all frames and reset the pose to the identity. */
+    void
+    reset();
+
+    /** Returns the frame added age calls ago (0 is the last frame) or an empty pointer. */
+    Ptr<OdometryFrame>
+    getFrame(int age = 0) const;
+
+    /** Returns the pose of the last frame in the coordinate system of the first one (4x4, CV_64FC1). */
+    Mat getPose() const
+    {
+        return pose.clone();
+    }
+    /** @copybrief getPose @see getPose */
+    void setPose(const Mat& val)
+    {
+        CV_Assert(val.size() == Size(4,4));
+        val.convertTo(pose, CV_64FC1);
+    }
+    int getFrameCount() const
+    {
+        return frameCount;
+    }
+    int getHistorySize() const
+    {
+        return (int)frames.size();
+    }
+    Ptr<Odometry> getOdometry() const
+    {
+        return odometry;
+    }
+
+  protected:
+    Ptr<Odometry> odometry;
+
+    /** Ring of the last frames, head is the index of the last added frame. */
+    std::vector<Ptr<OdometryFrame> > frames;
+    int head;
+    int frameCount;
+
+    Mat pose;
+  };
+
+  /** Truncated signed distance function (TSDF) volume that fuses depth frames into a dense surface model,
+   * as in "KinectFusion: Real-Time Dense Surface Mapping and Tracking", Richard A. Newcombe, et al., 2011.
+   * The voxels are stored in blocks of blockSize^3 voxels that are allocated through a spatial hash only
+   * around the observed surface ("Real-time 3D Reconstruction at Scale using Voxel Hashing", M. Niessner, et al., 2013),
+   * so the memory scales with the surface and not with the bounding volume.
+   * Camera poses have the same meaning as the pose of OdometryStream: p_volume = cameraPose * p_camera.
+   */
+  class CV_EXPORTS TSDFVolume: public Algorithm
+  {
+  public:
+    /** Fuse a depth frame into the volume. The blocks are allocated serially and integrated in parallel.
+     * @param depth Depth data of the frame (CV_32FC1, in meters, NaN or 0 for invalid pixels)
+     * @param cameraMatrix Camera matrix
+     * @param cameraPose Pose of the camera in the volume coordinates (4x4)
+     */
+    virtual void
+    integrate(const Mat& depth, const Mat& cameraMatrix, const Mat& cameraPose) = 0;
+
+    /** Render the model from the given camera for the model-to-frame tracking.
+     * The output can be used as the cloud and the normals of an OdometryFrame (eg. for ICPOdometry).
+     * @param cameraPose Pose of the camera in the volume coordinates (4x4)
+     * @param cameraMatrix Camera matrix
+     * @param frameSize Size of the rendered frame
+     * @param points The 3d points in the camera coordinates (CV_32FC3, NaN where the ray does not hit the surface)
+     * @param normals The normals in the camera coordinates (CV_32FC3, pointing towards the camera)
+     */
+    virtual void
+    raycast(const Mat& cameraPose, const Mat& cameraMatrix, const Size& frameSize, Mat& points, Mat& normals) const = 0;
+
+    /** Extract the zero level set of the volume as a point cloud.
+     * @param points The points in the volume coordinates (N x 1, CV_32FC3)
+     * @param normals The normals of the points (N x 1, CV_32FC3), it is not computed if the pointer is null
+     */
+    virtual void
+    fetchCloud(Mat& points, Mat* normals = 0) const = 0;
+
+    /** Release all blocks. */
+    virtual void
+    reset() = 0;
+
+    /** Count of the allocated voxel blocks. */
+    virtual int
+    getBlockCount() const = 0;
+
+    /** Constructor.
+     * @param voxelSize Size of the voxel edge (in meters)
+     * @param truncDist Truncation distance of the signed distance function (in meters)
+     * @param maxWeight Maximum weight of the running average of each voxel
+     * @param blockSize Count of voxels along the edge of the block
+     */
+    static Ptr<TSDFVolume> create(float voxelSize = 0.01f, float truncDist = 0.04f, int maxWeight = 64, int blockSize = 8);
+
+    virtual double getVoxelSize() const = 0;
+    virtual double getTruncDist() const = 0;
+    virtual int getBlockSize() const = 0;
+    virtual int getMaxWeight() const = 0;
+    /** @copybrief getMaxWeight @see getMaxWeight */
+    virtual void setMaxWeight(int val) = 0;
+    /** Pixels with depth less than minDepth will not be integrated, the raycasting starts at minDepth */
+    virtual double getMinDepth() const = 0;
+    /** @copybrief getMinDepth @see getMinDepth */
+    virtual void setMinDepth(double val) = 0;
+    /** Pixels with depth larger than maxDepth will not be integrated, the raycasting stops at maxDepth */
+    virtual double getMaxDepth() const = 0;
+    /** @copybrief getMaxDepth @see getMaxDepth */
+    virtual void setMaxDepth(double val) = 0;
+  };
+
   /** Warp the image: compute 3d points from the depth, transform them using given transformation,
    * then project color point cloud to an image plane.
    * This function can be used to visualize results of the Odometry algorithm.
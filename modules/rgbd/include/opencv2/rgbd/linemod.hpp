@@ -339,6 +339,8 @@ public:
    * \brief Detect objects by template matching.
    *
    * Matches globally at the lowest pyramid level, then refines locally stepping up the pyramid.
+   * Templates of all classes are matched in parallel. Templates whose partial similarity
+   * already rules out the threshold are rejected before all their features are scored.
    *
    * \param      sources   Source images, one for each modality.
    * \param      threshold Similarity threshold, a percentage between 0 and 100.
@@ -415,6 +417,23 @@ public:
                    const String& format = "templates_%s.yml.gz");
   void writeClasses(const String& format = "templates_%s.yml.gz") const;
 
+  /**
+   * \brief Write the templates of all classes into one binary file.
+   *
+   * The features of each template are stored as one linear array, so a large template set
+   * loads much faster than with readClasses(). Detector parameters are not stored, use
+   * write() for them.
+   */
+  void writeTemplatesBinary(const String& filename) const;
+
+  /**
+   * \brief Read templates written by writeTemplatesBinary().
+   *
+   * The detector must use the same modalities and pyramid levels and must not contain
+   * the stored classes yet. A corrupted file raises an error and leaves the detector unchanged.
+   */
+  void readTemplatesBinary(const String& filename);
+
 protected:
   std::vector< Ptr<Modality> > modalities;
   int pyramid_levels;
@@ -1159,12 +1159,16 @@ static const unsigned char* accessLinearMemory(const std::vector<Mat>& linear_me
  *
  * \param[in]  linear_memories Vector of 8 linear memories, one for each label.
  * \param[in]  templ           Template to match against.
- * \param[out] dst             Destination 8-bit similarity image of size (W/T, H/T).
+ * \param[in,out] dst          Destination 8-bit similarity image of size (W/T, H/T).
  * \param      size            Size (W, H) of the original input image.
  * \param      T               Sampling step.
+ * \param      first_feature   Index of the first feature to accumulate.
+ * \param      last_feature    Index after the last feature to accumulate.
+ * \param      init            If true, dst is (re)allocated and zeroed, otherwise the responses
+ *                             of the given features are added to the existing dst.
  */
 static void similarity(const std::vector<Mat>& linear_memories, const Template& templ,
-                Mat& dst, Size size, int T)
+                Mat& dst, Size size, int T, int first_feature, int last_feature, bool init)
 {
   // 63 features or less is a special case because the max similarity per-feature is 4.
   // 255/4 = 63, so up to that many we can add up similarities in 8 bits without worrying
@@ -1193,7 +1197,13 @@ static void similarity(const std::vector<Mat>& linear_memories, const Template&
 
   /// @todo In old code, dst is buffer of size m_U. Could make it something like
   /// (span_x)x(span_y) instead?
-  dst = Mat::zeros(H, W, CV_8U);
+  if (init)
+  {
+    // Reuses the buffer of the previous template if the size is the same
+    dst.create(H, W, CV_8U);
+    dst.setTo(Scalar::all(0));
+  }
+  CV_DbgAssert(dst.size() == Size(W, H) && dst.type() == CV_8U);
   uchar* dst_ptr = dst.ptr<uchar>();
 
 #if CV_SSE2
@@ -1205,7 +1215,7 @@ static void similarity(const std::vector<Mat>& linear_memories, const Template&
 
   // Compute the similarity measure for this template by accumulating the contribution of
   // each feature
-  for (int i = 0; i < (int)templ.features.size(); ++i)
+  for (int i = first_feature; i < last_feature; ++i)
   {
     // Add the linear memory at the appropriate offset computed from the location of
     // the feature in the template
@@ -1268,7 +1278,8 @@ static void similarityLocal(const std::vector<Mat>& linear_memories, const Templ
 
   // Compute the similarity map in a 16x16 patch around center
   int W = size.width / T;
-  dst = Mat::zeros(16, 16, CV_8U);
+  dst.create(16, 16, CV_8U);
+  dst.setTo(Scalar::all(0));
 
   // Offset each feature point by the requested center. Further adjust to (-8,-8) from the
   // center to get the top-left corner of the 16x16 patch.
@@ -1373,6 +1384,216 @@ static void addSimilarities(const std::vector<Mat>& similarities, Mat& dst)
   }
 }
 
+// Used to filter out weak matches
+struct MatchPredicate
+{
+  MatchPredicate(float _threshold) : threshold(_threshold) {}
+  bool operator() (const Match& m) { return m.similarity < threshold; }
+  float threshold;
+};
+
+/**
+ * \brief Similarity buffers of one thread, reused for all templates it matches.
+ */
+struct MatchBuffers
+{
+  MatchBuffers(size_t num_modalities) : similarities(num_modalities), similarities2(num_modalities) {}
+
+  std::vector<Mat> similarities;
+  Mat total_similarity;
+  std::vector<Mat> similarities2;
+  Mat total_similarity2;
+};
+
+/**
+ * \brief Match one template pyramid: globally at the lowest pyramid level, then locally
+ * refining the candidates up the pyramid.
+ *
+ * At the lowest level the features are accumulated coarse-to-fine (1/4, 1/2, all of them).
+ * After each partial step the template is rejected if even the maximum response of all
+ * remaining features cannot lift the best location over the threshold, so most templates
+ * are never scored with all their features.
+ */
+static void matchTemplatePyramid(const std::vector< std::vector< std::vector<Mat> > >& lm_pyramid,
+                                 const std::vector<Size>& sizes, const std::vector<int>& T_at_level,
+                                 float threshold, const String& class_id, int template_id,
+                                 const std::vector<Template>& tp, MatchBuffers& buffers,
+                                 std::vector<Match>& candidates)
+{
+  static const int FEATURE_QUARTERS[] = {0, 1, 2, 4};
+  const int num_modalities = static_cast<int>(buffers.similarities.size());
+  const int pyramid_levels = static_cast<int>(T_at_level.size());
+
+  // First match over the whole image at the lowest pyramid level
+  const std::vector< std::vector<Mat> >& lowest_lm = lm_pyramid.back();
+  int lowest_start = static_cast<int>(tp.size() - num_modalities);
+  int lowest_T = T_at_level.back();
+  int num_features = 0;
+  for (int i = 0; i < num_modalities; ++i)
+    num_features += static_cast<int>(tp[lowest_start + i].features.size());
+
+  // Convert user-friendly percentage to raw similarity threshold. The percentage
+  // threshold scales from half the max response (what you would expect from applying
+  // the template to a completely random image) to the max response.
+  // NOTE: This assumes max per-feature response is 4, so we scale between [2*nf, 4*nf].
+  int raw_threshold = static_cast<int>(2*num_features + (threshold / 100.f) * (2*num_features) + 0.5f);
+
+  // Compute similarity maps for each modality at lowest pyramid level and combine them
+  /// @todo Support weighting the modalities
+  Mat& total_similarity = buffers.total_similarity;
+  for (int stage = 0; stage < 3; ++stage)
+  {
+    int accumulated = 0;
+    for (int i = 0; i < num_modalities; ++i)
+    {
+      const Template& templ = tp[lowest_start + i];
+      int n = static_cast<int>(templ.features.size());
+      int first = n * FEATURE_QUARTERS[stage] / 4, last = n * FEATURE_QUARTERS[stage + 1] / 4;
+      similarity(lowest_lm[i], templ, buffers.similarities[i], sizes.back(), lowest_T, first, last, stage == 0);
+      accumulated += last;
+    }
+    addSimilarities(buffers.similarities, total_similarity);
+
+    if (accumulated < num_features)
+    {
+      double max_score = 0;
+      minMaxLoc(total_similarity, 0, &max_score);
+      if (static_cast<int>(max_score) + 4 * (num_features - accumulated) <= raw_threshold)
+        return;
+    }
+  }
+
+  // Find initial matches
+  size_t first_candidate = candidates.size();
+  for (int r = 0; r < total_similarity.rows; ++r)
+  {
+    const ushort* row = total_similarity.ptr<ushort>(r);
+    for (int c = 0; c < total_similarity.cols; ++c)
+    {
+      int raw_score = row[c];
+      if (raw_score > raw_threshold)
+      {
+        int offset = lowest_T / 2 + (lowest_T % 2 - 1);
+        int x = c * lowest_T + offset;
+        int y = r * lowest_T + offset;
+        float score =(raw_score * 100.f) / (4 * num_features) + 0.5f;
+        candidates.push_back(Match(x, y, score, class_id, template_id));
+      }
+    }
+  }
+
+  // Locally refine each match by marching up the pyramid
+  for (int l = pyramid_levels - 2; l >= 0; --l)
+  {
+    const std::vector< std::vector<Mat> >& lms = lm_pyramid[l];
+    int T = T_at_level[l];
+    int start = static_cast<int>(l * num_modalities);
+    Size size = sizes[l];
+    int border = 8 * T;
+    int offset = T / 2 + (T % 2 - 1);
+    int max_x = size.width - tp[start].width - border;
+    int max_y = size.height - tp[start].height - border;
+
+    std::vector<Mat>& similarities2 = buffers.similarities2;
+    Mat& total_similarity2 = buffers.total_similarity2;
+    for (size_t m = first_candidate; m < candidates.size(); ++m)
+    {
+      Match& match2 = candidates[m];
+      int x = match2.x * 2 + 1; /// @todo Support other pyramid distance
+      int y = match2.y * 2 + 1;
+
+      // Require 8 (reduced) row/cols to the up/left
+      x = std::max(x, border);
+      y = std::max(y, border);
+
+      // Require 8 (reduced) row/cols to the down/left, plus the template size
+      x = std::min(x, max_x);
+      y = std::min(y, max_y);
+
+      // Compute local similarity maps for each modality
+      int numFeatures = 0;
+      for (int i = 0; i < num_modalities; ++i)
+      {
+        const Template& templ = tp[start + i];
+        numFeatures += static_cast<int>(templ.features.size());
+        similarityLocal(lms[i], templ, similarities2[i], size, T, Point(x, y));
+      }
+      addSimilarities(similarities2, total_similarity2);
+
+      // Find best local adjustment
+      int best_score = 0;
+      int best_r = -1, best_c = -1;
+      for (int r = 0; r < total_similarity2.rows; ++r)
+      {
+        const ushort* row = total_similarity2.ptr<ushort>(r);
+        for (int c = 0; c < total_similarity2.cols; ++c)
+        {
+          int score = row[c];
+          if (score > best_score)
+          {
+            best_score = score;
+            best_r = r;
+            best_c = c;
+          }
+        }
+      }
+      // Update current match
+      match2.x = (x / T - 8 + best_c) * T + offset;
+      match2.y = (y / T - 8 + best_r) * T + offset;
+      match2.similarity = (best_score * 100.f) / (4 * numFeatures);
+    }
+
+    // Filter out any matches that drop below the similarity threshold
+    std::vector<Match>::iterator new_end = std::remove_if(candidates.begin() + first_candidate, candidates.end(),
+                                                          MatchPredicate(threshold));
+    candidates.erase(new_end, candidates.end());
+  }
+}
+
+/**
+ * \brief A template pyramid of some class, the unit of the parallel matching.
+ */
+struct MatchJob
+{
+  MatchJob(const String* _class_id, const std::vector<Template>* _tp, int _template_id)
+    : class_id(_class_id), tp(_tp), template_id(_template_id) {}
+
+  const String* class_id;
+  const std::vector<Template>* tp;
+  int template_id;
+};
+
+class MatchInvoker : public ParallelLoopBody
+{
+public:
+  MatchInvoker(const std::vector<MatchJob>& _jobs,
+               const std::vector< std::vector< std::vector<Mat> > >& _lm_pyramid,
+               const std::vector<Size>& _sizes, const std::vector<int>& _T_at_level,
+               size_t _num_modalities, float _threshold, std::vector< std::vector<Match> >& _results)
+    : jobs(_jobs), lm_pyramid(_lm_pyramid), sizes(_sizes), T_at_level(_T_at_level),
+      num_modalities(_num_modalities), threshold(_threshold), results(_results) {}
+
+  virtual void operator()(const Range& range) const
+  {
+    MatchBuffers buffers(num_modalities);
+    for (int i = range.start; i < range.end; ++i)
+    {
+      const MatchJob& job = jobs[i];
+      matchTemplatePyramid(lm_pyramid, sizes, T_at_level, threshold, *job.class_id, job.template_id,
+                           *job.tp, buffers, results[i]);
+    }
+  }
+
+private:
+  const std::vector<MatchJob>& jobs;
+  const std::vector< std::vector< std::vector<Mat> > >& lm_pyramid;
+  const std::vector<Size>& sizes;
+  const std::vector<int>& T_at_level;
+  size_t num_modalities;
+  float threshold;
+  std::vector< std::vector<Match> >& results;
+};
+
 /****************************************************************************************\
 *                               High-level Detector API                                  *
 \****************************************************************************************/
@@ -1446,12 +1667,15 @@ void Detector::match(const std::vector<Mat>& sources, float threshold, std::vect
     sizes.push_back(quantized.size());
   }
 
+  // Collect the templates of all requested classes, they are matched in parallel
+  std::vector<MatchJob> jobs;
   if (class_ids.empty())
   {
     // Match all templates
     TemplatesMap::const_iterator it = class_templates.begin(), itend = class_templates.end();
     for ( ; it != itend; ++it)
-      matchClass(lm_pyramid, sizes, threshold, matches, it->first, it->second);
+      for (size_t j = 0; j < it->second.size(); ++j)
+        jobs.push_back(MatchJob(&it->first, &it->second[j], static_cast<int>(j)));
   }
   else
   {
@@ -1460,150 +1684,35 @@ void Detector::match(const std::vector<Mat>& sources, float threshold, std::vect
     {
       TemplatesMap::const_iterator it = class_templates.find(class_ids[i]);
       if (it != class_templates.end())
-        matchClass(lm_pyramid, sizes, threshold, matches, it->first, it->second);
+        for (size_t j = 0; j < it->second.size(); ++j)
+          jobs.push_back(MatchJob(&it->first, &it->second[j], static_cast<int>(j)));
     }
   }
 
+  std::vector< std::vector<Match> > results(jobs.size());
+  parallel_for_(Range(0, static_cast<int>(jobs.size())),
+                MatchInvoker(jobs, lm_pyramid, sizes, T_at_level, modalities.size(), threshold, results));
+
+  // Merge in the order of the templates, so the result does not depend on the scheduling
+  for (size_t i = 0; i < results.size(); ++i)
+    matches.insert(matches.end(), results[i].begin(), results[i].end());
+
   // Sort matches by similarity, and prune any duplicates introduced by pyramid refinement
   std::sort(matches.begin(), matches.end());
   std::vector<Match>::iterator new_end = std::unique(matches.begin(), matches.end());
   matches.erase(new_end, matches.end());
 }
 
-// Used to filter out weak matches
-struct MatchPredicate
-{
-  MatchPredicate(float _threshold) : threshold(_threshold) {}
-  bool operator() (const Match& m) { return m.similarity < threshold; }
-  float threshold;
-};
-
 void Detector::matchClass(const LinearMemoryPyramid& lm_pyramid,
                           const std::vector<Size>& sizes,
                           float threshold, std::vector<Match>& matches,
                           const String& class_id,
                           const std::vector<TemplatePyramid>& template_pyramids) const
 {
-  // For each template...
+  MatchBuffers buffers(modalities.size());
   for (size_t template_id = 0; template_id < template_pyramids.size(); ++template_id)
-  {
-    const TemplatePyramid& tp = template_pyramids[template_id];
-
-    // First match over the whole image at the lowest pyramid level
-    /// @todo Factor this out into separate function
-    const std::vector<LinearMemories>& lowest_lm = lm_pyramid.back();
-
-    // Compute similarity maps for each modality at lowest pyramid level
-    std::vector<Mat> similarities(modalities.size());
-    int lowest_start = static_cast<int>(tp.size() - modalities.size());
-    int lowest_T = T_at_level.back();
-    int num_features = 0;
-    for (int i = 0; i < (int)modalities.size(); ++i)
-    {
-      const Template& templ = tp[lowest_start + i];
-      num_features += static_cast<int>(templ.features.size());
-      similarity(lowest_lm[i], templ, similarities[i], sizes.back(), lowest_T);
-    }
-
-    // Combine into overall similarity
-    /// @todo Support weighting the modalities
-    Mat total_similarity;
-    addSimilarities(similarities, total_similarity);
-
-    // Convert user-friendly percentage to raw similarity threshold. The percentage
-    // threshold scales from half the max response (what you would expect from applying
-    // the template to a completely random image) to the max response.
-    // NOTE: This assumes max per-feature response is 4, so we scale between [2*nf, 4*nf].
-    int raw_threshold = static_cast<int>(2*num_features + (threshold / 100.f) * (2*num_features) + 0.5f);
-
-    // Find initial matches
-    std::vector<Match> candidates;
-    for (int r = 0; r < total_similarity.rows; ++r)
-    {
-      ushort* row = total_similarity.ptr<ushort>(r);
-      for (int c = 0; c < total_similarity.cols; ++c)
-      {
-        int raw_score = row[c];
-        if (raw_score > raw_threshold)
-        {
-          int offset = lowest_T / 2 + (lowest_T % 2 - 1);
-          int x = c * lowest_T + offset;
-          int y = r * lowest_T + offset;
-          float score =(raw_score * 100.f) / (4 * num_features) + 0.5f;
-          candidates.push_back(Match(x, y, score, class_id, static_cast<int>(template_id)));
-        }
-      }
-    }
-
-    // Locally refine each match by marching up the pyramid
-    for (int l = pyramid_levels - 2; l >= 0; --l)
-    {
-      const std::vector<LinearMemories>& lms = lm_pyramid[l];
-      int T = T_at_level[l];
-      int start = static_cast<int>(l * modalities.size());
-      Size size = sizes[l];
-      int border = 8 * T;
-      int offset = T / 2 + (T % 2 - 1);
-      int max_x = size.width - tp[start].width - border;
-      int max_y = size.height - tp[start].height - border;
-
-      std::vector<Mat> similarities2(modalities.size());
-      Mat total_similarity2;
-      for (int m = 0; m < (int)candidates.size(); ++m)
-      {
-        Match& match2 = candidates[m];
-        int x = match2.x * 2 + 1; /// @todo Support other pyramid distance
-        int y = match2.y * 2 + 1;
-
-        // Require 8 (reduced) row/cols to the up/left
-        x = std::max(x, border);
-        y = std::max(y, border);
-
-        // Require 8 (reduced) row/cols to the down/left, plus the template size
-        x = std::min(x, max_x);
-        y = std::min(y, max_y);
-
-        // Compute local similarity maps for each modality
-        int numFeatures = 0;
-        for (int i = 0; i < (int)modalities.size(); ++i)
-        {
-          const Template& templ = tp[start + i];
-          numFeatures += static_cast<int>(templ.features.size());
-          similarityLocal(lms[i], templ, similarities2[i], size, T, Point(x, y));
-        }
-        addSimilarities(similarities2, total_similarity2);
-
-        // Find best local adjustment
-        int best_score = 0;
-        int best_r = -1, best_c = -1;
-        for (int r = 0; r < total_similarity2.rows; ++r)
-        {
-          ushort* row = total_similarity2.ptr<ushort>(r);
-          for (int c = 0; c < total_similarity2.cols; ++c)
-          {
-            int score = row[c];
-            if (score > best_score)
-            {
-              best_score = score;
-              best_r = r;
-              best_c = c;
-            }
-          }
-        }
-        // Update current match
-        match2.x = (x / T - 8 + best_c) * T + offset;
-        match2.y = (y / T - 8 + best_r) * T + offset;
-        match2.similarity = (best_score * 100.f) / (4 * numFeatures);
-      }
-
-      // Filter out any matches that drop below the similarity threshold
-      std::vector<Match>::iterator new_end = std::remove_if(candidates.begin(), candidates.end(),
-                                                            MatchPredicate(threshold));
-      candidates.erase(new_end, candidates.end());
-    }
-
-    matches.insert(matches.end(), candidates.begin(), candidates.end());
-  }
+    matchTemplatePyramid(lm_pyramid, sizes, T_at_level, threshold, class_id, static_cast<int>(template_id),
+                         template_pyramids[template_id], buffers, matches);
 }
 
 int Detector::addTemplate(const std::vector<Mat>& sources, const String& class_id,
@@ -1822,6 +1931,187 @@ void Detector::writeClasses(const String& format) const
   }
 }
 
+// Binary template file: "LMTB" tag, version, modality count and names, pyramid levels, class count,
+// then for each class its id, template pyramid count and for each template its header followed by
+// all its features as one linear array of (x, y, label) int triplets. Strings are stored as their
+// length followed by the characters.
+static const char LINEMOD_BINARY_TAG[4] = {'L', 'M', 'T', 'B'};
+static const int LINEMOD_BINARY_VERSION = 2;
+
+static inline void writeInt(std::ofstream& file, int value)
+{
+  file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static inline int readInt(std::ifstream& file)
+{
+  int value = 0;
+  file.read(reinterpret_cast<char*>(&value), sizeof(value));
+  if (!file.good())
+    CV_Error(Error::StsParseError, "Unexpected end of the binary template file");
+  return value;
+}
+
+static inline void writeString(std::ofstream& file, const String& value)
+{
+  writeInt(file, static_cast<int>(value.size()));
+  file.write(value.c_str(), value.size());
+}
+
+/**
+ * \brief Read a count and check it against the bytes left in the file.
+ *
+ * \param item_size Minimal number of bytes each counted item occupies in the file.
+ */
+static int readCount(std::ifstream& file, std::streamoff file_size, std::streamoff item_size)
+{
+  int count = readInt(file);
+  std::streamoff remaining = file_size - static_cast<std::streamoff>(file.tellg());
+  if (count < 0 || static_cast<std::streamoff>(count) * item_size > remaining)
+    CV_Error(Error::StsParseError, "Corrupted count in the binary template file");
+  return count;
+}
+
+static String readString(std::ifstream& file, std::streamoff file_size)
+{
+  int length = readCount(file, file_size, 1);
+  std::vector<char> chars(length + 1, '\0');
+  if (length > 0)
+    file.read(&chars[0], length);
+  if (!file.good())
+    CV_Error(Error::StsParseError, "Unexpected end of the binary template file");
+  return String(&chars[0], length);
+}
+
+void Detector::writeTemplatesBinary(const String& filename) const
+{
+  std::ofstream file(filename.c_str(), std::ofstream::binary);
+  if (!file.good())
+    CV_Error(Error::StsError, "Can not open the binary template file for writing: " + filename);
+
+  file.write(LINEMOD_BINARY_TAG, sizeof(LINEMOD_BINARY_TAG));
+  writeInt(file, LINEMOD_BINARY_VERSION);
+  writeInt(file, static_cast<int>(modalities.size()));
+  for (size_t i = 0; i < modalities.size(); ++i)
+    writeString(file, modalities[i]->name());
+  writeInt(file, pyramid_levels);
+  writeInt(file, static_cast<int>(class_templates.size()));
+
+  std::vector<int> linear_features;
+  TemplatesMap::const_iterator it = class_templates.begin(), it_end = class_templates.end();
+  for ( ; it != it_end; ++it)
+  {
+    writeString(file, it->first);
+
+    const std::vector<TemplatePyramid>& tps = it->second;
+    writeInt(file, static_cast<int>(tps.size()));
+    for (size_t i = 0; i < tps.size(); ++i)
+    {
+      const TemplatePyramid& tp = tps[i];
+      writeInt(file, static_cast<int>(tp.size()));
+      for (size_t j = 0; j < tp.size(); ++j)
+      {
+        const Template& templ = tp[j];
+        writeInt(file, templ.width);
+        writeInt(file, templ.height);
+        writeInt(file, templ.pyramid_level);
+        writeInt(file, static_cast<int>(templ.features.size()));
+
+        linear_features.resize(templ.features.size() * 3);
+        for (size_t k = 0; k < templ.features.size(); ++k)
+        {
+          linear_features[3*k]     = templ.features[k].x;
+          linear_features[3*k + 1] = templ.features[k].y;
+          linear_features[3*k + 2] = templ.features[k].label;
+        }
+        if (!linear_features.empty())
+          file.write(reinterpret_cast<const char*>(&linear_features[0]), linear_features.size() * sizeof(int));
+      }
+    }
+  }
+
+  if (!file.good())
+    CV_Error(Error::StsError, "Can not write the binary template file: " + filename);
+}
+
+void Detector::readTemplatesBinary(const String& filename)
+{
+  std::ifstream file(filename.c_str(), std::ifstream::binary);
+  if (!file.good())
+    CV_Error(Error::StsError, "Can not open the binary template file: " + filename);
+  file.seekg(0, std::ifstream::end);
+  std::streamoff file_size = file.tellg();
+  file.seekg(0, std::ifstream::beg);
+
+  char tag[sizeof(LINEMOD_BINARY_TAG)];
+  file.read(tag, sizeof(tag));
+  if (!file.good() || memcmp(tag, LINEMOD_BINARY_TAG, sizeof(tag)) != 0)
+    CV_Error(Error::StsParseError, "Wrong tag of the binary template file: " + filename);
+  if (readInt(file) != LINEMOD_BINARY_VERSION)
+    CV_Error(Error::StsParseError, "Unsupported version of the binary template file: " + filename);
+
+  // Verify compatible with Detector settings
+  CV_Assert(readInt(file) == static_cast<int>(modalities.size()));
+  for (size_t i = 0; i < modalities.size(); ++i)
+    CV_Assert(readString(file, file_size) == modalities[i]->name());
+  CV_Assert(readInt(file) == pyramid_levels);
+  const int templates_per_pyramid = static_cast<int>(modalities.size()) * pyramid_levels;
+
+  // Minimal sizes of the records following each count: class id and pyramid count, template
+  // count, template header, one feature
+  const std::streamoff class_size = 2 * sizeof(int), pyramid_size = sizeof(int);
+  const std::streamoff template_size = 4 * sizeof(int), feature_size = 3 * sizeof(int);
+
+  // Read everything before touching the detector, so a corrupted file leaves it unchanged
+  TemplatesMap classes;
+  int num_classes = readCount(file, file_size, class_size);
+  std::vector<int> linear_features;
+  for (int c = 0; c < num_classes; ++c)
+  {
+    String class_id = readString(file, file_size);
+
+    // Detector should not already have this class
+    CV_Assert(class_templates.find(class_id) == class_templates.end() &&
+              classes.find(class_id) == classes.end());
+    std::vector<TemplatePyramid>& tps = classes[class_id];
+
+    tps.resize(readCount(file, file_size, pyramid_size));
+    for (size_t i = 0; i < tps.size(); ++i)
+    {
+      TemplatePyramid& tp = tps[i];
+      int num_templates = readCount(file, file_size, template_size);
+      CV_Assert(num_templates == templates_per_pyramid);
+      tp.resize(num_templates);
+      for (size_t j = 0; j < tp.size(); ++j)
+      {
+        Template& templ = tp[j];
+        templ.width = readInt(file);
+        templ.height = readInt(file);
+        templ.pyramid_level = readInt(file);
+        CV_Assert(templ.width >= 0 && templ.height >= 0);
+        CV_Assert(templ.pyramid_level >= 0 && templ.pyramid_level < pyramid_levels);
+        int num_features = readCount(file, file_size, feature_size);
+
+        templ.features.resize(num_features);
+        linear_features.resize(num_features * 3);
+        if (num_features > 0)
+          file.read(reinterpret_cast<char*>(&linear_features[0]), linear_features.size() * sizeof(int));
+        if (!file.good())
+          CV_Error(Error::StsParseError, "Unexpected end of the binary template file: " + filename);
+        for (int k = 0; k < num_features; ++k)
+        {
+          // Features are relative to the template origin and labels index the 8 response maps
+          CV_Assert(linear_features[3*k] >= 0 && linear_features[3*k + 1] >= 0);
+          CV_Assert(linear_features[3*k + 2] >= 0 && linear_features[3*k + 2] < 8);
+          templ.features[k] = Feature(linear_features[3*k], linear_features[3*k + 1], linear_features[3*k + 2]);
+        }
+      }
+    }
+  }
+
+  class_templates.insert(classes.begin(), classes.end());
+}
+
 static const int T_DEFAULTS[] = {5, 8};
 
 Ptr<Detector> getDefaultLINE()
@@ -1401,6 +1401,66 @@ bool RgbdICPOdometry::computeImpl(const Ptr<OdometryFrame>& srcFrame, const Ptr<
     return RGBDICPOdometryImpl(Rt, initRt, srcFrame, dstFrame, cameraMatrix, (float)maxDepthDiff, iterCounts,  maxTranslation, maxRotation, MERGED_ODOMETRY, transformType);
 }
 
+//
+OdometryStream::OdometryStream(const Ptr<Odometry>& _odometry, int historySize) :
+    odometry(_odometry), frames(std::max(historySize, 2)), head(-1), frameCount(0)
+{
+    if(odometry.empty())
+        CV_Error(Error::StsBadArg, "Null odometry pointer.");
+
+    reset();
+}
+
+void OdometryStream::reset()
+{
+    for(size_t i = 0; i < frames.size(); i++)
+        frames[i].release();
+    head = -1;
+    frameCount = 0;
+    pose = Mat::eye(4,4,CV_64FC1);
+}
+
+Ptr<OdometryFrame> OdometryStream::getFrame(int age) const
+{
+    if(age < 0 || age >= std::min(frameCount, (int)frames.size()))
+        return Ptr<OdometryFrame>();
+
+    int ringSize = (int)frames.size();
+    return frames[(head - age + ringSize) % ringSize];
+}
+
+bool OdometryStream::process(const Mat& image, const Mat& depth, const Mat& mask, Mat& Rt)
+{
+    Ptr<OdometryFrame> frame(new OdometryFrame(image, depth, mask, Mat(), frameCount));
+    return process(frame, Rt);
+}
+
+bool OdometryStream::process(Ptr<OdometryFrame>& frame, Mat& Rt)
+{
+    // The frame is the source now and it will be the destination for the next one,
+    // so all its cache data is computed here. Odometry::compute only checks it later.
+    odometry->prepareFrameCache(frame, OdometryFrame::CACHE_ALL);
+
+    bool isComputed = true;
+    Ptr<OdometryFrame> prevFrame = getFrame(0);
+    if(prevFrame.empty())
+        Rt = Mat::eye(4,4,CV_64FC1);
+    else
+    {
+        isComputed = odometry->compute(frame, prevFrame, Rt);
+        if(isComputed)
+            pose = pose * Rt;
+        else
+            Rt = Mat::eye(4,4,CV_64FC1);
+    }
+
+    head = (head + 1) % (int)frames.size();
+    frames[head] = frame;
+    frameCount++;
+
+    return isComputed;
+}
+
 //
 
 void
@@ -49,6 +49,7 @@
 #include "opencv2/core/utility.hpp"
 #include "opencv2/core/private.hpp"
 #include <iostream>
+#include <fstream>
 #include <list>
 #include <set>
 #include <limits>
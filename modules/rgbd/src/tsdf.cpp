@@ -0,0 +1,547 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                          License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Copyright (C) 2014, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "precomp.hpp"
+
+namespace cv
+{
+namespace rgbd
+{
+
+struct TSDFVoxel
+{
+    float tsdf;
+    float weight;
+};
+
+/** Open addressing hash table from the block coordinates to the block index.
+ * Block indices are dense, so the voxels of all blocks are stored in one array.
+ */
+class VoxelBlockHash
+{
+public:
+    VoxelBlockHash()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        slots.assign(1 << 12, -1);
+        coords.clear();
+    }
+
+    int size() const
+    {
+        return (int)coords.size();
+    }
+
+    const Vec3i& operator[](int idx) const
+    {
+        return coords[idx];
+    }
+
+    /** Returns the block index or -1. It can be called concurrently if there are no insertions. */
+    int find(const Vec3i& c) const
+    {
+        const size_t mask = slots.size() - 1;
+        for(size_t i = hash(c) & mask; ; i = (i + 1) & mask)
+        {
+            int idx = slots[i];
+            if(idx < 0 || coords[idx] == c)
+                return idx;
+        }
+    }
+
+    /** Returns the index of the existing or of the newly allocated block. */
+    int insert(const Vec3i& c)
+    {
+        if(2 * (coords.size() + 1) > slots.size())
+            rehash(2 * slots.size());
+
+        const size_t mask = slots.size() - 1;
+        size_t i = hash(c) & mask;
+        for(; slots[i] >= 0; i = (i + 1) & mask)
+        {
+            if(coords[slots[i]] == c)
+                return slots[i];
+        }
+        slots[i] = (int)coords.size();
+        coords.push_back(c);
+        return slots[i];
+    }
+
+private:
+    static size_t hash(const Vec3i& c)
+    {
+        return (size_t)(((unsigned)c[0] * 73856093u) ^ ((unsigned)c[1] * 19349669u) ^ ((unsigned)c[2] * 83492791u));
+    }
+
+    void rehash(size_t slotCount)
+    {
+        slots.assign(slotCount, -1);
+        const size_t mask = slotCount - 1;
+        for(size_t idx = 0; idx < coords.size(); idx++)
+        {
+            size_t i = hash(coords[idx]) & mask;
+            while(slots[i] >= 0)
+                i = (i + 1) & mask;
+            slots[i] = (int)idx;
+        }
+    }
+
+    std::vector<int> slots;
+    std::vector<Vec3i> coords;
+};
+
+static inline
+int floorDiv(int a, int b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+class TSDFVolumeImpl : public TSDFVolume
+{
+public:
+    TSDFVolumeImpl(float voxelSize, float truncDist, int maxWeight, int blockSize);
+
+    virtual void
+    integrate(const Mat& depth, const Mat& cameraMatrix, const Mat& cameraPose);
+
+    virtual void
+    raycast(const Mat& cameraPose, const Mat& cameraMatrix, const Size& frameSize, Mat& points, Mat& normals) const;
+
+    virtual void
+    fetchCloud(Mat& points, Mat* normals) const;
+
+    virtual void
+    reset();
+
+    virtual int getBlockCount() const { return blocks.size(); }
+
+    virtual double getVoxelSize() const { return voxelSize; }
+    virtual double getTruncDist() const { return truncDist; }
+    virtual int getBlockSize() const { return blockSize; }
+    virtual int getMaxWeight() const { return maxWeight; }
+    virtual void setMaxWeight(int val) { CV_Assert(val > 0); maxWeight = val; }
+    virtual double getMinDepth() const { return minDepth; }
+    virtual void setMinDepth(double val) { minDepth = val; }
+    virtual double getMaxDepth() const { return maxDepth; }
+    virtual void setMaxDepth(double val) { maxDepth = val; }
+
+    /** Returns the voxel with the given integer coordinates or null if its block is not allocated. */
+    inline const TSDFVoxel*
+    findVoxel(int x, int y, int z) const
+    {
+        Vec3i b(floorDiv(x, blockSize), floorDiv(y, blockSize), floorDiv(z, blockSize));
+        int idx = blocks.find(b);
+        if(idx < 0)
+            return 0;
+        x -= b[0] * blockSize; y -= b[1] * blockSize; z -= b[2] * blockSize;
+        return &voxels[(size_t)idx * blockVolume + (z * blockSize + y) * blockSize + x];
+    }
+
+    /** Trilinear interpolation of the TSDF at the point given in voxel units.
+     * Returns false if some of 8 neighbour voxels was never observed.
+     */
+    bool
+    interpolate(const Point3f& p, float& value) const;
+
+    /** Normalized gradient of the TSDF at the point given in voxel units. */
+    bool
+    gradient(const Point3f& p, Point3f& n) const;
+
+    float voxelSize, truncDist;
+    int maxWeight;
+    int blockSize, blockVolume;
+    double minDepth, maxDepth;
+
+    VoxelBlockHash blocks;
+    std::vector<TSDFVoxel> voxels;
+};
+
+TSDFVolumeImpl::TSDFVolumeImpl(float _voxelSize, float _truncDist, int _maxWeight, int _blockSize) :
+    voxelSize(_voxelSize), truncDist(_truncDist), maxWeight(_maxWeight),
+    blockSize(_blockSize), blockVolume(_blockSize * _blockSize * _blockSize),
+    minDepth(Odometry::DEFAULT_MIN_DEPTH()), maxDepth(Odometry::DEFAULT_MAX_DEPTH())
+{
+    CV_Assert(voxelSize > 0.f && truncDist >= voxelSize);
+    CV_Assert(maxWeight > 0 && blockSize > 0);
+}
+
+void TSDFVolumeImpl::reset()
+{
+    blocks.clear();
+    voxels.clear();
+}
+
+bool TSDFVolumeImpl::interpolate(const Point3f& p, float& value) const
+{
+    int x0 = cvFloor(p.x), y0 = cvFloor(p.y), z0 = cvFloor(p.z);
+    float tx = p.x - x0, ty = p.y - y0, tz = p.z - z0;
+
+    float v[8];
+    for(int i = 0; i < 8; i++)
+    {
+        const TSDFVoxel* voxel = findVoxel(x0 + (i & 1), y0 + ((i >> 1) & 1), z0 + (i >> 2));
+        if(!voxel || voxel->weight <= 0.f)
+            return false;
+        v[i] = voxel->tsdf;
+    }
+
+    float vy0 = (v[0] + tx * (v[1] - v[0])) + ty * ((v[2] + tx * (v[3] - v[2])) - (v[0] + tx * (v[1] - v[0])));
+    float vy1 = (v[4] + tx * (v[5] - v[4])) + ty * ((v[6] + tx * (v[7] - v[6])) - (v[4] + tx * (v[5] - v[4])));
+    value = vy0 + tz * (vy1 - vy0);
+    return true;
+}
+
+bool TSDFVolumeImpl::gradient(const Point3f& p, Point3f& n) const
+{
+    const float h = 0.5f;
+    float fx0, fx1, fy0, fy1, fz0, fz1;
+    if(!interpolate(Point3f(p.x - h, p.y, p.z), fx0) || !interpolate(Point3f(p.x + h, p.y, p.z), fx1) ||
+       !interpolate(Point3f(p.x, p.y - h, p.z), fy0) || !interpolate(Point3f(p.x, p.y + h, p.z), fy1) ||
+       !interpolate(Point3f(p.x, p.y, p.z - h), fz0) || !interpolate(Point3f(p.x, p.y, p.z + h), fz1))
+        return false;
+
+    n = Point3f(fx1 - fx0, fy1 - fy0, fz1 - fz0);
+    double nrm = norm(n);
+    if(nrm < FLT_EPSILON)
+        return false;
+    n *= 1./nrm;
+    return true;
+}
+
+static
+void getCameraParams(const Mat& cameraMatrix, double& fx, double& fy, double& cx, double& cy)
+{
+    CV_Assert(cameraMatrix.size() == Size(3,3) && (cameraMatrix.type() == CV_32FC1 || cameraMatrix.type() == CV_64FC1));
+    Mat K;
+    cameraMatrix.convertTo(K, CV_64FC1);
+    fx = K.at<double>(0,0);
+    fy = K.at<double>(1,1);
+    cx = K.at<double>(0,2);
+    cy = K.at<double>(1,2);
+}
+
+static
+Matx44d getPose(const Mat& cameraPose)
+{
+    CV_Assert(cameraPose.size() == Size(4,4) && (cameraPose.type() == CV_32FC1 || cameraPose.type() == CV_64FC1));
+    Mat pose;
+    cameraPose.convertTo(pose, CV_64FC1);
+    return Matx44d((const double*)pose.data);
+}
+
+static inline
+Point3f transformPoint(const Matx44d& Rt, const Point3f& p)
+{
+    return Point3f((float)(Rt(0,0) * p.x + Rt(0,1) * p.y + Rt(0,2) * p.z + Rt(0,3)),
+                   (float)(Rt(1,0) * p.x + Rt(1,1) * p.y + Rt(1,2) * p.z + Rt(1,3)),
+                   (float)(Rt(2,0) * p.x + Rt(2,1) * p.y + Rt(2,2) * p.z + Rt(2,3)));
+}
+
+static inline
+Point3f rotateVector(const Matx44d& Rt, const Point3f& v)
+{
+    return Point3f((float)(Rt(0,0) * v.x + Rt(0,1) * v.y + Rt(0,2) * v.z),
+                   (float)(Rt(1,0) * v.x + Rt(1,1) * v.y + Rt(1,2) * v.z),
+                   (float)(Rt(2,0) * v.x + Rt(2,1) * v.y + Rt(2,2) * v.z));
+}
+
+/** Updates the voxels of the blocks that are visible in the depth frame, each block is processed by one thread only.
+ */
+class TSDFIntegrateInvoker : public ParallelLoopBody
+{
+public:
+    TSDFIntegrateInvoker(TSDFVolumeImpl& _volume, const std::vector<int>& _visibleBlocks, const Mat& _depth,
+                         const Matx44d& _volumeToCamera, double _fx, double _fy, double _cx, double _cy) :
+        volume(_volume), visibleBlocks(_visibleBlocks), depth(_depth), volumeToCamera(_volumeToCamera),
+        fx(_fx), fy(_fy), cx(_cx), cy(_cy) {}
+
+    virtual void operator()(const Range& range) const
+    {
+        const int blockSize = volume.blockSize;
+        const float voxelSize = volume.voxelSize;
+        const float truncDist = volume.truncDist;
+        const float maxWeight = (float)volume.maxWeight;
+        const float minDepth = (float)volume.minDepth, maxDepth = (float)volume.maxDepth;
+
+        for(int i = range.start; i < range.end; i++)
+        {
+            int idx = visibleBlocks[i];
+            const Vec3i& b = volume.blocks[idx];
+            TSDFVoxel* voxel = &volume.voxels[(size_t)idx * volume.blockVolume];
+
+            for(int z = 0; z < blockSize; z++)
+                for(int y = 0; y < blockSize; y++)
+                    for(int x = 0; x < blockSize; x++, voxel++)
+                    {
+                        Point3f pv((b[0] * blockSize + x) * voxelSize,
+                                   (b[1] * blockSize + y) * voxelSize,
+                                   (b[2] * blockSize + z) * voxelSize);
+                        Point3f pc = transformPoint(volumeToCamera, pv);
+                        if(pc.z <= 0.f)
+                            continue;
+
+                        int u = cvRound(fx * pc.x / pc.z + cx);
+                        int v = cvRound(fy * pc.y / pc.z + cy);
+                        if(u < 0 || v < 0 || u >= depth.cols || v >= depth.rows)
+                            continue;
+
+                        float d = depth.at<float>(v, u);
+                        if(cvIsNaN(d) || d <= minDepth || d >= maxDepth)
+                            continue;
+
+                        float sdf = d - pc.z;
+                        if(sdf < -truncDist)
+                            continue;
+
+                        float tsdf = std::min(1.f, sdf / truncDist);
+                        voxel->tsdf = (voxel->tsdf * voxel->weight + tsdf) / (voxel->weight + 1.f);
+                        voxel->weight = std::min(voxel->weight + 1.f, maxWeight);
+                    }
+        }
+    }
+
+private:
+    TSDFVolumeImpl& volume;
+    const std::vector<int>& visibleBlocks;
+    const Mat& depth;
+    Matx44d volumeToCamera;
+    double fx, fy, cx, cy;
+};
+
+void TSDFVolumeImpl::integrate(const Mat& depth, const Mat& cameraMatrix, const Mat& cameraPose)
+{
+    if(depth.empty() || depth.type() != CV_32FC1)
+        CV_Error(Error::StsBadSize, "Depth type has to be CV_32FC1.");
+
+    double fx, fy, cx, cy;
+    getCameraParams(cameraMatrix, fx, fy, cx, cy);
+    const Matx44d cameraToVolume = getPose(cameraPose);
+    const Matx44d volumeToCamera = cameraToVolume.inv();
+
+    // Allocate the blocks along the truncation band of each ray. The hash table is not thread-safe for insertions,
+    // so it is done serially; the blocks that are seen in this frame are collected for the parallel update.
+    const float blockEdge = voxelSize * blockSize;
+    const float blockEdge_inv = 1.f / blockEdge;
+    const float step = 0.5f * blockEdge;
+    std::vector<uchar> isVisible(blocks.size(), 0);
+    std::vector<int> visibleBlocks;
+    for(int v = 0; v < depth.rows; v++)
+    {
+        const float* depth_row = depth.ptr<float>(v);
+        for(int u = 0; u < depth.cols; u++)
+        {
+            float d = depth_row[u];
+            if(cvIsNaN(d) || d <= minDepth || d >= maxDepth)
+                continue;
+
+            Point3f ray((float)((u - cx) / fx), (float)((v - cy) / fy), 1.f);
+            for(float z = std::max(d - truncDist, (float)minDepth); z <= d + truncDist + step; z += step)
+            {
+                Point3f pv = transformPoint(cameraToVolume, ray * std::min(z, d + truncDist));
+                Vec3i b(cvFloor(pv.x * blockEdge_inv), cvFloor(pv.y * blockEdge_inv), cvFloor(pv.z * blockEdge_inv));
+                int idx = blocks.insert(b);
+                if(idx >= (int)isVisible.size())
+                {
+                    TSDFVoxel emptyVoxel = {0.f, 0.f};
+                    voxels.resize((size_t)(idx + 1) * blockVolume, emptyVoxel);
+                    isVisible.resize(idx + 1, 0);
+                }
+                if(!isVisible[idx])
+                {
+                    isVisible[idx] = 1;
+                    visibleBlocks.push_back(idx);
+                }
+            }
+        }
+    }
+
+    parallel_for_(Range(0, (int)visibleBlocks.size()),
+                  TSDFIntegrateInvoker(*this, visibleBlocks, depth, volumeToCamera, fx, fy, cx, cy));
+}
+
+/** Casts a ray per pixel, the volume is only read so the rows are processed in parallel.
+ */
+class TSDFRaycastInvoker : public ParallelLoopBody
+{
+public:
+    TSDFRaycastInvoker(const TSDFVolumeImpl& _volume, const Matx44d& _cameraToVolume,
+                       double _fx, double _fy, double _cx, double _cy, Mat& _points, Mat& _normals) :
+        volume(_volume), cameraToVolume(_cameraToVolume), fx(_fx), fy(_fy), cx(_cx), cy(_cy),
+        points(_points), normals(_normals) {}
+
+    virtual void operator()(const Range& range) const
+    {
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const float voxelSize_inv = 1.f / volume.voxelSize;
+        const float truncDist = volume.truncDist;
+        const float minDepth = std::max((float)volume.minDepth, volume.voxelSize);
+        const float maxDepth = (float)volume.maxDepth;
+        const Point3f origin((float)cameraToVolume(0,3), (float)cameraToVolume(1,3), (float)cameraToVolume(2,3));
+        const Matx44d volumeToCamera = cameraToVolume.inv();
+
+        for(int v = range.start; v < range.end; v++)
+        {
+            Point3f* points_row = points.ptr<Point3f>(v);
+            Point3f* normals_row = normals.ptr<Point3f>(v);
+            for(int u = 0; u < points.cols; u++)
+            {
+                points_row[u] = normals_row[u] = Point3f(nan, nan, nan);
+
+                // z of the camera ray is 1, so the ray parameter is the depth of the point
+                Point3f rayCamera((float)((u - cx) / fx), (float)((v - cy) / fy), 1.f);
+                Point3f ray = rotateVector(cameraToVolume, rayCamera);
+                const float rayLength = (float)norm(ray);
+
+                float z = minDepth, prevZ = z, prevValue = 0.f;
+                bool hasPrev = false;
+                while(z < maxDepth)
+                {
+                    Point3f pv = (origin + ray * z) * voxelSize_inv;
+                    float value;
+                    if(!volume.interpolate(pv, value))
+                    {
+                        hasPrev = false;
+                        prevZ = z;
+                        z += 0.5f * truncDist / rayLength;
+                        continue;
+                    }
+
+                    if(hasPrev && prevValue > 0.f && value <= 0.f)
+                    {
+                        float zSurface = prevZ + (z - prevZ) * prevValue / (prevValue - value);
+                        Point3f ps = origin + ray * zSurface;
+                        Point3f n;
+                        if(volume.gradient(ps * voxelSize_inv, n))
+                        {
+                            points_row[u] = rayCamera * zSurface;
+                            normals_row[u] = rotateVector(volumeToCamera, n);
+                        }
+                        break;
+                    }
+                    if(hasPrev && prevValue < 0.f && value > 0.f)
+                        break; // back side of a surface
+
+                    hasPrev = true;
+                    prevValue = value;
+                    prevZ = z;
+                    z += std::max(volume.voxelSize, 0.8f * value * truncDist) / rayLength;
+                }
+            }
+        }
+    }
+
+private:
+    const TSDFVolumeImpl& volume;
+    Matx44d cameraToVolume;
+    double fx, fy, cx, cy;
+    Mat& points;
+    Mat& normals;
+};
+
+void TSDFVolumeImpl::raycast(const Mat& cameraPose, const Mat& cameraMatrix, const Size& frameSize,
+                             Mat& points, Mat& normals) const
+{
+    double fx, fy, cx, cy;
+    getCameraParams(cameraMatrix, fx, fy, cx, cy);
+
+    points.create(frameSize, CV_32FC3);
+    normals.create(frameSize, CV_32FC3);
+
+    parallel_for_(Range(0, frameSize.height),
+                  TSDFRaycastInvoker(*this, getPose(cameraPose), fx, fy, cx, cy, points, normals));
+}
+
+void TSDFVolumeImpl::fetchCloud(Mat& points, Mat* normals) const
+{
+    std::vector<Point3f> cloud, cloudNormals;
+
+    for(int idx = 0; idx < blocks.size(); idx++)
+    {
+        const Vec3i& b = blocks[idx];
+        const TSDFVoxel* voxel = &voxels[(size_t)idx * blockVolume];
+        for(int z = 0; z < blockSize; z++)
+            for(int y = 0; y < blockSize; y++)
+                for(int x = 0; x < blockSize; x++, voxel++)
+                {
+                    if(voxel->weight <= 0.f)
+                        continue;
+
+                    // a point is emitted on each edge to the positive neighbours which crosses the zero level
+                    Point3i pv(b[0] * blockSize + x, b[1] * blockSize + y, b[2] * blockSize + z);
+                    for(int axis = 0; axis < 3; axis++)
+                    {
+                        Point3i pn = pv;
+                        (&pn.x)[axis]++;
+                        const TSDFVoxel* neighbour = findVoxel(pn.x, pn.y, pn.z);
+                        if(!neighbour || neighbour->weight <= 0.f || (voxel->tsdf > 0.f) == (neighbour->tsdf > 0.f))
+                            continue;
+
+                        Point3f ps((float)pv.x, (float)pv.y, (float)pv.z);
+                        (&ps.x)[axis] += voxel->tsdf / (voxel->tsdf - neighbour->tsdf);
+
+                        Point3f n;
+                        if(normals && !gradient(ps, n))
+                            continue;
+                        cloud.push_back(ps * voxelSize);
+                        if(normals)
+                            cloudNormals.push_back(n);
+                    }
+                }
+    }
+
+    Mat(cloud, true).copyTo(points);
+    if(normals)
+        Mat(cloudNormals, true).copyTo(*normals);
+}
+
+Ptr<TSDFVolume> TSDFVolume::create(float voxelSize, float truncDist, int maxWeight, int blockSize)
+{
+    return makePtr<TSDFVolumeImpl>(voxelSize, truncDist, maxWeight, blockSize);
+}
+
+}
+} // namespace cv
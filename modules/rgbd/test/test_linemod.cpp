@@ -0,0 +1,239 @@
+/*M///////////////////////////////////////////////////////////////////////////////////////
+//
+//  IMPORTANT: READ BEFORE DOWNLOADING, COPYING, INSTALLING OR USING.
+//
+//  By downloading, copying, installing or using the software you agree to this license.
+//  If you do not agree to this license, do not download, install,
+//  copy or use the software.
+//
+//
+//                          License Agreement
+//                For Open Source Computer Vision Library
+//
+// Copyright (C) 2000-2008, Intel Corporation, all rights reserved.
+// Copyright (C) 2009, Willow Garage Inc., all rights reserved.
+// Copyright (C) 2014, OpenCV Foundation, all rights reserved.
+// Third party copyrights are property of their respective owners.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//   * Redistribution's of source code must retain the above copyright notice,
+//     this list of conditions and the following disclaimer.
+//
+//   * Redistribution's in binary form must reproduce the above copyright notice,
+//     this list of conditions and the following disclaimer in the documentation
+//     and/or other materials provided with the distribution.
+//
+//   * The name of the copyright holders may not be used to endorse or promote products
+//     derived from this software without specific prior written permission.
+//
+// This software is provided by the copyright holders and contributors "as is" and
+// any express or implied warranties, including, but not limited to, the implied
+// warranties of merchantability and fitness for a particular purpose are disclaimed.
+// In no event shall the Intel Corporation or contributors be liable for any direct,
+// indirect, incidental, special, exemplary, or consequential damages
+// (including, but not limited to, procurement of substitute goods or services;
+// loss of use, data, or profits; or business interruption) however caused
+// and on any theory of liability, whether in contract, strict liability,
+// or tort (including negligence or otherwise) arising in any way out of
+// the use of this software, even if advised of the possibility of such damage.
+//
+//M*/
+
+#include "test_precomp.hpp"
+#include <opencv2/imgproc.hpp>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+using namespace cv;
+
+namespace
+{
+
+// Gray background with a few filled shapes, each one a separate object class
+Mat makeScene(std::vector<Mat>& object_masks)
+{
+  Mat scene(480, 640, CV_8UC3, Scalar(90, 90, 90));
+  RNG rng(0x4c4d);
+  object_masks.clear();
+  for (int i = 0; i < 4; ++i)
+  {
+    Mat mask = Mat::zeros(scene.size(), CV_8UC1);
+    Point center(100 + 150 * i, 140 + 200 * (i % 2));
+    Scalar color(rng.uniform(0, 255), rng.uniform(0, 255), rng.uniform(0, 255));
+    if (i % 2 == 0)
+    {
+      rectangle(scene, Rect(center.x - 50, center.y - 35, 100, 70), color, -1);
+      circle(scene, center, 25, Scalar(255, 255, 255) - color, -1);
+      rectangle(mask, Rect(center.x - 55, center.y - 40, 110, 80), Scalar(255), -1);
+    }
+    else
+    {
+      circle(scene, center, 55, color, -1);
+      rectangle(scene, Rect(center.x - 20, center.y - 30, 40, 60), Scalar(255, 255, 255) - color, -1);
+      circle(mask, center, 60, Scalar(255), -1);
+    }
+    object_masks.push_back(mask);
+  }
+  return scene;
+}
+
+Ptr<linemod::Detector> makeTrainedDetector(const Mat& scene, const std::vector<Mat>& object_masks)
+{
+  Ptr<linemod::Detector> detector = linemod::getDefaultLINE();
+  std::vector<Mat> sources(1, scene);
+  for (size_t i = 0; i < object_masks.size(); ++i)
+  {
+    String class_id = format("object_%d", (int)i);
+    EXPECT_GE(detector->addTemplate(sources, class_id, object_masks[i]), 0);
+    // A second, shifted template so every class has more than one pyramid to match
+    Mat shifted_scene, shifted_mask;
+    Mat shift = (Mat_<double>(2, 3) << 1, 0, 3, 0, 1, 2);
+    warpAffine(scene, shifted_scene, shift, scene.size());
+    warpAffine(object_masks[i], shifted_mask, shift, scene.size(), INTER_NEAREST);
+    EXPECT_GE(detector->addTemplate(std::vector<Mat>(1, shifted_scene), class_id, shifted_mask), 0);
+  }
+  return detector;
+}
+
+void expectEqualMatches(const std::vector<linemod::Match>& expected, const std::vector<linemod::Match>& actual)
+{
+  ASSERT_EQ(expected.size(), actual.size());
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    EXPECT_EQ(expected[i].x, actual[i].x);
+    EXPECT_EQ(expected[i].y, actual[i].y);
+    EXPECT_EQ(expected[i].similarity, actual[i].similarity);
+    EXPECT_EQ(expected[i].class_id, actual[i].class_id);
+    EXPECT_EQ(expected[i].template_id, actual[i].template_id);
+  }
+}
+
+}
+
+TEST(Rgbd_Linemod, parallel_match_equals_serial)
+{
+  std::vector<Mat> object_masks;
+  Mat scene = makeScene(object_masks);
+  Ptr<linemod::Detector> detector = makeTrainedDetector(scene, object_masks);
+  ASSERT_EQ((int)object_masks.size(), detector->numClasses());
+
+  std::vector<Mat> sources(1, scene);
+  const int nThreads = getNumThreads();
+  std::vector<linemod::Match> parallel_matches, serial_matches;
+
+  setNumThreads(getNumberOfCPUs());
+  detector->match(sources, 80.f, parallel_matches);
+  setNumThreads(1);
+  detector->match(sources, 80.f, serial_matches);
+  setNumThreads(nThreads);
+
+  // Every object is found where it was trained
+  ASSERT_FALSE(serial_matches.empty());
+  EXPECT_GE(serial_matches[0].similarity, 90.f);
+  expectEqualMatches(serial_matches, parallel_matches);
+}
+
+TEST(Rgbd_Linemod, binary_templates_round_trip)
+{
+  std::vector<Mat> object_masks;
+  Mat scene = makeScene(object_masks);
+  Ptr<linemod::Detector> detector = makeTrainedDetector(scene, object_masks);
+  String filename = tempfile(".bin");
+  detector->writeTemplatesBinary(filename);
+
+  Ptr<linemod::Detector> loaded = linemod::getDefaultLINE();
+  loaded->readTemplatesBinary(filename);
+
+  ASSERT_EQ(detector->classIds(), loaded->classIds());
+  std::vector<String> class_ids = detector->classIds();
+  for (size_t c = 0; c < class_ids.size(); ++c)
+  {
+    ASSERT_EQ(detector->numTemplates(class_ids[c]), loaded->numTemplates(class_ids[c]));
+    for (int t = 0; t < detector->numTemplates(class_ids[c]); ++t)
+    {
+      const std::vector<linemod::Template>& expected = detector->getTemplates(class_ids[c], t);
+      const std::vector<linemod::Template>& actual = loaded->getTemplates(class_ids[c], t);
+      ASSERT_EQ(expected.size(), actual.size());
+      for (size_t i = 0; i < expected.size(); ++i)
+      {
+        EXPECT_EQ(expected[i].width, actual[i].width);
+        EXPECT_EQ(expected[i].height, actual[i].height);
+        EXPECT_EQ(expected[i].pyramid_level, actual[i].pyramid_level);
+        ASSERT_EQ(expected[i].features.size(), actual[i].features.size());
+        for (size_t k = 0; k < expected[i].features.size(); ++k)
+        {
+          EXPECT_EQ(expected[i].features[k].x, actual[i].features[k].x);
+          EXPECT_EQ(expected[i].features[k].y, actual[i].features[k].y);
+          EXPECT_EQ(expected[i].features[k].label, actual[i].features[k].label);
+        }
+      }
+    }
+  }
+
+  std::vector<Mat> sources(1, scene);
+  std::vector<linemod::Match> expected_matches, loaded_matches;
+  detector->match(sources, 80.f, expected_matches);
+  loaded->match(sources, 80.f, loaded_matches);
+  expectEqualMatches(expected_matches, loaded_matches);
+
+  // Stored classes can not be read twice into the same detector
+  EXPECT_ANY_THROW(loaded->readTemplatesBinary(filename));
+  // The modalities must match
+  EXPECT_ANY_THROW(linemod::getDefaultLINEMOD()->readTemplatesBinary(filename));
+
+  remove(filename.c_str());
+}
+
+TEST(Rgbd_Linemod, binary_templates_corrupted)
+{
+  std::vector<Mat> object_masks;
+  Mat scene = makeScene(object_masks);
+  Ptr<linemod::Detector> detector = makeTrainedDetector(scene, object_masks);
+  String filename = tempfile(".bin");
+  detector->writeTemplatesBinary(filename);
+
+  std::vector<char> content;
+  {
+    std::ifstream file(filename.c_str(), std::ifstream::binary);
+    content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+  ASSERT_GT(content.size(), 64u);
+
+  // Truncated file
+  {
+    std::ofstream file(filename.c_str(), std::ofstream::binary);
+    file.write(&content[0], content.size() / 2);
+  }
+  Ptr<linemod::Detector> loaded = linemod::getDefaultLINE();
+  EXPECT_ANY_THROW(loaded->readTemplatesBinary(filename));
+  EXPECT_EQ(0, loaded->numClasses());
+
+  // Class count far beyond the file size; it follows the tag, version, modality count,
+  // the modality name and the pyramid levels
+  String name = loaded->getModalities()[0]->name();
+  size_t class_count_offset = 4 + 3 * sizeof(int) + name.size() + sizeof(int);
+  std::vector<char> corrupted = content;
+  int huge_count = 1 << 30;
+  memcpy(&corrupted[class_count_offset], &huge_count, sizeof(huge_count));
+  {
+    std::ofstream file(filename.c_str(), std::ofstream::binary);
+    file.write(&corrupted[0], corrupted.size());
+  }
+  EXPECT_ANY_THROW(loaded->readTemplatesBinary(filename));
+  EXPECT_EQ(0, loaded->numClasses());
+
+  // Negative class count
+  int negative_count = -1;
+  memcpy(&corrupted[class_count_offset], &negative_count, sizeof(negative_count));
+  {
+    std::ofstream file(filename.c_str(), std::ofstream::binary);
+    file.write(&corrupted[0], corrupted.size());
+  }
+  EXPECT_ANY_THROW(loaded->readTemplatesBinary(filename));
+  EXPECT_EQ(0, loaded->numClasses());
+
+  remove(filename.c_str());
+}
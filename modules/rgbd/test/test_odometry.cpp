@@ -330,6 +330,92 @@ void CV_OdometryTest::run(int)
     }
 }
 
+class CV_OdometryStreamTest : public CV_OdometryTest
+{
+public:
+    CV_OdometryStreamTest(const Ptr<Odometry>& _odometry) :
+        CV_OdometryTest(_odometry, 0., 0.) {}
+
+protected:
+    virtual void run(int);
+};
+
+void CV_OdometryStreamTest::run(int)
+{
+    Mat K = Mat::eye(3,3,CV_32FC1);
+    {
+        K.at<float>(0,0) = 525.0f;
+        K.at<float>(1,1) = 525.0f;
+        K.at<float>(0,2) = 319.5f;
+        K.at<float>(1,2) = 239.5f;
+    }
+
+    Mat image, depth;
+    if(!readData(image, depth))
+        return;
+
+    odometry->setCameraMatrix(K);
+
+    // The stream has to give the same transformations and the chained pose
+    // as the pairwise computation on the Mat data.
+    OdometryStream stream(odometry);
+    Mat pose = Mat::eye(4,4,CV_64FC1);
+    Mat prevImage = image, prevDepth = depth;
+    int iterCount = 5;
+    for(int iter = 0; iter <= iterCount; iter++)
+    {
+        Mat currImage = image, currDepth = depth;
+        if(iter > 0)
+        {
+            Mat rvec, tvec;
+            generateRandomTransformation(rvec, tvec);
+            warpFrame(image, depth, rvec, tvec, K, currImage, currDepth);
+            dilateFrame(currImage, currDepth);
+        }
+
+        Mat streamRt;
+        bool isStreamComputed = stream.process(currImage, currDepth, Mat(), streamRt);
+
+        if(iter > 0)
+        {
+            Mat calcRt;
+            bool isComputed = odometry->compute(currImage, currDepth, Mat(), prevImage, prevDepth, Mat(), calcRt);
+            if(isComputed != isStreamComputed)
+            {
+                ts->printf(cvtest::TS::LOG, "Different results of the stream and the pairwise odometry on frame %d", iter);
+                ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+                return;
+            }
+            if(isComputed)
+            {
+                double diff = norm(calcRt, streamRt);
+                if(diff > FLT_EPSILON)
+                {
+                    ts->printf(cvtest::TS::LOG, "Incorrect transformation of the stream on frame %d, diff = %f", iter, diff);
+                    ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+                    return;
+                }
+                pose = pose * calcRt;
+            }
+        }
+        prevImage = currImage;
+        prevDepth = currDepth;
+    }
+
+    if(stream.getFrameCount() != iterCount + 1 || stream.getFrame(0).empty() || !stream.getFrame(2).empty())
+    {
+        ts->printf(cvtest::TS::LOG, "Incorrect frames ring of the stream");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_OUTPUT);
+    }
+
+    double poseDiff = norm(pose, stream.getPose());
+    if(poseDiff > FLT_EPSILON)
+    {
+        ts->printf(cvtest::TS::LOG, "Incorrect chained pose of the stream, diff = %f", poseDiff);
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+    }
+}
+
 /****************************************************************************************\
 *                                Tests registrations                                     *
 \****************************************************************************************/
@@ -353,3 +439,9 @@ TEST(DISABLED_RGBD_Odometry_RgbdICP, algorithmic)
     cv::rgbd::CV_OdometryTest test(cv::rgbd::Odometry::create("RgbdICPOdometry"), 0.99, 0.99);
     test.safe_run();
 }
+
+TEST(RGBD_OdometryStream_Rgbd, algorithmic)
+{
+    cv::rgbd::CV_OdometryStreamTest test(cv::rgbd::Odometry::create("RgbdOdometry"));
+    test.safe_run();
+}
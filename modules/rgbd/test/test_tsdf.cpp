@@ -0,0 +1,77 @@
+#include "test_precomp.hpp"
+
+namespace cv
+{
+namespace rgbd
+{
+
+class CV_RgbdTSDFVolumeTest: public cvtest::BaseTest
+{
+public:
+  CV_RgbdTSDFVolumeTest()
+  {
+  }
+  ~CV_RgbdTSDFVolumeTest()
+  {
+  }
+protected:
+  void
+  run(int)
+  {
+    // K from a VGA Kinect
+    Mat K = (Mat_<float>(3, 3) << 525., 0., 319.5, 0., 525., 239.5, 0., 0., 1.);
+
+    // A fronto-parallel wall at 1m seen from two poses
+    const float wallDepth = 1.f, shift = 0.05f;
+    Mat depth0(480, 640, CV_32FC1, Scalar(wallDepth));
+    Mat depth1(480, 640, CV_32FC1, Scalar(wallDepth - shift));
+    depth1(Rect(0, 0, 640, 10)).setTo(std::numeric_limits<float>::quiet_NaN());
+    Mat pose0 = Mat::eye(4, 4, CV_64FC1);
+    Mat pose1 = Mat::eye(4, 4, CV_64FC1);
+    pose1.at<double>(2, 3) = shift;
+
+    const float voxelSize = 0.01f;
+    Ptr<TSDFVolume> volume = TSDFVolume::create(voxelSize, 0.04f);
+    volume->integrate(depth0, K, pose0);
+    volume->integrate(depth1, K, pose1);
+    ASSERT_GT(volume->getBlockCount(), 0);
+
+    // Rendered model has to be the same wall
+    Mat points, normals;
+    volume->raycast(pose1, K, depth1.size(), points, normals);
+    ASSERT_EQ(CV_32FC3, points.type());
+    ASSERT_EQ(CV_32FC3, normals.type());
+    int validCount = 0;
+    for (int y = 100; y < 380; ++y)
+      for (int x = 100; x < 540; ++x)
+      {
+        Vec3f p = points.at<Vec3f>(y, x), n = normals.at<Vec3f>(y, x);
+        if (cvIsNaN(p[2]))
+          continue;
+        validCount++;
+        ASSERT_NEAR(wallDepth - shift, p[2], voxelSize);
+        ASSERT_NEAR(-1., n[2], 0.05);
+      }
+    ASSERT_GT(validCount, 280 * 440 * 9 / 10);
+
+    // Exported cloud lies on the wall too
+    Mat cloud, cloudNormals;
+    volume->fetchCloud(cloud, &cloudNormals);
+    ASSERT_GT(cloud.total(), 0u);
+    ASSERT_EQ(cloud.total(), cloudNormals.total());
+    for (size_t i = 0; i < cloud.total(); ++i)
+      ASSERT_NEAR(wallDepth, cloud.at<Vec3f>((int)i)[2], voxelSize);
+
+    volume->reset();
+    ASSERT_EQ(0, volume->getBlockCount());
+  }
+};
+
+}
+}
+
+TEST(Rgbd_TSDFVolume, integrate_raycast)
+{
+  cv::rgbd::CV_RgbdTSDFVolumeTest test;
+  test.safe_run();
+}
@@ -299,6 +299,19 @@ public:
      */
   std::vector<float> getobjectnessValues();
 
+  /** @brief Computes the objectness bounding boxes of a set of images, in parallel.
+
+    The trained model is loaded once and shared read-only by all the images, the boxes and the values
+    of each image are the same as the ones given by computeSaliency() and getobjectnessValues(). Nothing
+    is written in the results folder.
+    @param images input images, each one a *Mat* as in computeSaliency()
+    @param objectnessBoundingBoxes the *vector\<Vec4i\>* of bounding boxes of each image
+    @param objectnessValues the *vector\<float\>* of objectness values of each image, in the same order
+    as its bounding boxes
+     */
+  void computeSaliencyBatch( InputArrayOfArrays images, std::vector<std::vector<Vec4i> >& objectnessBoundingBoxes,
+                             std::vector<std::vector<float> >& objectnessValues );
+
   /** @brief This is a utility function that allows to set the correct path from which the algorithm will load
     the trained model.
     @param trainingPath trained model path
@@ -359,9 +372,9 @@ private:
     void update( Mat &w );
 
     // For a W by H gradient magnitude map, find a W-7 by H-7 CV_32F matching score map
-    Mat matchTemplate( const Mat &mag1u );
+    Mat matchTemplate( const Mat &mag1u ) const;
 
-    float dot( int64_t tig1, int64_t tig2, int64_t tig4, int64_t tig8 );
+    float dot( int64_t tig1, int64_t tig2, int64_t tig4, int64_t tig8 ) const;
     void reconstruct( Mat &w );// For illustration purpose
 
   private:
@@ -402,6 +415,18 @@ private:
     std::vector<ST> sortedStructVals;
   };
 
+  // Trained model of one color space
+  struct TrainedModel
+  {
+    std::string name;// Name the model was loaded from
+    std::vector<int> svmSzIdxs;// Indexes of active size. It's equal to _svmFilters.size() and _svmReW1f.rows
+    Mat svmFilter;// Filters learned at stage I, each is a _H by _W CV_32F matrix
+    FilterTIG tigF;// TIG filter
+    Mat svmReW1f;// Re-weight parameters learned at stage II.
+  };
+
+  class BatchInvoker;
+
   enum
   {
     MAXBGR,
@@ -420,10 +445,8 @@ private:
   // Names and paths to read model and to store results
   std::string _modelName, _bbResDir, _trainingPath, _resultsDir;
 
-  std::vector<int> _svmSzIdxs;// Indexes of active size. It's equal to _svmFilters.size() and _svmReW1f.rows
-  Mat _svmFilter;// Filters learned at stage I, each is a _H by _W CV_32F matrix
-  FilterTIG _tigF;// TIG filter
-  Mat _svmReW1f;// Re-weight parameters learned at stage II.
+  // Models of the color spaces, the predictions work on a copy taken by loadTrainedModels()
+  TrainedModel _models[3];
 
   // List of the rectangles' objectness value, in the same order as
   // the  vector<Vec4i> objectnessBoundingBox returned by the algorithm (in computeSaliencyImpl function)
@@ -445,23 +468,27 @@ private:
 
   // Load trained model.
   int loadTrainedModel( std::string modelName = "" );// Return -1, 0, or 1 if partial, none, or all loaded
+  // Load the models of all the color spaces that are not loaded yet and copy them in models
+  void loadTrainedModels( std::vector<TrainedModel> &models );
 
   // Get potential bounding boxes, each of which is represented by a Vec4i for (minX, minY, maxX, maxY).
   // The trained model should be prepared before calling this function: loadTrainedModel() or trainStageI() + trainStageII().
   // Use numDet to control the final number of proposed bounding boxes, and number of per size (scale and aspect ratio)
-  void getObjBndBoxes( Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, int numDetPerSize = 120 );
-  void getObjBndBoxesForSingleImage( Mat img, ValStructVec<float, Vec4i> &boxes, int numDetPerSize );
+  void getObjBndBoxes( const TrainedModel &model, int clr, Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, int numDetPerSize = 120 ) const;
+  void getObjBndBoxesForSingleImage( const std::vector<TrainedModel> &models, Mat img, ValStructVec<float, Vec4i> &boxes, int numDetPerSize, bool verbose ) const;
+  static void getSortedBoxes( ValStructVec<float, Vec4i> &finalBoxes, std::vector<Vec4i> &sortedBB, std::vector<float> &values );
+  void writeBoxes( const std::vector<Vec4i> &sortedBB );
 
-  bool filtersLoaded()
+  bool filtersLoaded( const TrainedModel &model ) const
   {
-    int n = (int) _svmSzIdxs.size();
-    return n > 0 && _svmReW1f.size() == Size( 2, n ) && _svmFilter.size() == Size( _W, _W );
+    int n = (int) model.svmSzIdxs.size();
+    return n > 0 && model.svmReW1f.size() == Size( 2, n ) && model.svmFilter.size() == Size( _W, _W );
   }
-  void predictBBoxSI( Mat &mag3u, ValStructVec<float, Vec4i> &valBoxes, std::vector<int> &sz, int NUM_WIN_PSZ = 100, bool fast = true );
-  void predictBBoxSII( ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz );
+  void predictBBoxSI( const TrainedModel &model, int clr, Mat &mag3u, ValStructVec<float, Vec4i> &valBoxes, std::vector<int> &sz, int NUM_WIN_PSZ = 100, bool fast = true ) const;
+  static void predictBBoxSII( const TrainedModel &model, ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz );
 
   // Calculate the image gradient: center option as in VLFeat
-  void gradientMag( Mat &imgBGR3u, Mat &mag1u );
+  static void gradientMag( int clr, Mat &imgBGR3u, Mat &mag1u );
 
   static void gradientRGB( Mat &bgr3u, Mat &mag1u );
   static void gradientGray( Mat &bgr3u, Mat &mag1u );
@@ -0,0 +1,114 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::saliency;
+
+// A smooth random scene with a bright square moving across it.
+static void makeFrames(Size sz, int type, int count, std::vector<Mat>& frames)
+{
+    RNG rng(0);
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    GaussianBlur(background, background, Size(15, 15), 0);
+    frames.resize(count);
+    for (int i = 0; i < count; i++)
+    {
+        background.copyTo(frames[i]);
+        int side = sz.height / 5;
+        Rect object((i * 16) % std::max(1, sz.width - side), sz.height / 2 - side / 2, side, side);
+        frames[i](object).setTo(Scalar::all(255));
+    }
+}
+
+CV_ENUM(ImageTypes, CV_8UC1, CV_8UC3);
+typedef tuple<ImageTypes, Size> FineGrainedParams;
+
+typedef TestBaseWithParam<FineGrainedParams> StaticSaliencyFineGrainedPerfTest;
+
+PERF_TEST_P( StaticSaliencyFineGrainedPerfTest, computeSaliency, Combine(ImageTypes::all(), Values(szVGA, sz720p, sz1080p)) )
+{
+    int type = get<0>(GetParam());
+    Size sz  = get<1>(GetParam());
+
+    std::vector<Mat> frames;
+    makeFrames(sz, type, 1, frames);
+    Mat saliencyMap;
+    Ptr<StaticSaliencyFineGrained> saliency = StaticSaliencyFineGrained::create();
+
+    TEST_CYCLE()
+    {
+        saliency->computeSaliency(frames[0], saliencyMap);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam<Size> MotionSaliencyBinWangApr2014PerfTest;
+
+PERF_TEST_P( MotionSaliencyBinWangApr2014PerfTest, computeSaliency, Values(szVGA, sz720p, sz1080p) )
+{
+    Size sz = GetParam();
+
+    std::vector<Mat> frames;
+    makeFrames(sz, CV_8UC1, 16, frames);
+    Mat saliencyMap;
+    Ptr<MotionSaliencyBinWangApr2014> saliency = MotionSaliencyBinWangApr2014::create();
+    saliency->setImagesize(sz.width, sz.height);
+    saliency->init();
+    // let the background model settle, so that all the detection stages run
+    for (int i = 0; i < 8; i++)
+        saliency->computeSaliency(frames[i], saliencyMap);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        saliency->computeSaliency(frames[frame++ % frames.size()], saliencyMap);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
@@ -57,6 +57,9 @@ namespace saliency
 const char* ObjectnessBING::_clrName[3] =
 { "MAXBGR", "HSV", "I" };
 
+// Serializes the loading of the models and the copies taken of them for the predictions
+static Mutex modelsMutex;
+
 ObjectnessBING::ObjectnessBING()
 {
   _base = 2;  // base for window size quantization
@@ -101,6 +104,7 @@ int ObjectnessBING::loadTrainedModel( std::string modelName )  // Return -1, 0,
     modelName = _modelName;
   CStr s1 = modelName + ".wS1", s2 = modelName + ".wS2", sI = modelName + ".idx";
   Mat filters1f, reW1f, idx1i, show3u;
+  TrainedModel &model = _models[_Clr];
 
   if( !matRead( s1, filters1f ) || !matRead( sI, idx1i ) )
   {
@@ -108,32 +112,55 @@ int ObjectnessBING::loadTrainedModel( std::string modelName )  // Return -1, 0,
     return 0;
   }
 
+  CV_Assert( idx1i.total() > 1 && filters1f.size() == Size(_W, _W) && filters1f.type() == CV_32F );
+
+  // The model is named after a complete load only, so that a partial load is retried
+  // by loadTrainedModels() instead of being taken for the model of modelName
+  model.name.clear();
 
   normalize( filters1f, show3u, 1, 255, NORM_MINMAX, CV_8U );
-  _tigF.update( filters1f );
+  model.tigF.update( filters1f );
 
-  _svmSzIdxs = idx1i;
-  CV_Assert( _svmSzIdxs.size() > 1 && filters1f.size() == Size(_W, _W) && filters1f.type() == CV_32F );
-  _svmFilter = filters1f;
+  model.svmSzIdxs = idx1i;
+  model.svmFilter = filters1f;
 
-  if( !matRead( s2, _svmReW1f ) || _svmReW1f.size() != Size( 2, (int) _svmSzIdxs.size() ) )
+  if( !matRead( s2, reW1f ) || reW1f.size() != Size( 2, (int) model.svmSzIdxs.size() ) )
   {
-    _svmReW1f = Mat();
+    model.svmReW1f = Mat();
     return -1;
   }
+  model.svmReW1f = reW1f;
+  model.name = modelName;
   return 1;
 }
 
-void ObjectnessBING::predictBBoxSI( Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, std::vector<int> &sz, int NUM_WIN_PSZ, bool fast )
+void ObjectnessBING::loadTrainedModels( std::vector<TrainedModel> &models )
 {
-  const int numSz = (int) _svmSzIdxs.size();
+  AutoLock lock( modelsMutex );
+  // The models are only read again when the training path or the parameters they depend on change
+  for ( int clr = MAXBGR; clr <= G; clr++ )
+  {
+    setColorSpace( clr );
+    if( _models[clr].name != _modelName )
+      loadTrainedModel();
+  }
+
+  // A load replaces the matrices of a model instead of writing in them, so the copy is
+  // not affected by the loads that follow
+  models.assign( _models, _models + 3 );
+}
+
+void ObjectnessBING::predictBBoxSI( const TrainedModel &model, int clr, Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, std::vector<int> &sz,
+                                    int NUM_WIN_PSZ, bool fast ) const
+{
+  const int numSz = (int) model.svmSzIdxs.size();
   const int imgW = img3u.cols, imgH = img3u.rows;
   valBoxes.reserve( 10000 );
   sz.clear();
   sz.reserve( 10000 );
   for ( int ir = numSz - 1; ir >= 0; ir-- )
   {
-    int r = _svmSzIdxs[ir];
+    int r = model.svmSzIdxs[ir];
     int height = cvRound( pow( _base, r / _numT + _minT ) ), width = cvRound( pow( _base, r % _numT + _minT ) );
     if( height > imgH * _base || width > imgW * _base )
       continue;
@@ -141,9 +168,9 @@ void ObjectnessBING::predictBBoxSI( Mat &img3u, ValStructVec<float, Vec4i> &valB
     height = min( height, imgH ), width = min( width, imgW );
     Mat im3u, matchCost1f, mag1u;
     resize( img3u, im3u, Size( cvRound( _W * imgW * 1.0 / width ), cvRound( _W * imgH * 1.0 / height ) ) );
-    gradientMag( im3u, mag1u );
+    gradientMag( clr, im3u, mag1u );
 
-    matchCost1f = _tigF.matchTemplate( mag1u );
+    matchCost1f = model.tigF.matchTemplate( mag1u );
 
     ValStructVec<float, Point> matchCost;
     nonMaxSup( matchCost1f, matchCost, _NSS, NUM_WIN_PSZ, fast );
@@ -167,12 +194,13 @@ void ObjectnessBING::predictBBoxSI( Mat &img3u, ValStructVec<float, Vec4i> &valB
 
 }
 
-void ObjectnessBING::predictBBoxSII( ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz )
+void ObjectnessBING::predictBBoxSII( const TrainedModel &model, ValStructVec<float, Vec4i> &valBoxes, const std::vector<int> &sz )
 {
-  int numI = valBoxes.size();
+  // A model without its stage II weights keeps the stage I scores
+  int numI = model.svmReW1f.empty() ? 0 : valBoxes.size();
   for ( int i = 0; i < numI; i++ )
   {
-    const float* svmIIw = _svmReW1f.ptr<float>( sz[i] );
+    const float* svmIIw = model.svmReW1f.ptr<float>( sz[i] );
     valBoxes( i ) = valBoxes( i ) * svmIIw[0] + svmIIw[1];
   }
   //valBoxes.sort();
@@ -184,12 +212,12 @@ void ObjectnessBING::predictBBoxSII( ValStructVec<float, Vec4i> &valBoxes, const
 // Get potential bounding boxes, each of which is represented by a Vec4i for (minX, minY, maxX, maxY).
 // The trained model should be prepared before calling this function: loadTrainedModel() or trainStageI() + trainStageII().
 // Use numDet to control the final number of proposed bounding boxes, and number of per size (scale and aspect ratio)
-void ObjectnessBING::getObjBndBoxes( Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, int numDetPerSize )
+void ObjectnessBING::getObjBndBoxes( const TrainedModel &model, int clr, Mat &img3u, ValStructVec<float, Vec4i> &valBoxes, int numDetPerSize ) const
 {
-  //CV_Assert_(filtersLoaded() , ("SVM filters should be initialized before getting object proposals\n"));
+  //CV_Assert_(filtersLoaded(model) , ("SVM filters should be initialized before getting object proposals\n"));
   vecI sz;
-  predictBBoxSI( img3u, valBoxes, sz, numDetPerSize, false );
-  predictBBoxSII( valBoxes, sz );
+  predictBBoxSI( model, clr, img3u, valBoxes, sz, numDetPerSize, false );
+  predictBBoxSII( model, valBoxes, sz );
   return;
 }
 
@@ -243,9 +271,9 @@ void ObjectnessBING::nonMaxSup( Mat &matchCost1f, ValStructVec<float, Point> &ma
   }
 }
 
-void ObjectnessBING::gradientMag( Mat &imgBGR3u, Mat &mag1u )
+void ObjectnessBING::gradientMag( int clr, Mat &imgBGR3u, Mat &mag1u )
 {
-  switch ( _Clr )
+  switch ( clr )
   {
     case MAXBGR:
       gradientRGB( imgBGR3u, mag1u );
@@ -374,7 +402,10 @@ void ObjectnessBING::gradientXY( Mat &x1i, Mat &y1i, Mat &mag1u )
   }
 }
 
-void ObjectnessBING::getObjBndBoxesForSingleImage( Mat img, ValStructVec<float, Vec4i> &finalBoxes, int numDetPerSize )
+// Uses a copy of the models taken by loadTrainedModels() without modifying it, so it can run
+// concurrently on several images
+void ObjectnessBING::getObjBndBoxesForSingleImage( const std::vector<TrainedModel> &models, Mat img, ValStructVec<float, Vec4i> &finalBoxes,
+                                                   int numDetPerSize, bool verbose ) const
 {
   ValStructVec<float, Vec4i> boxes;
   finalBoxes.reserve( 10000 );
@@ -383,23 +414,38 @@ void ObjectnessBING::getObjBndBoxesForSingleImage( Mat img, ValStructVec<float,
   { 1, 3, 5 };
   for ( int clr = MAXBGR; clr <= G; clr++ )
   {
-    setColorSpace( clr );
-    loadTrainedModel();
     CmTimer tm( "Predict" );
     tm.Start();
 
-    getObjBndBoxes( img, boxes, numDetPerSize );
+    getObjBndBoxes( models[clr], clr, img, boxes, numDetPerSize );
     finalBoxes.append( boxes, scales[clr] );
 
     tm.Stop();
-    printf( "Average time for predicting an image (%s) is %gs\n", _clrName[_Clr], tm.TimeInSeconds() );
+    if( verbose )
+      printf( "Average time for predicting an image (%s) is %gs\n", _clrName[clr], tm.TimeInSeconds() );
   }
+}
+
+void ObjectnessBING::getSortedBoxes( ValStructVec<float, Vec4i> &finalBoxes, std::vector<Vec4i> &sortedBB, std::vector<float> &values )
+{
+  // List of rectangles returned by objectess function in descending order.
+  // At the top there are the rectangles with higher values, ie more
+  // likely to have objects in them.
+  sortedBB = finalBoxes.getSortedStructVal();
 
-  //Write on file the total number and the list of rectangles returned by objectess, one for each row.
+  // List of the rectangles' objectness value
+  std::vector<std::pair<float, int> > valIdxes = finalBoxes.getvalIdxes();
+  values.resize( valIdxes.size() );
+  for ( size_t i = 0; i < valIdxes.size(); i++ )
+    values[valIdxes[i].second] = valIdxes[i].first;
+}
 
+//Write on file the total number and the list of rectangles returned by objectess, one for each row.
+void ObjectnessBING::writeBoxes( const std::vector<Vec4i> &sortedBB )
+{
+  setColorSpace( G );
   CmFile::MkDir( _bbResDir );
   CStr fName = _bbResDir + "bb";
-  std::vector<Vec4i> sortedBB = finalBoxes.getSortedStructVal();
   std::ofstream ofs;
   ofs.open( ( fName + ".txt" ).c_str(), std::ofstream::out );
   std::stringstream dim;
@@ -462,24 +508,64 @@ void ObjectnessBING::write() const
 
 bool ObjectnessBING::computeSaliencyImpl( InputArray image, OutputArray objectnessBoundingBox )
 {
+  std::vector<TrainedModel> models;
+  loadTrainedModels( models );
+
   ValStructVec<float, Vec4i> finalBoxes;
-  getObjBndBoxesForSingleImage( image.getMat(), finalBoxes, 250 );
+  getObjBndBoxesForSingleImage( models, image.getMat(), finalBoxes, 250, true );
 
-  // List of rectangles returned by objectess function in descending order.
-  // At the top there are the rectangles with higher values, ie more
-  // likely to have objects in them.
-  std::vector<Vec4i> sortedBB = finalBoxes.getSortedStructVal();
+  std::vector<Vec4i> sortedBB;
+  getSortedBoxes( finalBoxes, sortedBB, objectnessValues );
+  writeBoxes( sortedBB );
   Mat( sortedBB ).copyTo( objectnessBoundingBox );
 
-  // List of the rectangles' objectness value
-  unsigned long int valIdxesSize = (unsigned long int) finalBoxes.getvalIdxes().size();
-  objectnessValues.resize( valIdxesSize );
-  for ( uint i = 0; i < valIdxesSize; i++ )
-    objectnessValues[finalBoxes.getvalIdxes()[i].second] = finalBoxes.getvalIdxes()[i].first;
-
   return true;
 }
 
+class ObjectnessBING::BatchInvoker : public ParallelLoopBody
+{
+public:
+  BatchInvoker( const ObjectnessBING &bing, const std::vector<TrainedModel> &models, const std::vector<Mat> &images,
+                std::vector<std::vector<Vec4i> > &boxes, std::vector<std::vector<float> > &values ) :
+      _bing( bing ), _models( models ), _images( images ), _boxes( boxes ), _values( values )
+  {
+  }
+
+  void operator()( const Range &range ) const
+  {
+    for ( int i = range.start; i < range.end; i++ )
+    {
+      ValStructVec<float, Vec4i> finalBoxes;
+      _bing.getObjBndBoxesForSingleImage( _models, _images[i], finalBoxes, 250, false );
+      getSortedBoxes( finalBoxes, _boxes[i], _values[i] );
+    }
+  }
+
+private:
+  const ObjectnessBING &_bing;
+  const std::vector<TrainedModel> &_models;
+  const std::vector<Mat> &_images;
+  std::vector<std::vector<Vec4i> > &_boxes;
+  std::vector<std::vector<float> > &_values;
+};
+
+void ObjectnessBING::computeSaliencyBatch( InputArrayOfArrays images, std::vector<std::vector<Vec4i> >& objectnessBoundingBoxes,
+                                           std::vector<std::vector<float> >& objectnessValues_ )
+{
+  std::vector<Mat> imgs;
+  images.getMatVector( imgs );
+  for ( size_t i = 0; i < imgs.size(); i++ )
+    CV_Assert( !imgs[i].empty() && imgs[i].type() == CV_8UC3 );
+
+  std::vector<TrainedModel> models;
+  loadTrainedModels( models );
+
+  // The images are independent and the copy of the models is only read, one image per task
+  objectnessBoundingBoxes.resize( imgs.size() );
+  objectnessValues_.resize( imgs.size() );
+  parallel_for_( Range( 0, (int) imgs.size() ), BatchInvoker( *this, models, imgs, objectnessBoundingBoxes, objectnessValues_ ) );
+}
+
 template<typename VT, typename ST>
 void ObjectnessBING::ValStructVec<VT, ST>::append( const ValStructVec<VT, ST> &newVals, int startV )
 {
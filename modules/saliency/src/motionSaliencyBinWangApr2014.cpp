@@ -104,111 +104,202 @@ MotionSaliencyBinWangApr2014::~MotionSaliencyBinWangApr2014()
 
 }
 
-// classification (and adaptation) functions
-bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image2, Mat& highResBFMask )
+// Classifies and adapts a range of rows with the full resolution background model,
+// the pixels are independent so the rows are processed in parallel.
+class FullResolutionDetectionInvoker : public ParallelLoopBody
 {
-  Mat image = image2.clone();
-
-  float currentPixelValue;
-  float currentEpslonValue;
-  bool backgFlag = false;
-
-  // Initially, all pixels are considered as foreground and then we evaluate with the background model
-  highResBFMask.create( image.rows, image.cols, CV_32F );
-  highResBFMask.setTo( 1 );
-
-  uchar* pImage;
-  float* pEpslon;
-  float* pMask;
+public:
+  FullResolutionDetectionInvoker( const Mat& _image, const Mat& _epslon, const std::vector<Ptr<Mat> >& _backgroundModel,
+                                  Mat& _mask, float _alpha, int _L0, int _L1 ) :
+      image( &_image ), epslon( &_epslon ), backgroundModel( &_backgroundModel ), mask( &_mask ), alpha( _alpha ), L0( _L0 ), L1( _L1 )
+  {
+  }
 
-  // Scan all pixels of image
-  for ( int i = 0; i < image.rows; i++ )
+  void operator()( const Range& range ) const
   {
+    size_t nTemplates = backgroundModel->size();
+    std::vector<Vec2f*> pModel( nTemplates );
 
-    pImage = image.ptr<uchar>( i );
-    pEpslon = epslonPixelsValue.ptr<float>( i );
-    pMask = highResBFMask.ptr<float>( i );
-    for ( int j = 0; j < image.cols; j++ )
+    for ( int i = range.start; i < range.end; i++ )
     {
+      const uchar* pImage = image->ptr<uchar>( i );
+      const float* pEpslon = epslon->ptr<float>( i );
+      float* pMask = mask->ptr<float>( i );
+      for ( size_t z = 0; z < nTemplates; z++ )
+        pModel[z] = ( *backgroundModel )[z]->ptr<Vec2f>( i );
 
-      backgFlag = false;
-      currentPixelValue = pImage[j];
-      currentEpslonValue = pEpslon[j];
-
-      int counter = 0;
-      for ( size_t z = 0; z < backgroundModel.size(); z++ )
-      {
-
-        counter += (int) backgroundModel[z]->ptr<Vec2f>( i )[j][1];
-      }
-
-      if( counter != 0 )  //if at least the first template is activated / initialized
+      for ( int j = 0; j < image->cols; j++ )
       {
+        bool backgFlag = false;
+        float currentPixelValue = pImage[j];
+        float currentEpslonValue = pEpslon[j];
 
-        // scan background model vector
-        for ( size_t z = 0; z < backgroundModel.size(); z++ )
+        int counter = 0;
+        for ( size_t z = 0; z < nTemplates; z++ )
         {
-          float* currentB;
-          float* currentC;
-          currentB = & ( backgroundModel[z]->ptr<Vec2f>( i )[j][0] );
-          currentC = & ( backgroundModel[z]->ptr<Vec2f>( i )[j][1] );
+          counter += (int) pModel[z][j][1];
+        }
 
-          //continue;
-          if( ( *currentC ) > 0 )  //The current template is active
+        if( counter != 0 )  //if at least the first template is activated / initialized
+        {
+          // scan background model vector
+          for ( size_t z = 0; z < nTemplates; z++ )
           {
-            // If there is a match with a current background template
-            if( abs( currentPixelValue - ( *currentB ) ) < currentEpslonValue && !backgFlag )
+            float* currentB = &pModel[z][j][0];
+            float* currentC = &pModel[z][j][1];
+
+            if( ( *currentC ) > 0 )  //The current template is active
             {
-              // The correspondence pixel in the  BF mask is set as background ( 0 value)
-              pMask[j] = 0;
-              if( ( *currentC < L0 && z == 0 ) || ( *currentC < L1 && z == 1 ) || ( z > 1 ) )
+              // If there is a match with a current background template
+              if( abs( currentPixelValue - ( *currentB ) ) < currentEpslonValue && !backgFlag )
               {
-                *currentC += 1;  // increment the efficacy of this template
+                // The correspondence pixel in the  BF mask is set as background ( 0 value)
+                pMask[j] = 0;
+                if( ( *currentC < L0 && z == 0 ) || ( *currentC < L1 && z == 1 ) || ( z > 1 ) )
+                {
+                  *currentC += 1;  // increment the efficacy of this template
+                }
+
+                *currentB = ( ( 1 - alpha ) * ( *currentB ) ) + ( alpha * currentPixelValue );  // Update the template value
+                backgFlag = true;
+              }
+              else
+              {
+                *currentC -= 1;  // decrement the efficacy of this template
               }
-
-              *currentB = ( ( 1 - alpha ) * ( *currentB ) ) + ( alpha * currentPixelValue );  // Update the template value
-              backgFlag = true;
-            }
-            else
-            {
-              *currentC -= 1;  // decrement the efficacy of this template
             }
+          }  // end "for" cicle of template vector
+        }
+        else
+        {
+          pMask[j] = 1;  //if the model of the current pixel is not yet initialized, we mark the pixels as foreground
+        }
+      }
+    }
+  }
 
-          }
-
-        }  // end "for" cicle of template vector
+private:
+  const Mat* image;
+  const Mat* epslon;
+  const std::vector<Ptr<Mat> >* backgroundModel;
+  Mat* mask;
+  float alpha;
+  int L0, L1;
+};
+
+// Classifies a range of the NxN blocks of the low resolution detection with their mean values.
+class LowResolutionDetectionInvoker : public ParallelLoopBody
+{
+public:
+  LowResolutionDetectionInvoker( const Mat& _image, const Mat& _epslon, const std::vector<Ptr<Mat> >& _backgroundModel,
+                                 const std::vector<Rect>& _blocks, Mat& _mask, int _N_DS ) :
+      image( &_image ), epslon( &_epslon ), backgroundModel( &_backgroundModel ), blocks( &_blocks ), mask( &_mask ), N_DS( _N_DS )
+  {
+  }
 
-      }
-      else
+  void operator()( const Range& range ) const
+  {
+    for ( int b = range.start; b < range.end; b++ )
+    {
+      const Rect& roi = ( *blocks )[b];
+      double count = (double) roi.area();
+      double sumImage = 0, sumEpslon = 0;
+      for ( int y = roi.y; y < roi.y + roi.height; y++ )
       {
-        pMask[j] = 1;  //if the model of the current pixel is not yet initialized, we mark the pixels as foreground
+        const uchar* pImage = image->ptr<uchar>( y );
+        const float* pEpslon = epslon->ptr<float>( y );
+        for ( int x = roi.x; x < roi.x + roi.width; x++ )
+        {
+          sumImage += pImage[x];
+          sumEpslon += pEpslon[x];
+        }
       }
+      float currentPixelValue = (float) ( sumImage / count );
+      float currentEpslonValue = (float) ( sumEpslon / count );
+
+      // scan background model vector
+      for ( int z = 0; z < N_DS; z++ )
+      {
+        double sumB = 0, sumC = 0;
+        for ( int y = roi.y; y < roi.y + roi.height; y++ )
+        {
+          const Vec2f* pModel = ( *backgroundModel )[z]->ptr<Vec2f>( y );
+          for ( int x = roi.x; x < roi.x + roi.width; x++ )
+          {
+            sumB += pModel[x][0];
+            sumC += pModel[x][1];
+          }
+        }
+        float currentB = (float) ( sumB / count );
+        float currentC = (float) ( sumC / count );
 
+        if( ( currentC ) > 0 )  //The current template is active
+        {
+          // If there is a match with a current background template
+          if( abs( currentPixelValue - ( currentB ) ) < currentEpslonValue )
+          {
+            // The correspondence pixels in the  BF mask are set as background ( 0 value)
+            ( *mask )( roi ).setTo( Scalar( 0 ) );
+            break;
+          }
+        }
+      }
     }
-  }  // end "for" cicle of all image's pixels
+  }
+
+private:
+  const Mat* image;
+  const Mat* epslon;
+  const std::vector<Ptr<Mat> >* backgroundModel;
+  const std::vector<Rect>* blocks;
+  Mat* mask;
+  int N_DS;
+};
+
+// Sorts the templates of a range of rows by efficacy, the pixels are independent
+// so the rows are processed in parallel.
+class TemplateOrderingInvoker : public ParallelLoopBody
+{
+public:
+  TemplateOrderingInvoker( const std::vector<Ptr<Mat> >& _backgroundModel, int _thetaL, int _gamma ) :
+      backgroundModel( &_backgroundModel ), thetaL( _thetaL ), gamma( _gamma )
+  {
+  }
+
+  void operator()( const Range& range ) const;
+
+private:
+  const std::vector<Ptr<Mat> >* backgroundModel;
+  int thetaL;
+  int gamma;
+};
+
+// classification (and adaptation) functions
+bool MotionSaliencyBinWangApr2014::fullResolutionDetection( const Mat& image, Mat& highResBFMask )
+{
+  // Initially, all pixels are considered as foreground and then we evaluate with the background model
+  highResBFMask.create( image.rows, image.cols, CV_32F );
+  highResBFMask.setTo( 1 );
+
+  // Scan all pixels of image
+  parallel_for_( Range( 0, image.rows ),
+                 FullResolutionDetectionInvoker( image, epslonPixelsValue, backgroundModel, highResBFMask, alpha, L0, L1 ),
+                 image.total() / (double) ( 1 << 16 ) );
 
   return true;
 }
 
 bool MotionSaliencyBinWangApr2014::lowResolutionDetection( const Mat& image, Mat& lowResBFMask )
 {
-  std::vector<Mat> mv;
-  split( *backgroundModel[0], mv );
+  Mat activeTemplate;
+  extractChannel( *backgroundModel[0], activeTemplate, 1 );
 
   //if at least the first template is activated / initialized for all pixels
-  if( countNonZero( mv[1] ) > ( mv[1].cols * mv[1].rows ) / 2 )
+  if( countNonZero( activeTemplate ) > ( activeTemplate.cols * activeTemplate.rows ) / 2 )
   {
-    float currentPixelValue;
-    float currentEpslonValue;
-    float currentB;
-    float currentC;
-
-    // Create a mask to select ROI in the original Image and Backgound model and at the same time compute the mean
-
+    // Collect the blocks, the ROI is moved over the image exactly as it always was
+    std::vector<Rect> blocks;
     Rect roi( Point( 0, 0 ), Size( N, N ) );
-    Scalar imageROImean;
-    Scalar backGModelROImean;
-    Mat currentModel;
 
     // Initially, all pixels are considered as foreground and then we evaluate with the background model
     lowResBFMask.create( image.rows, image.cols, CV_32F );
@@ -225,32 +316,8 @@ bool MotionSaliencyBinWangApr2014::lowResolutionDetection( const Mat& image, Mat
 
       for ( int j = 0; j < ceil( (float) image.cols / N ); j++ )
       {
-        // Compute the mean of image's block and epslonMatrix's block based on ROI
-        Mat roiImage = image( roi );
-        Mat roiEpslon = epslonPixelsValue( roi );
-        currentPixelValue = (float) mean( roiImage ).val[0];
-        currentEpslonValue = (float) mean( roiEpslon ).val[0];
-
-        // scan background model vector
-        for ( int z = 0; z < N_DS; z++ )
-        {
-          // Select the current template 2 channel matrix, select ROI and compute the mean for each channel separately
-          Mat roiTemplate = ( * ( backgroundModel[z] ) )( roi );
-          Scalar templateMean = mean( roiTemplate );
-          currentB = (float) templateMean[0];
-          currentC = (float) templateMean[1];
+        blocks.push_back( roi );
 
-          if( ( currentC ) > 0 )  //The current template is active
-          {
-            // If there is a match with a current background template
-            if( abs( currentPixelValue - ( currentB ) ) < currentEpslonValue )
-            {
-              // The correspondence pixel in the  BF mask is set as background ( 0 value)
-              rectangle( lowResBFMask, roi, Scalar( 0 ), FILLED );
-              break;
-            }
-          }
-        }
         // Shift the ROI from left to right follow the block dimension
         roi = roi + Point( N, 0 );
         if( ( roi.x + ( roi.width - 1 ) ) > ( image.cols - 1 ) && ( roi.y + ( N - 1 ) ) <= ( image.rows - 1 ) )
@@ -269,8 +336,12 @@ bool MotionSaliencyBinWangApr2014::lowResolutionDetection( const Mat& image, Mat
       {
         roi = Rect( Point( roi.x, roi.y ), Size( N, abs( ( image.rows - 1 ) - roi.y ) + 1 ) );
       }
-
     }
+
+    // The blocks do not overlap, compare them with the downsampled templates in parallel
+    parallel_for_( Range( 0, (int) blocks.size() ),
+                   LowResolutionDetectionInvoker( image, epslonPixelsValue, backgroundModel, blocks, lowResBFMask, N_DS ),
+                   image.total() / (double) ( 1 << 16 ) );
     return true;
   }
   else
@@ -289,38 +360,37 @@ bool inline pairCompare( std::pair<float, float> t, std::pair<float, float> t_pl
 
 }
 
-// Background model maintenance functions
-bool MotionSaliencyBinWangApr2014::templateOrdering()
+void TemplateOrderingInvoker::operator()( const Range& range ) const
 {
-  std::vector<std::pair<float, float> > pixelTemplates( backgroundModel.size() );
+  // T1...Tk of a pixel, T0 is not sorted
+  size_t nTemplates = backgroundModel->size();
+  std::vector<std::pair<float, float> > pixelTemplates( nTemplates - 1 );
+  std::vector<Vec2f*> pModel( nTemplates );
 
-  Vec2f* bgModel_0P;
-  Vec2f* bgModel_1P;
-
-// Scan all pixels of image
-  for ( int i = 0; i < backgroundModel[0]->rows; i++ )
+  for ( int i = range.start; i < range.end; i++ )
   {
-    bgModel_0P = backgroundModel[0]->ptr<Vec2f>( i );
-    bgModel_1P = backgroundModel[1]->ptr<Vec2f>( i );
-    for ( int j = 0; j < backgroundModel[0]->cols; j++ )
+    for ( size_t z = 0; z < nTemplates; z++ )
+      pModel[z] = ( *backgroundModel )[z]->ptr<Vec2f>( i );
+    Vec2f* bgModel_0P = pModel[0];
+    Vec2f* bgModel_1P = pModel[1];
+    for ( int j = 0; j < ( *backgroundModel )[0]->cols; j++ )
     {
       // scan background model vector from T1 to Tk
-      for ( size_t z = 1; z < backgroundModel.size(); z++ )
+      for ( size_t z = 1; z < nTemplates; z++ )
       {
-        Vec2f bgModel_zP = backgroundModel[z]->ptr<Vec2f>( i )[j];
         // Fill vector of pairs
-        pixelTemplates[z - 1].first = bgModel_zP[0];  // Current B (background value)
-        pixelTemplates[z - 1].second = bgModel_zP[1];  // Current C (efficacy value)
+        pixelTemplates[z - 1].first = pModel[z][j][0];  // Current B (background value)
+        pixelTemplates[z - 1].second = pModel[z][j][1];  // Current C (efficacy value)
       }
 
       //SORT template from T1 to Tk
       std::sort( pixelTemplates.begin(), pixelTemplates.end(), pairCompare );
 
       //REFILL CURRENT MODEL ( T1...Tk)
-      for ( size_t zz = 1; zz < backgroundModel.size(); zz++ )
+      for ( size_t zz = 1; zz < nTemplates; zz++ )
       {
-        backgroundModel[zz]->ptr<Vec2f>( i )[j][0] = pixelTemplates[zz - 1].first;  // Replace previous B with new ordered B value
-        backgroundModel[zz]->ptr<Vec2f>( i )[j][1] = pixelTemplates[zz - 1].second;  // Replace previous C with new ordered C value
+        pModel[zz][j][0] = pixelTemplates[zz - 1].first;  // Replace previous B with new ordered B value
+        pModel[zz][j][1] = pixelTemplates[zz - 1].second;  // Replace previous C with new ordered C value
       }
 
       // SORT Template T0 and T1
@@ -338,16 +408,75 @@ bool MotionSaliencyBinWangApr2014::templateOrdering()
 
     }
   }
+}
+
+// Background model maintenance functions
+bool MotionSaliencyBinWangApr2014::templateOrdering()
+{
+  // Scan all pixels of image
+  parallel_for_( Range( 0, backgroundModel[0]->rows ), TemplateOrderingInvoker( backgroundModel, thetaL, gamma ),
+                 backgroundModel[0]->total() / (double) ( 1 << 16 ) );
 
   return true;
 }
+// Maintains the potential background of the foreground pixels of a range of rows.
+class PotentialBackgroundInvoker : public ParallelLoopBody
+{
+public:
+  PotentialBackgroundInvoker( const Mat& _finalBFMask, const Mat& _image, const Mat& _epslon, Mat& _potentialBackground ) :
+      finalBFMask( &_finalBFMask ), image( &_image ), epslon( &_epslon ), potentialBackground( &_potentialBackground )
+  {
+  }
+
+  void operator()( const Range& range ) const
+  {
+    for ( int i = range.start; i < range.end; i++ )
+    {
+      const float* finalBFMaskP = finalBFMask->ptr<float>( i );
+      Vec2f* pbgP = potentialBackground->ptr<Vec2f>( i );
+      const uchar* imageP = image->ptr<uchar>( i );
+      const float* epslonP = epslon->ptr<float>( i );
+      for ( int j = 0; j < finalBFMask->cols; j++ )
+      {
+        if( finalBFMaskP[j] == 1 )  // i.e. the corresponding frame pixel has been market as foreground
+        {
+          /* For the pixels with CA= 0, if the current frame pixel has been classified as foreground, its value
+           * will be loaded into BA and CA will be set to 1*/
+          if( pbgP[j][1] == 0 )
+          {
+            pbgP[j][0] = (float) imageP[j];
+            pbgP[j][1] = 1;
+          }
+
+          /*the distance between this pixel value and BA is calculated, and if this distance is smaller than
+           the decision threshold epslon, then CA is increased by 1, otherwise is decreased by 1*/
+          else if( abs( (float) imageP[j] - pbgP[j][0] ) < epslonP[j] )
+          {
+            pbgP[j][1] += 1;
+          }
+          else
+          {
+            pbgP[j][1] -= 1;
+          }
+        }
+      }
+    }
+  }
+
+private:
+  const Mat* finalBFMask;
+  const Mat* image;
+  const Mat* epslon;
+  Mat* potentialBackground;
+};
+
 bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask, const Mat& image )
 {
-  std::vector<Mat> temp;
-  split( *backgroundModel[0], temp );
+  Mat activeTemplate;
+  extractChannel( *backgroundModel[0], activeTemplate, 1 );
 
 //if at least the first template is activated / initialized for all pixels
-  if( countNonZero( temp[1] ) <= ( temp[1].cols * temp[1].rows ) / 2 )
+  if( countNonZero( activeTemplate ) <= ( activeTemplate.cols * activeTemplate.rows ) / 2 )
   {
     thetaA = 50;
     thetaL = 150;
@@ -361,141 +490,62 @@ bool MotionSaliencyBinWangApr2014::templateReplacement( const Mat& finalBFMask,
     neighborhoodCheck = true;
   }
 
-  int roiSize = 3;  // FIXED ROI SIZE, not change until you first appropriately adjust the following controls in the EVALUATION section!
-  int countNonZeroElements = 0;
-  std::vector<Mat> mv;
-  Mat replicateCurrentBAMat( roiSize, roiSize, CV_32F );
-  Mat backgroundModelROI( roiSize, roiSize, CV_32F );
-  Mat diffResult( roiSize, roiSize, CV_32F );
-
-// Scan all pixels of finalBFMask and all pixels of others models (the dimension are the same)
-  const float* finalBFMaskP;
-  Vec2f* pbgP;
-  const uchar* imageP;
-  float* epslonP;
+  /////////////////// MAINTENANCE of potentialBackground model ///////////////////
+  // Every pixel only updates its own potential background, so the rows are processed in parallel
+  parallel_for_( Range( 0, finalBFMask.rows ), PotentialBackgroundInvoker( finalBFMask, image, epslonPixelsValue, potentialBackground ),
+                 finalBFMask.total() / (double) ( 1 << 16 ) );
+
+  /////////////////// EVALUATION of potentialBackground values ///////////////////
+  // A replaced template is visible to the neighborhood check of the following pixels, so this
+  // pass is sequential. The neighborhood is the 3x3 block centered in the pixel, clipped to the image.
+  const Vec2f* templateRows[3];
+  Vec2f* lastTemplate;
+  int nTemplates = (int) backgroundModel.size();
   for ( int i = 0; i < finalBFMask.rows; i++ )
   {
-    finalBFMaskP = finalBFMask.ptr<float>( i );
-    pbgP = potentialBackground.ptr<Vec2f>( i );
-    imageP = image.ptr<uchar>( i );
-    epslonP = epslonPixelsValue.ptr<float>( i );
+    const float* finalBFMaskP = finalBFMask.ptr<float>( i );
+    Vec2f* pbgP = potentialBackground.ptr<Vec2f>( i );
+    const float* epslonP = epslonPixelsValue.ptr<float>( i );
+    lastTemplate = backgroundModel[nTemplates - 1]->ptr<Vec2f>( i );
+    int y0 = std::max( i - 1, 0 ), y1 = std::min( i + 1, finalBFMask.rows - 1 );
     for ( int j = 0; j < finalBFMask.cols; j++ )
     {
-      /////////////////// MAINTENANCE of potentialBackground model ///////////////////
-      if( finalBFMaskP[j] == 1 )  // i.e. the corresponding frame pixel has been market as foreground
-      {
-        /* For the pixels with CA= 0, if the current frame pixel has been classified as foreground, its value
-         * will be loaded into BA and CA will be set to 1*/
-        if( pbgP[j][1] == 0 )
-        {
-          pbgP[j][0] = (float) imageP[j];
-          pbgP[j][1] = 1;
-        }
+      if( finalBFMaskP[j] != 1 || !( pbgP[j][1] > thetaA ) )
+        continue;
 
-        /*the distance between this pixel value and BA is calculated, and if this distance is smaller than
-         the decision threshold epslon, then CA is increased by 1, otherwise is decreased by 1*/
-        else if( abs( (float) imageP[j] - pbgP[j][0] ) < epslonP[j] )
-        {
-          pbgP[j][1] += 1;
-        }
-        else
-        {
-          pbgP[j][1] -= 1;
-        }
-        /*}*/  /////////////////// END of potentialBackground model MAINTENANCE///////////////////
-        /////////////////// EVALUATION of potentialBackground values ///////////////////
-        if( pbgP[j][1] > thetaA )
+      bool replace = !neighborhoodCheck;
+      if( neighborhoodCheck )
+      {
+        int x0 = std::max( j - 1, 0 ), x1 = std::min( j + 1, finalBFMask.cols - 1 );
+        float currentBA = pbgP[j][0];
+        for ( int z = 0; z < nTemplates && !replace; z++ )
         {
-          if( neighborhoodCheck )
-          {
-            // replicate currentBA value
-            replicateCurrentBAMat.setTo( pbgP[j][0] );
-
-            for ( size_t z = 0; z < backgroundModel.size(); z++ )
+          /* Check if the value of current pixel BA in potentialBackground model is already contained in at least one of its neighbors'
+           * background model
+           */
+          for ( int y = y0; y <= y1; y++ )
+            templateRows[y - y0] = backgroundModel[z]->ptr<Vec2f>( y );
+          for ( int y = 0; y <= y1 - y0 && !replace; y++ )
+            for ( int x = x0; x <= x1; x++ )
             {
-              // Neighborhood of current pixel in the current background model template.
-              // The ROI is centered in the pixel coordinates
-
-              if( i > 0 && j > 0 && i < ( backgroundModel[z]->rows - 1 ) && j < ( backgroundModel[z]->cols - 1 ) )
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), roiSize, roiSize ) );
-              }
-              else if( i == 0 && j == 0 )  // upper leftt
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i, (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( j == 0 && i > 0 && i < ( backgroundModel[z]->rows - 1 ) )  // middle left
+              // a NaN (not initialized) neighbor value counts as a match
+              if( !( abs( currentBA - templateRows[y][x][0] ) > epslonP[j] ) )
               {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), roiSize ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j == 0 )  //down left
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j, i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == 0 && j > 0 && j < ( backgroundModel[z]->cols - 1 ) )  // upper - middle
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( ( j - (int) floor((float) roiSize / 2 ) ), i, roiSize, (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j > 0 && j < ( backgroundModel[z]->cols - 1 ) )  //down middle
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), roiSize, (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( i == 0 && j == ( backgroundModel[z]->cols - 1 ) )  // upper right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0]( Rect( j - (int) floor((float) roiSize / 2 ), i, (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-              else if( j == ( backgroundModel[z]->cols - 1 ) && i > 0 && i < ( backgroundModel[z]->rows - 1 ) )  // middle - right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), roiSize ) );
-              }
-              else if( i == ( backgroundModel[z]->rows - 1 ) && j == ( backgroundModel[z]->cols - 1 ) )  // down right
-              {
-                split( *backgroundModel[z], mv );
-                backgroundModelROI = mv[0](
-                    Rect( j - (int) floor((float) roiSize / 2 ), i - (int) floor((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ), (int) ceil((float) roiSize / 2 ) ) );
-              }
-
-              /* Check if the value of current pixel BA in potentialBackground model is already contained in at least one of its neighbors'
-               * background model
-               */
-              resize( replicateCurrentBAMat, replicateCurrentBAMat, Size( backgroundModelROI.cols, backgroundModelROI.rows ), 0, 0, INTER_LINEAR );
-              resize( diffResult, diffResult, Size( backgroundModelROI.cols, backgroundModelROI.rows ), 0, 0, INTER_LINEAR );
-
-              absdiff( replicateCurrentBAMat, backgroundModelROI, diffResult );
-              threshold( diffResult, diffResult, epslonP[j], 255, THRESH_BINARY_INV );
-              countNonZeroElements = countNonZero( diffResult );
-
-              if( countNonZeroElements > 0 )
-              {
-                /////////////////// REPLACEMENT of backgroundModel template ///////////////////
-                //replace TA with current TK
-                backgroundModel[backgroundModel.size() - 1]->at<Vec2f>( i, j ) = potentialBackground.at<Vec2f>( i, j );
-                potentialBackground.at<Vec2f>( i, j )[0] = std::numeric_limits<float>::quiet_NaN();
-                potentialBackground.at<Vec2f>( i, j )[1] = 0;
-
+                replace = true;
                 break;
               }
-            }  // end for backgroundModel size
-          }
-          else
-          {
-            backgroundModel[backgroundModel.size() - 1]->at<Vec2f>( i, j ) = potentialBackground.at<Vec2f>( i, j );
-            potentialBackground.at<Vec2f>( i, j )[0] = std::numeric_limits<float>::quiet_NaN();
-            potentialBackground.at<Vec2f>( i, j )[1] = 0;
-          }
-        }  // close if of EVALUATION
-      }  // end of  if( finalBFMask.at<uchar>( i, j ) == 1 )  // i.e. the corresponding frame pixel has been market as foreground
+            }
+        }
+      }
 
+      if( replace )
+      {
+        /////////////////// REPLACEMENT of backgroundModel template ///////////////////
+        //replace TA with current TK
+        lastTemplate[j] = pbgP[j];
+        pbgP[j][0] = std::numeric_limits<float>::quiet_NaN();
+        pbgP[j][1] = 0;
+      }
     }  // end of second for
   }  // end of first for
 
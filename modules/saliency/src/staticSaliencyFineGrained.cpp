@@ -139,37 +139,64 @@ void StaticSaliencyFineGrained::calcIntensityChannel(Mat srcArg, Mat dstArg)
     intensity.copyTo(dstArg);
 }
 
-void StaticSaliencyFineGrained::getIntensityScaled(Mat integralImage, Mat gray, Mat intensityScaledOn, Mat intensityScaledOff, int neighborhood)
+// Computes the on/off center-surround differences of a range of rows at one scale.
+// The surround means are read from the integral image with pointers, the clamped
+// box columns being the same for all the rows.
+class IntensityScaledInvoker : public ParallelLoopBody
 {
-    float value, meanOn, meanOff;
-    Point2i point;
-    int x,y;
-    intensityScaledOn.setTo(Scalar::all(0));
-    intensityScaledOff.setTo(Scalar::all(0));
-
+public:
+    IntensityScaledInvoker(const Mat& _integralImage, const Mat& _gray, Mat& _intensityScaledOn, Mat& _intensityScaledOff, int _neighborhood) :
+        integralImage(&_integralImage), gray(&_gray), intensityScaledOn(&_intensityScaledOn), intensityScaledOff(&_intensityScaledOff),
+        neighborhood(_neighborhood), x1(_gray.cols), x2(_gray.cols)
+    {
+        for (int x = 0; x < gray->cols; x++)
+        {
+            x1[x] = std::min(std::max(x - neighborhood + 1, 0), integralImage->cols - 1);
+            x2[x] = std::min(std::max(x + neighborhood + 1, 0), integralImage->cols - 1);
+        }
+    }
 
-    for(y = 0; y < gray.rows; y++)
+    void operator()(const Range& range) const
     {
-        for(x = 0; x < gray.cols; x++)
+        for (int y = range.start; y < range.end; y++)
         {
-            point.x = x;
-            point.y = y;
-            value = getMean(integralImage, point, neighborhood, gray.at<uchar>(y, x));
-
-            meanOn = gray.at<uchar>(y, x) - value;
-            meanOff = value - gray.at<uchar>(y, x);
-
-            if(meanOn > 0)
-                intensityScaledOn.at<uchar>(y, x) = (uchar)meanOn;
-            else
-                intensityScaledOn.at<uchar>(y, x) = 0;
-
-            if(meanOff > 0)
-                intensityScaledOff.at<uchar>(y, x) = (uchar)meanOff;
-            else
-                intensityScaledOff.at<uchar>(y, x) = 0;
+            int y1 = std::min(std::max(y - neighborhood + 1, 0), integralImage->rows - 1);
+            int y2 = std::min(std::max(y + neighborhood + 1, 0), integralImage->rows - 1);
+            const float* top = integralImage->ptr<float>(y1);
+            const float* bottom = integralImage->ptr<float>(y2);
+            const uchar* src = gray->ptr<uchar>(y);
+            uchar* on = intensityScaledOn->ptr<uchar>(y);
+            uchar* off = intensityScaledOff->ptr<uchar>(y);
+
+            for (int x = 0; x < gray->cols; x++)
+            {
+                int centerVal = src[x];
+                // we use the integral image to compute fast features
+                float value = (float)(bottom[x2[x]] + top[x1[x]] - bottom[x1[x]] - top[x2[x]]);
+                value = (value - centerVal) / (((x2[x] - x1[x]) * (y2 - y1)) - 1);
+
+                float meanOn = centerVal - value;
+                float meanOff = value - centerVal;
+                on[x] = meanOn > 0 ? (uchar)meanOn : 0;
+                off[x] = meanOff > 0 ? (uchar)meanOff : 0;
+            }
         }
     }
+
+private:
+    const Mat* integralImage;
+    const Mat* gray;
+    Mat* intensityScaledOn;
+    Mat* intensityScaledOff;
+    int neighborhood;
+    std::vector<int> x1, x2;
+};
+
+void StaticSaliencyFineGrained::getIntensityScaled(Mat integralImage, Mat gray, Mat intensityScaledOn, Mat intensityScaledOff, int neighborhood)
+{
+    parallel_for_(Range(0, gray.rows),
+                  IntensityScaledInvoker(integralImage, gray, intensityScaledOn, intensityScaledOff, neighborhood),
+                  gray.total() / (double)(1 << 16));
 }
 
 float StaticSaliencyFineGrained::getMean(Mat srcArg, Point2i PixArg, int neighbourhood, int centerVal)
@@ -210,97 +237,84 @@ float StaticSaliencyFineGrained::getMean(Mat srcArg, Point2i PixArg, int neighbo
     return value;
 }
 
-void StaticSaliencyFineGrained::mixScales(Mat *intensityScaledOn, Mat intensityOn, Mat *intensityScaledOff, Mat intensityOff, const int numScales)
+// Maps the values of a range of rows through a lookup table.
+class LookupInvoker : public ParallelLoopBody
 {
-    int i=0, x, y;
-    int width = intensityScaledOn[0].cols;
-    int height = intensityScaledOn[0].rows;
-    short int maxValOn = 0, currValOn=0;
-    short int maxValOff = 0, currValOff=0;
-    int maxValSumOff = 0, maxValSumOn=0;
-    Mat mixedValuesOn(Size(width, height), CV_16UC1);
-    Mat mixedValuesOff(Size(width, height), CV_16UC1);
-
-    mixedValuesOn.setTo(Scalar::all(0));
-    mixedValuesOff.setTo(Scalar::all(0));
-
-    for(i=0;i<numScales;i++)
+public:
+    LookupInvoker(const Mat& _src, Mat& _dst, const std::vector<uchar>& _table) :
+        src(&_src), dst(&_dst), table(&_table)
     {
-        for(y=0;y<height;y++)
-            for(x=0;x<width;x++)
-            {
-                      currValOn = intensityScaledOn[i].at<uchar>(y, x);
-                      if(currValOn > maxValOn)
-                          maxValOn = currValOn;
-
-                      currValOff = intensityScaledOff[i].at<uchar>(y, x);
-                      if(currValOff > maxValOff)
-                          maxValOff = currValOff;
-
-                      mixedValuesOn.at<unsigned short>(y, x) += currValOn;
-                      mixedValuesOff.at<unsigned short>(y, x) += currValOff;
-            }
     }
 
-    for(y=0;y<height;y++)
-        for(x=0;x<width;x++)
-        {
-            currValOn = mixedValuesOn.at<unsigned short>(y, x);
-            currValOff = mixedValuesOff.at<unsigned short>(y, x);
-                  if(currValOff > maxValSumOff)
-                      maxValSumOff = currValOff;
-                  if(currValOn > maxValSumOn)
-                      maxValSumOn = currValOn;
-        }
-
-
-    for(y=0;y<height;y++)
-        for(x=0;x<width;x++)
+    void operator()(const Range& range) const
+    {
+        const uchar* lut = &(*table)[0];
+        for (int y = range.start; y < range.end; y++)
         {
-            intensityOn.at<uchar>(y, x) = (uchar)(255.*((float)(mixedValuesOn.at<unsigned short>(y, x) / (float)maxValSumOn)));
-            intensityOff.at<uchar>(y, x) = (uchar)(255.*((float)(mixedValuesOff.at<unsigned short>(y, x) / (float)maxValSumOff)));
+            const ushort* s = src->ptr<ushort>(y);
+            uchar* d = dst->ptr<uchar>(y);
+            for (int x = 0; x < src->cols; x++)
+                d[x] = lut[s[x]];
         }
+    }
 
-}
+private:
+    const Mat* src;
+    Mat* dst;
+    const std::vector<uchar>* table;
+};
 
-void StaticSaliencyFineGrained::mixOnOff(Mat intensityOn, Mat intensityOff, Mat intensityArg)
+void StaticSaliencyFineGrained::mixScales(Mat *intensityScaledOn, Mat intensityOn, Mat *intensityScaledOff, Mat intensityOff, const int numScales)
 {
-    int x,y;
-    int width = intensityOn.cols;
-    int height= intensityOn.rows;
-    int maxVal=0;
-
-    int currValOn, currValOff, maxValSumOff, maxValSumOn;
-
-    Mat intensity(Size(width, height), CV_8UC1);
-
-
-    maxValSumOff = 0;
-    maxValSumOn = 0;
+    int i=0;
+    int width = intensityScaledOn[0].cols;
+    int height = intensityScaledOn[0].rows;
+    double maxValSumOff = 0, maxValSumOn = 0;
+    Mat mixedValuesOn = Mat::zeros(Size(width, height), CV_16UC1);
+    Mat mixedValuesOff = Mat::zeros(Size(width, height), CV_16UC1);
 
-    for(y=0;y<height;y++)
-    for(x=0;x<width;x++)
+    for(i=0;i<numScales;i++)
     {
-        currValOn = intensityOn.at<uchar>(y, x);
-        currValOff = intensityOff.at<uchar>(y, x);
-              if(currValOff > maxValSumOff)
-                  maxValSumOff = currValOff;
-              if(currValOn > maxValSumOn)
-                  maxValSumOn = currValOn;
+        add(mixedValuesOn, intensityScaledOn[i], mixedValuesOn, noArray(), CV_16U);
+        add(mixedValuesOff, intensityScaledOff[i], mixedValuesOff, noArray(), CV_16U);
     }
 
-    if(maxValSumOn > maxValSumOff)
-        maxVal = maxValSumOn;
-    else
-        maxVal = maxValSumOff;
-
-
+    minMaxLoc(mixedValuesOn, 0, &maxValSumOn);
+    minMaxLoc(mixedValuesOff, 0, &maxValSumOff);
+
+    // the mixed values are small integers up to their maximum, normalize them
+    // with a table; a map without any contrast stays black
+    int maxOn = (int)maxValSumOn, maxOff = (int)maxValSumOff;
+    std::vector<uchar> tableOn(maxOn + 1, 0), tableOff(maxOff + 1, 0);
+    for(i=1;i<=maxOn;i++)
+        tableOn[i] = (uchar)(255.*((float)(i / (float)maxOn)));
+    for(i=1;i<=maxOff;i++)
+        tableOff[i] = (uchar)(255.*((float)(i / (float)maxOff)));
+
+    double nstripes = (double)width*height / (1 << 16);
+    parallel_for_(Range(0, height), LookupInvoker(mixedValuesOn, intensityOn, tableOn), nstripes);
+    parallel_for_(Range(0, height), LookupInvoker(mixedValuesOff, intensityOff, tableOff), nstripes);
+}
 
-    for(y=0;y<height;y++)
-        for(x=0;x<width;x++)
-        {
-            intensity.at<uchar>(y, x) = (uchar) (255. * (float) (intensityOn.at<uchar>(y, x) + intensityOff.at<uchar>(y, x)) / (float)maxVal);
-        }
+void StaticSaliencyFineGrained::mixOnOff(Mat intensityOn, Mat intensityOff, Mat intensityArg)
+{
+    double maxValSumOff = 0, maxValSumOn = 0;
+
+    minMaxLoc(intensityOn, 0, &maxValSumOn);
+    minMaxLoc(intensityOff, 0, &maxValSumOff);
+    int maxVal = (int)std::max(maxValSumOn, maxValSumOff);
+
+    // the sums of the on and off values are small integers up to twice the
+    // maximum, normalize them with a table saturating at white
+    Mat intensitySum;
+    add(intensityOn, intensityOff, intensitySum, noArray(), CV_16U);
+    std::vector<uchar> table(2*maxVal + 1, 0);
+    for(int i=1;i<(int)table.size();i++)
+        table[i] = (uchar) std::min(255. * (float) i / (float)maxVal, 255.);
+
+    Mat intensity(intensityOn.size(), CV_8UC1);
+    parallel_for_(Range(0, intensity.rows), LookupInvoker(intensitySum, intensity, table),
+                  intensity.total() / (double)(1 << 16));
 
     intensity.copyTo(intensityArg);
 }
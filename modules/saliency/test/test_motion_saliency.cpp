@@ -0,0 +1,87 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::saliency;
+
+// frames of a textured scene, in which the brightness of a region changes
+// after a while and a square moves from left to right
+static std::vector<Mat> makeMotionFrames(int count)
+{
+    RNG rng(0xb1a5);
+    Mat background(480, 640, CV_8UC1);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    GaussianBlur(background, background, Size(15, 15), 0);
+
+    std::vector<Mat> frames;
+    for (int f = 0; f < count; f++)
+    {
+        Mat frame = background.clone();
+        if (f >= 30)
+            frame(Rect(320, 40, 200, 120)) += Scalar::all(60);
+        Rect square(20 + 9 * f, 260, 60, 60);
+        frame(square & Rect(0, 0, frame.cols, frame.rows)).setTo(Scalar::all(f % 2 ? 240 : 10));
+        frames.push_back(frame);
+    }
+    return frames;
+}
+
+static std::vector<Mat> computeMotionSaliency(const std::vector<Mat>& frames)
+{
+    Ptr<MotionSaliencyBinWangApr2014> saliency = MotionSaliencyBinWangApr2014::create();
+    saliency->setImagesize(frames[0].cols, frames[0].rows);
+    saliency->init();
+
+    std::vector<Mat> masks(frames.size());
+    for (size_t f = 0; f < frames.size(); f++)
+        saliency->computeSaliency(frames[f], masks[f]);
+    return masks;
+}
+
+TEST(Saliency_MotionBinWangApr2014, same_masks_with_any_number_of_threads)
+{
+    // long enough for the background to be learned into the templates
+    std::vector<Mat> frames = makeMotionFrames(70);
+
+    int nThreads = getNumThreads();
+    setNumThreads(1);
+    std::vector<Mat> expected = computeMotionSaliency(frames);
+    setNumThreads(getNumberOfCPUs());
+    std::vector<Mat> masks = computeMotionSaliency(frames);
+    setNumThreads(nThreads);
+
+    int foreground = 0;
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        ASSERT_EQ(expected[f].size(), masks[f].size());
+        EXPECT_EQ(0, cvtest::norm(expected[f], masks[f], NORM_INF)) << "frame " << f;
+        foreground += countNonZero(masks[f]);
+    }
+    EXPECT_GT(foreground, 0);
+}
+
+// A constant scene is learned after 51 frames. When its brightness changes,
+// the potential background replaces the last template once it has been seen
+// more than 200 times, and the ordering must bring it in front of the empty
+// templates so that the low resolution detection also takes it as
+// background in the next frame.
+TEST(Saliency_MotionBinWangApr2014, changed_background_is_ordered_in_front)
+{
+    Ptr<MotionSaliencyBinWangApr2014> saliency = MotionSaliencyBinWangApr2014::create();
+    saliency->setImagesize(8, 8);
+    saliency->init();
+
+    Mat mask;
+    for (int f = 0; f < 650; f++)
+    {
+        Mat frame(8, 8, CV_8UC1, Scalar::all(f < 400 ? 60 : 180));
+        saliency->computeSaliency(frame, mask);
+
+        bool foreground = f < 51 || (f >= 400 && f < 601);
+        ASSERT_EQ(foreground ? 64 : 0, countNonZero(mask)) << "frame " << f;
+    }
+}
+
+}
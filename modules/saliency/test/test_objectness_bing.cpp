@@ -0,0 +1,132 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::saliency;
+
+// directory of the temporary files
+static std::string tempDirectory()
+{
+    std::string name = tempfile();
+    size_t pos = name.find_last_of("/\\");
+    return pos == std::string::npos ? std::string(".") : name.substr(0, pos);
+}
+
+// writes a BING model with random filters in the layout read by ObjectnessBING::loadTrainedModel
+static void writeBingModel(const std::string& dir)
+{
+    static const char* clrNames[] = { "MAXBGR", "HSV", "I" };
+    // window sizes from 16x16 to 128x128, index r stands for 2^(r/6+4) rows by 2^(r%6+4) columns
+    const int sizes[] = { 0, 7, 8, 13, 14, 21 };
+    const int nbSizes = (int)(sizeof(sizes) / sizeof(sizes[0]));
+
+    RNG rng(0x1357);
+    for (int clr = 0; clr < 3; clr++)
+    {
+        std::string name = format("ObjNessB2W8%s", clrNames[clr]);
+
+        Mat filter(8, 8, CV_32F);
+        rng.fill(filter, RNG::UNIFORM, -1, 1);
+        Mat idx(nbSizes, 1, CV_32S, (void*)sizes);
+        Mat reweight(nbSizes, 2, CV_32F);
+        for (int i = 0; i < nbSizes; i++)
+        {
+            reweight.at<float>(i, 0) = rng.uniform(0.5f, 1.5f);
+            reweight.at<float>(i, 1) = rng.uniform(-0.5f, 0.5f);
+        }
+
+        FileStorage fs1(dir + "/" + name + ".wS1.yml.gz", FileStorage::WRITE);
+        fs1 << name << filter;
+        FileStorage fsI(dir + "/" + name + ".idx.yml.gz", FileStorage::WRITE);
+        fsI << name << idx;
+        FileStorage fs2(dir + "/" + name + ".wS2.yml.gz", FileStorage::WRITE);
+        fs2 << name << reweight;
+    }
+}
+
+static Mat makeObjectnessImage(RNG& rng)
+{
+    Mat img(120, 160, CV_8UC3, Scalar::all(rng.uniform(0, 256)));
+    for (int i = 0; i < 8; i++)
+    {
+        Point corner(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        rectangle(img, corner, corner + Point(rng.uniform(10, 60), rng.uniform(10, 60)), color, -1);
+    }
+    return img;
+}
+
+TEST(Saliency_ObjectnessBING, batch_matches_single_images)
+{
+    std::string dir = tempDirectory();
+    writeBingModel(dir);
+
+    RNG rng(0x2468);
+    std::vector<Mat> images;
+    for (int i = 0; i < 4; i++)
+        images.push_back(makeObjectnessImage(rng));
+
+    Ptr<ObjectnessBING> bing = ObjectnessBING::create();
+    bing->setTrainingPath(dir);
+    bing->setBBResDir(dir);
+
+    std::vector<std::vector<Vec4i> > batchBoxes;
+    std::vector<std::vector<float> > batchValues;
+    bing->computeSaliencyBatch(images, batchBoxes, batchValues);
+    ASSERT_EQ(images.size(), batchBoxes.size());
+    ASSERT_EQ(images.size(), batchValues.size());
+
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        std::vector<Vec4i> boxes;
+        ASSERT_TRUE(bing->computeSaliency(images[i], boxes));
+        std::vector<float> values = bing->getobjectnessValues();
+        EXPECT_FALSE(boxes.empty()) << "image " << i;
+
+        ASSERT_EQ(boxes.size(), batchBoxes[i].size()) << "image " << i;
+        ASSERT_EQ(values.size(), batchValues[i].size()) << "image " << i;
+        for (size_t j = 0; j < boxes.size(); j++)
+        {
+            EXPECT_EQ(boxes[j], batchBoxes[i][j]) << "image " << i << ", box " << j;
+            EXPECT_EQ(values[j], batchValues[i][j]) << "image " << i << ", box " << j;
+        }
+    }
+}
+
+TEST(Saliency_ObjectnessBING, partial_model_is_loaded_again)
+{
+    std::string dir = tempDirectory();
+    writeBingModel(dir);
+
+    RNG rng(0x8642);
+    std::vector<Mat> images(1, makeObjectnessImage(rng));
+
+    Ptr<ObjectnessBING> reference = ObjectnessBING::create();
+    reference->setTrainingPath(dir);
+    std::vector<std::vector<Vec4i> > expectedBoxes;
+    std::vector<std::vector<float> > expectedValues;
+    reference->computeSaliencyBatch(images, expectedBoxes, expectedValues);
+
+    // without the stage II weights, the model is only partially loaded
+    static const char* clrNames[] = { "MAXBGR", "HSV", "I" };
+    for (int clr = 0; clr < 3; clr++)
+        std::remove((dir + format("/ObjNessB2W8%s.wS2.yml.gz", clrNames[clr])).c_str());
+
+    Ptr<ObjectnessBING> bing = ObjectnessBING::create();
+    bing->setTrainingPath(dir);
+    std::vector<std::vector<Vec4i> > boxes;
+    std::vector<std::vector<float> > values;
+    bing->computeSaliencyBatch(images, boxes, values);
+
+    // once the weights are back, the next call loads the whole model
+    writeBingModel(dir);
+    bing->computeSaliencyBatch(images, boxes, values);
+    ASSERT_EQ(1u, boxes.size());
+    ASSERT_EQ(1u, values.size());
+    EXPECT_TRUE(boxes[0] == expectedBoxes[0]);
+    EXPECT_TRUE(values[0] == expectedValues[0]);
+}
+
+}
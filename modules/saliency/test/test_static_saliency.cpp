@@ -0,0 +1,118 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::saliency;
+
+// fine grained saliency computed pixel by pixel with the integral image,
+// as in the original implementation
+static Mat referenceFineGrained(const Mat& image)
+{
+    const int numScales = 6;
+    const int neighborhoods[numScales] = { 3*4, 3*4*2, 3*4*2*2, 7*4, 7*4*2, 7*4*2*2 };
+
+    Mat gray;
+    if (image.channels() == 3)
+        cvtColor(image, gray, COLOR_BGR2GRAY);
+    else
+        image.copyTo(gray);
+    GaussianBlur(gray, gray, Size(3, 3), 0, 0);
+    GaussianBlur(gray, gray, Size(3, 3), 0, 0);
+
+    Mat integralImage;
+    integral(gray, integralImage, CV_32F);
+
+    Mat sumOn = Mat::zeros(gray.size(), CV_32S), sumOff = Mat::zeros(gray.size(), CV_32S);
+    for (int s = 0; s < numScales; s++)
+    {
+        for (int y = 0; y < gray.rows; y++)
+            for (int x = 0; x < gray.cols; x++)
+            {
+                int n = neighborhoods[s];
+                int x1 = std::min(std::max(x - n + 1, 0), integralImage.cols - 1);
+                int x2 = std::min(std::max(x + n + 1, 0), integralImage.cols - 1);
+                int y1 = std::min(std::max(y - n + 1, 0), integralImage.rows - 1);
+                int y2 = std::min(std::max(y + n + 1, 0), integralImage.rows - 1);
+                int centerVal = gray.at<uchar>(y, x);
+
+                float value = (float)(integralImage.at<float>(y2, x2) + integralImage.at<float>(y1, x1) -
+                                      integralImage.at<float>(y2, x1) - integralImage.at<float>(y1, x2));
+                value = (value - centerVal) / (((x2 - x1) * (y2 - y1)) - 1);
+
+                float meanOn = centerVal - value;
+                float meanOff = value - centerVal;
+                sumOn.at<int>(y, x) += meanOn > 0 ? (uchar)meanOn : 0;
+                sumOff.at<int>(y, x) += meanOff > 0 ? (uchar)meanOff : 0;
+            }
+    }
+
+    double maxOn = 0, maxOff = 0;
+    minMaxLoc(sumOn, 0, &maxOn);
+    minMaxLoc(sumOff, 0, &maxOff);
+
+    Mat on(gray.size(), CV_8U), off(gray.size(), CV_8U);
+    for (int y = 0; y < gray.rows; y++)
+        for (int x = 0; x < gray.cols; x++)
+        {
+            int vOn = sumOn.at<int>(y, x), vOff = sumOff.at<int>(y, x);
+            on.at<uchar>(y, x) = maxOn > 0 ? (uchar)(255.*((float)(vOn / (float)(int)maxOn))) : 0;
+            off.at<uchar>(y, x) = maxOff > 0 ? (uchar)(255.*((float)(vOff / (float)(int)maxOff))) : 0;
+        }
+
+    minMaxLoc(on, 0, &maxOn);
+    minMaxLoc(off, 0, &maxOff);
+    int maxVal = (int)std::max(maxOn, maxOff);
+
+    Mat saliency(gray.size(), CV_8U);
+    for (int y = 0; y < gray.rows; y++)
+        for (int x = 0; x < gray.cols; x++)
+        {
+            int sum = on.at<uchar>(y, x) + off.at<uchar>(y, x);
+            saliency.at<uchar>(y, x) = maxVal > 0 ? (uchar)std::min(255. * (float)sum / (float)maxVal, 255.) : 0;
+        }
+
+    return saliency;
+}
+
+TEST(Saliency_FineGrained, matches_reference)
+{
+    RNG rng(0x5a11);
+    // larger than the largest neighborhood, so that the boxes are clipped
+    // on some sides only
+    Mat image(150, 260, CV_8UC3, Scalar::all(rng.uniform(0, 256)));
+    for (int i = 0; i < 10; i++)
+    {
+        Point center(rng.uniform(0, image.cols), rng.uniform(0, image.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2)
+            circle(image, center, rng.uniform(5, 40), color, -1);
+        else
+            rectangle(image, center, center + Point(rng.uniform(5, 80), rng.uniform(5, 80)), color, -1);
+    }
+
+    Ptr<StaticSaliencyFineGrained> saliency = StaticSaliencyFineGrained::create();
+    Mat saliencyMap;
+    ASSERT_TRUE(saliency->computeSaliency(image, saliencyMap));
+
+    Mat expected = referenceFineGrained(image);
+    ASSERT_EQ(CV_8U, saliencyMap.type());
+    ASSERT_EQ(expected.size(), saliencyMap.size());
+    EXPECT_EQ(0, cvtest::norm(expected, saliencyMap, NORM_INF));
+    EXPECT_EQ(255, cvtest::norm(saliencyMap, NORM_INF));
+}
+
+TEST(Saliency_FineGrained, flat_image_has_no_saliency)
+{
+    Mat image(60, 80, CV_8UC1, Scalar::all(90));
+
+    Ptr<StaticSaliencyFineGrained> saliency = StaticSaliencyFineGrained::create();
+    Mat saliencyMap;
+    ASSERT_TRUE(saliency->computeSaliency(image, saliencyMap));
+
+    ASSERT_EQ(image.size(), saliencyMap.size());
+    EXPECT_EQ(0, countNonZero(saliencyMap));
+}
+
+}
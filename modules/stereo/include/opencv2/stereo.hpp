@@ -112,6 +112,26 @@ namespace cv
             virtual int getDisp12MaxDiff() const = 0;
             virtual void setDisp12MaxDiff(int disp12MaxDiff) = 0;
 
+            /** @brief Video mode for stereo streams from a fixed rig.
+
+            In the video mode the matcher keeps the disparity of the previous frame pair and searches, for every
+            pixel with a valid previous disparity, only the disparities within getTemporalSearchRadius() of it.
+            The pixels without a previous disparity are searched over the full range. If too many pixels end on the
+            border of their search window (for example after a scene cut), the frame is computed again over the
+            full range. The census transforms of the rows that did not change since the previous pair are reused.
+            */
+            virtual bool getVideoMode() const = 0;
+            virtual void setVideoMode(bool videoMode) = 0;
+
+            /** @brief Half size of the disparity window searched around the previous disparity in the video mode.
+            */
+            virtual int getTemporalSearchRadius() const = 0;
+            virtual void setTemporalSearchRadius(int radius) = 0;
+
+            /** @brief Forgets the previous frame pair, the next frame is computed over the full disparity range.
+            */
+            virtual void resetTemporalPrior() = 0;
+
         };
         //!speckle removal algorithms. These algorithms have the purpose of removing small regions
         enum {
@@ -230,6 +250,23 @@ namespace cv
             virtual int getSubPixelInterpolationMethod() const = 0;
             virtual void setSubPixelInterpolationMethod(int value) = 0;
 
+            /** @brief Number of horizontal stripes aggregated in parallel.
+
+            The default value 1 runs the aggregation over the whole image on one thread. With more stripes, each
+            stripe is aggregated by its own thread over a few extra overlap rows, so the vertical paths warm up
+            before they reach the rows that are kept. The result can differ slightly from the single stripe one.
+            The value 0 uses cv::getNumThreads() stripes.
+            */
+            virtual int getNumStripes() const = 0;
+            virtual void setNumStripes(int numStripes) = 0;
+
+            /** @brief If true, the Hamming matching costs are computed row by row during the aggregation instead
+            of being stored for the whole image (rows x cols x (numDisparities + 1) shorts). The disparity is the
+            same in both modes.
+            */
+            virtual bool getLowMemoryMode() const = 0;
+            virtual void setLowMemoryMode(bool lowMemoryMode) = 0;
+
             /** @brief Creates StereoSGBM object
 
             @param minDisparity Minimum possible disparity value. Normally, it is zero but sometimes
@@ -144,6 +144,77 @@ namespace cv
                     hamLut[i] = dist;
                 }
             }
+        public:
+            //!computes the hamming distance cost of one row for the disparities [0, maxDisp]
+            //!the cost is computed for the columns [kernelSize, width - kernelSize), the other columns are left unchanged
+            //!if centerRow is given, only the disparities [centerRow[j] - radius, centerRow[j] + radius] are searched for the
+            //!pixels with a non negative center, the other disparities get the largest hamming distance
+            static void hammingDistanceRow(const int *leftRow, const int *rightRow, short *c, int width, int maxDisp,
+                                           int kernelSize, bool usePopcnt, const int *hammLut,
+                                           const short *centerRow = 0, int radius = 0)
+            {
+                const int MASK = 65535;
+                //the largest hamming distance between two 32 bit descriptors
+                const short MAX_HAMMING = 32;
+                for (int j = kernelSize; j < width - kernelSize; j++)
+                {
+                    short *cj = c + j * (maxDisp + 1);
+                    int dlo = 0, dhi = maxDisp;
+                    if (centerRow && centerRow[j] >= 0)
+                    {
+                        dlo = std::max(centerRow[j] - radius, 0);
+                        dhi = std::min(centerRow[j] + radius, maxDisp);
+                        for (int d = 0; d < dlo; d++)
+                            cj[d] = MAX_HAMMING;
+                        for (int d = dhi + 1; d <= maxDisp; d++)
+                            cj[d] = MAX_HAMMING;
+                    }
+                    int xorul;
+                    //for the disparities larger than j the right pixel is clamped to the first column
+                    int dmax = std::min(dhi, j);
+                    int dclamp = std::max(dmax + 1, dlo);
+#if CV_POPCNT
+                    if (usePopcnt)
+                    {
+                        for (int d = dlo; d <= dmax; d++)
+                        {
+                            xorul = leftRow[j] ^ rightRow[j - d];
+                            cj[d] = (short)_mm_popcnt_u32(xorul);
+                        }
+                        xorul = leftRow[j] ^ rightRow[0];
+                        for (int d = dclamp; d <= dhi; d++)
+                            cj[d] = (short)_mm_popcnt_u32(xorul);
+                    }
+                    else
+#endif
+                    {
+                        for (int d = dlo; d <= dmax; d++)
+                        {
+                            xorul = leftRow[j] ^ rightRow[j - d];
+                            cj[d] = (short)(hammLut[xorul & MASK] + hammLut[(xorul >> 16) & MASK]);
+                        }
+                        xorul = leftRow[j] ^ rightRow[0];
+                        for (int d = dclamp; d <= dhi; d++)
+                            cj[d] = (short)(hammLut[xorul & MASK] + hammLut[(xorul >> 16) & MASK]);
+                    }
+                }
+                (void)usePopcnt;
+            }
+            //!returns true if the hardware popcount can be used by hammingDistanceRow
+            static bool useHardwarePopcount()
+            {
+#if CV_POPCNT
+                return checkHardwareSupport(CV_CPU_POPCNT);
+#else
+                return false;
+#endif
+            }
+            //!returns the Hamming lookup table used when the hardware popcount is not available
+            const int *getHammingLut() const
+            {
+                return hamLut;
+            }
+        private:
             //!the class used in computing the hamming distance
             class hammingDistance : public ParallelLoopBody
             {
@@ -151,37 +222,21 @@ namespace cv
                 int *left, *right;
                 short *c;
                 int v,kernelSize, width;
-                int MASK;
+                bool usePopcnt;
                 int *hammLut;
+                const short *prior;
+                int radius;
             public :
-                hammingDistance(const Mat &leftImage, const Mat &rightImage, short *cost, int maxDisp, int kerSize, int *hammingLUT):
-                    left((int *)leftImage.data), right((int *)rightImage.data), c(cost), v(maxDisp),kernelSize(kerSize),width(leftImage.cols), MASK(65535), hammLut(hammingLUT){}
+                hammingDistance(const Mat &leftImage, const Mat &rightImage, short *cost, int maxDisp, int kerSize, int *hammingLUT,
+                                const short *priorCenters = 0, int priorRadius = 0):
+                    left((int *)leftImage.data), right((int *)rightImage.data), c(cost), v(maxDisp),kernelSize(kerSize),width(leftImage.cols), usePopcnt(useHardwarePopcount()), hammLut(hammingLUT),
+                    prior(priorCenters), radius(priorRadius){}
                 void operator()(const cv::Range &r) const {
-                    for (int i = r.start; i <= r.end ; i++)
+                    for (int i = r.start; i < r.end ; i++)
                     {
                         int iw = i * width;
-                        for (int j = kernelSize; j < width - kernelSize; j++)
-                        {
-                            int j2;
-                            int xorul;
-                            int iwj;
-                            iwj = iw + j;
-                            for (int d = 0; d <= v; d++)
-                            {
-                                j2 = (0 > j - d) ? (0) : (j - d);
-                                xorul = left[(iwj)] ^ right[(iw + j2)];
-#if CV_POPCNT
-                                if (checkHardwareSupport(CV_CPU_POPCNT))
-                                {
-                                    c[(iwj)* (v + 1) + d] = (short)_mm_popcnt_u32(xorul);
-                                }
-                                else
-#endif
-                                {
-                                    c[(iwj)* (v + 1) + d] = (short)(hammLut[xorul & MASK] + hammLut[(xorul >> 16) & MASK]);
-                                }
-                            }
-                        }
+                        hammingDistanceRow(left + iw, right + iw, c + iw * (v + 1), width, v, kernelSize, usePopcnt, hammLut,
+                                           prior ? prior + iw : 0, radius);
                     }
                 }
             };
@@ -231,12 +286,14 @@ namespace cv
                 int width,disparity,scallingFact,th;
                 double confCheck;
                 uint8_t *map;
+                uint8_t *invalid;
                 short *c;
             public:
-                makeMap(const Mat &costVolume, int threshold, int maxDisp, double confidence,int scale, Mat &mapFinal)
+                makeMap(const Mat &costVolume, int threshold, int maxDisp, double confidence,int scale, Mat &mapFinal, uint8_t *invalidMap = 0)
                 {
                     c = (short *)costVolume.data;
                     map = mapFinal.data;
+                    invalid = invalidMap;
                     disparity = maxDisp;
                     width = costVolume.cols / ( disparity + 1) - 1;
                     th = threshold;
@@ -261,7 +318,7 @@ namespace cv
                                     p1 = Matching::symetricVInterpolation(c, iw + j - lr, disparity + 1, v,CV_DIAGONAL_SEARCH);
                                     p2 = Matching::symetricVInterpolation(c, iw + j, disparity + 1, lr,CV_VERTICAL_SEARCH);
                                     if (abs(p1 - p2) <= th)
-                                        map[iw + j] = (uint8_t)((p2)* scallingFact);
+                                        setValid(iw + j, (uint8_t)((p2)* scallingFact));
                                     else
                                     {
                                         map[iw + j] = 0;
@@ -272,7 +329,7 @@ namespace cv
                                     if (width - j <= disparity)
                                     {
                                         p2 = Matching::symetricVInterpolation(c, iw + j, disparity + 1, lr,CV_VERTICAL_SEARCH);
-                                        map[iw + j] = (uint8_t)(p2* scallingFact);
+                                        setValid(iw + j, (uint8_t)(p2* scallingFact));
                                     }
                                 }
                             }
@@ -283,6 +340,14 @@ namespace cv
                         }
                     }
                 }
+            private:
+                //!writes a matched disparity, the zero value of a match is not a rejected pixel
+                void setValid(int k, uint8_t value) const
+                {
+                    map[k] = value;
+                    if (invalid)
+                        invalid[k] = 0;
+                }
             };
             //!median 1x9 paralelized filter
             template <typename T>
@@ -373,6 +438,54 @@ namespace cv
             //int *specklePointY;
             //long long *pus;
             int previous_size;
+            //!the census transform inputs of the previous frame pair, used in the video mode
+            Mat previousCensusInput[2];
+            //!census images of a band of rows
+            Mat bandCensus[2];
+            //!computes the census transform of the two images with the parameters of the matcher
+            //!it has to be implemented by the matchers calling updateCensusImages
+            virtual void censusTransformPair(const Mat &, const Mat &, Mat &, Mat &)
+            {
+                CV_Error(Error::StsNotImplemented, "the matcher does not implement the census transform of an image pair");
+            }
+            //!updates the census images of the left and right image, recomputing only the rows affected by
+            //!the rows that differ from the previous pair. margin is the half size of the census kernel
+            void updateCensusImages(const Mat &left, const Mat &right, Mat &censusLeft, Mat &censusRight, int margin)
+            {
+                std::vector<Range> bands;
+                changedCensusBands(left, right, previousCensusInput[0], previousCensusInput[1], margin, bands);
+                for (size_t b = 0; b < bands.size(); b++)
+                {
+                    //the census rows of the band depend on margin image rows above and below it
+                    int y0 = std::max(bands[b].start - margin, 0);
+                    int y1 = std::min(bands[b].end + margin, left.rows);
+                    if (y1 - y0 < 2 * margin + 1)
+                    {
+                        y1 = std::min(y0 + 2 * margin + 1, left.rows);
+                        y0 = std::max(y1 - 2 * margin - 1, 0);
+                    }
+                    if (y0 == 0 && y1 == left.rows)
+                    {
+                        censusTransformPair(left, right, censusLeft, censusRight);
+                        continue;
+                    }
+                    bandCensus[0].create(y1 - y0, left.cols, censusLeft.type());
+                    bandCensus[1].create(y1 - y0, left.cols, censusRight.type());
+                    bandCensus[0].setTo(0);
+                    bandCensus[1].setTo(0);
+                    censusTransformPair(left.rowRange(y0, y1), right.rowRange(y0, y1), bandCensus[0], bandCensus[1]);
+                    copyCensusRows(bandCensus[0], bands[b].start - y0, censusLeft, bands[b].start, bands[b].size());
+                    copyCensusRows(bandCensus[1], bands[b].start - y0, censusRight, bands[b].start, bands[b].size());
+                }
+                left.copyTo(previousCensusInput[0]);
+                right.copyTo(previousCensusInput[1]);
+            }
+            //!forgets the previous frame pair, the next call of updateCensusImages computes the whole images
+            void resetCensusHistory()
+            {
+                previousCensusInput[0].release();
+                previousCensusInput[1].release();
+            }
             //!method for setting the maximum disparity
             void setMaxDisparity(int val)
             {
@@ -418,7 +531,114 @@ namespace cv
                 CV_Assert(cost.cols / (maxDisparity + 1) == leftImage.cols);
                 short *c = (short *)cost.data;
                 memset(c, 0, sizeof(c[0]) * leftImage.cols * leftImage.rows * (maxDisparity + 1));
-                parallel_for_(cv::Range(kernelSize / 2,leftImage.rows - kernelSize / 2), hammingDistance(leftImage,rightImage,(short *)cost.data,maxDisparity,kernelSize / 2,hamLut));
+                //the rows [kernelSize / 2, rows - kernelSize / 2] are computed
+                parallel_for_(cv::Range(kernelSize / 2,leftImage.rows - kernelSize / 2 + 1), hammingDistance(leftImage,rightImage,(short *)cost.data,maxDisparity,kernelSize / 2,hamLut));
+            }
+            //! Hamming distance computation restricted around a disparity prior
+            //! prior is a CV_16S image holding for every pixel the center of the searched disparities, or -1 for the full range
+            //! only the disparities [center - radius, center + radius] are computed, the others get the largest hamming distance
+            void hammingDistanceBlockMatching(const Mat &leftImage, const Mat &rightImage, Mat &cost, const Mat &prior, int radius, const int kernelSize = 9)
+            {
+                CV_Assert(leftImage.cols == rightImage.cols);
+                CV_Assert(leftImage.rows == rightImage.rows);
+                CV_Assert(kernelSize % 2 != 0);
+                CV_Assert(cost.rows == leftImage.rows);
+                CV_Assert(cost.cols / (maxDisparity + 1) == leftImage.cols);
+                CV_Assert(prior.type() == CV_16S && prior.size() == leftImage.size() && prior.isContinuous());
+                CV_Assert(radius >= 0);
+                short *c = (short *)cost.data;
+                memset(c, 0, sizeof(c[0]) * leftImage.cols * leftImage.rows * (maxDisparity + 1));
+                parallel_for_(cv::Range(kernelSize / 2,leftImage.rows - kernelSize / 2 + 1), hammingDistance(leftImage,rightImage,(short *)cost.data,maxDisparity,kernelSize / 2,hamLut,
+                                                                                                            (const short *)prior.data, radius));
+            }
+            //! converts a disparity map of the matcher into the search centers used by the temporal prior
+            //! a disparity value v gives the center cvRound(v / scale) - offset, the value invalid, the pixels set in
+            //! invalidMask and the centers outside [0, numDisp) give -1, that is the full disparity range
+            static void disparityPrior(const Mat &disp, double scale, int invalid, int offset, int numDisp, Mat &prior,
+                                       const Mat &invalidMask = Mat())
+            {
+                CV_Assert(disp.type() == CV_8U || disp.type() == CV_16S);
+                CV_Assert(scale > 0);
+                CV_Assert(invalidMask.empty() || (invalidMask.type() == CV_8U && invalidMask.size() == disp.size()));
+                prior.create(disp.size(), CV_16S);
+                for (int i = 0; i < disp.rows; i++)
+                {
+                    short *p = prior.ptr<short>(i);
+                    const uchar *m = invalidMask.empty() ? 0 : invalidMask.ptr<uchar>(i);
+                    for (int j = 0; j < disp.cols; j++)
+                    {
+                        int v = disp.type() == CV_8U ? (int)disp.at<uchar>(i, j) : (int)disp.at<short>(i, j);
+                        int center = cvRound(v / scale) - offset;
+                        p[j] = (short)((v == invalid || (m && m[j]) || center < 0 || center >= numDisp) ? -1 : center);
+                    }
+                }
+            }
+            //! returns the fraction of the pixels searched around a prior center, whose new center is invalid or lies
+            //! on the border of the searched window, which means that the true minimum may be outside of the window
+            static double priorDisagreement(const Mat &prior, const Mat &newPrior, int radius)
+            {
+                CV_Assert(prior.type() == CV_16S && newPrior.type() == CV_16S && prior.size() == newPrior.size());
+                int searched = 0, disagree = 0;
+                for (int i = 0; i < prior.rows; i++)
+                {
+                    const short *p = prior.ptr<short>(i);
+                    const short *q = newPrior.ptr<short>(i);
+                    for (int j = 0; j < prior.cols; j++)
+                    {
+                        if (p[j] < 0)
+                            continue;
+                        searched++;
+                        if (q[j] < 0 || std::abs(q[j] - p[j]) >= radius)
+                            disagree++;
+                    }
+                }
+                return searched > 0 ? (double)disagree / searched : 0;
+            }
+            //! finds the bands of rows whose census transform has to be recomputed, because an image row
+            //! closer than margin rows differs from the same row of the previous pair
+            //! if the previous pair is empty or of another size, the whole image is returned
+            static void changedCensusBands(const Mat &left, const Mat &right, const Mat &prevLeft, const Mat &prevRight,
+                                           int margin, std::vector<Range> &bands)
+            {
+                bands.clear();
+                int rows = left.rows;
+                if (prevLeft.size() != left.size() || prevRight.size() != right.size() ||
+                    prevLeft.type() != left.type() || prevRight.type() != right.type())
+                {
+                    bands.push_back(Range(0, rows));
+                    return;
+                }
+                size_t rowSize = left.cols * left.elemSize();
+                std::vector<uchar> changed(rows, 0);
+                for (int i = 0; i < rows; i++)
+                {
+                    if (memcmp(left.ptr(i), prevLeft.ptr(i), rowSize) != 0 ||
+                        memcmp(right.ptr(i), prevRight.ptr(i), rowSize) != 0)
+                    {
+                        for (int k = std::max(i - margin, 0); k <= std::min(i + margin, rows - 1); k++)
+                            changed[k] = 1;
+                    }
+                }
+                for (int i = 0; i < rows; )
+                {
+                    if (!changed[i])
+                    {
+                        i++;
+                        continue;
+                    }
+                    int start = i;
+                    while (i < rows && changed[i])
+                        i++;
+                    bands.push_back(Range(start, i));
+                }
+            }
+            //! copies count rows of a census image, starting at srcRow, to the rows of dst starting at dstRow
+            //! the census images are stored as width ints per row
+            static void copyCensusRows(const Mat &src, int srcRow, Mat &dst, int dstRow, int count)
+            {
+                CV_Assert(src.cols == dst.cols);
+                int width = src.cols;
+                memcpy((int *)dst.data + dstRow * width, (const int *)src.data + srcRow * width, sizeof(int) * width * count);
             }
             //preprocessing the cost volume in order to get it ready for aggregation
             void costGathering(const Mat &hammingDistanceCost, Mat &cost)
@@ -565,15 +785,23 @@ namespace cv
             *disparity - represents the maximum disparity
             *map - is the disparity map that will result
             *th - is the LR threshold
+            *invalidMap - if given, receives 255 for the pixels without a match, which are 0 in the map, and 0 for the others
             */
-            void dispartyMapFormation(const Mat &costVolume, Mat &mapFinal, int th)
+            void dispartyMapFormation(const Mat &costVolume, Mat &mapFinal, int th, Mat *invalidMap = 0)
             {
                 uint8_t *map = mapFinal.data;
                 int disparity = maxDisparity;
                 int width = costVolume.cols / ( disparity + 1) - 1;
                 int height = costVolume.rows - 1;
                 memset(map, 0, sizeof(map[0]) * width * height);
-                parallel_for_(Range(0,height - 1), makeMap(costVolume,th,disparity,confidenceCheck,scallingFactor,mapFinal));
+                uint8_t *invalid = 0;
+                if (invalidMap)
+                {
+                    invalidMap->create(height, width, CV_8U);
+                    invalidMap->setTo(Scalar::all(255));
+                    invalid = invalidMap->data;
+                }
+                parallel_for_(Range(0,height - 1), makeMap(costVolume,th,disparity,confidenceCheck,scallingFactor,mapFinal,invalid));
             }
         public:
             //!a median filter of 1x9 and 9x1
@@ -599,7 +827,7 @@ namespace cv
             {
                 hammingLut();
             }
-            ~Matching(void)
+            virtual ~Matching(void)
             {
             }
             //constructor for the matching class
@@ -49,6 +49,8 @@ using namespace perf;
 
 typedef std::tr1::tuple<Size, MatType, MatDepth> s_bm_test_t;
 typedef perf::TestBaseWithParam<s_bm_test_t> s_bm;
+typedef std::tr1::tuple<Size, int, bool> s_sgm_stripes_test_t;
+typedef perf::TestBaseWithParam<s_sgm_stripes_test_t> s_sgm_stripes;
 
 PERF_TEST_P( s_bm, sgm_perf,
             testing::Combine(
@@ -77,6 +79,35 @@ PERF_TEST_P( s_bm, sgm_perf,
     }
     SANITY_CHECK(out1);
 }
+PERF_TEST_P( s_sgm_stripes, sgm_stripes_perf,
+            testing::Combine(
+            testing::Values( cv::Size(512, 283),  cv::Size(320, 240)),
+            testing::Values( 1, 0 ),
+            testing::Bool()
+            )
+            )
+{
+    Size sz = std::tr1::get<0>(GetParam());
+    int numStripes = std::tr1::get<1>(GetParam());
+    bool lowMemory = std::tr1::get<2>(GetParam());
+
+    Mat left(sz, CV_8UC1);
+    Mat right(sz, CV_8UC1);
+    Mat out1(sz, CV_16S);
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 16, 5);
+    sgbm->setBinaryKernelType(CV_DENSE_CENSUS);
+    sgbm->setNumStripes(numStripes);
+    sgbm->setLowMemoryMode(lowMemory);
+    declare.in(left, right, WARMUP_RNG)
+        .out(out1)
+        .time(0.1)
+        .iterations(20);
+    TEST_CYCLE()
+    {
+        sgbm->compute(left, right, out1);
+    }
+    SANITY_CHECK_NOTHING();
+}
 PERF_TEST_P( s_bm, bm_perf,
             testing::Combine(
             testing::Values( cv::Size(512, 383),  cv::Size(320, 240) ),
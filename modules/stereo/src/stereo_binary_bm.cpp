@@ -74,6 +74,8 @@ namespace cv
                 scalling = 4;
                 kernelType = CV_MODIFIED_CENSUS_TRANSFORM;
                 agregationWindowSize = 9;
+                videoMode = false;
+                temporalSearchRadius = 4;
             }
 
             int preFilterType;
@@ -93,6 +95,8 @@ namespace cv
             int regionRemoval;
             int kernelType;
             int agregationWindowSize;
+            bool videoMode;
+            int temporalSearchRadius;
         };
 
         static void prefilterNorm(const Mat& src, Mat& dst, int winsize, int ftzero, uchar* buf)
@@ -364,46 +368,80 @@ namespace cv
                     left = left0;
                     right = right0;
                 }
+                if(params.videoMode)
+                    updateCensusImages(left, right, censusImage[0], censusImage[1], params.kernelSize / 2);
+                else
+                    censusTransformPair(left, right, censusImage[0], censusImage[1]);
+
+                //the map written by dispartyMapFormation, one byte per pixel
+                Mat map(height, width, CV_8U, disp0.data);
+                bool usePrior = params.videoMode && disparityPriorMap.size() == left0.size();
+                if(usePrior)
+                    hammingDistanceBlockMatching(censusImage[0], censusImage[1], hammingDistance, disparityPriorMap, params.temporalSearchRadius);
+                else
+                    hammingDistanceBlockMatching(censusImage[0], censusImage[1], hammingDistance);
+                disparityFromCost(disp0, aux, FILTERED);
+                if(params.videoMode)
+                {
+                    //above this fraction of disagreeing pixels the frame is computed again over the full range
+                    const double MAX_PRIOR_DISAGREEMENT = 0.25;
+                    Mat newPrior;
+                    temporalPrior(map, FILTERED, newPrior);
+                    //the previous disparity does not explain this frame, for example after a scene cut
+                    if(usePrior && priorDisagreement(disparityPriorMap, newPrior, params.temporalSearchRadius) > MAX_PRIOR_DISAGREEMENT)
+                    {
+                        hammingDistanceBlockMatching(censusImage[0], censusImage[1], hammingDistance);
+                        disparityFromCost(disp0, aux, FILTERED);
+                        temporalPrior(map, FILTERED, newPrior);
+                    }
+                    disparityPriorMap = newPrior;
+                }
+            }
+            void censusTransformPair(const Mat &left, const Mat &right, Mat &censusLeft, Mat &censusRight)
+            {
                 if(params.kernelType == CV_SPARSE_CENSUS)
                 {
-                    censusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_SPARSE_CENSUS);
+                    censusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_SPARSE_CENSUS);
                 }
                 else if(params.kernelType == CV_DENSE_CENSUS)
                 {
-                    censusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_SPARSE_CENSUS);
+                    censusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_SPARSE_CENSUS);
                 }
                 else if(params.kernelType == CV_CS_CENSUS)
                 {
-                    symetricCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_CS_CENSUS);
+                    symetricCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_CS_CENSUS);
                 }
                 else if(params.kernelType == CV_MODIFIED_CS_CENSUS)
                 {
-                    symetricCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_MODIFIED_CS_CENSUS);
+                    symetricCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_MODIFIED_CS_CENSUS);
                 }
                 else if(params.kernelType == CV_MODIFIED_CENSUS_TRANSFORM)
                 {
-                    modifiedCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_MODIFIED_CENSUS_TRANSFORM,0);
+                    modifiedCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_MODIFIED_CENSUS_TRANSFORM,0);
                 }
                 else if(params.kernelType == CV_MEAN_VARIATION)
                 {
-                    parSumsIntensityImage[0].create(left0.rows, left0.cols,CV_32SC4);
-                    parSumsIntensityImage[1].create(left0.rows, left0.cols,CV_32SC4);
-                    Integral[0].create(left0.rows,left0.cols,CV_32SC4);
-                    Integral[1].create(left0.rows,left0.cols,CV_32SC4);
+                    parSumsIntensityImage[0].create(left.rows, left.cols,CV_32SC4);
+                    parSumsIntensityImage[1].create(left.rows, left.cols,CV_32SC4);
+                    Integral[0].create(left.rows,left.cols,CV_32SC4);
+                    Integral[1].create(left.rows,left.cols,CV_32SC4);
                     integral(left, parSumsIntensityImage[0],CV_32S);
                     integral(right, parSumsIntensityImage[1],CV_32S);
                     imageMeanKernelSize(parSumsIntensityImage[0], params.kernelSize,Integral[0]);
                     imageMeanKernelSize(parSumsIntensityImage[1], params.kernelSize, Integral[1]);
-                    modifiedCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1],CV_MEAN_VARIATION,0,Integral[0], Integral[1]);
+                    modifiedCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_MEAN_VARIATION,0,Integral[0], Integral[1]);
                 }
                 else if(params.kernelType == CV_STAR_KERNEL)
                 {
-                    starCensusTransform(left,right,params.kernelSize,censusImage[0],censusImage[1]);
+                    starCensusTransform(left,right,params.kernelSize,censusLeft,censusRight);
                 }
-                hammingDistanceBlockMatching(censusImage[0], censusImage[1], hammingDistance);
+            }
+            //!the steps of the block matching which compute the disparity from the Hamming cost volume
+            void disparityFromCost(Mat &disp0, Mat &aux, int FILTERED)
+            {
                 costGathering(hammingDistance, partialSumsLR);
                 blockAgregation(partialSumsLR, params.agregationWindowSize, agregatedHammingLRCost);
-                dispartyMapFormation(agregatedHammingLRCost, disp0, 3);
+                dispartyMapFormation(agregatedHammingLRCost, disp0, 3, params.videoMode ? &unmatchedMap : 0);
                 Median1x9Filter<uint8_t>(disp0, aux);
                 Median9x1Filter<uint8_t>(aux,disp0);
 
@@ -417,29 +455,41 @@ namespace cv
                         filterSpeckles(disp0, FILTERED, params.speckleWindowSize, params.speckleRange, slidingSumBuf);
                 }
             }
+            //!computes the search centers of the next frame from the disparity map
+            void temporalPrior(const Mat &map, int FILTERED, Mat &prior)
+            {
+                //a pixel without a match is 0 in the map, like a match with the disparity 0, so the pixels
+                //still 0 after the filtering are told apart with the map of the unmatched pixels
+                Mat invalid;
+                compare(map, Scalar::all(0), invalid, CMP_EQ);
+                bitwise_and(invalid, unmatchedMap, invalid);
+                //the speckle filter marks the removed regions with FILTERED
+                int filtered = params.regionRemoval == CV_SPECKLE_REMOVAL_ALGORITHM ? (int)(uchar)FILTERED : -1;
+                disparityPrior(map, params.scalling, filtered, 0, params.numDisparities + 1, prior, invalid);
+            }
             int getAgregationWindowSize() const { return params.agregationWindowSize;}
             void setAgregationWindowSize(int value = 9) { CV_Assert(value % 2 != 0); params.agregationWindowSize = value;}
 
             int getBinaryKernelType() const { return params.kernelType;}
-            void setBinaryKernelType(int value = CV_MODIFIED_CENSUS_TRANSFORM) { CV_Assert(value < 7); params.kernelType = value; }
+            void setBinaryKernelType(int value = CV_MODIFIED_CENSUS_TRANSFORM) { CV_Assert(value < 7); params.kernelType = value; resetTemporalPrior(); }
 
             int getSpekleRemovalTechnique() const { return params.regionRemoval;}
             void setSpekleRemovalTechnique(int factor = CV_SPECKLE_REMOVAL_AVG_ALGORITHM) {CV_Assert(factor < 2); params.regionRemoval = factor; }
 
             bool getUsePrefilter() const { return params.usePrefilter;}
-            void setUsePrefilter(bool value = false) { params.usePrefilter = value;}
+            void setUsePrefilter(bool value = false) { params.usePrefilter = value; resetTemporalPrior();}
 
             int getScalleFactor() const { return params.scalling;}
-            void setScalleFactor(int factor = 4) {CV_Assert(factor > 0); params.scalling = factor; setScallingFactor(factor);}
+            void setScalleFactor(int factor = 4) {CV_Assert(factor > 0); params.scalling = factor; setScallingFactor(factor); resetTemporalPrior();}
 
             int getMinDisparity() const { return params.minDisparity; }
             void setMinDisparity(int minDisparity) {CV_Assert(minDisparity >= 0); params.minDisparity = minDisparity; }
 
             int getNumDisparities() const { return params.numDisparities; }
-            void setNumDisparities(int numDisparities) {CV_Assert(numDisparities > 0); params.numDisparities = numDisparities; }
+            void setNumDisparities(int numDisparities) {CV_Assert(numDisparities > 0); params.numDisparities = numDisparities; resetTemporalPrior(); }
 
             int getBlockSize() const { return params.kernelSize; }
-            void setBlockSize(int blockSize) {CV_Assert(blockSize % 2 != 0); params.kernelSize = blockSize; }
+            void setBlockSize(int blockSize) {CV_Assert(blockSize % 2 != 0); params.kernelSize = blockSize; resetTemporalPrior(); }
 
             int getSpeckleWindowSize() const { return params.speckleWindowSize; }
             void setSpeckleWindowSize(int speckleWindowSize) {CV_Assert(speckleWindowSize >= 0); params.speckleWindowSize = speckleWindowSize; }
@@ -451,13 +501,13 @@ namespace cv
             void setDisp12MaxDiff(int disp12MaxDiff) {CV_Assert(disp12MaxDiff >= 0); params.disp12MaxDiff = disp12MaxDiff; }
 
             int getPreFilterType() const { return params.preFilterType; }
-            void setPreFilterType(int preFilterType) { CV_Assert(preFilterType >= 0); params.preFilterType = preFilterType; }
+            void setPreFilterType(int preFilterType) { CV_Assert(preFilterType >= 0); params.preFilterType = preFilterType; resetTemporalPrior(); }
 
             int getPreFilterSize() const { return params.preFilterSize; }
-            void setPreFilterSize(int preFilterSize) { CV_Assert(preFilterSize >= 0);  params.preFilterSize = preFilterSize; }
+            void setPreFilterSize(int preFilterSize) { CV_Assert(preFilterSize >= 0);  params.preFilterSize = preFilterSize; resetTemporalPrior(); }
 
             int getPreFilterCap() const { return params.preFilterCap; }
-            void setPreFilterCap(int preFilterCap) {CV_Assert(preFilterCap >= 0); params.preFilterCap = preFilterCap; }
+            void setPreFilterCap(int preFilterCap) {CV_Assert(preFilterCap >= 0); params.preFilterCap = preFilterCap; resetTemporalPrior(); }
 
             int getTextureThreshold() const { return params.textureThreshold; }
             void setTextureThreshold(int textureThreshold) {CV_Assert(textureThreshold >= 0); params.textureThreshold = textureThreshold; }
@@ -468,6 +518,18 @@ namespace cv
             int getSmallerBlockSize() const { return 0; }
             void setSmallerBlockSize(int) {}
 
+            bool getVideoMode() const { return params.videoMode; }
+            void setVideoMode(bool videoMode) { params.videoMode = videoMode; resetTemporalPrior(); }
+
+            int getTemporalSearchRadius() const { return params.temporalSearchRadius; }
+            void setTemporalSearchRadius(int radius) { CV_Assert(radius > 0); params.temporalSearchRadius = radius; }
+
+            void resetTemporalPrior()
+            {
+                disparityPriorMap.release();
+                resetCensusHistory();
+            }
+
             void write(FileStorage& fs) const
             {
                 fs << "name" << name_
@@ -481,7 +543,9 @@ namespace cv
                     << "preFilterSize" << params.preFilterSize
                     << "preFilterCap" << params.preFilterCap
                     << "textureThreshold" << params.textureThreshold
-                    << "uniquenessRatio" << params.uniquenessRatio;
+                    << "uniquenessRatio" << params.uniquenessRatio
+                    << "videoMode" << (int)params.videoMode
+                    << "temporalSearchRadius" << params.temporalSearchRadius;
             }
 
             void read(const FileNode& fn)
@@ -499,6 +563,11 @@ namespace cv
                 params.preFilterCap = (int)fn["preFilterCap"];
                 params.textureThreshold = (int)fn["textureThreshold"];
                 params.uniquenessRatio = (int)fn["uniquenessRatio"];
+                if (!fn["videoMode"].empty())
+                    params.videoMode = (int)fn["videoMode"] != 0;
+                if (!fn["temporalSearchRadius"].empty())
+                    params.temporalSearchRadius = (int)fn["temporalSearchRadius"];
+                resetTemporalPrior();
             }
 
             StereoBinaryBMParams params;
@@ -511,6 +580,10 @@ namespace cv
             Mat partialSumsLR;
             Mat agregatedHammingLRCost;
             Mat aux;
+            //!the search centers taken from the previous disparity in the video mode
+            Mat disparityPriorMap;
+            //!the pixels left without a match by the last disparity map formation, in the video mode
+            Mat unmatchedMap;
             static const char* name_;
         };
 
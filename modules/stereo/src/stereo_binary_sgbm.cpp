@@ -73,6 +73,10 @@ namespace cv
                 speckleWindowSize = 0;
                 speckleRange = 0;
                 mode = StereoBinarySGBM::MODE_SGBM;
+                numStripes = 1;
+                lowMemoryMode = false;
+                videoMode = false;
+                temporalSearchRadius = 4;
             }
             StereoBinarySGBMParams( int _minDisparity, int _numDisparities, int _SADWindowSize,
                 int _P1, int _P2, int _disp12MaxDiff, int _preFilterCap,
@@ -93,6 +97,10 @@ namespace cv
                 regionRemoval = 1;
                 kernelType = CV_MODIFIED_CENSUS_TRANSFORM;
                 subpixelInterpolationMethod = CV_QUADRATIC_INTERPOLATION;
+                numStripes = 1;
+                lowMemoryMode = false;
+                videoMode = false;
+                temporalSearchRadius = 4;
             }
             int minDisparity;
             int numDisparities;
@@ -108,6 +116,61 @@ namespace cv
             int regionRemoval;
             int kernelType;
             int subpixelInterpolationMethod;
+            int numStripes;
+            bool lowMemoryMode;
+            bool videoMode;
+            int temporalSearchRadius;
+        };
+
+        /*
+        provides the matching cost of one image row for the disparities [0, numDisparities).
+        the cost is either copied from the precomputed Hamming cost volume or, in the low memory mode,
+        computed on the fly from the census transformed images. Both give the same values.
+        in the low memory mode, an optional prior restricts the computed disparities around the per pixel centers
+        (see Matching::hammingDistanceBlockMatching).
+        */
+        struct BinaryCostRows
+        {
+            BinaryCostRows(const Mat& _hamDist, int _numDisparities) :
+                hamDist(&_hamDist), censusLeft(0), censusRight(0), numDisparities(_numDisparities),
+                border(0), usePopcnt(false), hamLut(0), prior(0), radius(0) {}
+            BinaryCostRows(const Mat& _censusLeft, const Mat& _censusRight, int _numDisparities,
+                int _border, const int* _hamLut, const Mat* _prior = 0, int _radius = 0) :
+                hamDist(0), censusLeft(&_censusLeft), censusRight(&_censusRight), numDisparities(_numDisparities),
+                border(_border), usePopcnt(Matching::useHardwarePopcount()), hamLut(_hamLut),
+                prior(_prior), radius(_radius) {}
+
+            void fill(int y, CostType* pixDiff) const
+            {
+                if( hamDist )
+                {
+                    int ww = hamDist->cols / (numDisparities + 1);
+                    const short* ham = hamDist->ptr<short>(y);
+                    for( int ii = 0; ii < ww; ii++ )
+                        for( int dd = 0; dd < numDisparities; dd++ )
+                            pixDiff[ii * numDisparities + dd] = (CostType)ham[ii * (numDisparities + 1) + dd];
+                    return;
+                }
+                int ww = censusLeft->cols;
+                memset(pixDiff, 0, ww * numDisparities * sizeof(CostType));
+                // same rows as the ones filled by Matching::hammingDistanceBlockMatching
+                if( y < border || y > censusLeft->rows - border )
+                    return;
+                // the census images are addressed as ww ints per row, like in Matching::hammingDistanceBlockMatching.
+                // with maxDisp = numDisparities - 1 the cost row has exactly the layout of pixDiff
+                Matching::hammingDistanceRow((const int*)censusLeft->data + y * ww, (const int*)censusRight->data + y * ww,
+                    pixDiff, ww, numDisparities - 1, border, usePopcnt, hamLut, prior ? prior->ptr<short>(y) : 0, radius);
+            }
+
+            const Mat* hamDist;
+            const Mat* censusLeft;
+            const Mat* censusRight;
+            int numDisparities;
+            int border;
+            bool usePopcnt;
+            const int* hamLut;
+            const Mat* prior;
+            int radius;
         };
 
         /*
@@ -126,10 +189,12 @@ namespace cv
         is written as is, without interpolation.
         disp2cost also has the same size as img1 (or img2).
         It contains the minimum current cost, used to find the best disparity, corresponding to the minimal cost.
+        the row y of disp1 is computed from the matching cost row y + rowOffset of costRows, which allows to
+        process horizontal stripes of the image independently.
         */
         static void computeDisparityBinarySGBM( const Mat& img1, const Mat& img2,
             Mat& disp1, const StereoBinarySGBMParams& params,
-            Mat& buffer,const Mat& hamDist)
+            Mat& buffer, const BinaryCostRows& costRows, int rowOffset)
         {
 #if CV_SSE2
             static const uchar LSBTab[] =
@@ -179,9 +244,6 @@ namespace cv
             // the previous row, i.e. 2 rows in total
             const int NLR = 2;
             const int LrBorder = NLR - 1;
-            int ww = img2.cols;
-            short *ham;
-            ham = (short *)hamDist.data;
             // for each possible stereo match (img1(x,y) <=> img2(x-d,y))
             // we keep pixel difference cost (C) and the summary cost over NR directions (S).
             // we also keep all the partial costs for the previous line L_r(x,d) and also min_k L_r(x, k)
@@ -248,13 +310,7 @@ namespace cv
                             CostType* hsumAdd = hsumBuf + (std::min(k, height-1) % hsumBufNRows)*costBufSize;
                             if( k < height )
                             {
-                                for(int ii = 0; ii <= ww; ii++)
-                                {
-                                    for(int dd = 0; dd <= params.numDisparities; dd++)
-                                    {
-                                        pixDiff[ii * (params.numDisparities)+ dd] = (CostType)(ham[(k * (ww) + ii) * (params.numDisparities +1) + dd]);
-                                    }
-                                }
+                                costRows.fill(k + rowOffset, pixDiff);
                                 memset(hsumAdd, 0, D*sizeof(CostType));
                                 for( x = 0; x <= SW2*D; x += D )
                                 {
@@ -618,6 +674,44 @@ namespace cv
                 }
             }
         }
+        /*
+        aggregates horizontal stripes of the image in parallel. every stripe is extended by "overlap" rows
+        on both sides, so that the aggregation paths are warmed up before reaching the rows of the stripe,
+        and only the rows of the stripe itself are copied to the output disparity.
+        */
+        class BinarySGBMStripeInvoker : public ParallelLoopBody
+        {
+        public:
+            BinarySGBMStripeInvoker(const Mat& _img1, const Mat& _img2, Mat& _disp1,
+                const StereoBinarySGBMParams& _params, std::vector<Mat>& _buffers,
+                const BinaryCostRows& _costRows, int _nstripes, int _overlap) :
+                img1(&_img1), img2(&_img2), disp1(&_disp1), params(&_params), buffers(&_buffers),
+                costRows(&_costRows), nstripes(_nstripes), overlap(_overlap) {}
+
+            void operator()(const Range& range) const
+            {
+                int height = disp1->rows;
+                for( int s = range.start; s < range.end; s++ )
+                {
+                    int y0 = s * height / nstripes, y1 = (s + 1) * height / nstripes;
+                    int ys0 = std::max(y0 - overlap, 0), ys1 = std::min(y1 + overlap, height);
+                    Mat stripeDisp(ys1 - ys0, disp1->cols, disp1->type());
+                    computeDisparityBinarySGBM(*img1, *img2, stripeDisp, *params, (*buffers)[s], *costRows, ys0);
+                    Mat dst = disp1->rowRange(y0, y1);
+                    stripeDisp.rowRange(y0 - ys0, y1 - ys0).copyTo(dst);
+                }
+            }
+        private:
+            const Mat* img1;
+            const Mat* img2;
+            Mat* disp1;
+            const StereoBinarySGBMParams* params;
+            std::vector<Mat>* buffers;
+            const BinaryCostRows* costRows;
+            int nstripes;
+            int overlap;
+        };
+
         class StereoBinarySGBMImpl : public StereoBinarySGBM, public Matching
         {
         public:
@@ -645,27 +739,52 @@ namespace cv
                 censusImageLeft.create(left.rows,left.cols,CV_32SC4);
                 censusImageRight.create(left.rows,left.cols,CV_32SC4);
 
-                hamDist.create(left.rows, left.cols * (params.numDisparities + 1),CV_16S);
+                if( params.videoMode )
+                    updateCensusImages(left, right, censusImageLeft, censusImageRight, params.kernelSize / 2);
+                else
+                    censusTransformPair(left, right, censusImageLeft, censusImageRight);
 
+                bool usePrior = params.videoMode && disparityPriorMap.size() == left.size();
+                disparityFromCensus(left, right, disp, usePrior ? &disparityPriorMap : 0);
+                if( params.videoMode )
+                {
+                    //above this fraction of disagreeing pixels the frame is computed again over the full range
+                    const double MAX_PRIOR_DISAGREEMENT = 0.25;
+                    //the invalid disparity of the matching and of the speckle filter, the 0 values kept by
+                    //the small region removal are matches of the disparity 0
+                    int invalid = (params.minDisparity - 1) * StereoMatcher::DISP_SCALE;
+                    Mat newPrior;
+                    disparityPrior(disp, StereoMatcher::DISP_SCALE, invalid, params.minDisparity, params.numDisparities, newPrior);
+                    //the previous disparity does not explain this frame, for example after a scene cut
+                    if( usePrior && priorDisagreement(disparityPriorMap, newPrior, params.temporalSearchRadius) > MAX_PRIOR_DISAGREEMENT )
+                    {
+                        disparityFromCensus(left, right, disp, 0);
+                        disparityPrior(disp, StereoMatcher::DISP_SCALE, invalid, params.minDisparity, params.numDisparities, newPrior);
+                    }
+                    disparityPriorMap = newPrior;
+                }
+            }
+            void censusTransformPair(const Mat &left, const Mat &right, Mat &censusLeft, Mat &censusRight)
+            {
                 if(params.kernelType == CV_SPARSE_CENSUS)
                 {
-                    censusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_SPARSE_CENSUS);
+                    censusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_SPARSE_CENSUS);
                 }
                 else if(params.kernelType == CV_DENSE_CENSUS)
                 {
-                    censusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_SPARSE_CENSUS);
+                    censusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_SPARSE_CENSUS);
                 }
                 else if(params.kernelType == CV_CS_CENSUS)
                 {
-                    symetricCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_CS_CENSUS);
+                    symetricCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_CS_CENSUS);
                 }
                 else if(params.kernelType == CV_MODIFIED_CS_CENSUS)
                 {
-                    symetricCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_MODIFIED_CS_CENSUS);
+                    symetricCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_MODIFIED_CS_CENSUS);
                 }
                 else if(params.kernelType == CV_MODIFIED_CENSUS_TRANSFORM)
                 {
-                    modifiedCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_MODIFIED_CENSUS_TRANSFORM,0);
+                    modifiedCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_MODIFIED_CENSUS_TRANSFORM,0);
                 }
                 else if(params.kernelType == CV_MEAN_VARIATION)
                 {
@@ -677,16 +796,48 @@ namespace cv
                     integral(right, parSumsIntensityImage[1],CV_32S);
                     imageMeanKernelSize(parSumsIntensityImage[0], params.kernelSize,Integral[0]);
                     imageMeanKernelSize(parSumsIntensityImage[1], params.kernelSize, Integral[1]);
-                    modifiedCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight,CV_MEAN_VARIATION,0,Integral[0], Integral[1]);
+                    modifiedCensusTransform(left,right,params.kernelSize,censusLeft,censusRight,CV_MEAN_VARIATION,0,Integral[0], Integral[1]);
                 }
                 else if(params.kernelType == CV_STAR_KERNEL)
                 {
-                    starCensusTransform(left,right,params.kernelSize,censusImageLeft,censusImageRight);
+                    starCensusTransform(left,right,params.kernelSize,censusLeft,censusRight);
+                }
+            }
+            //!computes the matching costs from the census images, aggregates them and filters the disparity
+            //!if prior is given, only the disparities around its per pixel centers are searched
+            void disparityFromCensus(const Mat &left, const Mat &right, Mat &disp, const Mat *prior)
+            {
+                // kernel size used for the Hamming cost volume, its half is the unfilled border of the volume
+                const int hammingKernelSize = 9;
+                Ptr<BinaryCostRows> costRows;
+                if( params.lowMemoryMode )
+                {
+                    hamDist.release();
+                    costRows = makePtr<BinaryCostRows>(censusImageLeft, censusImageRight, params.numDisparities,
+                        hammingKernelSize / 2, getHammingLut(), prior, params.temporalSearchRadius);
+                }
+                else
+                {
+                    hamDist.create(left.rows, left.cols * (params.numDisparities + 1),CV_16S);
+                    if( prior )
+                        hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist, *prior,
+                            params.temporalSearchRadius, hammingKernelSize);
+                    else
+                        hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist, hammingKernelSize);
+                    costRows = makePtr<BinaryCostRows>(hamDist, params.numDisparities);
                 }
 
-                hammingDistanceBlockMatching(censusImageLeft, censusImageRight, hamDist);
-
-                computeDisparityBinarySGBM( left, right, disp, params, buffer,hamDist);
+                int nstripes = params.numStripes > 0 ? params.numStripes : getNumThreads();
+                // a stripe should not be dominated by its overlap rows
+                nstripes = std::max(std::min(nstripes, left.rows / STRIPE_OVERLAP), 1);
+                if( nstripes == 1 )
+                    computeDisparityBinarySGBM( left, right, disp, params, buffer, *costRows, 0);
+                else
+                {
+                    stripeBuffers.resize(nstripes);
+                    parallel_for_(Range(0, nstripes), BinarySGBMStripeInvoker(left, right, disp, params,
+                        stripeBuffers, *costRows, nstripes, STRIPE_OVERLAP));
+                }
 
                 if(params.regionRemoval == CV_SPECKLE_REMOVAL_AVG_ALGORITHM)
                 {
@@ -722,19 +873,19 @@ namespace cv
             void setSubPixelInterpolationMethod(int value = CV_QUADRATIC_INTERPOLATION) { CV_Assert(value < 2); params.subpixelInterpolationMethod = value;}
 
             int getBinaryKernelType() const { return params.kernelType;}
-            void setBinaryKernelType(int value = CV_MODIFIED_CENSUS_TRANSFORM) { CV_Assert(value < 7); params.kernelType = value; }
+            void setBinaryKernelType(int value = CV_MODIFIED_CENSUS_TRANSFORM) { CV_Assert(value < 7); params.kernelType = value; resetTemporalPrior(); }
 
             int getSpekleRemovalTechnique() const { return params.regionRemoval;}
             void setSpekleRemovalTechnique(int factor = CV_SPECKLE_REMOVAL_AVG_ALGORITHM) { CV_Assert(factor < 2); params.regionRemoval = factor; }
 
             int getMinDisparity() const { return params.minDisparity; }
-            void setMinDisparity(int minDisparity) {CV_Assert(minDisparity >= 0); params.minDisparity = minDisparity; }
+            void setMinDisparity(int minDisparity) {CV_Assert(minDisparity >= 0); params.minDisparity = minDisparity; resetTemporalPrior(); }
 
             int getNumDisparities() const { return params.numDisparities; }
-            void setNumDisparities(int numDisparities) { CV_Assert(numDisparities > 0); params.numDisparities = numDisparities; }
+            void setNumDisparities(int numDisparities) { CV_Assert(numDisparities > 0); params.numDisparities = numDisparities; resetTemporalPrior(); }
 
             int getBlockSize() const { return params.kernelSize; }
-            void setBlockSize(int blockSize) {CV_Assert(blockSize % 2 != 0); params.kernelSize = blockSize; }
+            void setBlockSize(int blockSize) {CV_Assert(blockSize % 2 != 0); params.kernelSize = blockSize; resetTemporalPrior(); }
 
             int getSpeckleWindowSize() const { return params.speckleWindowSize; }
             void setSpeckleWindowSize(int speckleWindowSize) {CV_Assert(speckleWindowSize >= 0); params.speckleWindowSize = speckleWindowSize; }
@@ -760,6 +911,24 @@ namespace cv
             int getMode() const { return params.mode; }
             void setMode(int mode) { params.mode = mode; }
 
+            int getNumStripes() const { return params.numStripes; }
+            void setNumStripes(int numStripes) { CV_Assert(numStripes >= 0); params.numStripes = numStripes; }
+
+            bool getLowMemoryMode() const { return params.lowMemoryMode; }
+            void setLowMemoryMode(bool lowMemoryMode) { params.lowMemoryMode = lowMemoryMode; }
+
+            bool getVideoMode() const { return params.videoMode; }
+            void setVideoMode(bool videoMode) { params.videoMode = videoMode; resetTemporalPrior(); }
+
+            int getTemporalSearchRadius() const { return params.temporalSearchRadius; }
+            void setTemporalSearchRadius(int radius) { CV_Assert(radius > 0); params.temporalSearchRadius = radius; }
+
+            void resetTemporalPrior()
+            {
+                disparityPriorMap.release();
+                resetCensusHistory();
+            }
+
             void write(FileStorage& fs) const
             {
                 fs << "name" << name_
@@ -773,7 +942,11 @@ namespace cv
                     << "uniquenessRatio" << params.uniquenessRatio
                     << "P1" << params.P1
                     << "P2" << params.P2
-                    << "mode" << params.mode;
+                    << "mode" << params.mode
+                    << "numStripes" << params.numStripes
+                    << "lowMemoryMode" << (int)params.lowMemoryMode
+                    << "videoMode" << (int)params.videoMode
+                    << "temporalSearchRadius" << params.temporalSearchRadius;
             }
 
             void read(const FileNode& fn)
@@ -791,10 +964,24 @@ namespace cv
                 params.P1 = (int)fn["P1"];
                 params.P2 = (int)fn["P2"];
                 params.mode = (int)fn["mode"];
+                if( !fn["numStripes"].empty() )
+                    params.numStripes = (int)fn["numStripes"];
+                if( !fn["lowMemoryMode"].empty() )
+                    params.lowMemoryMode = (int)fn["lowMemoryMode"] != 0;
+                if( !fn["videoMode"].empty() )
+                    params.videoMode = (int)fn["videoMode"] != 0;
+                if( !fn["temporalSearchRadius"].empty() )
+                    params.temporalSearchRadius = (int)fn["temporalSearchRadius"];
+                resetTemporalPrior();
             }
 
+            //!the number of rows by which every stripe is extended when aggregating in parallel
+            enum { STRIPE_OVERLAP = 32 };
             StereoBinarySGBMParams params;
             Mat buffer;
+            std::vector<Mat> stripeBuffers;
+            //!the search centers taken from the previous disparity in the video mode
+            Mat disparityPriorMap;
             static const char* name_;
             Mat censusImageLeft;
             Mat censusImageRight;
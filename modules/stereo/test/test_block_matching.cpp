@@ -237,5 +237,244 @@ void CV_SGBlockMatchingTest::run(int )
         return;
     }
 }
+
+class CV_SGBlockMatchingModesTest : public cvtest::BaseTest
+{
+public:
+    CV_SGBlockMatchingModesTest();
+    ~CV_SGBlockMatchingModesTest();
+protected:
+    void run(int /* idx */);
+};
+
+CV_SGBlockMatchingModesTest::CV_SGBlockMatchingModesTest(){}
+CV_SGBlockMatchingModesTest::~CV_SGBlockMatchingModesTest(){}
+
+void CV_SGBlockMatchingModesTest::run(int )
+{
+    Mat image1, image2, gt;
+    image1 = imread(ts->get_data_path() + "testdata/imL2l.bmp", CV_8UC1);
+    image2 = imread(ts->get_data_path() + "testdata/imL2.bmp", CV_8UC1);
+    gt = imread(ts->get_data_path() + "testdata/groundtruth.bmp", CV_8UC1);
+
+    if(image1.empty() || image2.empty() || gt.empty())
+    {
+        ts->printf(cvtest::TS::LOG, "Wrong input data \n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_TEST_DATA);
+        return;
+    }
+
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 16, 9);
+    sgbm->setP1(10);
+    sgbm->setP2(100);
+    sgbm->setUniquenessRatio(1);
+    sgbm->setSpeckleWindowSize(400);
+    sgbm->setSpeckleRange(200);
+    sgbm->setDisp12MaxDiff(1);
+    sgbm->setBinaryKernelType(CV_MODIFIED_CENSUS_TRANSFORM);
+    sgbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sgbm->setSubPixelInterpolationMethod(CV_SIMETRICV_INTERPOLATION);
+
+    Mat dispFull, dispLowMemory, dispStripes;
+    sgbm->compute(image1, image2, dispFull);
+
+    //computing the costs row by row must not change the disparity
+    sgbm->setLowMemoryMode(true);
+    sgbm->compute(image1, image2, dispLowMemory);
+    if(cvtest::norm(dispFull, dispLowMemory, NORM_INF) != 0)
+    {
+        ts->printf(cvtest::TS::LOG, "The low memory mode changes the disparity\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_MISMATCH);
+        return;
+    }
+
+    //the stripes are only approximately equal to the whole image aggregation
+    sgbm->setNumStripes(4);
+    sgbm->compute(image1, image2, dispStripes);
+    double minVal; double maxVal;
+    minMaxLoc(dispStripes, &minVal, &maxVal);
+    Mat test;
+    dispStripes.convertTo(test, CV_8UC1, 255 / (maxVal - minVal));
+    double error = errorLevel(gt,test);
+    if(error > 10)
+    {
+        ts->printf( cvtest::TS::LOG,
+            "Too big error\n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+        return;
+    }
+}
+
+class CV_SGBlockMatchingVideoTest : public cvtest::BaseTest
+{
+public:
+    CV_SGBlockMatchingVideoTest();
+    ~CV_SGBlockMatchingVideoTest();
+protected:
+    void run(int /* idx */);
+};
+
+CV_SGBlockMatchingVideoTest::CV_SGBlockMatchingVideoTest(){}
+CV_SGBlockMatchingVideoTest::~CV_SGBlockMatchingVideoTest(){}
+
+void CV_SGBlockMatchingVideoTest::run(int )
+{
+    Mat image1, image2, gt;
+    image1 = imread(ts->get_data_path() + "testdata/imL2l.bmp", CV_8UC1);
+    image2 = imread(ts->get_data_path() + "testdata/imL2.bmp", CV_8UC1);
+    gt = imread(ts->get_data_path() + "testdata/groundtruth.bmp", CV_8UC1);
+
+    if(image1.empty() || image2.empty() || gt.empty())
+    {
+        ts->printf(cvtest::TS::LOG, "Wrong input data \n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_TEST_DATA);
+        return;
+    }
+
+    Ptr<StereoBinarySGBM> sgbm = StereoBinarySGBM::create(0, 16, 9);
+    sgbm->setP1(10);
+    sgbm->setP2(100);
+    sgbm->setUniquenessRatio(1);
+    sgbm->setSpeckleWindowSize(400);
+    sgbm->setSpeckleRange(200);
+    sgbm->setDisp12MaxDiff(1);
+    sgbm->setBinaryKernelType(CV_MODIFIED_CENSUS_TRANSFORM);
+    sgbm->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+    sgbm->setSubPixelInterpolationMethod(CV_SIMETRICV_INTERPOLATION);
+    sgbm->setVideoMode(true);
+    sgbm->setTemporalSearchRadius(3);
+
+    //the first frame is searched over the full range, the next ones around the previous disparity
+    //and with the census rows of the unchanged images reused
+    Mat disp;
+    for(int frame = 0; frame < 3; frame++)
+    {
+        sgbm->compute(image1, image2, disp);
+        double minVal; double maxVal;
+        minMaxLoc(disp, &minVal, &maxVal);
+        Mat test;
+        disp.convertTo(test, CV_8UC1, 255 / (maxVal - minVal));
+        double error = errorLevel(gt,test);
+        if(error > 10)
+        {
+            ts->printf( cvtest::TS::LOG,
+                "Too big error at frame %d\n", frame);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
+//the fraction of the pixels whose disparities differ by more than maxDiff
+static double differingFraction(const Mat &expected, const Mat &actual, double maxDiff)
+{
+    Mat diff;
+    absdiff(expected, actual, diff);
+    return (double)countNonZero(diff > maxDiff) / expected.total();
+}
+
+class CV_BlockMatchingStaticVideoTest : public cvtest::BaseTest
+{
+public:
+    CV_BlockMatchingStaticVideoTest();
+    ~CV_BlockMatchingStaticVideoTest();
+protected:
+    void run(int /* idx */);
+};
+
+CV_BlockMatchingStaticVideoTest::CV_BlockMatchingStaticVideoTest(){}
+CV_BlockMatchingStaticVideoTest::~CV_BlockMatchingStaticVideoTest(){}
+
+void CV_BlockMatchingStaticVideoTest::run(int )
+{
+    Mat image1, image2;
+    image1 = imread(ts->get_data_path() + "testdata/imL2l.bmp", CV_8UC1);
+    image2 = imread(ts->get_data_path() + "testdata/imL2.bmp", CV_8UC1);
+
+    if(image1.empty() || image2.empty())
+    {
+        ts->printf(cvtest::TS::LOG, "Wrong input data \n");
+        ts->set_failed_test_info(cvtest::TS::FAIL_INVALID_TEST_DATA);
+        return;
+    }
+
+    //on a static pair the video mode searches around the disparity of the previous frame, which is the
+    //disparity of the single frame matching, so it has to find the same disparities
+    const int scale = 16;
+    Ptr<StereoBinaryBM> sbm[2];
+    for(int i = 0; i < 2; i++)
+    {
+        sbm[i] = StereoBinaryBM::create(16, 9);
+        sbm[i]->setPreFilterCap(31);
+        sbm[i]->setMinDisparity(0);
+        sbm[i]->setTextureThreshold(10);
+        sbm[i]->setUniquenessRatio(0);
+        sbm[i]->setSpeckleWindowSize(400);
+        sbm[i]->setSpeckleRange(200);
+        sbm[i]->setDisp12MaxDiff(0);
+        sbm[i]->setScalleFactor(scale);
+        sbm[i]->setBinaryKernelType(CV_MODIFIED_CENSUS_TRANSFORM);
+        sbm[i]->setAgregationWindowSize(11);
+        sbm[i]->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+        sbm[i]->setUsePrefilter(false);
+    }
+    sbm[1]->setVideoMode(true);
+    sbm[1]->setTemporalSearchRadius(3);
+
+    Mat single(image1.rows, image1.cols, CV_8UC1);
+    sbm[0]->compute(image1, image2, single);
+    for(int frame = 0; frame < 4; frame++)
+    {
+        //the prior is dropped before the last frame, which is searched over the full range again
+        if(frame == 3)
+            sbm[1]->resetTemporalPrior();
+        Mat video(image1.rows, image1.cols, CV_8UC1);
+        sbm[1]->compute(image1, image2, video);
+        //without a prior the video mode is the single frame matching
+        bool fullRange = frame == 0 || frame == 3;
+        if(differingFraction(single, video, fullRange ? 0 : scale) > (fullRange ? 0 : 0.05))
+        {
+            ts->printf(cvtest::TS::LOG, "The block matching video mode differs from the single frame at frame %d\n", frame);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+
+    Ptr<StereoBinarySGBM> sgbm[2];
+    for(int i = 0; i < 2; i++)
+    {
+        sgbm[i] = StereoBinarySGBM::create(0, 16, 9);
+        sgbm[i]->setP1(10);
+        sgbm[i]->setP2(100);
+        sgbm[i]->setUniquenessRatio(1);
+        sgbm[i]->setSpeckleWindowSize(400);
+        sgbm[i]->setSpeckleRange(200);
+        sgbm[i]->setDisp12MaxDiff(1);
+        sgbm[i]->setBinaryKernelType(CV_MODIFIED_CENSUS_TRANSFORM);
+        sgbm[i]->setSpekleRemovalTechnique(CV_SPECKLE_REMOVAL_AVG_ALGORITHM);
+        sgbm[i]->setSubPixelInterpolationMethod(CV_SIMETRICV_INTERPOLATION);
+    }
+    sgbm[1]->setVideoMode(true);
+    sgbm[1]->setTemporalSearchRadius(3);
+
+    Mat singleDisp;
+    sgbm[0]->compute(image1, image2, singleDisp);
+    for(int frame = 0; frame < 4; frame++)
+    {
+        if(frame == 3)
+            sgbm[1]->resetTemporalPrior();
+        Mat videoDisp;
+        sgbm[1]->compute(image1, image2, videoDisp);
+        bool fullRange = frame == 0 || frame == 3;
+        if(differingFraction(singleDisp, videoDisp, fullRange ? 0 : cv::stereo::StereoMatcher::DISP_SCALE) > (fullRange ? 0 : 0.05))
+        {
+            ts->printf(cvtest::TS::LOG, "The semi global matching video mode differs from the single frame at frame %d\n", frame);
+            ts->set_failed_test_info(cvtest::TS::FAIL_BAD_ACCURACY);
+            return;
+        }
+    }
+}
 TEST(block_matching_simple_test, accuracy) { CV_BlockMatchingTest test; test.safe_run(); }
 TEST(SG_block_matching_simple_test, accuracy) { CV_SGBlockMatchingTest test; test.safe_run(); }
+TEST(SG_block_matching_modes_test, accuracy) { CV_SGBlockMatchingModesTest test; test.safe_run(); }
+TEST(SG_block_matching_video_test, accuracy) { CV_SGBlockMatchingVideoTest test; test.safe_run(); }
+TEST(block_matching_static_video_test, accuracy) { CV_BlockMatchingStaticVideoTest test; test.safe_run(); }
@@ -137,6 +137,25 @@ CV_EXPORTS void FastHoughTransform( InputArray  src,
                                     int         op = FHT_ADD,
                                     int         makeSkew = HDO_DESKEW );
 
+/**
+* @brief   Calculates 2D Fast Hough transform of a batch of images.
+* @param   srcs        The source (input) images, they may have different sizes.
+* @param   dsts        The destination images, one per source image.
+* @param   dstMatDepth The depth of destination images
+* @param   op          The operation to be applied, see cv::HoughOp
+* @param   angleRange  The part of Hough space to calculate, see cv::AngleRangeOption
+* @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
+*
+* The function gives the same results as cv::ximgproc::FastHoughTransform
+* called on each image, the images are transformed concurrently.
+*/
+CV_EXPORTS void FastHoughTransformBatch( InputArrayOfArrays  srcs,
+                                         OutputArrayOfArrays dsts,
+                                         int                 dstMatDepth,
+                                         int                 angleRange = ARO_315_135,
+                                         int                 op = FHT_ADD,
+                                         int                 makeSkew = HDO_DESKEW );
+
 /**
 * @brief   Calculates coordinates of line segment corresponded by point in Hough space.
 * @param   houghPoint  Point in Hough space.
@@ -95,9 +95,24 @@ public:
     can be seen below.
 
     ![image](pics/superpixels_blocks2.png)
+
+    The updates run in parallel on separate tiles of superpixels, the result does not depend on the
+    number of threads.
      */
     CV_WRAP virtual void iterate(InputArray img, int num_iterations=4) = 0;
 
+    /** @brief Enables or disables the temporal mode, for the frames of a video.
+
+    In temporal mode, each call to iterate() after the first one starts from the segmentation of
+    the previous call instead of the initial grid: the histograms of the superpixels are computed
+    on the new image and only the pixel level iterations are run. It is disabled by default.
+     */
+    CV_WRAP virtual void setTemporalMode(bool temporal) = 0;
+
+    /** @brief Returns true if the temporal mode is enabled, see setTemporalMode().
+     */
+    CV_WRAP virtual bool getTemporalMode() const = 0;
+
     /** @brief Returns the segmentation labeling of the image.
 
     Each label represents a superpixel, and each pixel is assigned to one superpixel label.
@@ -59,6 +59,14 @@ namespace cv {
 
                             CV_WRAP virtual void setMinSize(int min_size) = 0;
                             CV_WRAP virtual int getMinSize() = 0;
+
+                            /** @brief Set the number of rows of the bands the image is segmented by, for very large images.
+                                The bands are segmented in parallel, then merged along their seams, so the result can slightly
+                                differ from the segmentation of the whole image.
+                                @param tile_rows The number of rows of each band, 0 (the default) to segment the whole image at once
+                            */
+                            CV_WRAP virtual void setTileRows(int tile_rows) = 0;
+                            CV_WRAP virtual int getTileRows() = 0;
                     };
 
                     /** @brief Creates a graph based segmentor
@@ -234,6 +242,9 @@ namespace cv {
                             CV_WRAP virtual void clearStrategies() = 0;
 
                             /** @brief Based on all images, graph segmentations and stragies, computes all possible rects and return them
+
+                                The (image, graph segmentation) pairs are processed in parallel, each with its own copy of the strategies.
+                                They are processed serially if a strategy is not one of the strategies created by this module.
                                 @param rects The list of rects. The first ones are more relevents than the lasts ones.
                             */
                             CV_WRAP virtual void process(std::vector<Rect>& rects) = 0;
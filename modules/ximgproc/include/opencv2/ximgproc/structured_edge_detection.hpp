@@ -107,6 +107,17 @@ public:
     @sa Sobel, Canny
      */
     CV_WRAP virtual void detectEdges(const Mat &src, CV_OUT Mat &dst) const = 0;
+
+    /** @brief The function detects edges in src at several scales and draw their average to dst.
+
+    The image is converted to the feature color space once, then resized to each scale.
+    @param src source image (RGB, float, in [0;1]) to detect edges
+    @param dst destination image (grayscale, float, in [0;1]) where edges are drawn
+    @param scales scales at which edges are detected, e.g. 0.5, 1 and 2
+    @sa detectEdges
+     */
+    CV_WRAP virtual void detectEdgesMultiscale(const Mat &src, CV_OUT Mat &dst,
+                                               const std::vector<float> &scales) const = 0;
 };
 
 /*!
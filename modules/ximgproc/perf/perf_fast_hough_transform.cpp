@@ -85,6 +85,32 @@ PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransform,
     SANITY_CHECK_NOTHING();
 }
 
+typedef perf::TestBaseWithParam<Size> FastHoughTransformBatchTest;
+
+PERF_TEST_P(FastHoughTransformBatchTest, FastHoughTransformBatch,
+            testing::Values(szVGA, sz720p))
+{
+    Size srcSize = GetParam();
+
+    vector<Mat> srcs(16);
+    for (size_t i = 0; i < srcs.size(); ++i)
+    {
+        srcs[i].create(srcSize, CV_8UC1);
+        randu(srcs[i], 0, 256);
+    }
+    vector<Mat> fhts;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    declare.tbb_threads(cv::getNumberOfCPUs());
+
+    TEST_CYCLE_N(3)
+    {
+        FastHoughTransformBatch(srcs, fhts, CV_32S);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 #undef ALL_MAT_DEPHTS
 
 } // namespace cvtest
@@ -0,0 +1,82 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::ximgproc;
+
+typedef tuple<Size, bool> SEEDSTestParam;
+typedef TestBaseWithParam<SEEDSTestParam> SEEDSTest;
+
+PERF_TEST_P(SEEDSTest, perf,
+            Combine(SZ_TYPICAL, Values(false, true)))
+{
+    SEEDSTestParam params = GetParam();
+    Size sz       = get<0>(params);
+    bool temporal = get<1>(params);
+
+    // a few frames of a slowly changing video
+    std::vector<Mat> frames(5);
+    frames[0].create(sz, CV_8UC3);
+    randu(frames[0], 0, 255);
+    GaussianBlur(frames[0], frames[0], Size(5, 5), 0);
+    for (size_t i = 1; i < frames.size(); i++)
+        add(frames[i - 1], Scalar::all(2), frames[i]);
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(sz.width, sz.height, 3, 400, 4);
+    seeds->setTemporalMode(temporal);
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    declare.tbb_threads(cv::getNumberOfCPUs());
+
+    TEST_CYCLE_N(3)
+    {
+        for (size_t i = 0; i < frames.size(); i++)
+            seeds->iterate(frames[i], 4);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
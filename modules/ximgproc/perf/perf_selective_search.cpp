@@ -0,0 +1,88 @@
+/*
+ *  By downloading, copying, installing or using the software you agree to this license.
+ *  If you do not agree to this license, do not download, install,
+ *  copy or use the software.
+ *
+ *
+ *  License Agreement
+ *  For Open Source Computer Vision Library
+ *  (3 - clause BSD License)
+ *
+ *  Redistribution and use in source and binary forms, with or without modification,
+ *  are permitted provided that the following conditions are met :
+ *
+ *  * Redistributions of source code must retain the above copyright notice,
+ *  this list of conditions and the following disclaimer.
+ *
+ *  * Redistributions in binary form must reproduce the above copyright notice,
+ *  this list of conditions and the following disclaimer in the documentation
+ *  and / or other materials provided with the distribution.
+ *
+ *  * Neither the names of the copyright holders nor the names of the contributors
+ *  may be used to endorse or promote products derived from this software
+ *  without specific prior written permission.
+ *
+ *  This software is provided by the copyright holders and contributors "as is" and
+ *  any express or implied warranties, including, but not limited to, the implied
+ *  warranties of merchantability and fitness for a particular purpose are disclaimed.
+ *  In no event shall copyright holders or contributors be liable for any direct,
+ *  indirect, incidental, special, exemplary, or consequential damages
+ *  (including, but not limited to, procurement of substitute goods or services;
+ *  loss of use, data, or profits; or business interruption) however caused
+ *  and on any theory of liability, whether in contract, strict liability,
+ *  or tort(including negligence or otherwise) arising in any way out of
+ *  the use of this software, even if advised of the possibility of such damage.
+ */
+
+#include "perf_precomp.hpp"
+
+namespace cvtest
+{
+
+using std::tr1::tuple;
+using std::tr1::get;
+using namespace perf;
+using namespace testing;
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+typedef tuple<Size, bool> SelectiveSearchTestParam;
+typedef TestBaseWithParam<SelectiveSearchTestParam> SelectiveSearchTest;
+
+PERF_TEST_P(SelectiveSearchTest, perf,
+    Combine(
+    Values(szQVGA, szVGA),
+    Values(false, true))
+)
+{
+    SelectiveSearchTestParam params = GetParam();
+    Size sz         = get<0>(params);
+    bool quality    = get<1>(params);
+
+    // Smooth blobs, so the graph segmentations give regions of realistic sizes
+    Mat noise(sz.height / 16, sz.width / 16, CV_8UC3), src;
+    RNG rnd(sz.height + quality);
+    rnd.fill(noise, RNG::UNIFORM, 0, 256);
+    resize(noise, src, sz, 0, 0, INTER_CUBIC);
+
+    std::vector<Rect> rects;
+
+    cv::setNumThreads(cv::getNumberOfCPUs());
+    declare.in(src).tbb_threads(cv::getNumberOfCPUs());
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(src);
+
+    if (quality)
+        ss->switchToSelectiveSearchQuality();
+    else
+        ss->switchToSelectiveSearchFast();
+
+    TEST_CYCLE_N(1)
+    {
+        ss->process(rects);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+}
@@ -85,4 +85,36 @@
 
      SANITY_CHECK_NOTHING();
  }
+
+ typedef tuple<Size, int, int> WMFDisparityTestParam;
+ typedef TestBaseWithParam<WMFDisparityTestParam> WeightedMedianFilterDisparityTest;
+
+ // Disparity refinement: 1-channel disparity guided by the color image, at video resolutions
+ PERF_TEST_P(WeightedMedianFilterDisparityTest, perf,
+     Combine(
+     Values(szVGA, sz720p),
+     Values(1, 3),
+     Values(5, 9))
+ )
+ {
+     WMFDisparityTestParam params = GetParam();
+
+     Size sz         = get<0>(params);
+     int jCn         = get<1>(params);
+     int r           = get<2>(params);
+
+     Mat joint(sz, CV_MAKE_TYPE(CV_8U, jCn));
+     Mat src(sz, CV_8UC1);
+     Mat dst(sz, src.type());
+
+     cv::setNumThreads(cv::getNumberOfCPUs());
+     declare.in(joint, src, WARMUP_RNG).out(dst).tbb_threads(cv::getNumberOfCPUs());
+
+     TEST_CYCLE_N(3)
+     {
+         weightedMedianFilter(joint, src, dst, r);
+     }
+
+     SANITY_CHECK_NOTHING();
+ }
  }
@@ -45,43 +45,157 @@
 
 namespace cv { namespace ximgproc {
 
-#if defined(_WIN32) && !defined(int32_t)
-    typedef __int32 int32_t;
-#endif
+template<typename T> struct HoughAveType { typedef float type; };
+template<> struct HoughAveType<int> { typedef double type; };
+template<> struct HoughAveType<double> { typedef double type; };
+
+// Element-wise operations, rounded and saturated as cv::add, cv::min, cv::max
+// and cv::addWeighted do
+template<typename T, HoughOp Op>
+struct HoughScalarOp { };
+template<typename T>
+struct HoughScalarOp<T, FHT_ADD> {
+    static inline T apply(T a, T b) { return saturate_cast<T>(a + b); }
+};
+template<typename T>
+struct HoughScalarOp<T, FHT_MIN> {
+    static inline T apply(T a, T b) { return std::min(a, b); }
+};
+template<typename T>
+struct HoughScalarOp<T, FHT_MAX> {
+    static inline T apply(T a, T b) { return std::max(a, b); }
+};
+template<typename T>
+struct HoughScalarOp<T, FHT_AVE> {
+    static inline T apply(T a, T b) {
+        typedef typename HoughAveType<T>::type WT;
+        return saturate_cast<T>(a * (WT)0.5 + b * (WT)0.5);
+    }
+};
+
+// Vectorized head of a row, returns the number of processed elements
+template<typename T, HoughOp Op>
+struct HoughSIMDOp {
+    static inline int operate(T *, const T *, const T *, int) { return 0; }
+};
 
-template<typename T, int D, HoughOp Op>
-struct HoughOperator { };
-#define SPECIALIZE_HOUGHOP(TOp, body)                                         \
-    template<typename T, int D>                                               \
-    struct HoughOperator<T, D, TOp> {                                         \
-        static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
-            Mat dst (Size(1, len), D, pDst);                                  \
-            Mat src0(Size(1, len), D, pSrc0);                                 \
-            Mat src1(Size(1, len), D, pSrc1);                                 \
-            body;                                                             \
+#if CV_SSE2
+#define FHT_LOAD_SI128(p)     _mm_loadu_si128((const __m128i *)(p))
+#define FHT_STORE_SI128(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#define SPECIALIZE_HOUGHOP_SSE2(T, TOp, VT, load, store, step, body)          \
+    template<>                                                                \
+    struct HoughSIMDOp<T, TOp> {                                              \
+        static inline int operate(T *pDst, const T *pSrc0, const T *pSrc1,    \
+                                  int len) {                                  \
+            int i = 0;                                                        \
+            for (; i <= len - step; i += step)                                \
+            {                                                                 \
+                VT a = load(pSrc0 + i);                                       \
+                VT b = load(pSrc1 + i);                                       \
+                store(pDst + i, body);                                        \
+            }                                                                 \
+            return i;                                                         \
         }                                                                     \
     };
-SPECIALIZE_HOUGHOP(FHT_ADD, add(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MIN, min(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
-SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
-#undef SPECIALIZE_HOUGHOP
+// min and max take their operands swapped to keep the std::min and std::max
+// results on equal or unordered values
+SPECIALIZE_HOUGHOP_SSE2(uchar,  FHT_ADD, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128, 16, _mm_adds_epu8(a, b));
+SPECIALIZE_HOUGHOP_SSE2(uchar,  FHT_MIN, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128, 16, _mm_min_epu8(b, a));
+SPECIALIZE_HOUGHOP_SSE2(uchar,  FHT_MAX, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128, 16, _mm_max_epu8(b, a));
+SPECIALIZE_HOUGHOP_SSE2(schar,  FHT_ADD, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128, 16, _mm_adds_epi8(a, b));
+SPECIALIZE_HOUGHOP_SSE2(ushort, FHT_ADD, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128,  8, _mm_adds_epu16(a, b));
+SPECIALIZE_HOUGHOP_SSE2(short,  FHT_ADD, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128,  8, _mm_adds_epi16(a, b));
+SPECIALIZE_HOUGHOP_SSE2(short,  FHT_MIN, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128,  8, _mm_min_epi16(b, a));
+SPECIALIZE_HOUGHOP_SSE2(short,  FHT_MAX, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128,  8, _mm_max_epi16(b, a));
+SPECIALIZE_HOUGHOP_SSE2(int,    FHT_ADD, __m128i, FHT_LOAD_SI128, FHT_STORE_SI128,  4, _mm_add_epi32(a, b));
+SPECIALIZE_HOUGHOP_SSE2(float,  FHT_ADD, __m128,  _mm_loadu_ps,   _mm_storeu_ps,    4, _mm_add_ps(a, b));
+SPECIALIZE_HOUGHOP_SSE2(float,  FHT_MIN, __m128,  _mm_loadu_ps,   _mm_storeu_ps,    4, _mm_min_ps(b, a));
+SPECIALIZE_HOUGHOP_SSE2(float,  FHT_MAX, __m128,  _mm_loadu_ps,   _mm_storeu_ps,    4, _mm_max_ps(b, a));
+SPECIALIZE_HOUGHOP_SSE2(float,  FHT_AVE, __m128,  _mm_loadu_ps,   _mm_storeu_ps,    4,
+                        _mm_add_ps(_mm_mul_ps(a, _mm_set1_ps(0.5f)), _mm_mul_ps(b, _mm_set1_ps(0.5f))));
+SPECIALIZE_HOUGHOP_SSE2(double, FHT_ADD, __m128d, _mm_loadu_pd,   _mm_storeu_pd,    2, _mm_add_pd(a, b));
+SPECIALIZE_HOUGHOP_SSE2(double, FHT_MIN, __m128d, _mm_loadu_pd,   _mm_storeu_pd,    2, _mm_min_pd(b, a));
+SPECIALIZE_HOUGHOP_SSE2(double, FHT_MAX, __m128d, _mm_loadu_pd,   _mm_storeu_pd,    2, _mm_max_pd(b, a));
+SPECIALIZE_HOUGHOP_SSE2(double, FHT_AVE, __m128d, _mm_loadu_pd,   _mm_storeu_pd,    2,
+                        _mm_add_pd(_mm_mul_pd(a, _mm_set1_pd(0.5)), _mm_mul_pd(b, _mm_set1_pd(0.5))));
+#undef SPECIALIZE_HOUGHOP_SSE2
+#undef FHT_STORE_SI128
+#undef FHT_LOAD_SI128
+#endif
+
+template<typename T, HoughOp Op>
+struct HoughOperator {
+    static inline void operate(T *pDst, const T *pSrc0, const T *pSrc1,
+                               int len, bool useSIMD) {
+        int i = useSIMD ? HoughSIMDOp<T, Op>::operate(pDst, pSrc0, pSrc1, len) : 0;
+        for (; i < len; i++)
+            pDst[i] = HoughScalarOp<T, Op>::apply(pSrc0[i], pSrc1[i]);
+    }
+};
 
 //----------------------fht----------------------------------------------------
 
-template <typename T, int D, HoughOp OP>
-void fhtCore(Mat     &img0,
-             Mat     &img1,
-             int32_t  y0,
-             int32_t  h,
-             bool     isPositiveShift,
-             int      level,
-             double   aspl)
+// Node of the recursive butterfly: merges the rows [y0, y0 + h) of the two
+// halves computed one recursion level deeper, or copies the row for h == 1
+struct FHTNode
+{
+    int32_t y0;
+    int32_t h;
+    int     level;
+    int     quad;
+};
+
+// One part of Hough space, its transform is computed in dst and tmp by turns
+struct FHTQuadrant
+{
+    FHTQuadrant(int _quadrant, const Mat &_dst, const Mat &_src)
+        : quadrant(_quadrant), dst(_dst), src(_src),
+          isPositiveShift(true), aspl(0.0) { }
+
+    int    quadrant;
+    Mat    dst;
+    Mat    src;
+    Mat    tmp;
+    bool   isPositiveShift;
+    double aspl;
+    std::vector<std::vector<FHTNode> > nodes; // butterfly nodes by depth
+};
+
+static void buildFHTNodes(std::vector<std::vector<FHTNode> > &nodes,
+                          int32_t y0,
+                          int32_t h,
+                          int     level,
+                          int     quad,
+                          int     depth)
 {
     if (level <= 0)
         return;
 
     CV_Assert(h > 0);
+    if ((int)nodes.size() <= depth)
+        nodes.resize(depth + 1);
+    FHTNode node = { y0, h, level, quad };
+    nodes[depth].push_back(node);
+    if (h == 1)
+        return;
+
+    const int32_t k = h >> 1;
+    buildFHTNodes(nodes, y0, k, level - 1, quad, depth + 1);
+    buildFHTNodes(nodes, y0 + k, h - k, level - 1, quad, depth + 1);
+}
+
+template <typename T, HoughOp OP>
+static void fhtRow(Mat           &img0,
+                   Mat           &img1,
+                   const FHTNode &node,
+                   int32_t        s,
+                   bool           isPositiveShift,
+                   double         aspl,
+                   bool           useSIMD)
+{
+    const int32_t y0 = node.y0;
+    const int32_t h = node.h;
+    const int level = node.level;
     if (h == 1)
     {
         if ((aspl != 0.0) && (level == 1))
@@ -105,10 +219,6 @@ void fhtCore(Mat     &img0,
         return;
     }
     const int32_t k = h >> 1;
-    fhtCore<T, D, OP>(img1, img0, y0, k,
-                      isPositiveShift, level - 1, aspl);
-    fhtCore<T, D, OP>(img1, img0, y0 + k, h - k,
-                      isPositiveShift, level - 1, aspl);
 
     int au = 2 * k - 2;
     int ad = 2 * h - 2 * k - 2;
@@ -117,125 +227,181 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
+    int su = (s * au + b) / d;
+    int sd = (s * ad + b) / d;
+    int rd = isPositiveShift ? sd - s : s - sd;
+    rd = (rd + wm) % w;
+    T *pLine0 = (T *)(img0.data + img0.step * (y0 + s));
+    const T *pLineU = (const T *)(img1.data + img1.step * (y0 + su));
+    const T *pLineD = (const T *)(img1.data + img1.step * (y0 + k + sd));
+    int w0 = img0.channels() * rd;
+    int w1 = img0.channels() * (w - rd);
+
+    if ((aspl != 0.0) && (level == 1))
     {
-        int su = (s * au + b) / d;
-        int sd = (s * ad + b) / d;
-        int rd = isPositiveShift ? sd - s : s - sd;
-        rd = (rd + wm) % w;
-        uchar *pLine0 = img0.data + img0.step * (y0 + s);
-        uchar *pLineU = img1.data + img1.step * (y0 + su);
-        uchar *pLineD = img1.data + img1.step * (y0 + k + sd);
-        int w0 = img0.channels() * rd;
-        int w1 = img0.channels() * (w - rd);
-
-        if ((aspl != 0.0) && (level == 1))
+        int dU = cvRound((y0 + su) * aspl);
+        dU = dU % w;
+        dU *= img0.channels();
+        int dD = cvRound((y0 + k + sd) * aspl);
+        dD = dD % w;
+        dD *= img0.channels();
+        int wB = w * img0.channels();
+
+        int dX = dD - dU;
+        if (w0 >= dX)
         {
-            int dU = cvRound((y0 + su) * aspl);
-            dU = dU % w;
-            dU *= img0.channels();
-            int dD = cvRound((y0 + k + sd) * aspl);
-            dD = dD % w;
-            dD *= img0.channels();
-            int wB = w * img0.channels();
-
-            int dX = dD - dU;
-            if (w0 >= dX)
+            if (w0 >= dD)
             {
-                if (w0 >= dD)
-                {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               w1 + dX);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dD);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 - dD),
-                                               dU);
-                }
-                else
-                {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               wB - dU);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 + wB - dD),
-                                               dD - w0);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dX);
-                }
+                HoughOperator<T, OP>::operate(pLine0 + dU,
+                                              pLineU,
+                                              pLineD + (w0 - dX),
+                                              w1 + dX, useSIMD);
+                HoughOperator<T, OP>::operate(pLine0 + (w1 + dD),
+                                              pLineU + (w1 + dX),
+                                              pLineD,
+                                              w0 - dD, useSIMD);
+                HoughOperator<T, OP>::operate(pLine0,
+                                              pLineU + (wB - dU),
+                                              pLineD + (w0 - dD),
+                                              dU, useSIMD);
             }
             else
             {
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                           (T *)pLineU,
-                                           (T *)pLineD + (wB - (dX - w0)),
-                                           dX - w0);
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                           (T *)pLineU + (dX - w0),
-                                           (T *)pLineD,
-                                           wB - (dX - w0) - dU);
-                HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                           (T *)pLineU + (wB - dU),
-                                           (T *)pLineD + (wB - (dX - w0) - dU),
-                                           dU);
+                HoughOperator<T, OP>::operate(pLine0 + dU,
+                                              pLineU,
+                                              pLineD + (w0 - dX),
+                                              wB - dU, useSIMD);
+                HoughOperator<T, OP>::operate(pLine0,
+                                              pLineU + (wB - dU),
+                                              pLineD + (w0 + wB - dD),
+                                              dD - w0, useSIMD);
+                HoughOperator<T, OP>::operate(pLine0 + (dD - w0),
+                                              pLineU + (w1 + dX),
+                                              pLineD,
+                                              w0 - dX, useSIMD);
             }
         }
         else
         {
-            HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                        (T *)pLineU,
-                                        (T *)pLineD + w0,
-                                        w1);
-            HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
-                                        (T *)pLineU + w1,
-                                        (T *)pLineD,
-                                        w0);
+            HoughOperator<T, OP>::operate(pLine0 + dU,
+                                          pLineU,
+                                          pLineD + (wB - (dX - w0)),
+                                          dX - w0, useSIMD);
+            HoughOperator<T, OP>::operate(pLine0 + (dD - w0),
+                                          pLineU + (dX - w0),
+                                          pLineD,
+                                          wB - (dX - w0) - dU, useSIMD);
+            HoughOperator<T, OP>::operate(pLine0,
+                                          pLineU + (wB - dU),
+                                          pLineD + (wB - (dX - w0) - dU),
+                                          dU, useSIMD);
         }
     }
+    else
+    {
+        HoughOperator<T, OP>::operate(pLine0,
+                                      pLineU,
+                                      pLineD + w0,
+                                      w1, useSIMD);
+        HoughOperator<T, OP>::operate(pLine0 + w1,
+                                      pLineU + w1,
+                                      pLineD,
+                                      w0, useSIMD);
+    }
 }
 
-template <typename T, int D, HoughOp Op>
-void fhtVoT(Mat    &img0,
-            Mat    &img1,
-            bool    isPositiveShift,
-            double  aspl)
+// Computes the rows of all the butterfly nodes at one recursion depth of all
+// the quadrants, the nodes of a depth only depend on the deeper ones
+template <typename T, HoughOp OP>
+class FHTLevelInvoker : public ParallelLoopBody
 {
-    int level = 0;
-    for (int thres = 1; img0.rows > thres; thres <<= 1)
-        level++;
+public:
+    FHTLevelInvoker(std::vector<FHTQuadrant>   &_quads,
+                    const std::vector<FHTNode> &_nodes,
+                    const std::vector<int>     &_offsets,
+                    int                         _depth)
+        : quads(_quads), nodes(_nodes), offsets(_offsets), depth(_depth)
+    {
+        useSIMD = checkHardwareSupport(CV_CPU_SSE2);
+    }
+
+    void operator()(const Range &range) const
+    {
+        size_t n = std::upper_bound(offsets.begin(), offsets.end(),
+                                    range.start) - offsets.begin() - 1;
+        for (int i = range.start; i < range.end; i++)
+        {
+            while (offsets[n + 1] <= i)
+                n++;
+            const FHTNode &node = nodes[n];
+            FHTQuadrant &q = quads[node.quad];
+            Mat &img0 = (depth & 1) ? q.tmp : q.dst;
+            Mat &img1 = (depth & 1) ? q.dst : q.tmp;
+            fhtRow<T, OP>(img0, img1, node, i - offsets[n],
+                          q.isPositiveShift, q.aspl, useSIMD);
+        }
+    }
+
+private:
+    std::vector<FHTQuadrant>   &quads;
+    const std::vector<FHTNode> &nodes;
+    const std::vector<int>     &offsets;
+    int                         depth;
+    bool                        useSIMD;
+};
+
+template <typename T, HoughOp Op>
+void fhtVoT(std::vector<FHTQuadrant> &quads,
+            bool                      parallel)
+{
+    size_t nbDepths = 0;
+    for (size_t i = 0; i < quads.size(); i++)
+        nbDepths = std::max(nbDepths, quads[i].nodes.size());
+
+    std::vector<FHTNode> nodes;
+    std::vector<int> offsets;
+    for (int depth = (int)nbDepths - 1; depth >= 0; depth--)
+    {
+        nodes.clear();
+        offsets.assign(1, 0);
+        for (size_t i = 0; i < quads.size(); i++)
+        {
+            if ((int)quads[i].nodes.size() <= depth)
+                continue;
+            const std::vector<FHTNode> &quadNodes = quads[i].nodes[depth];
+            for (size_t j = 0; j < quadNodes.size(); j++)
+            {
+                nodes.push_back(quadNodes[j]);
+                offsets.push_back(offsets.back() + quadNodes[j].h);
+            }
+        }
 
-    fhtCore<T, D, Op>(img0, img1, 0, img0.rows, isPositiveShift, level, aspl);
+        FHTLevelInvoker<T, Op> body(quads, nodes, offsets, depth);
+        if (parallel)
+            parallel_for_(Range(0, offsets.back()), body);
+        else
+            body(Range(0, offsets.back()));
+    }
 }
 
-template <typename T, int D>
-void fhtVo(Mat    &img0,
-           Mat    &img1,
-           bool    isPositiveShift,
-           int     operation,
-           double  aspl)
+template <typename T>
+void fhtVo(std::vector<FHTQuadrant> &quads,
+           int                       operation,
+           bool                      parallel)
 {
     switch (operation)
     {
     case FHT_ADD:
-        fhtVoT<T, D, FHT_ADD>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_ADD>(quads, parallel);
         break;
     case FHT_AVE:
-        fhtVoT<T, D, FHT_AVE>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_AVE>(quads, parallel);
         break;
     case FHT_MAX:
-        fhtVoT<T, D, FHT_MAX>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_MAX>(quads, parallel);
         break;
     case FHT_MIN:
-        fhtVoT<T, D, FHT_MIN>(img0, img1, isPositiveShift, aspl);
+        fhtVoT<T, FHT_MIN>(quads, parallel);
         break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown operation %d", operation));
@@ -243,35 +409,33 @@ void fhtVo(Mat    &img0,
     }
 }
 
-static void fhtVo(Mat    &img0,
-                  Mat    &img1,
-                  bool    isPositiveShift,
-                  int     operation,
-                  double  aspl)
+static void fhtVo(std::vector<FHTQuadrant> &quads,
+                  int                       operation,
+                  bool                      parallel)
 {
-    int const depth = img0.depth();
+    int const depth = quads[0].dst.depth();
     switch (depth)
     {
     case CV_8U:
-        fhtVo<uchar, CV_8UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<uchar>(quads, operation, parallel);
         break;
     case CV_8S:
-        fhtVo<schar, CV_8SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<schar>(quads, operation, parallel);
         break;
     case CV_16U:
-        fhtVo<ushort, CV_16UC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<ushort>(quads, operation, parallel);
         break;
     case CV_16S:
-        fhtVo<short, CV_16SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<short>(quads, operation, parallel);
         break;
     case CV_32S:
-        fhtVo<int, CV_32SC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<int>(quads, operation, parallel);
         break;
     case CV_32F:
-        fhtVo<float, CV_32FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<float>(quads, operation, parallel);
         break;
     case CV_64F:
-        fhtVo<double, CV_64FC1>(img0, img1, isPositiveShift, operation, aspl);
+        fhtVo<double>(quads, operation, parallel);
         break;
     default:
         CV_Error_(CV_StsNotImplemented, ("Unknown depth %d", depth));
@@ -279,13 +443,14 @@ static void fhtVo(Mat    &img0,
     }
 }
 
-static void FHT(Mat       &dst,
-                const Mat &src,
-                int        operation,
-                bool       isVertical,
-                bool       isClockwise,
-                double     aspl)
+static void initFHT(FHTQuadrant &q,
+                    int          quad,
+                    bool         isVertical,
+                    bool         isClockwise,
+                    double       aspl)
 {
+    Mat &dst = q.dst;
+    const Mat &src = q.src;
     CV_Assert(dst.cols > 0 && dst.rows > 0);
     CV_Assert(src.channels() == dst.channels());
     if (isVertical)
@@ -297,26 +462,24 @@ static void FHT(Mat       &dst,
     for (int thres = 1; dst.rows > thres; thres <<= 1)
         level++;
 
-    Mat tmp;
-    src.convertTo(tmp, dst.type());
+    src.convertTo(q.tmp, dst.type());
     if (!isVertical)
-        transpose(tmp, tmp);
-    tmp.copyTo(dst);
+        transpose(q.tmp, q.tmp);
+    q.tmp.copyTo(dst);
 
-    fhtVo(dst, tmp,
-          isVertical ? isClockwise : !isClockwise,
-          operation, aspl);
+    q.isPositiveShift = isVertical ? isClockwise : !isClockwise;
+    q.aspl = aspl;
+    q.nodes.clear();
+    buildFHTNodes(q.nodes, 0, dst.rows, level, quad, 0);
 }
 
-static void calculateFHTQuadrant(Mat       &dst,
-                                 const Mat &src,
-                                 int        operation,
-                                 int        quadrant)
+static void initFHTQuadrant(FHTQuadrant &q,
+                            int          quad)
 {
     bool bVert = true;
     bool bClock = true;
     double aspl = 0.0;
-    switch (quadrant)
+    switch (q.quadrant)
     {
     case ARO_315_0:
         bVert = true;
@@ -345,20 +508,17 @@ static void calculateFHTQuadrant(Mat       &dst,
         aspl = 0.5;
         break;
     default:
-        CV_Error_(CV_StsNotImplemented, ("Unknown quadrant %d", quadrant));
+        CV_Error_(CV_StsNotImplemented, ("Unknown quadrant %d", q.quadrant));
     }
 
-  FHT(dst, src, operation, bVert, bClock, aspl);
+  initFHT(q, quad, bVert, bClock, aspl);
 }
 
-static void createDstFhtMat(OutputArray dst,
-                            InputArray  src,
-                            int         depth,
-                            int         angleRange)
+static Size fhtDstSize(const Size &srcSize,
+                       int         angleRange)
 {
-    int const rows = src.size().height;
-    int const cols = src.size().width;
-    int const channels = src.channels();
+    int const rows = srcSize.height;
+    int const cols = srcSize.width;
 
     int wd = cols + rows;
     int ht = 0;
@@ -388,7 +548,16 @@ static void createDstFhtMat(OutputArray dst,
         CV_Error_(CV_StsNotImplemented, ("Unknown angleRange %d", angleRange));
     }
 
-    dst.create(ht, wd, CV_MAKETYPE(depth, channels));
+    return Size(wd, ht);
+}
+
+static void createDstFhtMat(OutputArray dst,
+                            InputArray  src,
+                            int         depth,
+                            int         angleRange)
+{
+    dst.create(fhtDstSize(src.size(), angleRange),
+               CV_MAKETYPE(depth, src.channels()));
 }
 
 static void createFHTSrc(Mat       &srcFull,
@@ -545,6 +714,134 @@ static void skewQuadrant(Mat         &quad,
     }
 }
 
+static void getFHTQuadrants(std::vector<FHTQuadrant> &quads,
+                            const Mat                &src,
+                            const Mat                &dst,
+                            int                       angleRange)
+{
+    static const int halves[][2] = {{ARO_315_0, ARO_0_45},
+                                    {ARO_45_90, ARO_90_135}};
+
+    int halfFirst = 0;
+    int halfLast = 1;
+    switch (angleRange)
+    {
+    case ARO_315_0:
+    case ARO_0_45:
+    case ARO_45_90:
+    case ARO_90_135:
+    case ARO_CTR_VER:
+    case ARO_CTR_HOR:
+    {
+        Mat imgSrc;
+        createFHTSrc(imgSrc, src, angleRange);
+        quads.push_back(FHTQuadrant(angleRange, dst, imgSrc));
+        return;
+    }
+    case ARO_315_45:
+        halfLast = 0;
+        break;
+    case ARO_45_135:
+        halfFirst = 1;
+        break;
+    case ARO_315_135:
+        break;
+    default:
+        CV_Error_(CV_StsNotImplemented, ("Unknown angleRange %d", angleRange));
+    }
+
+    Mat imgRegDst;
+    for (int half = halfFirst; half <= halfLast; half++)
+    {
+        Mat imgSrc;
+        createFHTSrc(imgSrc, src, half == 0 ? ARO_315_45 : ARO_45_135);
+        for (int i = 0; i < 2; i++)
+        {
+            setFHTDstRegion(imgRegDst, dst, src, halves[half][i], angleRange);
+            quads.push_back(FHTQuadrant(halves[half][i], imgRegDst, imgSrc));
+        }
+    }
+}
+
+static void finishFHTQuadrant(FHTQuadrant &q,
+                              int          makeSkew)
+{
+    q.tmp.release();
+    switch (q.quadrant)
+    {
+    case ARO_315_0:
+    case ARO_45_90:
+    case ARO_CTR_VER:
+        flip(q.dst, q.dst, 0);
+        break;
+    default:
+        break;
+    }
+    if (HDO_DESKEW == makeSkew)
+    {
+        std::vector<uchar> buf(q.dst.cols * q.dst.elemSize());
+        skewQuadrant(q.dst, q.src, &buf[0], q.quadrant);
+    }
+}
+
+// Prepares or finishes the quadrants of Hough space, each one independently
+class FHTQuadrantInvoker : public ParallelLoopBody
+{
+public:
+    FHTQuadrantInvoker(std::vector<FHTQuadrant> &_quads,
+                       bool                      _finish,
+                       int                       _makeSkew)
+        : quads(_quads), finish(_finish), makeSkew(_makeSkew) { }
+
+    void operator()(const Range &range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            if (finish)
+                finishFHTQuadrant(quads[i], makeSkew);
+            else
+                initFHTQuadrant(quads[i], i);
+        }
+    }
+
+private:
+    std::vector<FHTQuadrant> &quads;
+    bool                      finish;
+    int                       makeSkew;
+};
+
+// All the quadrants are computed together: their preparation and finishing
+// run concurrently, and each butterfly level is computed row-parallel over
+// all of them
+static void fastHoughTransform(const Mat &srcMat,
+                               Mat       &dstMat,
+                               int        angleRange,
+                               int        operation,
+                               int        makeSkew,
+                               bool       parallel)
+{
+    CV_Assert(srcMat.cols > 0 && srcMat.rows > 0);
+    CV_Assert(dstMat.cols * static_cast<int>(dstMat.elemSize()) > 0);
+
+    std::vector<FHTQuadrant> quads;
+    getFHTQuadrants(quads, srcMat, dstMat, angleRange);
+    const Range range(0, (int)quads.size());
+
+    FHTQuadrantInvoker init(quads, false, makeSkew);
+    if (parallel && range.size() > 1)
+        parallel_for_(range, init);
+    else
+        init(range);
+
+    fhtVo(quads, operation, parallel);
+
+    FHTQuadrantInvoker finish(quads, true, makeSkew);
+    if (parallel && range.size() > 1)
+        parallel_for_(range, finish);
+    else
+        finish(range);
+}
+
 void FastHoughTransform(InputArray  src,
                         OutputArray dst,
                         int         dstMatDepth,
@@ -560,112 +857,70 @@ void FastHoughTransform(InputArray  src,
     createDstFhtMat(dst, src, dstMatDepth, angleRange);
     Mat dstMat = dst.getMat();
 
-    Mat imgRegDst;
-    const int len = dstMat.cols * static_cast<int>(dstMat.elemSize());
-    CV_Assert(len > 0);
-    std::vector<uchar> buf_(len);
-    uchar *buf(&buf_[0]);
+    fastHoughTransform(srcMat, dstMat, angleRange, operation, makeSkew, true);
+}
 
-    if (angleRange == ARO_315_135)
+// Transforms whole frames concurrently, each one serially
+class FHTBatchInvoker : public ParallelLoopBody
+{
+public:
+    FHTBatchInvoker(const std::vector<Mat> &_srcs,
+                    std::vector<Mat>       &_dsts,
+                    int                     _angleRange,
+                    int                     _operation,
+                    int                     _makeSkew)
+        : srcs(_srcs), dsts(_dsts), angleRange(_angleRange),
+          operation(_operation), makeSkew(_makeSkew) { }
+
+    void operator()(const Range &range) const
     {
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_315_45);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        }
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_45_135);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        }
-        return;
+        for (int i = range.start; i < range.end; i++)
+            fastHoughTransform(srcs[i], dsts[i], angleRange, operation,
+                               makeSkew, false);
     }
 
-    Mat imgSrc;
-    createFHTSrc(imgSrc, srcMat, angleRange);
+private:
+    const std::vector<Mat> &srcs;
+    std::vector<Mat>       &dsts;
+    int                     angleRange;
+    int                     operation;
+    int                     makeSkew;
+};
 
-    switch (angleRange)
+void FastHoughTransformBatch(InputArrayOfArrays  srcs,
+                             OutputArrayOfArrays dsts,
+                             int                 dstMatDepth,
+                             int                 angleRange,
+                             int                 operation,
+                             int                 makeSkew)
+{
+    std::vector<Mat> srcMats;
+    srcs.getMatVector(srcMats);
+    const int nb = (int)srcMats.size();
+
+    dsts.create(nb, 1, 0, -1, true);
+    std::vector<Mat> dstMats(nb);
+    for (int i = 0; i < nb; i++)
     {
-    case ARO_315_0:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_0_45:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_45_90:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_90_135:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_315_45:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        return;
-    case ARO_45_135:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        return;
-    case ARO_CTR_VER:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_CTR_HOR:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
+        if (!srcMats[i].isContinuous())
+            srcMats[i] = srcMats[i].clone();
+        CV_Assert(srcMats[i].cols > 0 && srcMats[i].rows > 0);
+
+        const Size dstSize = fhtDstSize(srcMats[i].size(), angleRange);
+        dsts.create(dstSize.height, dstSize.width,
+                    CV_MAKETYPE(dstMatDepth, srcMats[i].channels()), i, true);
+        dstMats[i] = dsts.getMat(i);
+    }
+
+    if (nb == 1)
+    {
+        fastHoughTransform(srcMats[0], dstMats[0], angleRange, operation,
+                           makeSkew, true);
         return;
-    default:
-        CV_Error_(CV_StsNotImplemented, ("Unknown angleRange %d", angleRange));
     }
+    parallel_for_(Range(0, nb),
+                  FHTBatchInvoker(srcMats, dstMats, angleRange, operation,
+                                  makeSkew));
 }
 
 //-----------------------------------------------------------------------------
@@ -37,7 +37,6 @@ the use of this software, even if advised of the possibility of such damage.
 *                                                                             *
 * Author: Maximilien Cuony / LTS2 / EPFL / 2015                               *
 *******************************************************************************/
-
 #include "precomp.hpp"
 #include "opencv2/ximgproc/segmentation.hpp"
 
@@ -49,16 +48,20 @@ namespace cv {
 
             // Helpers
 
-            // Represent an edge between two pixels
+            // Represent an edge between a pixel and its right or its bottom neighbour, on 64 bits
             class Edge {
                 public:
-                    int from;
-                    int to;
-                    float weight;
+                    unsigned weight; // Bits of the weight. Weights are non negative floats, so they compare as their bits do.
+                    unsigned id; // (pixel << 1) | direction, the direction being 0 for the right neighbour and 1 for the bottom one
 
-                    bool operator <(const Edge& e) const {
-                        return weight < e.weight;
+                    float getWeight() const {
+                        Cv32suf w;
+                        w.u = weight;
+                        return w.f;
                     }
+
+                    int from() const { return (int)(id >> 1); }
+                    int to(int cols) const { return (int)(id >> 1) + ((id & 1) ? cols : 1); }
             };
 
             // A point in the sets of points
@@ -89,6 +92,9 @@ namespace cv {
                     // Join two sets of points, based on their main point
                     void joinPoints(int p_a, int p_b);
 
+                    // Join two sets of points without updating nb_elements. Sets of disjoint points can be linked concurrently.
+                    void linkPoints(int p_a, int p_b);
+
                     // Return the set size of a set (based on the main point)
                     int size(unsigned int p) { return mapping[p].size; }
 
@@ -103,6 +109,7 @@ namespace cv {
                         sigma = 0.5;
                         k = 300;
                         min_size = 100;
+                        tile_rows = 0;
                         name_ = "GraphSegmentation";
                     }
 
@@ -120,11 +127,15 @@ namespace cv {
                     virtual void setMinSize(int min_size_) { min_size = min_size_; }
                     virtual int getMinSize() { return min_size; }
 
+                    virtual void setTileRows(int tile_rows_) { tile_rows = std::max(tile_rows_, 0); }
+                    virtual int getTileRows() { return tile_rows; }
+
                     virtual void write(FileStorage& fs) const {
                         fs << "name" << name_
                         << "sigma" << sigma
                         << "k" << k
-                        << "min_size" << (int)min_size;
+                        << "min_size" << (int)min_size
+                        << "tile_rows" << (int)tile_rows;
                     }
 
                     virtual void read(const FileNode& fn) {
@@ -133,128 +144,345 @@ namespace cv {
                         sigma = (double)fn["sigma"];
                         k = (float)fn["k"];
                         min_size = (int)(int)fn["min_size"];
+                        tile_rows = fn["tile_rows"].empty() ? 0 : (int)fn["tile_rows"];
                     }
 
                 private:
                     double sigma;
                     float k;
                     int min_size;
+                    int tile_rows;
                     String name_;
 
                     // Pre-filter the image
                     void filter(const Mat &img, Mat &img_filtered);
 
                     // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    void buildGraph(std::vector<Edge> &edges, const Mat &img_filtered);
 
-                    // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    // Segment the graph, by bands of rows
+                    void segmentGraph(std::vector<Edge> &edges, const Mat &img_filtered, PointSet **es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<Edge> &edges, int cols, PointSet *es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
                     void finalMapping(PointSet *es, Mat &output);
             };
 
-            void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
+            // Index of the first edge of a row. Each row has the right edges of its pixels but the last one, then the
+            // bottom edges of its pixels (but for the last row).
+            static inline int rowEdges(int row, int cols) {
+                return row * (2 * cols - 1);
+            }
 
-                Mat img_converted;
+            // Compute the weights of the edges of a range of rows
+            class GraphBuildInvoker : public ParallelLoopBody {
+                public:
+                    GraphBuildInvoker(const Mat &img_filtered_, Edge *edges_) : img_filtered(img_filtered_), edges(edges_) {}
 
-                // Switch to float
-                img.convertTo(img_converted, CV_32F);
+                    void operator()(const Range& range) const {
+                        int nb_channels = img_filtered.channels();
+                        int cols = img_filtered.cols;
 
-                // Apply gaussian filter
-                GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
-            }
+                        for (int i = range.start; i < range.end; i++) {
+                            const float* p = img_filtered.ptr<float>(i);
+                            Edge* e = edges + rowEdges(i, cols);
+
+                            for (int j = 0; j < cols - 1; j++, e++) {
+                                e->weight = diff(p + j * nb_channels, p + (j + 1) * nb_channels, nb_channels);
+                                e->id = (unsigned)(i * cols + j) << 1;
+                            }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
+                            if (i + 1 < img_filtered.rows) {
+                                const float* p2 = img_filtered.ptr<float>(i + 1);
 
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+                                for (int j = 0; j < cols; j++, e++) {
+                                    e->weight = diff(p + j * nb_channels, p2 + j * nb_channels, nb_channels);
+                                    e->id = ((unsigned)(i * cols + j) << 1) | 1;
+                                }
+                            }
+                        }
+                    }
 
-                nb_edges = 0;
+                private:
+                    const Mat &img_filtered;
+                    Edge *edges;
 
-                int nb_channels = img_filtered.channels();
+                    static unsigned diff(const float* a, const float* b, int nb_channels) {
+                        float tmp_total = 0;
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                        for (int channel = 0; channel < nb_channels; channel++) {
+                            float d = a[channel] - b[channel];
+                            tmp_total += d * d;
+                        }
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                        Cv32suf w;
+                        w.f = std::sqrt(tmp_total);
+                        return w.u;
+                    }
+            };
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+            // Stable radix sort of the edges on their weights, by digits of 11 bits. The edges are split in chunks
+            // whose digits are counted then scattered in parallel.
+            static const int RADIX_BITS = 11;
+            static const int RADIX_SIZE = 1 << RADIX_BITS;
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+            class RadixCountInvoker : public ParallelLoopBody {
+                public:
+                    RadixCountInvoker(const Edge *edges_, int nb_edges_, int nb_chunks_, int shift_, int *counts_)
+                        : edges(edges_), nb_edges(nb_edges_), nb_chunks(nb_chunks_), shift(shift_), counts(counts_) {}
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                    void operator()(const Range& range) const {
+                        for (int chunk = range.start; chunk < range.end; chunk++) {
+                            int* count = counts + chunk * RADIX_SIZE;
+                            int end = (int)((int64)nb_edges * (chunk + 1) / nb_chunks);
 
-                                    float tmp_total = 0;
+                            std::fill(count, count + RADIX_SIZE, 0);
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        tmp_total += pow(p[j * nb_channels + channel] - p2[j2 * nb_channels + channel], 2);
-                                    }
+                            for (int i = (int)((int64)nb_edges * chunk / nb_chunks); i < end; i++) {
+                                count[(edges[i].weight >> shift) & (RADIX_SIZE - 1)]++;
+                            }
+                        }
+                    }
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                private:
+                    const Edge *edges;
+                    int nb_edges, nb_chunks, shift;
+                    int *counts;
+            };
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+            class RadixScatterInvoker : public ParallelLoopBody {
+                public:
+                    RadixScatterInvoker(const Edge *src_, Edge *dst_, int nb_edges_, int nb_chunks_, int shift_, const int *offsets_)
+                        : src(src_), dst(dst_), nb_edges(nb_edges_), nb_chunks(nb_chunks_), shift(shift_), offsets(offsets_) {}
 
-                                    nb_edges++;
+                    void operator()(const Range& range) const {
+                        std::vector<int> offset(RADIX_SIZE);
+
+                        for (int chunk = range.start; chunk < range.end; chunk++) {
+                            int end = (int)((int64)nb_edges * (chunk + 1) / nb_chunks);
+
+                            std::copy(offsets + chunk * RADIX_SIZE, offsets + (chunk + 1) * RADIX_SIZE, offset.begin());
+
+                            for (int i = (int)((int64)nb_edges * chunk / nb_chunks); i < end; i++) {
+                                dst[offset[(src[i].weight >> shift) & (RADIX_SIZE - 1)]++] = src[i];
+                            }
+                        }
+                    }
+
+                private:
+                    const Edge *src;
+                    Edge *dst;
+                    int nb_edges, nb_chunks, shift;
+                    const int *offsets;
+            };
+
+            // Sort edges, using buffer (of the same size) as temporary storage. Only parallel if nb_chunks > 1.
+            static void sortEdges(Edge *edges, Edge *buffer, int nb_edges, int nb_chunks) {
+
+                nb_chunks = std::max(std::min(nb_chunks, nb_edges / (1 << 16)), 1);
+
+                std::vector<int> counts(nb_chunks * RADIX_SIZE);
+                Edge *src = edges;
+                Edge *dst = buffer;
+
+                for (int shift = 0; shift < 32; shift += RADIX_BITS) {
+
+                    RadixCountInvoker count(src, nb_edges, nb_chunks, shift, &counts[0]);
+
+                    if (nb_chunks > 1) {
+                        parallel_for_(Range(0, nb_chunks), count);
+                    } else {
+                        count(Range(0, 1));
+                    }
+
+                    // Offsets of the digits in each chunk, digit by digit then chunk by chunk to keep the sort stable
+                    int total = 0;
+                    bool single_digit = false;
+
+                    for (int digit = 0; digit < RADIX_SIZE && !single_digit; digit++) {
+                        int digit_total = 0;
+
+                        for (int chunk = 0; chunk < nb_chunks; chunk++) {
+                            int c = counts[chunk * RADIX_SIZE + digit];
+                            counts[chunk * RADIX_SIZE + digit] = total + digit_total;
+                            digit_total += c;
+                        }
+
+                        // All the edges have this digit, nothing to sort
+                        single_digit = digit_total == nb_edges;
+                        total += digit_total;
+                    }
+
+                    if (single_digit) {
+                        continue;
+                    }
+
+                    RadixScatterInvoker scatter(src, dst, nb_edges, nb_chunks, shift, &counts[0]);
+
+                    if (nb_chunks > 1) {
+                        parallel_for_(Range(0, nb_chunks), scatter);
+                    } else {
+                        scatter(Range(0, 1));
+                    }
+
+                    std::swap(src, dst);
+                }
+
+                if (src != edges) {
+                    std::copy(src, src + nb_edges, edges);
+                }
+            }
+
+            // Sort and segment the edges of the bands of rows. The bands have disjoint points, so they are segmented
+            // concurrently, without the edges between them.
+            class GraphSegmentInvoker : public ParallelLoopBody {
+                public:
+                    GraphSegmentInvoker(Edge *edges_, Edge *buffer_, int nb_edges_, int rows_, int cols_, int band_rows_,
+                                        float k_, PointSet *es_, float *thresholds_, int *nb_joins_)
+                        : edges(edges_), buffer(buffer_), nb_edges(nb_edges_), rows(rows_), cols(cols_), band_rows(band_rows_),
+                          k(k_), es(es_), thresholds(thresholds_), nb_joins(nb_joins_) {}
+
+                    void operator()(const Range& range) const {
+                        int nb_bands = (rows + band_rows - 1) / band_rows;
+
+                        for (int band = range.start; band < range.end; band++) {
+                            int end_row = std::min((band + 1) * band_rows, rows);
+                            int start = rowEdges(band * band_rows, cols);
+                            int end = std::min(rowEdges(end_row, cols), nb_edges);
+
+                            // A single band is sorted in parallel
+                            sortEdges(edges + start, buffer + start, end - start, nb_bands == 1 ? getNumThreads() : 1);
+
+                            // Edges to the next band are left for the seams
+                            int end_point = end_row * cols;
+
+                            for (int i = start; i < end; i++) {
+                                if (edges[i].to(cols) < end_point) {
+                                    nb_joins[band] += segmentEdge(edges[i], cols, k, es, thresholds);
                                 }
                             }
                         }
                     }
+
+                    // Join the sets of an edge if its weight is below the thresholds of both sets. Return 1 if joined.
+                    static int segmentEdge(Edge &edge, int cols, float k, PointSet *es, float *thresholds) {
+                        int p_a = es->getBasePoint(edge.from());
+                        int p_b = es->getBasePoint(edge.to(cols));
+
+                        if (p_a != p_b) {
+                            float weight = edge.getWeight();
+
+                            if (weight <= thresholds[p_a] && weight <= thresholds[p_b]) {
+                                es->linkPoints(p_a, p_b);
+                                p_a = es->getBasePoint(p_a);
+                                thresholds[p_a] = weight + k / es->size(p_a);
+
+                                edge.weight = 0;
+                                return 1;
+                            }
+                        }
+
+                        return 0;
+                    }
+
+                private:
+                    Edge *edges, *buffer;
+                    int nb_edges, rows, cols, band_rows;
+                    float k;
+                    PointSet *es;
+                    float *thresholds;
+                    int *nb_joins;
+            };
+
+            void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
+
+                Mat img_converted;
+
+                // Switch to float
+                img.convertTo(img_converted, CV_32F);
+
+                // Apply gaussian filter
+                GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
+            }
+
+            void GraphSegmentationImpl::buildGraph(std::vector<Edge> &edges, const Mat &img_filtered) {
+
+                CV_Assert((int64)img_filtered.rows * img_filtered.cols < (1 << 30));
+
+                edges.resize(std::max(rowEdges(img_filtered.rows, img_filtered.cols) - img_filtered.cols, 0));
+
+                if (!edges.empty()) {
+                    parallel_for_(Range(0, img_filtered.rows), GraphBuildInvoker(img_filtered, &edges[0]));
                 }
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            void GraphSegmentationImpl::segmentGraph(std::vector<Edge> &edges, const Mat &img_filtered, PointSet **es) {
 
                 int total_points = ( int)(img_filtered.rows * img_filtered.cols);
-
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
+                int rows = img_filtered.rows;
+                int cols = img_filtered.cols;
+                int nb_edges = (int)edges.size();
 
                 // Create a set with all point (by default mapped to themselfs)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+                *es = new PointSet(total_points);
 
-                // Thresholds
-                float* thresholds = new float[total_points];
+                if (nb_edges == 0) {
+                    return;
+                }
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                // Thresholds
+                std::vector<float> thresholds(total_points, k);
 
-                for ( int i = 0; i < nb_edges; i++) {
+                // Sort and segment the bands
+                int band_rows = tile_rows > 0 ? std::min(tile_rows, rows) : rows;
+                int nb_bands = (rows + band_rows - 1) / band_rows;
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                // The edges between the bands: bottom edges of the last row of each band
+                std::vector<Edge> seams;
 
-                    if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                for (int band = 1; band < nb_bands; band++) {
+                    int row = band * band_rows - 1;
 
-                            edges[i].weight = 0;
-                        }
+                    for (int i = rowEdges(row, cols) + cols - 1; i < rowEdges(row + 1, cols); i++) {
+                        seams.push_back(edges[i]);
                     }
                 }
 
-                delete [] thresholds;
+                std::vector<Edge> buffer(nb_edges);
+                std::vector<int> nb_joins(nb_bands, 0);
+
+                GraphSegmentInvoker invoker(&edges[0], &buffer[0], nb_edges, rows, cols, band_rows, k, *es, &thresholds[0], &nb_joins[0]);
+
+                if (nb_bands > 1) {
+                    parallel_for_(Range(0, nb_bands), invoker);
+                } else {
+                    invoker(Range(0, 1));
+                }
+
+                for (int band = 0; band < nb_bands; band++) {
+                    (*es)->nb_elements -= nb_joins[band];
+                }
+
+                // Merge the bands along their seams, with the thresholds of their segments
+                if (!seams.empty()) {
+                    sortEdges(&seams[0], &buffer[0], (int)seams.size(), 1);
+
+                    for (size_t i = 0; i < seams.size(); i++) {
+                        (*es)->nb_elements -= GraphSegmentInvoker::segmentEdge(seams[i], cols, k, *es, &thresholds[0]);
+                    }
+                }
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<Edge> &edges, int cols, PointSet *es) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
                     if (edges[i].weight > 0) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                        int p_a = es->getBasePoint(edges[i].from());
+                        int p_b = es->getBasePoint(edges[i].to(cols));
 
                         if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
                             es->joinPoints(p_a, p_b);
@@ -316,23 +544,21 @@ namespace cv {
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<Edge> edges;
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                buildGraph(edges, img_filtered);
 
                 // Segment graph
                 PointSet *es;
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                segmentGraph(edges, img_filtered, &es);
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, img_filtered.cols, es);
 
                 // Map to final output
                 finalMapping(es, output);
 
-                delete [] edges;
                 delete es;
 
             }
@@ -378,14 +604,19 @@ namespace cv {
 
             void PointSet::joinPoints(int p_a, int p_b) {
 
+                linkPoints(p_a, p_b);
+
+                nb_elements--;
+            }
+
+            void PointSet::linkPoints(int p_a, int p_b) {
+
                 // Always target smaller set, to avoid redirection in getBasePoint
                 if (mapping[p_a].size < mapping[p_b].size)
                     swap(p_a, p_b);
 
                 mapping[p_b].p = p_a;
                 mapping[p_a].size += mapping[p_b].size;
-
-                nb_elements--;
             }
 
         }
@@ -61,6 +61,14 @@ using namespace std;
 
 #define MINIMUM_NR_SUBLABELS 1
 
+//the updates run in parallel in tiles of TILE_CELLS x TILE_CELLS top level blocks
+#define TILE_CELLS 4
+
+//update passes: every pair of labels, the pairs of the tiles of tiling 0 or 1,
+//the remaining pairs
+#define PASS_ALL -1
+#define PASS_REMAINING 2
+
 
 // the type of the histogram and the T array
 typedef float HISTN;
@@ -87,12 +95,21 @@ public:
     virtual void getLabels(OutputArray labels_out);
     virtual void getLabelContourMask(OutputArray image, bool thick_line = false);
 
+    virtual void setTemporalMode(bool temporal) { temporal_mode = temporal; }
+    virtual bool getTemporalMode() const { return temporal_mode; }
+
 private:
+    class HistogramInvoker;
+    class UpdateInvoker;
+    friend class HistogramInvoker;
+    friend class UpdateInvoker;
+
     /* initialization */
     void initialize(int num_superpixels, int num_levels);
-    void initImage(InputArray img);
+    void initImage(InputArray img, bool warm_start);
     void assignLabels();
     void computeHistograms(int until_level = -1);
+    void computeToplevelHistograms();
     template<typename _Tp>
     inline void initImageBins(const Mat& img, int max_value);
 
@@ -109,6 +126,7 @@ private:
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    void updatePixels(const Rect& roi, int pass);
 
 
     /* block operations */
@@ -122,6 +140,21 @@ private:
 
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
+    void updateBlocks(int level, const Rect& roi, int pass, float req_confidence);
+
+    /* parallel updates: the top level labels are owned by the tiles of two
+     * tilings, the second one shifted by half a tile. the tiles of a tiling
+     * that do not touch each other are updated concurrently, each one updates
+     * the pairs of labels it owns at the positions it covers */
+    //level -1 runs the pixel updates
+    void updateInTiles(int level, float req_confidence);
+    //tile of a position at a level (level -1: pixels) and tile owning a top level label
+    inline int tileOf(int tiling, int level, int x, int y) const;
+    inline int tileOwner(int tiling, int label) const;
+    //pass updating the pair of labels at a position: the first tiling where
+    //the tile of the position owns both labels, PASS_REMAINING otherwise
+    inline int pairPass(int level, int x, int y, int labelA, int labelB) const;
+    Rect tileRect(int tiling, int tile, int level) const;
 
     /* go to next block level */
     int goDownOneLevel();
@@ -154,6 +187,11 @@ private:
     bool seeds_double_step;
     int seeds_prior;
 
+    bool temporal_mode; // warm start from the labels of the previous image
+    bool has_labels; // iterate() was called at least once
+    bool parallel_updates;
+    int nr_tiles_wh[4]; // [2*tiling]/[2*tiling+1] number of tiles in x-direction/y-direction
+
     // keep one labeling for each level
     vector<int> nr_wh; // [2*level]/[2*level+1] number of labels in x-direction/y-direction
 
@@ -201,6 +239,8 @@ SuperpixelSEEDSImpl::SuperpixelSEEDSImpl(int image_width, int image_height, int
     nr_channels = image_channels;
     seeds_double_step = double_step;
     seeds_prior = std::min(prior, 5);
+    temporal_mode = false;
+    has_labels = false;
 
     histogram_size = nr_bins;
     for (int i = 1; i < nr_channels; ++i)
@@ -218,21 +258,27 @@ SuperpixelSEEDSImpl::~SuperpixelSEEDSImpl()
 
 void SuperpixelSEEDSImpl::iterate(InputArray img, int num_iterations)
 {
-    initImage(img);
+    // in temporal mode, the pixel updates continue from the previous labels
+    bool warm_start = temporal_mode && has_labels;
+    initImage(img, warm_start);
 
-    // block updates
-    while (seeds_current_level >= 0)
+    if( !warm_start )
     {
-        if( seeds_double_step )
-            updateBlocks(seeds_current_level, REQ_CONF);
+        // block updates
+        while (seeds_current_level >= 0)
+        {
+            if( seeds_double_step )
+                updateBlocks(seeds_current_level, REQ_CONF);
 
-        updateBlocks(seeds_current_level);
-        seeds_current_level = goDownOneLevel();
+            updateBlocks(seeds_current_level);
+            seeds_current_level = goDownOneLevel();
+        }
+        updateLabels();
     }
-    updateLabels();
 
     for (int i = 0; i < num_iterations; ++i)
         updatePixels();
+    has_labels = true;
 }
 void SuperpixelSEEDSImpl::getLabels(OutputArray labels_out)
 {
@@ -305,6 +351,15 @@ void SuperpixelSEEDSImpl::initialize(int num_superpixels, int num_levels)
             nr_wh[2 * seeds_top_level], CV_32SC1);
     nr_partitions = (unsigned int*)nr_partitions_mat.data;
 
+    // the second tiling is shifted by half a tile
+    for (int tiling = 0; tiling < 2; tiling++)
+    {
+        int offset = tiling ? TILE_CELLS / 2 : 0;
+        nr_tiles_wh[2 * tiling] = (nr_wh[2 * seeds_top_level] - 1 + offset) / TILE_CELLS + 1;
+        nr_tiles_wh[2 * tiling + 1] = (nr_wh[2 * seeds_top_level + 1] - 1 + offset) / TILE_CELLS + 1;
+    }
+    parallel_updates = nr_tiles_wh[0] > 1 || nr_tiles_wh[1] > 1;
+
     //preinit the labels (these are not changed anymore later)
     int i = 0;
     for (int y = 0; y < height; ++y)
@@ -332,48 +387,61 @@ void SuperpixelSEEDSImpl::initialize(int num_superpixels, int num_levels)
 }
 
 
+// computes the histogram bin of the pixels of a range of rows
 template<typename _Tp>
-void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
+class ImageBinsInvoker : public ParallelLoopBody
 {
-    int img_width = img.size().width;
-    int img_height = img.size().height;
-    int channels = img.channels();
+public:
+    ImageBinsInvoker(const Mat& _img, int _nr_bins, int _max_value, unsigned int* _image_bins)
+        : img(_img), nr_bins(_nr_bins), max_value(_max_value), image_bins(_image_bins)
+    {
+    }
 
-    for (int y = 0; y < img_height; ++y)
+    void operator()(const Range& range) const
     {
-        for (int x = 0; x < img_width; ++x)
+        int img_width = img.size().width;
+        int channels = img.channels();
+
+        for (int y = range.start; y < range.end; ++y)
         {
-            const _Tp* ptr = img.ptr<_Tp>(y, x);
-            int bin = 0;
-            for (int i = 0; i < channels; ++i)
-                bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
-            image_bins[y * img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+                image_bins[y * img_width + x] = pixelBin(img.ptr<_Tp>(y, x), channels);
         }
     }
-}
+
+private:
+    inline int pixelBin(const _Tp* ptr, int channels) const
+    {
+        int bin = 0;
+        for (int i = 0; i < channels; ++i)
+            bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
+        return bin;
+    }
+
+    const Mat& img;
+    int nr_bins;
+    int max_value;
+    unsigned int* image_bins;
+};
 
 /* specialization for float: max_value is assumed to be 1.0f */
 template<>
-void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
+inline int ImageBinsInvoker<float>::pixelBin(const float* ptr, int channels) const
 {
-    int img_width = img.size().width;
-    int img_height = img.size().height;
-    int channels = img.channels();
+    int bin = 0;
+    for(int i=0; i<channels; ++i)
+        bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
+    return bin;
+}
 
-    for (int y = 0; y < img_height; ++y)
-    {
-        for (int x = 0; x < img_width; ++x)
-        {
-            const float* ptr = img.ptr<float>(y, x);
-            int bin = 0;
-            for(int i=0; i<channels; ++i)
-                bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
-            image_bins[y*img_width + x] = bin;
-        }
-    }
+template<typename _Tp>
+void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
+{
+    parallel_for_(Range(0, img.size().height),
+            ImageBinsInvoker<_Tp>(img, nr_bins, max_value, image_bins));
 }
 
-void SuperpixelSEEDSImpl::initImage(InputArray img)
+void SuperpixelSEEDSImpl::initImage(InputArray img, bool warm_start)
 {
     Mat src;
 
@@ -401,10 +469,13 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
       CV_Error( Error::StsInternal, "Invalid InputArray." );
 
     int depth = src.depth();
-    seeds_current_level = seeds_nr_levels - 2;
-    forwardbackward = true;
+    if( !warm_start )
+    {
+        seeds_current_level = seeds_nr_levels - 2;
+        forwardbackward = true;
 
-    assignLabels();
+        assignLabels();
+    }
 
     CV_Assert(src.size().width == width && src.size().height == height);
     CV_Assert(depth == CV_8U || depth == CV_16U || depth == CV_32F);
@@ -424,7 +495,10 @@ void SuperpixelSEEDSImpl::initImage(InputArray img)
         break;
     }
 
-    computeHistograms();
+    if( warm_start )
+        computeToplevelHistograms();
+    else
+        computeHistograms();
 }
 
 // adds labeling to all the blocks at all levels and sets the correct parents
@@ -442,6 +516,29 @@ void SuperpixelSEEDSImpl::assignLabels()
     }
 }
 
+class SuperpixelSEEDSImpl::HistogramInvoker : public ParallelLoopBody
+{
+public:
+    HistogramInvoker(SuperpixelSEEDSImpl* _seeds) : seeds(_seeds)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        // rows of pixels of the rows of blocks, as in computeLabel()
+        int nr_blocks_h = seeds->nr_wh[1];
+        int block_height = seeds->height / nr_blocks_h;
+        int y_start = range.start * block_height;
+        int y_end = range.end == nr_blocks_h ? seeds->height : range.end * block_height;
+
+        for (int i = y_start * seeds->width; i < y_end * seeds->width; ++i)
+            seeds->addPixel(0, seeds->labels_bottom[i], i);
+    }
+
+private:
+    SuperpixelSEEDSImpl* seeds;
+};
+
 void SuperpixelSEEDSImpl::computeHistograms(int until_level)
 {
     if( until_level == -1 )
@@ -457,9 +554,9 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
         memset(T[level], 0, sizeof(HISTN) * nr_labels);
     }
 
-    // build histograms on the first level by adding the pixels to the blocks
-    for (int i = 0; i < width * height; ++i)
-        addPixel(0, labels_bottom[i], i);
+    // build histograms on the first level by adding the pixels to the blocks,
+    // each row of blocks covers its own rows of pixels
+    parallel_for_(Range(0, nr_wh[1]), HistogramInvoker(this));
 
     // build histograms on the upper levels by adding the histogram from the level below
     for (int level = 1; level < until_level; level++)
@@ -471,7 +568,169 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
     }
 }
 
+// rebuilds the top level histograms from the current labels
+void SuperpixelSEEDSImpl::computeToplevelHistograms()
+{
+    int nr_labels = nrLabels(seeds_top_level);
+    memset(histogram[seeds_top_level], 0,
+            sizeof(HISTN) * histogram_size_aligned * nr_labels);
+    memset(T[seeds_top_level], 0, sizeof(HISTN) * nr_labels);
+
+    for (int i = 0; i < width * height; ++i)
+        addPixel(seeds_top_level, labels[i], i);
+}
+
+// runs the updates of a level in the tiles
+class SuperpixelSEEDSImpl::UpdateInvoker : public ParallelLoopBody
+{
+public:
+    UpdateInvoker(SuperpixelSEEDSImpl* _seeds, int _level, int _tiling,
+            const vector<int>& _tiles, float _req_confidence)
+        : seeds(_seeds), level(_level), tiling(_tiling), tiles(_tiles),
+          req_confidence(_req_confidence)
+    {
+    }
+
+    void operator()(const Range& range) const
+    {
+        for (int i = range.start; i < range.end; ++i)
+        {
+            Rect roi = seeds->tileRect(tiling, tiles[i], level);
+            if( level < 0 )
+                seeds->updatePixels(roi, tiling);
+            else
+                seeds->updateBlocks(level, roi, tiling, req_confidence);
+        }
+    }
+
+private:
+    SuperpixelSEEDSImpl* seeds;
+    int level;
+    int tiling;
+    const vector<int>& tiles;
+    float req_confidence;
+};
+
+int SuperpixelSEEDSImpl::tileOf(int tiling, int level, int x, int y) const
+{
+    int nr_cells_w = nr_wh[2 * seeds_top_level];
+    int nr_cells_h = nr_wh[2 * seeds_top_level + 1];
+    int cell_x, cell_y;
+    if( level < 0 )
+    {
+        cell_x = std::min(x / (width / nr_cells_w), nr_cells_w - 1);
+        cell_y = std::min(y / (height / nr_cells_h), nr_cells_h - 1);
+    }
+    else
+    {
+        int shift = seeds_top_level - level;
+        cell_x = std::min(x >> shift, nr_cells_w - 1);
+        cell_y = std::min(y >> shift, nr_cells_h - 1);
+    }
+    int offset = tiling ? TILE_CELLS / 2 : 0;
+    return ((cell_y + offset) / TILE_CELLS) * nr_tiles_wh[2 * tiling]
+            + (cell_x + offset) / TILE_CELLS;
+}
+
+int SuperpixelSEEDSImpl::tileOwner(int tiling, int label) const
+{
+    int nr_cells_w = nr_wh[2 * seeds_top_level];
+    int offset = tiling ? TILE_CELLS / 2 : 0;
+    return ((label / nr_cells_w + offset) / TILE_CELLS) * nr_tiles_wh[2 * tiling]
+            + (label % nr_cells_w + offset) / TILE_CELLS;
+}
+
+int SuperpixelSEEDSImpl::pairPass(int level, int x, int y, int labelA, int labelB) const
+{
+    for (int tiling = 0; tiling < 2; tiling++)
+    {
+        int tile = tileOwner(tiling, labelA);
+        if( tile == tileOwner(tiling, labelB) && tile == tileOf(tiling, level, x, y) )
+            return tiling;
+    }
+    return PASS_REMAINING;
+}
+
+Rect SuperpixelSEEDSImpl::tileRect(int tiling, int tile, int level) const
+{
+    int nr_cells_w = nr_wh[2 * seeds_top_level];
+    int nr_cells_h = nr_wh[2 * seeds_top_level + 1];
+    int offset = tiling ? TILE_CELLS / 2 : 0;
+    int tile_x = tile % nr_tiles_wh[2 * tiling];
+    int tile_y = tile / nr_tiles_wh[2 * tiling];
+    int cell_x0 = std::max(tile_x * TILE_CELLS - offset, 0);
+    int cell_y0 = std::max(tile_y * TILE_CELLS - offset, 0);
+    int cell_x1 = std::min((tile_x + 1) * TILE_CELLS - offset, nr_cells_w);
+    int cell_y1 = std::min((tile_y + 1) * TILE_CELLS - offset, nr_cells_h);
+
+    // size of the cells and of the grid at the level, the last cells take the rest
+    int cell_w, cell_h, nr_w, nr_h;
+    if( level < 0 )
+    {
+        cell_w = width / nr_cells_w;
+        cell_h = height / nr_cells_h;
+        nr_w = width;
+        nr_h = height;
+    }
+    else
+    {
+        cell_w = cell_h = 1 << (seeds_top_level - level);
+        nr_w = nr_wh[2 * level];
+        nr_h = nr_wh[2 * level + 1];
+    }
+    int x0 = cell_x0 * cell_w;
+    int y0 = cell_y0 * cell_h;
+    int x1 = cell_x1 == nr_cells_w ? nr_w : cell_x1 * cell_w;
+    int y1 = cell_y1 == nr_cells_h ? nr_h : cell_y1 * cell_h;
+    return Rect(x0, y0, x1 - x0, y1 - y0);
+}
+
+void SuperpixelSEEDSImpl::updateInTiles(int level, float req_confidence)
+{
+    if( !parallel_updates )
+    {
+        if( level < 0 )
+            updatePixels(Rect(0, 0, width, height), PASS_ALL);
+        else
+            updateBlocks(level, Rect(0, 0, nr_wh[2 * level], nr_wh[2 * level + 1]),
+                    PASS_ALL, req_confidence);
+        return;
+    }
+
+    // the tiles of a tiling with the same column and row parities are at
+    // least one tile apart, so they read and write disjoint labels
+    vector<int> tiles;
+    for (int tiling = 0; tiling < 2; tiling++)
+    {
+        for (int parity = 0; parity < 4; parity++)
+        {
+            tiles.clear();
+            for (int tile_y = parity >> 1; tile_y < nr_tiles_wh[2 * tiling + 1]; tile_y += 2)
+            {
+                for (int tile_x = parity & 1; tile_x < nr_tiles_wh[2 * tiling]; tile_x += 2)
+                    tiles.push_back(tile_y * nr_tiles_wh[2 * tiling] + tile_x);
+            }
+            if( !tiles.empty() )
+                parallel_for_(Range(0, (int)tiles.size()),
+                        UpdateInvoker(this, level, tiling, tiles, req_confidence));
+        }
+    }
+
+    // the pairs of labels owned by no tile
+    if( level < 0 )
+        updatePixels(Rect(0, 0, width, height), PASS_REMAINING);
+    else
+        updateBlocks(level, Rect(0, 0, nr_wh[2 * level], nr_wh[2 * level + 1]),
+                PASS_REMAINING, req_confidence);
+}
+
 void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
+{
+    updateInTiles(level, req_confidence);
+}
+
+void SuperpixelSEEDSImpl::updateBlocks(int level, const Rect& roi, int pass,
+        float req_confidence)
 {
     int labelA;
     int labelB;
@@ -479,10 +738,15 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
     bool done;
     int step = nr_wh[2 * level];
 
+    int x_start = std::max(roi.x, 1);
+    int y_start = std::max(roi.y, 1);
+
     // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    int x_end = std::min(roi.x + roi.width, nr_wh[2 * level] - 2);
+    int y_end = std::min(roi.y + roi.height, nr_wh[2 * level + 1] - 1);
+    for (int y = y_start; y < y_end; y++)
     {
-        for (int x = 1; x < nr_wh[2 * level] - 2; x++)
+        for (int x = x_start; x < x_end; x++)
         {
             // choose a label at the current level
             sublabel = y * step + x;
@@ -491,7 +755,8 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
             // get the neighboring label at the top level (= superpixel label)
             labelB = parent[level][y * step + x + 1];
 
-            if( labelA == labelB )
+            if( labelA == labelB || (pass != PASS_ALL
+                    && pairPass(level, x, y, labelA, labelB) != pass) )
                 continue;
 
             // get the surrounding labels at the top level, to check for splitting
@@ -543,9 +808,11 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
     }
 
     // vertical bidirectional
-    for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+    x_end = std::min(roi.x + roi.width, nr_wh[2 * level] - 1);
+    y_end = std::min(roi.y + roi.height, nr_wh[2 * level + 1] - 2);
+    for (int x = x_start; x < x_end; x++)
     {
-        for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
+        for (int y = y_start; y < y_end; y++)
         {
             // choose a label at the current level
             sublabel = y * step + x;
@@ -554,7 +821,8 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
             // get the neighboring label at the top level (= superpixel label)
             labelB = parent[level][(y + 1) * step + x];
 
-            if( labelA == labelB )
+            if( labelA == labelB || (pass != PASS_ALL
+                    && pairPass(level, x, y, labelA, labelB) != pass) )
                 continue;
 
             int a11 = parent[level][(y - 1) * step + (x - 1)];
@@ -636,21 +904,59 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
 }
 
 void SuperpixelSEEDSImpl::updatePixels()
+{
+    int labelA;
+    int labelB;
+
+    updateInTiles(-1, 0.0f);
+    forwardbackward = !forwardbackward;
+
+    // update border pixels
+    for (int x = 0; x < width; x++)
+    {
+        labelA = labels[x];
+        labelB = labels[width + x];
+        if( labelA != labelB )
+            update(labelB, x, labelA);
+        labelA = labels[(height - 1) * width + x];
+        labelB = labels[(height - 2) * width + x];
+        if( labelA != labelB )
+            update(labelB, (height - 1) * width + x, labelA);
+    }
+    for (int y = 0; y < height; y++)
+    {
+        labelA = labels[y * width];
+        labelB = labels[y * width + 1];
+        if( labelA != labelB )
+            update(labelB, y * width, labelA);
+        labelA = labels[y * width + width - 1];
+        labelB = labels[y * width + width - 2];
+        if( labelA != labelB )
+            update(labelB, y * width + width - 1, labelA);
+    }
+}
+
+void SuperpixelSEEDSImpl::updatePixels(const Rect& roi, int pass)
 {
     int labelA;
     int labelB;
     int priorA = 0;
     int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
+    int x_start = std::max(roi.x, 1);
+    int y_start = std::max(roi.y, 1);
+    int x_end = std::min(roi.x + roi.width, width - 2);
+    int y_end = std::min(roi.y + roi.height, height - 1);
+    for (int y = y_start; y < y_end; y++)
     {
-        for (int x = 1; x < width - 2; x++)
+        for (int x = x_start; x < x_end; x++)
         {
 
             labelA = labels[(y) * width + (x)];
             labelB = labels[(y) * width + (x + 1)];
 
-            if( labelA != labelB )
+            if( labelA != labelB && (pass == PASS_ALL
+                    || pairPass(-1, x, y, labelA, labelB) == pass) )
             {
                 int a22 = labelA;
                 int a23 = labelB;
@@ -734,14 +1040,17 @@ void SuperpixelSEEDSImpl::updatePixels()
         } // for x
     } // for y
 
-    for (int x = 1; x < width - 1; x++)
+    x_end = std::min(roi.x + roi.width, width - 1);
+    y_end = std::min(roi.y + roi.height, height - 2);
+    for (int x = x_start; x < x_end; x++)
     {
-        for (int y = 1; y < height - 2; y++)
+        for (int y = y_start; y < y_end; y++)
         {
 
             labelA = labels[(y) * width + (x)];
             labelB = labels[(y + 1) * width + (x)];
-            if( labelA != labelB )
+            if( labelA != labelB && (pass == PASS_ALL
+                    || pairPass(-1, x, y, labelA, labelB) == pass) )
             {
                 int a22 = labelA;
                 int a32 = labelB;
@@ -825,31 +1134,6 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for y
     } // for x
-    forwardbackward = !forwardbackward;
-
-    // update border pixels
-    for (int x = 0; x < width; x++)
-    {
-        labelA = labels[x];
-        labelB = labels[width + x];
-        if( labelA != labelB )
-            update(labelB, x, labelA);
-        labelA = labels[(height - 1) * width + x];
-        labelB = labels[(height - 2) * width + x];
-        if( labelA != labelB )
-            update(labelB, (height - 1) * width + x, labelA);
-    }
-    for (int y = 0; y < height; y++)
-    {
-        labelA = labels[y * width];
-        labelB = labels[y * width + 1];
-        if( labelA != labelB )
-            update(labelB, y * width, labelA);
-        labelA = labels[y * width + width - 1];
-        labelB = labels[y * width + width - 2];
-        if( labelA != labelB )
-            update(labelB, y * width + width - 1, labelA);
-    }
 }
 
 void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
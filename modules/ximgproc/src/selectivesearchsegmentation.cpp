@@ -110,6 +110,38 @@ namespace cv {
                     }
             };
 
+            // Compute the size and the bounding rect of each region, in a single pass over the labels
+            static void computeRegionsStats(const Mat& regions, int nb_segs, Mat_<int>& sizes, std::vector<Rect>& bounding_rects) {
+
+                std::vector<int> min_x(nb_segs, INT_MAX), min_y(nb_segs, INT_MAX), max_x(nb_segs, -1), max_y(nb_segs, -1);
+
+                sizes = Mat_<int>::zeros(nb_segs, 1);
+
+                for (int i = 0; i < (int)regions.rows; i++) {
+                    const int* p = regions.ptr<int>(i);
+
+                    for (int j = 0; j < (int)regions.cols; j++) {
+                        int r = p[j];
+
+                        sizes(r, 0)++;
+                        min_x[r] = std::min(min_x[r], j);
+                        max_x[r] = std::max(max_x[r], j);
+                        min_y[r] = std::min(min_y[r], i);
+                        max_y[r] = std::max(max_y[r], i);
+                    }
+                }
+
+                bounding_rects.resize(nb_segs);
+
+                for (int seg = 0; seg < nb_segs; seg++) {
+                    if (sizes(seg, 0) > 0) {
+                        bounding_rects[seg] = Rect(min_x[seg], min_y[seg], max_x[seg] - min_x[seg] + 1, max_y[seg] - min_y[seg] + 1);
+                    } else {
+                        bounding_rects[seg] = Rect();
+                    }
+                }
+            }
+
             /****************************************
              * Stragegy / Color
              ***************************************/
@@ -145,14 +177,13 @@ namespace cv {
 
                 if (image_id != -1 && last_image_id != image_id) {
 
+                    CV_Assert(img.depth() == CV_8U);
+
                     std::vector<Mat> img_planes;
                     split(img, img_planes);
 
                     int histogram_bins_size = 25;
 
-                    float range[] = {0, 256};
-                    const float* histogram_ranges = {range};
-
                     double min, max;
                     minMaxLoc(regions, &min, &max);
                     int nb_segs = (int)max + 1;
@@ -161,45 +192,37 @@ namespace cv {
 
                     histograms = Mat_<float>(nb_segs, histogram_size);
 
-                    for (int r = 0; r < nb_segs; r++) {
-
-                        // Generate mask
-                        Mat mask = Mat(img.rows, img.cols, CV_8UC1);
-
-                        int* regions_data = (int*)regions.data;
-                        char* mask_data = (char*)mask.data;
-
-                        for (unsigned int x = 0; x < regions.total(); x++) {
-                            mask_data[x] = regions_data[x] == r ? 255 : 0;
-                        }
-
-                        // Compute histogram for each channels
-                        float tt = 0;
+                    // Bins are added directly based on the region of each pixel, instead of computing
+                    // a masked histogram of the whole image for every region
+                    Mat_<int> tmp_histograms = Mat_<int>::zeros(nb_segs, histogram_size);
+                    std::vector<int> totals(nb_segs, 0);
 
-                        Mat tmp_hists = Mat(histogram_size, 1, CV_32F);
-                        float *tmp_histogram = tmp_hists.ptr<float>(0);
-                        int h_pos = 0;
-                        Mat tmp_hist;
+                    for (int y = 0; y < img.rows; y++) {
+                        const int* regions_data = regions.ptr<int>(y);
 
                         for (int p = 0; p < img.channels(); p++) {
+                            const uchar* plane_data = img_planes[p].ptr<uchar>(y);
+                            int h_pos = p * histogram_bins_size;
 
-                            calcHist(&img_planes[p], 1, 0, mask, tmp_hist, 1, &histogram_bins_size, &histogram_ranges);
-
-                            float *tmp_hist_ = tmp_hist.ptr<float>(0);
-
-                            // Copy local histogram to global histogram
-                            for (int pos = 0; pos < histogram_bins_size; pos++) {
-                                tmp_histogram[pos + h_pos] = tmp_hist_[pos];
-                                tt += tmp_histogram[pos + h_pos];
+                            for (int x = 0; x < img.cols; x++) {
+                                // Same bins as calcHist with a [0, 256) range
+                                tmp_histograms(regions_data[x], h_pos + plane_data[x] * histogram_bins_size / 256)++;
                             }
-                            h_pos += histogram_bins_size;
                         }
 
-                        // Normalize historgrams
+                        for (int x = 0; x < img.cols; x++) {
+                            totals[regions_data[x]] += img.channels();
+                        }
+                    }
+
+                    // Normalize historgrams
+                    for (int r = 0; r < nb_segs; r++) {
+
                         float* histogram = histograms.ptr<float>(r);
+                        const int* tmp_histogram = tmp_histograms.ptr<int>(r);
 
                         for (int h_pos2 = 0; h_pos2 < histogram_size; h_pos2++) {
-                            histogram[h_pos2] = tmp_histogram[h_pos2] / tt;
+                            histogram[h_pos2] = (float)tmp_histogram[h_pos2] / (float)totals[r];
                         }
                     }
 
@@ -264,6 +287,9 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight);
                     virtual void clearStrategies();
 
+                    const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& getStrategies() const { return strategies; }
+                    const std::vector<float>& getWeights() const { return weights; }
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -433,25 +459,8 @@ namespace cv {
 
                 int nb_segs = (int)max + 1;
 
-                // Build a list of points for each regions
-                std::vector<std::vector<cv::Point> > points;
-
-                points.resize(nb_segs);
-
-                for (int i = 0; i < (int)regions.rows; i++) {
-                    const int* p = regions.ptr<int>(i);
-
-                    for (int j = 0; j < (int)regions.cols; j++) {
-                        points[p[j]].push_back(cv::Point(j, i));
-                    }
-                }
-
-                // Compute bounding rects for each regions
-                bounding_rects.resize(nb_segs);
-
-                for(int seg = 0; seg < nb_segs; seg++) {
-                    bounding_rects[seg] = cv::boundingRect(points[seg]);
-                }
+                Mat_<int> region_sizes;
+                computeRegionsStats(regions, nb_segs, region_sizes, bounding_rects);
             }
 
             float SelectiveSearchSegmentationStrategyFillImpl::get(int r1, int r2) {
@@ -684,8 +693,139 @@ namespace cv {
                 return s;
             }
 
+            // Create a new instance of a strategy, with the same parameters but no state, so it can be used
+            // concurrently with the original one. Strategies shared between several strategies are cloned
+            // once, using the 'clones' map. Returns an empty pointer for unknown (user) strategies.
+            static Ptr<SelectiveSearchSegmentationStrategy> cloneStrategy(const Ptr<SelectiveSearchSegmentationStrategy>& s, std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >& clones) {
+
+                std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> >::iterator it = clones.find(s.get());
+
+                if (it != clones.end()) {
+                    return it->second;
+                }
+
+                Ptr<SelectiveSearchSegmentationStrategy> c;
+
+                if (dynamic_cast<SelectiveSearchSegmentationStrategyColorImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategyColor();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategySizeImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategySize();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategyFillImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategyFill();
+                } else if (dynamic_cast<SelectiveSearchSegmentationStrategyTextureImpl*>(s.get())) {
+                    c = createSelectiveSearchSegmentationStrategyTexture();
+                } else if (SelectiveSearchSegmentationStrategyMultipleImpl* m = dynamic_cast<SelectiveSearchSegmentationStrategyMultipleImpl*>(s.get())) {
+                    Ptr<SelectiveSearchSegmentationStrategyMultiple> cm = createSelectiveSearchSegmentationStrategyMultiple();
+
+                    for (size_t i = 0; i < m->getStrategies().size(); i++) {
+                        Ptr<SelectiveSearchSegmentationStrategy> sub = cloneStrategy(m->getStrategies()[i], clones);
+
+                        if (sub.empty()) {
+                            return Ptr<SelectiveSearchSegmentationStrategy>();
+                        }
+
+                        cm->addStrategy(sub, m->getWeights()[i]);
+                    }
+
+                    c = cm;
+                }
+
+                if (!c.empty()) {
+                    clones[s.get()] = c;
+                }
+
+                return c;
+            }
+
             // Core
 
+            // Initial regions of a segmentation: for each region, the list of its neighbours with a greater id,
+            // sorted. Only the boundaries between regions contribute, so this is linear in the number of regions.
+            static void computeNeighbours(const Mat& img_regions, int nb_segs, std::vector<std::vector<int> >& neighbours) {
+
+                neighbours.assign(nb_segs, std::vector<int>());
+
+                const int* previous_p = NULL;
+
+                for (int i = 0; i < (int)img_regions.rows; i++) {
+                    const int* p = img_regions.ptr<int>(i);
+
+                    if (i > 0) {
+                        for (int j = 1; j < (int)img_regions.cols; j++) {
+                            int r = p[j];
+                            int others[3] = { p[j - 1], previous_p[j], previous_p[j - 1] };
+
+                            for (int o = 0; o < 3; o++) {
+                                if (others[o] < r) {
+                                    neighbours[others[o]].push_back(r);
+                                } else if (others[o] > r) {
+                                    neighbours[r].push_back(others[o]);
+                                }
+                            }
+                        }
+                    }
+                    previous_p = p;
+                }
+
+                for (int seg = 0; seg < nb_segs; seg++) {
+                    std::vector<int>& n = neighbours[seg];
+                    std::sort(n.begin(), n.end());
+                    n.erase(std::unique(n.begin(), n.end()), n.end());
+                }
+            }
+
+            static void hierarchicalGrouping(const Mat& img, const Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const std::vector<std::vector<int> >& neighbours, const Mat_<int>& sizes, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id);
+
+            // Process the (image, graph segmentation) pairs: each pair is segmented, then grouped with every strategy
+            class SelectiveSearchInvoker : public ParallelLoopBody {
+                public:
+                    SelectiveSearchInvoker(const std::vector<Mat>& images_, const std::vector<Ptr<GraphSegmentation> >& segmentations_,
+                                           const std::vector<std::vector<Ptr<SelectiveSearchSegmentationStrategy> > >& strategies_,
+                                           std::vector<std::vector<Region> >& regions_)
+                        : images(images_), segmentations(segmentations_), strategies(strategies_), regions(regions_) {}
+
+                    void operator()(const Range& range) const {
+                        for (int task = range.start; task < range.end; task++) {
+                            const Mat& image = images[task / segmentations.size()];
+                            const Ptr<GraphSegmentation>& gs = segmentations[task % segmentations.size()];
+
+                            // Tasks share the strategies when they could not be cloned, they are then run serially
+                            const std::vector<Ptr<SelectiveSearchSegmentationStrategy> >& task_strategies = strategies[strategies.size() == 1 ? 0 : task];
+
+                            Mat img_regions;
+
+                            // Compute initial segmentation
+                            gs->processImage(image, img_regions);
+
+                            // Get number of regions
+                            double min, max;
+                            minMaxLoc(img_regions, &min, &max);
+                            int nb_segs = (int)max + 1;
+
+                            // Compute sizes, bouding rects and neighbours
+                            Mat_<int> sizes;
+                            std::vector<Rect> bounding_rects;
+                            std::vector<std::vector<int> > neighbours;
+
+                            computeRegionsStats(img_regions, nb_segs, sizes, bounding_rects);
+                            computeNeighbours(img_regions, nb_segs, neighbours);
+
+                            for (size_t i = 0; i < task_strategies.size(); i++) {
+                                std::vector<Region> strategy_regions;
+                                hierarchicalGrouping(image, task_strategies[i], img_regions, neighbours, sizes, nb_segs, bounding_rects, strategy_regions, task);
+
+                                regions[task].insert(regions[task].end(), strategy_regions.begin(), strategy_regions.end());
+                            }
+                        }
+                    }
+
+                private:
+                    const std::vector<Mat>& images;
+                    const std::vector<Ptr<GraphSegmentation> >& segmentations;
+                    const std::vector<std::vector<Ptr<SelectiveSearchSegmentationStrategy> > >& strategies;
+                    std::vector<std::vector<Region> >& regions;
+            };
+
             class SelectiveSearchSegmentationImpl : public SelectiveSearchSegmentation {
                 public:
                     SelectiveSearchSegmentationImpl() {
@@ -728,8 +868,6 @@ namespace cv {
                     std::vector<Mat> images;
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
-
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -887,75 +1025,43 @@ namespace cv {
 
             void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
 
-                std::vector<Region> all_regions;
-
-                int image_id = 0;
-
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
-
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
-
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                int nb_tasks = (int)(images.size() * segmentations.size());
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                // Each (image, graph segmentation) pair is processed with its own copy of the strategies,
+                // so the pairs can run in parallel. The strategies shared between strategies stay shared in
+                // a copy, to keep their cache.
+                std::vector<std::vector<Ptr<SelectiveSearchSegmentationStrategy> > > task_strategies(nb_tasks);
+                bool clonable = true;
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+                for (int task = 0; task < nb_tasks && clonable; task++) {
+                    std::map<SelectiveSearchSegmentationStrategy*, Ptr<SelectiveSearchSegmentationStrategy> > clones;
 
-                        std::vector<std::vector<cv::Point> > points;
-
-                        points.resize(nb_segs);
-
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
-
-                        const int* previous_p = NULL;
-
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
-
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
-
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
-
-                                if (i > 0 && j > 0) {
-
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+                    for (size_t i = 0; i < strategies.size() && clonable; i++) {
+                        Ptr<SelectiveSearchSegmentationStrategy> c = cloneStrategy(strategies[i], clones);
+                        clonable = !c.empty();
+                        task_strategies[task].push_back(c);
+                    }
+                }
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
-                                }
-                            }
-                            previous_p = p;
-                        }
+                std::vector<std::vector<Region> > task_regions(nb_tasks);
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+                if (clonable) {
+                    parallel_for_(Range(0, nb_tasks), SelectiveSearchInvoker(images, segmentations, task_strategies, task_regions));
+                } else {
+                    task_strategies.assign(1, strategies);
+                    SelectiveSearchInvoker(images, segmentations, task_strategies, task_regions)(Range(0, nb_tasks));
+                }
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                std::vector<Region> all_regions;
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
-                            }
-                        }
+                for (int task = 0; task < nb_tasks; task++) {
+                    all_regions.insert(all_regions.end(), task_regions[task].begin(), task_regions[task].end());
+                }
 
-                        image_id++;
-                    }
+                // Compute regions' rank, in the order of the pairs and strategies
+                for(std::vector<Region>::iterator region = all_regions.begin(); region != all_regions.end(); ++region) {
+                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
+                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
                 }
 
                 std::sort(all_regions.begin(), all_regions.end());
@@ -974,7 +1080,7 @@ namespace cv {
 
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            static void hierarchicalGrouping(const Mat& img, const Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const std::vector<std::vector<int> >& neighbours, const Mat_<int>& sizes_, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
 
                 Mat sizes = sizes_.clone();
 
@@ -996,15 +1102,13 @@ namespace cv {
 
                     regions.push_back(r);
 
-                    for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
-                            Neighbour n;
-                            n.from = i;
-                            n.to = j;
-                            n.similarity = s->get(i, j);
+                    for (size_t k = 0; k < neighbours[i].size(); k++) {
+                        Neighbour n;
+                        n.from = i;
+                        n.to = neighbours[i][k];
+                        n.similarity = s->get(i, n.to);
 
-                            similarities.push_back(n);
-                        }
+                        similarities.push_back(n);
                     }
                 }
 
@@ -1042,7 +1146,10 @@ namespace cv {
 
                     std::vector<int> local_neighbours;
 
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
+                    // Remove the similarities of the merged regions, keeping the order of the other ones
+                    std::vector<Neighbour>::iterator kept = similarities.begin();
+
+                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
                         if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
                             int from = 0;
 
@@ -1063,13 +1170,13 @@ namespace cv {
                             if (!already_neighboor) {
                                 local_neighbours.push_back(from);
                             }
-
-                            similarity = similarities.erase(similarity);
                         } else {
-                            similarity++;
+                            *kept++ = *similarity;
                         }
                     }
 
+                    similarities.erase(kept, similarities.end());
+
                     for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
 
                         Neighbour n;
@@ -1080,13 +1187,6 @@ namespace cv {
                         similarities.push_back(n);
                     }
                 }
-
-                // Compute regions' rank
-                for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
-                }
-
             }
 
             Ptr<SelectiveSearchSegmentation> createSelectiveSearchSegmentation() {
@@ -106,6 +106,113 @@ static cv::Mat imsmooth(const cv::Mat &src, const int rad)
     }
 }
 
+/*!
+ *  Parallel body of rgb2luv, converting a range of rows
+ */
+class Rgb2LuvInvoker : public cv::ParallelLoopBody
+{
+public:
+    Rgb2LuvInvoker(const cv::Mat &_src, cv::Mat &_dst, const std::vector <float> &_lTable)
+        : src(_src), dst(_dst), lTable(_lTable)
+    {
+        useSIMD = cv::checkHardwareSupport(CV_CPU_SSE2);
+    }
+
+    void operator()(const cv::Range &range) const
+    {
+        const float mX[] = {0.430574f, 0.341550f, 0.178325f};
+        const float mY[] = {0.222015f, 0.706655f, 0.071330f};
+        const float mZ[] = {0.020183f, 0.129553f, 0.939180f};
+
+        const float maxi= 1.0f/270;
+        const float minu=  -88*maxi;
+        const float minv= -134*maxi;
+
+        const float un = 0.197833f;
+        const float vn = 0.468331f;
+
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const float *pSrc = src.ptr<float>(i);
+            float *pDst = dst.ptr<float>(i);
+
+            int j = 0;
+
+        #if CV_SSE2
+            if (useSIMD)
+            {
+                const __m128 mX0 = _mm_set1_ps(mX[0]), mX1 = _mm_set1_ps(mX[1]), mX2 = _mm_set1_ps(mX[2]);
+                const __m128 mY0 = _mm_set1_ps(mY[0]), mY1 = _mm_set1_ps(mY[1]), mY2 = _mm_set1_ps(mY[2]);
+                const __m128 mZ0 = _mm_set1_ps(mZ[0]), mZ1 = _mm_set1_ps(mZ[1]), mZ2 = _mm_set1_ps(mZ[2]);
+
+                int CV_DECL_ALIGNED(16) lIndex[4];
+                float CV_DECL_ALIGNED(16) l[4], u[4], v[4];
+
+                for (; j <= src.cols - 4; j += 4)
+                {
+                    // deinterleave 4 pixels: a = r0 g0 b0 r1, b = g1 b1 r2 g2, c = b2 r3 g3 b3
+                    __m128 a = _mm_loadu_ps(pSrc + 3*j);
+                    __m128 b = _mm_loadu_ps(pSrc + 3*j + 4);
+                    __m128 c = _mm_loadu_ps(pSrc + 3*j + 8);
+
+                    __m128 r = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 0, 2, 2)), _MM_SHUFFLE(3, 0, 3, 0));
+                    __m128 g = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+                                              _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+                    __m128 bl = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+                                               _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+                    __m128 x = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mX0, r), _mm_mul_ps(mX1, g)), _mm_mul_ps(mX2, bl));
+                    __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mY0, r), _mm_mul_ps(mY1, g)), _mm_mul_ps(mY2, bl));
+                    __m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(mZ0, r), _mm_mul_ps(mZ1, g)), _mm_mul_ps(mZ2, bl));
+
+                    __m128 nz = _mm_add_ps(_mm_add_ps(x, _mm_mul_ps(_mm_set1_ps(15.0f), y)), _mm_mul_ps(_mm_set1_ps(3.0f), z));
+                    nz = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(nz, _mm_set1_ps(1e-35f)));
+
+                    // y is non negative, so truncation is cvFloor
+                    _mm_store_si128((__m128i*)lIndex, _mm_cvttps_epi32(_mm_mul_ps(_mm_set1_ps(1024.0f), y)));
+                    for (int k = 0; k < 4; ++k)
+                        l[k] = lTable[lIndex[k]];
+
+                    __m128 lv = _mm_load_ps(l);
+                    _mm_store_ps(u, _mm_sub_ps(_mm_mul_ps(lv, _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(13*4.0f), x), nz),
+                        _mm_set1_ps(13*un))), _mm_set1_ps(minu)));
+                    _mm_store_ps(v, _mm_sub_ps(_mm_mul_ps(lv, _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(_mm_set1_ps(13*9.0f), y), nz),
+                        _mm_set1_ps(13*vn))), _mm_set1_ps(minv)));
+
+                    for (int k = 0; k < 4; ++k)
+                    {
+                        pDst[3*(j + k) + 0] = l[k];
+                        pDst[3*(j + k) + 1] = u[k];
+                        pDst[3*(j + k) + 2] = v[k];
+                    }
+                }
+            }
+        #endif
+
+            for (; j < src.cols; ++j)
+            {
+                const float rgb[] = {pSrc[3*j + 0], pSrc[3*j + 1], pSrc[3*j + 2]};
+
+                const float xyz[] = {mX[0]*rgb[0] + mX[1]*rgb[1] + mX[2]*rgb[2],
+                                     mY[0]*rgb[0] + mY[1]*rgb[1] + mY[2]*rgb[2],
+                                     mZ[0]*rgb[0] + mZ[1]*rgb[1] + mZ[2]*rgb[2]};
+                const float nz = 1.0f / float(xyz[0] + 15*xyz[1] + 3*xyz[2] + 1e-35);
+
+                const float l = pDst[3*j] = lTable[cvFloor(1024*xyz[1])];
+
+                pDst[3*j + 1] = l * (13*4*xyz[0]*nz - 13*un) - minu;
+                pDst[3*j + 2] = l * (13*9*xyz[1]*nz - 13*vn) - minv;
+            }
+        }
+    }
+
+private:
+    const cv::Mat &src;
+    cv::Mat &dst;
+    const std::vector <float> &lTable;
+    bool useSIMD;
+};
+
 /*!
  *  The function implements rgb to luv conversion in a way similar
  *  to UCSD computer vision toolbox
@@ -120,16 +227,7 @@ static cv::Mat rgb2luv(const cv::Mat &src)
     const float a  = CV_CUBE(29.0f)/27;
     const float y0 = 8.0f/a;
 
-    const float mX[] = {0.430574f, 0.341550f, 0.178325f};
-    const float mY[] = {0.222015f, 0.706655f, 0.071330f};
-    const float mZ[] = {0.020183f, 0.129553f, 0.939180f};
-
     const float maxi= 1.0f/270;
-    const float minu=  -88*maxi;
-    const float minv= -134*maxi;
-
-    const float un = 0.197833f;
-    const float vn = 0.468331f;
 
     // build (padded) lookup table for y->l conversion assuming y in [0,1]
     std::vector <float> lTable(1024);
@@ -143,31 +241,142 @@ static cv::Mat rgb2luv(const cv::Mat &src)
     for (int i = 0; i < 40; ++i)
         lTable.push_back(*--lTable.end());
 
-    const int nchannels = 3;
+    cv::parallel_for_(cv::Range(0, src.rows), Rgb2LuvInvoker(src, dst, lTable));
+
+    return dst;
+}
+
+/*!
+ *  Parallel body of gradientHist, selecting for a range of rows the
+ *  gradient of the channel with the largest magnitude
+ */
+class GradientSelectionInvoker : public cv::ParallelLoopBody
+{
+public:
+    GradientSelectionInvoker(const std::vector <cv::Mat> &_Dx, const std::vector <cv::Mat> &_Dy,
+                             cv::Mat &_magnitude, cv::Mat &_dx, cv::Mat &_dy)
+        : Dx(_Dx), Dy(_Dy), magnitude(_magnitude), dx(_dx), dy(_dy)
+    {
+        useSIMD = cv::checkHardwareSupport(CV_CPU_SSE2);
+    }
 
-    for (int i = 0; i < src.rows; ++i)
+    void operator()(const cv::Range &range) const
     {
-        const float *pSrc = src.ptr<float>(i);
-        float *pDst = dst.ptr<float>(i);
+        int nchannels = int( Dx.size() );
+
+        std::vector <const float *> pDx(nchannels), pDy(nchannels);
 
-        for (int j = 0; j < src.cols*nchannels; j += nchannels)
+        for (int i = range.start; i < range.end; ++i)
         {
-            const float rgb[] = {pSrc[j + 0], pSrc[j + 1], pSrc[j + 2]};
+            for (int k = 0; k < nchannels; ++k)
+            {
+                pDx[k] = Dx[k].ptr<float>(i);
+                pDy[k] = Dy[k].ptr<float>(i);
+            }
 
-            const float xyz[] = {mX[0]*rgb[0] + mX[1]*rgb[1] + mX[2]*rgb[2],
-                                 mY[0]*rgb[0] + mY[1]*rgb[1] + mY[2]*rgb[2],
-                                 mZ[0]*rgb[0] + mZ[1]*rgb[1] + mZ[2]*rgb[2]};
-            const float nz = 1.0f / float(xyz[0] + 15*xyz[1] + 3*xyz[2] + 1e-35);
+            float *pMagnitude = magnitude.ptr<float>(i);
+            float *pSelectedDx = dx.ptr<float>(i);
+            float *pSelectedDy = dy.ptr<float>(i);
 
-            const float l = pDst[j] = lTable[cvFloor(1024*xyz[1])];
+            int j = 0;
 
-            pDst[j + 1] = l * (13*4*xyz[0]*nz - 13*un) - minu;;
-            pDst[j + 2] = l * (13*9*xyz[1]*nz - 13*vn) - minv;
+        #if CV_SSE2
+            if (useSIMD)
+            {
+                for (; j <= magnitude.cols - 4; j += 4)
+                {
+                    __m128 fMagn = _mm_set1_ps(float(-1e-5)), fdx = _mm_setzero_ps(), fdy = _mm_setzero_ps();
+                    for (int k = 0; k < nchannels; ++k)
+                    {
+                        __m128 cdx = _mm_loadu_ps(pDx[k] + j);
+                        __m128 cdy = _mm_loadu_ps(pDy[k] + j);
+                        __m128 cMagn = _mm_add_ps(_mm_mul_ps(cdx, cdx), _mm_mul_ps(cdy, cdy));
+
+                        __m128 mask = _mm_cmpgt_ps(cMagn, fMagn);
+                        fMagn = _mm_or_ps(_mm_and_ps(mask, cMagn), _mm_andnot_ps(mask, fMagn));
+                        fdx = _mm_or_ps(_mm_and_ps(mask, cdx), _mm_andnot_ps(mask, fdx));
+                        fdy = _mm_or_ps(_mm_and_ps(mask, cdy), _mm_andnot_ps(mask, fdy));
+                    }
+
+                    _mm_storeu_ps(pMagnitude + j, _mm_sqrt_ps(fMagn));
+                    _mm_storeu_ps(pSelectedDx + j, fdx);
+                    _mm_storeu_ps(pSelectedDy + j, fdy);
+                }
+            }
+        #endif
+
+            for (; j < magnitude.cols; ++j)
+            {
+                float fMagn = float(-1e-5), fdx = 0, fdy = 0;
+                for (int k = 0; k < nchannels; ++k)
+                {
+                    float cMagn = CV_SQR( pDx[k][j] ) + CV_SQR( pDy[k][j] );
+                    if (cMagn > fMagn)
+                    {
+                        fMagn = cMagn;
+                        fdx = pDx[k][j];
+                        fdy = pDy[k][j];
+                    }
+                }
+
+                pMagnitude[j] = sqrtf(fMagn);
+                pSelectedDx[j] = fdx;
+                pSelectedDy[j] = fdy;
+            }
         }
     }
 
-    return dst;
-}
+private:
+    const std::vector <cv::Mat> &Dx, &Dy;
+    cv::Mat &magnitude, &dx, &dy;
+    bool useSIMD;
+};
+
+/*!
+ *  Parallel body of gradientHist, accumulating a range of histogram rows
+ */
+class GradientHistInvoker : public cv::ParallelLoopBody
+{
+public:
+    GradientHistInvoker(const cv::Mat &_phase, const cv::Mat &_dx, const cv::Mat &_dy,
+                        const cv::Mat &_magnitude, cv::Mat &_histogram, const int _nBins, const int _pSize)
+        : phase(_phase), dx(_dx), dy(_dy), magnitude(_magnitude), histogram(_histogram),
+          nBins(_nBins), pSize(_pSize) {}
+
+    void operator()(const cv::Range &range) const
+    {
+        int pHistSize = histogram.cols*histogram.channels() - 1;
+
+        for (int h = range.start; h < range.end; ++h)
+        {
+            float *pHist = histogram.ptr<float>(h);
+
+            for (int i = h*pSize; i < std::min((h + 1)*pSize, phase.rows); ++i)
+            {
+                const float *pPhase = phase.ptr<float>(i);
+                const float *pDx = dx.ptr<float>(i);
+                const float *pDy = dy.ptr<float>(i);
+                const float *pMagn  = magnitude.ptr<float>(i);
+
+                for (int j = 0; j < phase.cols; ++j)
+                {
+                    float angle = pPhase[j] / 180.0f - 1.0f * (pDy[j] < 0);
+                    if (std::fabs(pDx[j]) + std::fabs(pDy[j]) < 1e-5)
+                        angle = 0.5f;
+
+                    int index  = cvRound((j/pSize + angle)*nBins);
+                    index = std::max(0, std::min(index, pHistSize));
+                    pHist[index] += pMagn[j] / CV_SQR(pSize);
+                }
+            }
+        }
+    }
+
+private:
+    const cv::Mat &phase, &dx, &dy, &magnitude;
+    cv::Mat &histogram;
+    int nBins, pSize;
+};
 
 /*!
  * The function computes gradient magnitude and weighted (with magnitude)
@@ -184,10 +393,11 @@ static cv::Mat rgb2luv(const cv::Mat &src)
 static void gradientHist(const cv::Mat &src, cv::Mat &magnitude, cv::Mat &histogram,
                          const int nBins, const int pSize, const int gnrmRad)
 {
-    cv::Mat phase, Dx, Dy;
+    cv::Mat phase, Dx, Dy, dx, dy;
 
     magnitude.create( src.size(), cv::DataType<float>::type );
-    phase.create( src.size(), cv::DataType<float>::type );
+    dx.create( src.size(), cv::DataType<float>::type );
+    dy.create( src.size(), cv::DataType<float>::type );
     histogram.create( cv::Size( cvCeil(src.size().width/float(pSize)),
                                 cvCeil(src.size().height/float(pSize)) ),
         CV_MAKETYPE(cv::DataType<float>::type, nBins) );
@@ -199,57 +409,21 @@ static void gradientHist(const cv::Mat &src, cv::Mat &magnitude, cv::Mat &histog
     cv::Sobel( src, Dy, cv::DataType<float>::type,
         0, 1, 1, 1.0, 0.0, cv::BORDER_REFLECT );
 
-    int nchannels = src.channels();
+    std::vector <cv::Mat> DxChannels, DyChannels;
+    cv::split( Dx, DxChannels );
+    cv::split( Dy, DyChannels );
 
-    for (int i = 0; i < src.rows; ++i)
-    {
-        const float *pDx = Dx.ptr<float>(i);
-        const float *pDy = Dy.ptr<float>(i);
+    cv::parallel_for_( cv::Range(0, src.rows),
+        GradientSelectionInvoker(DxChannels, DyChannels, magnitude, dx, dy) );
 
-        float *pMagnitude = magnitude.ptr<float>(i);
-        float *pPhase = phase.ptr<float>(i);
-
-        for (int j = 0; j < src.cols*nchannels; j += nchannels)
-        {
-            float fMagn = float(-1e-5), fdx = 0, fdy = 0;
-            for (int k = 0; k < nchannels; ++k)
-            {
-                float cMagn = CV_SQR( pDx[j + k] ) + CV_SQR( pDy[j + k] );
-                if (cMagn > fMagn)
-                {
-                    fMagn = cMagn;
-                    fdx = pDx[j + k];
-                    fdy = pDy[j + k];
-                }
-            }
-
-            pMagnitude[j/nchannels] = sqrtf(fMagn);
-
-            float angle = cv::fastAtan2(fdy, fdx) / 180.0f - 1.0f * (fdy < 0);
-            if (std::fabs(fdx) + std::fabs(fdy) < 1e-5)
-                angle = 0.5f;
-            pPhase[j/nchannels] = angle;
-        }
-    }
+    // same angles as fastAtan2, in degrees
+    cv::phase( dx, dy, phase, true );
 
     magnitude /= imsmooth( magnitude, gnrmRad )
         + 0.01*cv::Mat::ones( magnitude.size(), magnitude.type() );
 
-    int pHistSize = histogram.cols*histogram.channels() - 1;
-    for (int i = 0; i < phase.rows; ++i)
-    {
-        const float *pPhase = phase.ptr<float>(i);
-        const float *pMagn  = magnitude.ptr<float>(i);
-
-        float *pHist = histogram.ptr<float>(i/pSize);
-
-        for (int j = 0; j < phase.cols; ++j)
-        {
-            int index  = cvRound((j/pSize + pPhase[j])*nBins);
-            index = std::max(0, std::min(index, pHistSize));
-            pHist[index] += pMagn[j] / CV_SQR(pSize);
-        }
-    }
+    cv::parallel_for_( cv::Range(0, histogram.rows),
+        GradientHistInvoker(phase, dx, dy, magnitude, histogram, nBins, pSize) );
 }
 
 /********************* RFFeatureGetter class *********************/
@@ -259,6 +433,43 @@ namespace cv
 namespace ximgproc
 {
 
+/*!
+ * The function extracts features from an image already converted
+ * to luv, see RFFeatureGetterImpl::getFeatures.
+ */
+static void getLuvFeatures(const Mat &luvImg, Mat &features, const int gnrmRad, const int gsmthRad,
+                           const int shrink, const int outNum, const int gradNum)
+{
+    std::vector <cv::Mat> featureArray;
+
+    cv::Size nSize = luvImg.size() / float(shrink);
+    split( imresize(luvImg, nSize), featureArray );
+
+    CV_INIT_VECTOR(scales, float, {1.0f, 0.5f});
+
+    for (size_t i = 0; i < scales.size(); ++i)
+    {
+        int pSize = std::max( 1, int(shrink*scales[i]) );
+
+        cv::Mat magnitude, histogram;
+        gradientHist(/**/ imsmooth(imresize(luvImg, scales[i]*luvImg.size()), gsmthRad),
+            magnitude, histogram, gradNum, pSize, gnrmRad /**/);
+
+        featureArray.push_back(/**/ imresize( magnitude, nSize ).clone() /**/);
+        featureArray.push_back(/**/ imresize( histogram, nSize ).clone() /**/);
+    }
+
+    // Mixing
+    int resType = CV_MAKETYPE(cv::DataType<float>::type, outNum);
+    features.create(nSize, resType);
+
+    std::vector <int> fromTo;
+    for (int i = 0; i < 2*outNum; ++i)
+        fromTo.push_back(i/2);
+
+    mixChannels(featureArray, features, fromTo);
+}
+
 class RFFeatureGetterImpl : public RFFeatureGetter
 {
 public:
@@ -283,36 +494,7 @@ public:
     virtual void getFeatures(const Mat &src, Mat &features, const int gnrmRad, const int gsmthRad,
                              const int shrink, const int outNum, const int gradNum) const
     {
-        cv::Mat luvImg = rgb2luv(src);
-
-        std::vector <cv::Mat> featureArray;
-
-        cv::Size nSize = src.size() / float(shrink);
-        split( imresize(luvImg, nSize), featureArray );
-
-        CV_INIT_VECTOR(scales, float, {1.0f, 0.5f});
-
-        for (size_t i = 0; i < scales.size(); ++i)
-        {
-            int pSize = std::max( 1, int(shrink*scales[i]) );
-
-            cv::Mat magnitude, histogram;
-            gradientHist(/**/ imsmooth(imresize(luvImg, scales[i]*src.size()), gsmthRad),
-                magnitude, histogram, gradNum, pSize, gnrmRad /**/);
-
-            featureArray.push_back(/**/ imresize( magnitude, nSize ).clone() /**/);
-            featureArray.push_back(/**/ imresize( histogram, nSize ).clone() /**/);
-        }
-
-        // Mixing
-        int resType = CV_MAKETYPE(cv::DataType<float>::type, outNum);
-        features.create(nSize, resType);
-
-        std::vector <int> fromTo;
-        for (int i = 0; i < 2*outNum; ++i)
-            fromTo.push_back(i/2);
-
-        mixChannels(featureArray, features, fromTo);
+        getLuvFeatures(rgb2luv(src), features, gnrmRad, gsmthRad, shrink, outNum, gradNum);
     }
 
 protected:
@@ -450,17 +632,64 @@ public:
     {
         CV_Assert( src.type() == CV_32FC3 );
 
-        dst.create( src.size(), cv::DataType<float>::type );
+        detectLuvEdges( rgb2luv(src), dst );
+    }
+
+    /*!
+     * The function detects edges in src at several scales and draw
+     * their average to dst. The luv conversion is shared by the scales.
+     *
+     * \param src : source image (RGB, float, in [0;1]) to detect edges
+     * \param dst : destination image (grayscale, float, in [0;1])
+     *              where edges are drawn
+     * \param scales : scales at which edges are detected
+     */
+    void detectEdgesMultiscale(const cv::Mat &src, cv::Mat &dst, const std::vector<float> &scales) const
+    {
+        CV_Assert( src.type() == CV_32FC3 );
+        CV_Assert( !scales.empty() );
+
+        cv::Mat luvImg = rgb2luv(src);
+        cv::Mat sum = cv::Mat::zeros( src.size(), cv::DataType<float>::type );
+
+        for (size_t i = 0; i < scales.size(); ++i)
+        {
+            CV_Assert( scales[i] > 0 );
+
+            cv::Mat edges;
+            if (scales[i] == 1.0f)
+                detectLuvEdges( luvImg, edges );
+            else
+            {
+                detectLuvEdges( imresize(luvImg, scales[i]*src.size()), edges );
+                edges = imresize( edges, src.size() );
+            }
+
+            sum += edges;
+        }
+
+        sum.convertTo( dst, cv::DataType<float>::type, 1.0/scales.size() );
+    }
+
+protected:
+    /*!
+     * The function detects edges in an image already converted
+     * to luv, see detectEdges.
+     */
+    void detectLuvEdges(const cv::Mat &luvImg, cv::Mat &dst) const
+    {
+        dst.create( luvImg.size(), cv::DataType<float>::type );
 
         int padding = ( __rf.options.patchSize
             - __rf.options.patchInnerSize )/2;
 
-        cv::Mat nSrc;
-        copyMakeBorder( src, nSrc, padding, padding,
+        // luv conversion is pointwise, so padding commutes with it
+        cv::Mat nLuvImg;
+        copyMakeBorder( luvImg, nLuvImg, padding, padding,
             padding, padding, BORDER_REFLECT );
 
         NChannelsMat features;
-        createRFFeatureGetter()->getFeatures( nSrc, features,
+        getLuvFeatures( nLuvImg, features,
             __rf.options.gradientNormalizationRadius,
             __rf.options.gradientSmoothingRadius,
             __rf.options.shrinkNumber,
@@ -469,7 +698,166 @@ public:
         predictEdges( features, dst );
     }
 
-protected:
+    /*!
+     * Parallel body of predictEdges, evaluating the forest
+     * on a range of rows of patches
+     */
+    class ForestEvaluationInvoker : public ParallelLoopBody
+    {
+    public:
+        ForestEvaluationInvoker(const StructuredEdgeDetectionImpl &_sed, const NChannelsMat &_regFeatures,
+                                const NChannelsMat &_ssFeatures, NChannelsMat &_indexes,
+                                const std::vector <int> &_offsetI, const std::vector <int> &_offsetX,
+                                const std::vector <int> &_offsetY, const int _nchannels, const int _width)
+            : sed(_sed), regFeatures(_regFeatures), ssFeatures(_ssFeatures), indexes(_indexes),
+              offsetI(_offsetI), offsetX(_offsetX), offsetY(_offsetY), nchannels(_nchannels), width(_width) {}
+
+        void operator()(const Range &range) const
+        {
+            const RandomForest &rf = sed.__rf;
+
+            int shrink = rf.options.shrinkNumber;
+            int stride = rf.options.stride;
+            int pSize  = rf.options.patchSize;
+
+            int nTreesEval = rf.options.numberOfTreesToEvaluate;
+            int nTrees = rf.options.numberOfTrees;
+            int nTreesNodes = rf.numberOfTreeNodes;
+
+            int nFeatures = CV_SQR(pSize/shrink)*nchannels;
+
+            for (int i = range.start; i < range.end; ++i)
+            {
+                const float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
+                const float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+
+                int *indexPtr = indexes.ptr<int>(i);
+
+                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
+                    // for j,k in [0;width)x[0;nTreesEval)
+                {
+                    int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
+                    int currentNode = baseNode;
+                    // select root node of the tree to evaluate
+
+                    int offset = (j*stride/shrink)*nchannels;
+                    while ( rf.childs[currentNode] != 0 )
+                    {
+                        int currentId = rf.featureIds[currentNode];
+                        float currentFeature;
+
+                        if (currentId >= nFeatures)
+                        {
+                            int xIndex = offsetX[currentId - nFeatures];
+                            float A = ssFeaturesPtr[offset + xIndex];
+
+                            int yIndex = offsetY[currentId - nFeatures];
+                            float B = ssFeaturesPtr[offset + yIndex];
+
+                            currentFeature = A - B;
+                        }
+                        else
+                            currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
+
+                        // compare feature to threshold and move left or right accordingly
+                        if (currentFeature < rf.thresholds[currentNode])
+                            currentNode = baseNode + rf.childs[currentNode] - 1;
+                        else
+                            currentNode = baseNode + rf.childs[currentNode];
+                    }
+
+                    indexPtr[j*nTreesEval + k] = currentNode;
+                }
+            }
+        }
+
+    private:
+        const StructuredEdgeDetectionImpl &sed;
+        const NChannelsMat &regFeatures, &ssFeatures;
+        NChannelsMat &indexes;
+        const std::vector <int> &offsetI, &offsetX, &offsetY;
+        int nchannels, width;
+    };
+
+    /*!
+     * Parallel body of predictEdges, drawing the edges of tiles of rows
+     * of patches. The patches of a tile cover its own rows of dstM, and
+     * spill over the rows of the next tiles: this part is accumulated in
+     * a buffer of the tile, added to dstM once all the tiles are drawn.
+     */
+    class EdgeAccumulationInvoker : public ParallelLoopBody
+    {
+    public:
+        EdgeAccumulationInvoker(const StructuredEdgeDetectionImpl &_sed, const NChannelsMat &_indexes,
+                                NChannelsMat &_dstM, std::vector <NChannelsMat> &_spills,
+                                const std::vector <int> &_rowE, const std::vector <int> &_colE,
+                                const int _tileRows, const int _height, const int _width)
+            : sed(_sed), indexes(_indexes), dstM(_dstM), spills(_spills), rowE(_rowE), colE(_colE),
+              tileRows(_tileRows), height(_height), width(_width) {}
+
+        void operator()(const Range &range) const
+        {
+            const RandomForest &rf = sed.__rf;
+
+            int nTreesEval = rf.options.numberOfTreesToEvaluate;
+            int outNum = rf.options.numberOfOutputChannels;
+            int stride = rf.options.stride;
+            int ipSize = rf.options.patchInnerSize;
+
+            float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
+
+            for (int t = range.start; t < range.end; ++t)
+            {
+                int startRow = t*tileRows, endRow = std::min((t + 1)*tileRows, height);
+
+                // rows of dstM owned by the tile, the others go to its spill buffer
+                int ownEnd = endRow*stride;
+                int spillRows = std::min((endRow - 1)*stride + ipSize, dstM.rows) - ownEnd;
+
+                NChannelsMat &spill = spills[t];
+                if (spillRows > 0)
+                {
+                    spill.create(spillRows, dstM.cols, dstM.type());
+                    spill.setTo(0);
+                }
+
+                for (int i = startRow; i < endRow; ++i)
+                {
+                    const int *pIndex = indexes.ptr<int>(i);
+
+                    for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
+                    {// for j,k in [0;width)x[0;nTreesEval)
+
+                        int currentNode = pIndex[j*nTreesEval + k];
+
+                        int start  = rf.edgeBoundaries[currentNode];
+                        int finish = rf.edgeBoundaries[currentNode + 1];
+
+                        if (start == finish)
+                            continue;
+
+                        int offset = j*stride*outNum;
+                        for (int p = start; p < finish; ++p)
+                        {
+                            int row = i*stride + rowE[rf.edgeBins[p]];
+                            float *pDst = row < ownEnd ? dstM.ptr<float>(row) : spill.ptr<float>(row - ownEnd);
+
+                            pDst[offset + colE[rf.edgeBins[p]]] += step;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        const StructuredEdgeDetectionImpl &sed;
+        const NChannelsMat &indexes;
+        NChannelsMat &dstM;
+        std::vector <NChannelsMat> &spills;
+        const std::vector <int> &rowE, &colE;
+        int tileRows, height, width;
+    };
+
     /*!
      * Private method used by process method. The function
      * predict edges in n-channel feature image and store them to dst.
@@ -484,13 +872,10 @@ protected:
         int sfs = __rf.options.ssFeatureSmoothingRadius;
 
         int nTreesEval = __rf.options.numberOfTreesToEvaluate;
-        int nTrees = __rf.options.numberOfTrees;
-        int nTreesNodes = __rf.numberOfTreeNodes;
 
         const int nchannels = features.channels();
         int pSize  = __rf.options.patchSize;
 
-        int nFeatures = CV_SQR(pSize/shrink)*nchannels;
         int outNum = __rf.options.numberOfOutputChannels;
 
         int stride = __rf.options.stride;
@@ -519,16 +904,18 @@ protected:
         }
         // lookup table for mapping linear index to offsets
 
-        std::vector <int> offsetE(/**/ CV_SQR(ipSize)*outNum, 0);
+        std::vector <int> rowE(/**/ CV_SQR(ipSize)*outNum, 0);
+        std::vector <int> colE(/**/ CV_SQR(ipSize)*outNum, 0);
         for (int i = 0; i < CV_SQR(ipSize)*outNum; ++i)
         {
             int z = i / CV_SQR(ipSize);
             int y = ( i % CV_SQR(ipSize) )/ipSize;
             int x = ( i % CV_SQR(ipSize) )%ipSize;
 
-            offsetE[i] = x*dst.cols*outNum + y*outNum + z;
+            rowE[i] = x;
+            colE[i] = y*outNum + z;
         }
-        // lookup table for mapping linear index to offsets
+        // lookup tables for mapping linear index to row and column offsets
 
         std::vector <int> offsetX( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
         std::vector <int> offsetY( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
@@ -554,82 +941,28 @@ protected:
                 offsetY[n] = x2*features.cols*nchannels + y2*nchannels + z;
             }
             // lookup tables for mapping linear index to offset pairs
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
-        {
-            float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
-            float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
 
-            int *indexPtr = indexes.ptr<int>(i);
-
-            for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                // for j,k in [0;width)x[0;nTreesEval)
-            {
-                int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
-                int currentNode = baseNode;
-                // select root node of the tree to evaluate
-
-                int offset = (j*stride/shrink)*nchannels;
-                while ( __rf.childs[currentNode] != 0 )
-                {
-                    int currentId = __rf.featureIds[currentNode];
-                    float currentFeature;
-
-                    if (currentId >= nFeatures)
-                    {
-                        int xIndex = offsetX[currentId - nFeatures];
-                        float A = ssFeaturesPtr[offset + xIndex];
-
-                        int yIndex = offsetY[currentId - nFeatures];
-                        float B = ssFeaturesPtr[offset + yIndex];
-
-                        currentFeature = A - B;
-                    }
-                    else
-                        currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
-
-                    // compare feature to threshold and move left or right accordingly
-                    if (currentFeature < __rf.thresholds[currentNode])
-                        currentNode = baseNode + __rf.childs[currentNode] - 1;
-                    else
-                        currentNode = baseNode + __rf.childs[currentNode];
-                }
-
-                indexPtr[j*nTreesEval + k] = currentNode;
-            }
-        }
+        parallel_for_( Range(0, height), ForestEvaluationInvoker(*this, regFeatures, ssFeatures,
+            indexes, offsetI, offsetX, offsetY, nchannels, width) );
 
         NChannelsMat dstM(dst.size(),
             CV_MAKETYPE(DataType<float>::type, outNum));
         dstM.setTo(0);
 
-        float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
-        #ifdef _OPENMP
-        #pragma omp parallel for
-        #endif
-        for (int i = 0; i < height; ++i)
-        {
-            int *pIndex = indexes.ptr<int>(i);
-            float *pDst = dstM.ptr<float>(i*stride);
-
-                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                {// for j,k in [0;width)x[0;nTreesEval)
-
-                    int currentNode = pIndex[j*nTreesEval + k];
+        const int tileRows = 32;
+        const int nTiles = (height + tileRows - 1)/tileRows;
 
-                    int start  = __rf.edgeBoundaries[currentNode];
-                    int finish = __rf.edgeBoundaries[currentNode + 1];
+        std::vector <NChannelsMat> spills(nTiles);
+        parallel_for_( Range(0, nTiles), EdgeAccumulationInvoker(*this, indexes, dstM,
+            spills, rowE, colE, tileRows, height, width) );
 
-                    if (start == finish)
-                        continue;
-
-                    int offset = j*stride*outNum;
-                    for (int p = start; p < finish; ++p)
-                        pDst[offset + offsetE[__rf.edgeBins[p]]] += step;
-                }
-        }
+        for (int t = 0; t < nTiles; ++t)
+            if (!spills[t].empty())
+            {
+                int ownEnd = std::min((t + 1)*tileRows, height)*stride;
+                NChannelsMat spilled = dstM.rowRange(ownEnd, ownEnd + spills[t].rows);
+                spilled += spills[t];
+            }
 
         cv::reduce( dstM.reshape(1, int( dstM.total() ) ), dstM, 2, CV_REDUCE_SUM);
         imsmooth( dstM.reshape(1, dst.rows), 1 ).copyTo(dst);
@@ -149,59 +149,13 @@ void from32STo32F(Mat &img, Mat &outImg, float *mapping)
 }
 
 
-/***************************************************************
- * Function: float2D
- * Description: allocate a 2D float array with dimension "dim1 x dim2"
- ***************************************************************/
-float** float2D(int dim1, int dim2)
-{
-    float **ret = new float*[dim1];
-    ret[0] = new float[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: float2D_release
- * Description: deallocate the 2D array created by float2D()
- ***************************************************************/
-void float2D_release(float **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
 /***************************************************************
  * Function: updateBCB
  * Description: maintain the necklace table of BCB
  ***************************************************************/
 inline void updateBCB(int &num,int *f,int *b,int i,int v)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -231,7 +185,7 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
  *                If F is 3-channel, perform k-means clustering
  *                If F is 1-channel, only perform type-casting
  ***************************************************************/
-void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType weightType){
+void featureIndexing(Mat &F, Mat &wMap, int &nF, float sigmaI, WMFWeightType weightType){
     // Configuration and Declaration
     Mat FNew;
     int cols = F.cols, rows = F.rows;
@@ -247,7 +201,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
         F.convertTo(FNew, CV_32S);
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -269,7 +223,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
                     default: val = exp(-(diff*diff)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
     }
@@ -279,9 +233,9 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
     {
         const int shift = 2; // 256(8-bit)->64(6-bit)
         const int LOW_NUM = 256>>shift;
-        static int hash[LOW_NUM][LOW_NUM][LOW_NUM]={{{0}}};
-
-        memset(hash,0,sizeof(hash));
+        // Local table, so that concurrent calls do not share it
+        std::vector<int> hashTable(LOW_NUM*LOW_NUM*LOW_NUM, 0);
+        int (*hash)[LOW_NUM][LOW_NUM] = (int (*)[LOW_NUM][LOW_NUM])&hashTable[0];
 
         // throw pixels into a 2D histogram
         int candCnt = 0;
@@ -347,7 +301,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
         }
 
         // Compute weight map (weight between each pair of feature index)
-        wMap = float2D(nF,nF);
+        wMap.create(nF,nF,CV_32F);
         float nSigmaI = sigmaI/256.0f*LOW_NUM;
         float divider = (1.0f/(2*nSigmaI*nSigmaI));
 
@@ -384,7 +338,7 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
                     default: val = exp(-(diff0*diff0+diff1*diff1+diff2*diff2)*divider);
                 }
 
-                wMap[i][j] = wMap[j][i] = val;
+                wMap.at<float>(i,j) = wMap.at<float>(j,i) = val;
             }
         }
 
@@ -394,178 +348,215 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, WMFWeightType
     F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+/***************************************************************
+ * Struct: WMFWorkspace
+ * Description: joint-histogram, BCB and their necklace tables used by filterCore.
+ *                Each thread keeps its workspace across calls. The joint-histogram
+ *                is stored in one block, its rows padded to 16 integers, and is left
+ *                empty after each column so that it never has to be cleared.
+ ***************************************************************/
+struct WMFWorkspace
 {
-    // Check validation
-    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
-    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
-
-    // Configuration and declaration
-    int rows = I.rows, cols = I.cols;
-    Mat outImg = I.clone();
-
-    // Handle Mask
-    if(mask.empty())
+    Mat H;  // joint-histogram
+    Mat Hf; // forward link
+    Mat Hb; // backward link
+    std::vector<int> BCB;
+    std::vector<int> BCBf; // forward link
+    std::vector<int> BCBb; // backward link
+
+    void create(int nI, int nF)
     {
-        mask = Mat(I.size(),CV_8U);
-        mask = Scalar(1);
+        int step = (int)alignSize(nF, 16);
+        if(H.rows != nI || H.cols != step)
+        {
+            H = Mat::zeros(nI, step, CV_32S);
+            Hf.create(nI, step, CV_32S);
+            Hb.create(nI, step, CV_32S);
+        }
+        BCB.resize(nF);
+        BCBf.resize(nF);
+        BCBb.resize(nF);
     }
+};
 
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+TLSData<WMFWorkspace>& getWMFWorkspace()
+{
+    static TLSData<WMFWorkspace>* volatile instance = NULL;
+    if(instance == NULL)
+    {
+        AutoLock lock(getInitializationMutex());
+        if(instance == NULL)
+            instance = new TLSData<WMFWorkspace>();
+    }
+    return *instance;
+}
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+/***************************************************************
+ * Class: FilterCoreInvoker
+ * Description: filters a band of columns. The columns are independent, each one
+ *                rebuilds the joint-histogram and BCB of its first window.
+ ***************************************************************/
+class FilterCoreInvoker : public ParallelLoopBody
+{
+public:
+    FilterCoreInvoker(const Mat &I_, const Mat &F_, const Mat &wMap_, int r_, int nF_, int nI_, const Mat &mask_, Mat &outImg_)
+        : I(I_), F(F_), wMap(wMap_), r(r_), nF(nF_), nI(nI_), mask(mask_), outImg(outImg_) {}
 
-    // Column Scanning
-    for(int x=0;x<cols;x++)
+    void operator()(const Range &range) const
     {
-        // Reset histogram and BCB for each column
-        memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
-        BCBf[0]=BCBb[0]=0;
-
-        // Reset cut-point
-        int medianVal = -1;
-
-        // Precompute "x" range and checks boundary
-        int downX = max(0,x-r);
-        int upX = min(cols-1,x+r);
-
-        // Initialize joint-histogram and BCB for the first window
-        int upY = min(rows-1,r);
-        for(int i=0;i<=upY;i++)
-        {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+        int rows = I.rows, cols = I.cols;
 
-            for(int j=downX;j<=upX;j++)
-            {
-                if(!maskPtr[j])continue;
+        WMFWorkspace &ws = *getWMFWorkspace().get();
+        ws.create(nI, nF);
 
-                int fval = IPtr[j];
-                int *curHist = H[fval];
-                int gval = FPtr[j];
+        int *BCB = &ws.BCB[0];
+        int *BCBf = &ws.BCBf[0];
+        int *BCBb = &ws.BCBb[0];
 
-                // Maintain necklace table of joint-histogram
-                if(!curHist[gval] && gval)
-                {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
-
-                    int p1=0,p2=curHf[0];
-                    curHf[p1]=gval;
-                    curHf[gval]=p2;
-                    curHb[p2]=gval;
-                    curHb[gval]=p1;
-                }
+        // Column Scanning
+        for(int x=range.start;x<range.end;x++)
+        {
+            // Reset BCB for each column, the joint-histogram is already empty
+            memset(BCB, 0, sizeof(int)*nF);
+            for(int i=0;i<nI;i++)ws.Hf.ptr<int>(i)[0]=ws.Hb.ptr<int>(i)[0]=0;
+            BCBf[0]=BCBb[0]=0;
 
-                curHist[gval]++;
-                // Maintain necklace table of BCB
-                updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
-            }
-        }
+            // Reset cut-point
+            int medianVal = -1;
 
-        for(int y=0;y<rows;y++)
-        {
-            // Find weighted median with help of BCB and joint-histogram
-            float balanceWeight = 0;
-            int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
-            int &curMedianVal = medianVal;
+            // Precompute "x" range and checks boundary
+            int downX = max(0,x-r);
+            int upX = min(cols-1,x+r);
 
-            // Compute current balance
+            // Initialize joint-histogram and BCB for the first window
+            int upY = min(rows-1,r);
+            for(int i=0;i<=upY;i++)
             {
-                int i=0;
-                do
+                const int *IPtr = I.ptr<int>(i);
+                const int *FPtr = F.ptr<int>(i);
+                const uchar *maskPtr = mask.ptr<uchar>(i);
+
+                for(int j=downX;j<=upX;j++)
                 {
-                    balanceWeight += BCB[i]*fPtr[i];
-                    i=BCBf[i];
-                }while(i);
+                    if(!maskPtr[j])continue;
+
+                    int fval = IPtr[j];
+                    int *curHist = ws.H.ptr<int>(fval);
+                    int gval = FPtr[j];
+
+                    // Maintain necklace table of joint-histogram
+                    if(!curHist[gval] && gval)
+                    {
+                        int *curHf = ws.Hf.ptr<int>(fval);
+                        int *curHb = ws.Hb.ptr<int>(fval);
+
+                        int p1=0,p2=curHf[0];
+                        curHf[p1]=gval;
+                        curHf[gval]=p2;
+                        curHb[p2]=gval;
+                        curHb[gval]=p1;
+                    }
+
+                    curHist[gval]++;
+                    // Maintain necklace table of BCB
+                    updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
+                }
             }
 
-            // Move cut-point to the left
-            if(balanceWeight >= 0)
+            for(int y=0;y<rows;y++)
             {
-                for(;balanceWeight >= 0 && curMedianVal; curMedianVal--)
-                {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                // Find weighted median with help of BCB and joint-histogram
+                float balanceWeight = 0;
+                int curIndex = F.ptr<int>(y,x)[0];
+                const float *fPtr = wMap.ptr<float>(curIndex);
+                int &curMedianVal = medianVal;
 
-                    // Compute weight change by shift cut-point
+                // Compute current balance
+                {
                     int i=0;
                     do
                     {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
+                        balanceWeight += BCB[i]*fPtr[i];
+                        i=BCBf[i];
+                    }while(i);
+                }
+
+                // Move cut-point to the left
+                if(balanceWeight >= 0)
+                {
+                    for(;balanceWeight >= 0 && curMedianVal; curMedianVal--)
+                    {
+                        float curWeight = 0;
+                        const int *nextHist = ws.H.ptr<int>(curMedianVal);
+                        const int *nextHf = ws.Hf.ptr<int>(curMedianVal);
+
+                        // Compute weight change by shift cut-point
+                        int i=0;
+                        do
+                        {
+                            curWeight += (nextHist[i]<<1)*fPtr[i];
 
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
+                            // Update BCB and maintain the necklace table of BCB
+                            updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
 
-                        i=nextHf[i];
-                    }while(i);
+                            i=nextHf[i];
+                        }while(i);
 
-                    balanceWeight -= curWeight;
+                        balanceWeight -= curWeight;
+                    }
                 }
-            }
-            // Move cut-point to the right
-            else if(balanceWeight < 0)
-            {
-                for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
+                // Move cut-point to the right
+                else if(balanceWeight < 0)
                 {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
-
-                    // Compute weight change by shift cut-point
-                    int i=0;
-                    do
+                    for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
                     {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
+                        float curWeight = 0;
+                        const int *nextHist = ws.H.ptr<int>(curMedianVal+1);
+                        const int *nextHf = ws.Hf.ptr<int>(curMedianVal+1);
 
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
+                        // Compute weight change by shift cut-point
+                        int i=0;
+                        do
+                        {
+                            curWeight += (nextHist[i]<<1)*fPtr[i];
 
-                        i=nextHf[i];
-                    }while(i);
-                    balanceWeight += curWeight;
+                            // Update BCB and maintain the necklace table of BCB
+                            updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
+
+                            i=nextHf[i];
+                        }while(i);
+                        balanceWeight += curWeight;
+                    }
                 }
-            }
 
-            // Weighted median is found and written to the output image
-            if(balanceWeight<0)outImg.ptr<int>(y,x)[0] = curMedianVal+1;
-            else outImg.ptr<int>(y,x)[0] = curMedianVal;
+                // Weighted median is found and written to the output image
+                if(balanceWeight<0)outImg.ptr<int>(y,x)[0] = curMedianVal+1;
+                else outImg.ptr<int>(y,x)[0] = curMedianVal;
 
-            // Update joint-histogram and BCB when local window is shifted.
-            int fval,gval,*curHist;
+                // Update joint-histogram and BCB when local window is shifted.
+                int fval,gval,*curHist;
 
-            // Add entering pixels into joint-histogram and BCB
-            int rownum = y + r + 1;
-            if(rownum < rows)
-            {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                // Add entering pixels into joint-histogram and BCB
+                int rownum = y + r + 1;
+                if(rownum < rows)
+                {
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
                         if(!maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = ws.H.ptr<int>(fval);
                         gval = guideImgPtr[j];
 
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = ws.Hf.ptr<int>(fval);
+                            int *curHb = ws.Hb.ptr<int>(fval);
 
                             int p1=0,p2=curHf[0];
                             curHf[gval]=p2;
@@ -580,21 +571,20 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                     }
                 }
 
-
                 // Delete leaving pixels into joint-histogram and BCB
                 rownum = y - r;
                 if(rownum >= 0)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
+                    const int *inputImgPtr = I.ptr<int>(rownum);
+                    const int *guideImgPtr = F.ptr<int>(rownum);
+                    const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
                     for(int j=downX;j<=upX;j++)
                     {
                         if(!maskPtr[j])continue;
 
                         fval = inputImgPtr[j];
-                        curHist = H[fval];
+                        curHist = ws.H.ptr<int>(fval);
                         gval = guideImgPtr[j];
 
                         curHist[gval]--;
@@ -602,8 +592,8 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         // Maintain necklace table of joint-histogram
                         if(!curHist[gval] && gval)
                         {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
+                            int *curHf = ws.Hf.ptr<int>(fval);
+                            int *curHb = ws.Hb.ptr<int>(fval);
 
                             int p1=curHb[gval],p2=curHf[gval];
                             curHf[p1]=p2;
@@ -614,19 +604,49 @@ Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, M
                         updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
                     }
                 }
+            }
+
+            // Empty the joint-histogram for the next column: only the pixels of the last window are left
+            for(int i=max(0,rows-r);i<rows;i++)
+            {
+                const int *inputImgPtr = I.ptr<int>(i);
+                const int *guideImgPtr = F.ptr<int>(i);
+                const uchar *maskPtr = mask.ptr<uchar>(i);
+
+                for(int j=downX;j<=upX;j++)
+                {
+                    if(maskPtr[j])ws.H.ptr<int>(inputImgPtr[j])[guideImgPtr[j]] = 0;
+                }
+            }
         }
     }
 
-    // Deallocate the memory
+private:
+    const Mat &I, &F, &wMap;
+    int r, nF, nI;
+    const Mat &mask;
+    Mat &outImg;
+};
+
+Mat filterCore(Mat &I, Mat &F, const Mat &wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+{
+    // Check validation
+    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
+    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
+
+    // Configuration and declaration
+    Mat outImg = I.clone();
+
+    // Handle Mask
+    if(mask.empty())
     {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
+        mask = Mat(I.size(),CV_8U);
+        mask = Scalar(1);
     }
 
+    // Column bands are filtered in parallel, each thread with its own joint-histogram and BCB
+    parallel_for_(Range(0, I.cols), FilterCoreInvoker(I, F, wMap, r, nF, nI, mask, outImg));
+
     // end of the function
     return outImg;
 }
@@ -690,8 +710,8 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
     //The output "F" is CV_32S type, containing indexes of feature values.
     //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
-    // wMap[i][j] is the weight between feature index "i" and "j".
-    float **wMap = NULL;
+    // wMap(i,j) is the weight between feature index "i" and "j".
+    Mat wMap;
     featureIndexing(F, wMap, nF, float(sigma), weightType);
 
     //Filtering - Joint-Histogram Framework
@@ -699,7 +719,6 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     {
         Is[i] = filterCore(Is[i], F, wMap, r, nF,nI,mask);
     }
-    float2D_release(wMap);
 
     //Postprocess F
     //Convert input image back to the original type.
@@ -467,4 +467,38 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+TEST(FastHoughTransformBatchTest, sameAsSingle)
+{
+    RNG& rng = TS::ptr()->get_rng();
+    const int angleRanges[] = {ARO_315_135, ARO_315_45, ARO_45_135,
+                               ARO_0_45, ARO_CTR_HOR, ARO_CTR_VER};
+    const int ops[] = {FHT_ADD, FHT_MIN, FHT_MAX, FHT_AVE};
+
+    for (int iTest = 0; iTest < 8; ++iTest)
+    {
+        int const angleRange = angleRanges[iTest % 6];
+        int const op = ops[iTest % 4];
+        int const depth = iTest % 2 ? CV_32S : CV_32F;
+
+        vector<Mat> srcs(5);
+        for (size_t i = 0; i < srcs.size(); ++i)
+        {
+            srcs[i].create(rng.uniform(2, 80), rng.uniform(2, 80), CV_8UC1);
+            rng.fill(srcs[i], RNG::UNIFORM, 0, 256);
+        }
+
+        vector<Mat> dsts;
+        FastHoughTransformBatch(srcs, dsts, depth, angleRange, op);
+        ASSERT_EQ(srcs.size(), dsts.size());
+        for (size_t i = 0; i < srcs.size(); ++i)
+        {
+            Mat fht;
+            FastHoughTransform(srcs[i], fht, depth, angleRange, op);
+            ASSERT_EQ(fht.size(), dsts[i].size());
+            ASSERT_EQ(fht.type(), dsts[i].type());
+            EXPECT_EQ(0, cvtest::norm(fht, dsts[i], NORM_INF));
+        }
+    }
+}
+
 } // namespace cvtest
@@ -0,0 +1,96 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+// blocks of random colors with a little noise
+static Mat makeSegmentationImage()
+{
+    RNG rng(0x2468);
+    Mat img(250, 320, CV_8UC3);
+    for (int y = 0; y < img.rows; y += 45)
+        for (int x = 0; x < img.cols; x += 55)
+        {
+            Rect block(x, y, std::min(55, img.cols - x), std::min(45, img.rows - y));
+            img(block).setTo(Scalar(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256)));
+        }
+
+    Mat noise(img.size(), CV_8UC3);
+    rng.fill(noise, RNG::UNIFORM, 0, 8);
+    img += noise;
+    return img;
+}
+
+static int countLabels(const Mat& labels)
+{
+    double maxLabel;
+    minMaxLoc(labels, 0, &maxLabel);
+    return (int)maxLabel + 1;
+}
+
+// fraction of the pixels of each region of a that fall in its best matching region of b
+static double overlap(const Mat& a, const Mat& b)
+{
+    int nb_a = countLabels(a), nb_b = countLabels(b);
+    Mat counts = Mat::zeros(nb_a, nb_b, CV_32S);
+    for (int y = 0; y < a.rows; y++)
+        for (int x = 0; x < a.cols; x++)
+            counts.at<int>(a.at<int>(y, x), b.at<int>(y, x))++;
+
+    double matched = 0;
+    for (int i = 0; i < nb_a; i++)
+    {
+        double best;
+        minMaxLoc(counts.row(i), 0, &best);
+        matched += best;
+    }
+    return matched / a.total();
+}
+
+TEST(ximgproc_GraphSegmentation, bands_match_whole_image)
+{
+    const int min_size = 100;
+    Mat img = makeSegmentationImage();
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.5, 300, min_size);
+    EXPECT_EQ(0, gs->getTileRows());
+
+    Mat whole;
+    gs->processImage(img, whole);
+    int nb_whole = countLabels(whole);
+
+    // a single band is the whole image
+    gs->setTileRows(img.rows);
+    Mat single;
+    gs->processImage(img, single);
+    EXPECT_EQ(0, cvtest::norm(whole, single, NORM_INF));
+
+    // bands whose seams cut the blocks
+    gs->setTileRows(32);
+    EXPECT_EQ(32, gs->getTileRows());
+    Mat banded;
+    gs->processImage(img, banded);
+    ASSERT_EQ(CV_32SC1, banded.type());
+    ASSERT_EQ(img.size(), banded.size());
+
+    // the labels are sequential and every region keeps the minimum size
+    int nb_banded = countLabels(banded);
+    std::vector<int> sizes(nb_banded, 0);
+    for (int y = 0; y < banded.rows; y++)
+        for (int x = 0; x < banded.cols; x++)
+        {
+            int label = banded.at<int>(y, x);
+            ASSERT_GE(label, 0);
+            sizes[label]++;
+        }
+    for (int i = 0; i < nb_banded; i++)
+        EXPECT_GE(sizes[i], min_size) << "region " << i;
+
+    EXPECT_LE(std::abs(nb_banded - nb_whole), nb_whole / 10 + 1);
+    EXPECT_GE(overlap(banded, whole), 0.95);
+    EXPECT_GE(overlap(whole, banded), 0.95);
+}
+
+}
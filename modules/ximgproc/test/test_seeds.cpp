@@ -0,0 +1,162 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc;
+
+// blocky image with a little texture, the same for every run
+static Mat makeSeedsImage(Size size, int shift = 0)
+{
+    Mat img(size, CV_8UC3);
+    for (int y = 0; y < size.height; ++y)
+    {
+        for (int x = 0; x < size.width; ++x)
+        {
+            int xs = x + shift;
+            int r = (xs / 9 + 2 * (y / 7)) % 4;
+            Vec3b& p = img.at<Vec3b>(y, x);
+            p[0] = (uchar)(r * 60 + (xs * 7 + y * 13) % 23);
+            p[1] = (uchar)(255 - r * 50 - (xs * 5 + y * 3) % 19);
+            p[2] = (uchar)((r * 90 + (xs + y * 11) % 29) % 256);
+        }
+    }
+    return img;
+}
+
+static Mat computeSeedsLabels(const Mat& img, int num_superpixels, int num_levels, bool double_step)
+{
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(),
+            num_superpixels, num_levels, 2, 5, double_step);
+    seeds->iterate(img, 4);
+    Mat labels;
+    seeds->getLabels(labels);
+    return labels.clone();
+}
+
+TEST(ximgproc_SuperpixelSEEDS, same_labels_for_any_number_of_threads)
+{
+    Mat img = makeSeedsImage(Size(320, 240));
+    int nthreads = getNumThreads();
+
+    for (int double_step = 0; double_step < 2; ++double_step)
+    {
+        setNumThreads(1);
+        Mat serial = computeSeedsLabels(img, 200, 4, double_step != 0);
+        setNumThreads(std::max(nthreads, 4));
+        Mat parallel = computeSeedsLabels(img, 200, 4, double_step != 0);
+        setNumThreads(nthreads);
+
+        EXPECT_EQ(0, cvtest::norm(serial, parallel, NORM_INF));
+    }
+}
+
+// labels of the serial implementation: with a single tile of top level
+// blocks, the updates run in the original order
+static const char* single_tile_labels[] =
+{
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222333333333333",
+    "000000000111111111555555555222222222777777777333",
+    "000000044111111111555555555222222222777777777333",
+    "000000444111111111555555555222222222777777777333",
+    "000000444111111111555555555222222222777777777333",
+    "444444444111111111555555555222222222777777777333",
+    "444444444111111111555555555222222222777777777333",
+    "444444444111111111555555555222222222777777777333",
+    "444444444111111111555555555666666666777777777733",
+    "444444444111111111555555555666666666777777777777",
+    "444444444111111111555555555666666666777777777777",
+    "444444444111111111555555555666666666777777777777",
+    "444444444111111111555555555666666666777777777777",
+    "4444444441111111115555555556666666667777777777bb",
+    "444444444111111111555555555666666666777777777bbb",
+    "444444444111111111555555555aaaaaaaaabbbbbbbbbbbb",
+    "444444444111111111555555555aaaaaaaaabbbbbbbbbbbb",
+    "444888884111111111555555555aaaaaaaaabbbbbbbbbbbb",
+    "888888888111111111555555555aaaaaaaaabbbbbbbbbbbb",
+    "888888888555555555555555555aaaaaaaaabbbbbbbbbbbb",
+    "888888888555555555555555555aaaaaaaaabbbbbbbbbbbb",
+    "888888888555555555555555555aaaaaaaaabbbbbbbbbbbb",
+    "888888888999999999555555555eeeeeeeeefffffffffbbb",
+    "888888888999999999555555555eeeeeeeeefffffffffbbb",
+    "888888888999999999555555555eeeeeeeeefffffffffbbb",
+    "888888888999999999555555555eeeeeeeeefffffffffbbb",
+    "888888888999999999555555555eeeeeeeeefffffffffbbb",
+    "888888888999999999955555555eeeeeeeeefffffffffbbb",
+    "888888888999999999955555555eeeeeeeeefffffffffbbb",
+    "888888888ddddddddd99999999999999999efffffffbbbbb",
+    "888888888ddddddddd99999999999999999efffffffbbbbb",
+    "888888888ddddddddd99999999999999999efffffffbbbbb",
+    "888888888ddddddddd99999999999999999effffffffbbbb",
+    "888888888ddddddddd99999999999999999efffffffffbbb",
+    "888888888ddddddddd99999999999999999effffffffffff",
+    "888888888ddddddddd99999999999999999effffffffffff",
+    "cccccccccddddddddddddddddddeeeeeeeeeffffffffffff",
+    "cccccccccddddddddddddddddddeeeeeeeeeffffffffffff",
+    "cccccccccddddddddddddddddddeeeeeeeeeffffffffffff",
+    "cccccccccddddddddddddddddddeeeeeeeeeffffffffffff",
+    "cccccccccddddddddddddddddddeeeeeeeeeffffffffffff",
+    "cccccccccddddddddddddddddddeeeeeeeeeffffffffffff"
+};
+
+TEST(ximgproc_SuperpixelSEEDS, single_tile_matches_serial_order)
+{
+    Mat img = makeSeedsImage(Size(48, 48));
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, 3, 16, 3, 2, 5, false);
+    seeds->iterate(img, 4);
+    ASSERT_EQ(16, seeds->getNumberOfSuperpixels());
+
+    Mat labels;
+    seeds->getLabels(labels);
+    ASSERT_EQ(CV_32SC1, labels.type());
+
+    int mismatches = 0;
+    for (int y = 0; y < labels.rows; ++y)
+    {
+        for (int x = 0; x < labels.cols; ++x)
+        {
+            char c = single_tile_labels[y][x];
+            int expected = c <= '9' ? c - '0' : c - 'a' + 10;
+            mismatches += labels.at<int>(y, x) != expected;
+        }
+    }
+    EXPECT_EQ(0, mismatches);
+}
+
+TEST(ximgproc_SuperpixelSEEDS, temporal_mode_starts_from_previous_labels)
+{
+    Mat first = makeSeedsImage(Size(160, 120));
+    Mat second = makeSeedsImage(Size(160, 120), 3);
+
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(first.cols, first.rows, 3, 100, 4, 2, 5, false);
+    EXPECT_FALSE(seeds->getTemporalMode());
+    seeds->setTemporalMode(true);
+    EXPECT_TRUE(seeds->getTemporalMode());
+    int nr_superpixels = seeds->getNumberOfSuperpixels();
+
+    Mat previous, labels;
+    seeds->iterate(first, 4);
+    seeds->getLabels(previous);
+    previous = previous.clone();
+
+    // without pixel iterations, the labels of the previous image are kept
+    seeds->iterate(second, 0);
+    seeds->getLabels(labels);
+    EXPECT_EQ(0, cvtest::norm(previous, labels, NORM_INF));
+    EXPECT_EQ(nr_superpixels, seeds->getNumberOfSuperpixels());
+
+    // the cold start recomputes them from the initial grid
+    seeds->setTemporalMode(false);
+    seeds->iterate(second, 0);
+    seeds->getLabels(labels);
+    EXPECT_GT(cvtest::norm(previous, labels, NORM_L1), 0);
+}
+
+}
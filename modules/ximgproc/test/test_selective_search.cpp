@@ -0,0 +1,73 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::ximgproc::segmentation;
+
+static Mat makeSelectiveSearchImage()
+{
+    RNG rng(0x1357);
+    Mat img(120, 160, CV_8UC3, Scalar::all(128));
+    for (int i = 0; i < 12; i++)
+    {
+        Point center(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        Scalar color(rng.uniform(0, 256), rng.uniform(0, 256), rng.uniform(0, 256));
+        if (i % 2)
+            circle(img, center, rng.uniform(5, 30), color, -1);
+        else
+            rectangle(img, center, center + Point(rng.uniform(5, 50), rng.uniform(5, 50)), color, -1);
+    }
+
+    Mat noise(img.size(), CV_8UC3);
+    rng.fill(noise, RNG::UNIFORM, 0, 8);
+    img += noise;
+    return img;
+}
+
+static std::vector<Rect> selectiveSearch(const Mat& img, bool quality, int nthreads)
+{
+    int savedThreads = getNumThreads();
+    setNumThreads(nthreads);
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    if (quality)
+        ss->switchToSelectiveSearchQuality();
+    else
+        ss->switchToSelectiveSearchFast();
+
+    // the ranks of the regions are drawn with rand()
+    srand(1);
+    std::vector<Rect> rects;
+    ss->process(rects);
+
+    setNumThreads(savedThreads);
+    return rects;
+}
+
+static void expectSameRects(const std::vector<Rect>& expected, const std::vector<Rect>& rects)
+{
+    ASSERT_EQ(expected.size(), rects.size());
+    for (size_t i = 0; i < rects.size(); i++)
+        EXPECT_EQ(expected[i], rects[i]) << "rect " << i;
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, fast_does_not_depend_on_threads)
+{
+    Mat img = makeSelectiveSearchImage();
+    std::vector<Rect> expected = selectiveSearch(img, false, 1);
+    EXPECT_FALSE(expected.empty());
+    expectSameRects(expected, selectiveSearch(img, false, std::max(getNumThreads(), 4)));
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, quality_does_not_depend_on_threads)
+{
+    Mat img = makeSelectiveSearchImage();
+    std::vector<Rect> expected = selectiveSearch(img, true, 1);
+    EXPECT_FALSE(expected.empty());
+    expectSameRects(expected, selectiveSearch(img, true, std::max(getNumThreads(), 4)));
+}
+
+}
@@ -37,4 +37,57 @@ TEST(ximpgroc_StructuredEdgeDetection, regression)
     }
 }
 
-}
\ No newline at end of file
+TEST(ximpgroc_StructuredEdgeDetection, multiscale)
+{
+    cv::String dir = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/";
+    cv::Ptr<cv::ximgproc::StructuredEdgeDetection> pDollar =
+        cv::ximgproc::createStructuredEdgeDetection(dir + "model.yml.gz");
+
+    cv::Mat src = cv::imread( dir + "sources/01.png", 1 );
+    ASSERT_TRUE(!src.empty());
+    src.convertTo( src, cv::DataType<float>::type, 1/255.0 );
+
+    cv::Mat edges;
+    pDollar->detectEdges( src, edges );
+
+    // a single scale of 1 is detectEdges
+    std::vector<float> scales(1, 1.0f);
+    cv::Mat oneScale;
+    pDollar->detectEdgesMultiscale( src, oneScale, scales );
+    ASSERT_EQ( edges.size(), oneScale.size() );
+    ASSERT_EQ( edges.type(), oneScale.type() );
+    EXPECT_LE( cvtest::norm( edges, oneScale, cv::NORM_INF ), 1e-6 );
+
+    // several scales give the average of the edges at each scale
+    scales.clear();
+    scales.push_back( 0.5f );
+    scales.push_back( 2.0f );
+    cv::Mat multiScale;
+    pDollar->detectEdgesMultiscale( src, multiScale, scales );
+    ASSERT_EQ( src.size(), multiScale.size() );
+    ASSERT_EQ( cv::DataType<float>::type, multiScale.type() );
+
+    cv::Mat average = cv::Mat::zeros( src.size(), cv::DataType<float>::type );
+    double maxEdge = 0;
+    for (size_t i = 0; i < scales.size(); ++i)
+    {
+        cv::Mat scaleEdges;
+        pDollar->detectEdgesMultiscale( src, scaleEdges, std::vector<float>(1, scales[i]) );
+        ASSERT_EQ( src.size(), scaleEdges.size() );
+
+        double minVal, maxVal;
+        cv::minMaxLoc( scaleEdges, &minVal, &maxVal );
+        EXPECT_GE( minVal, 0 );
+        maxEdge = std::max( maxEdge, maxVal );
+
+        average += scaleEdges / double( scales.size() );
+    }
+    EXPECT_LE( cvtest::norm( average, multiScale, cv::NORM_INF ), 1e-5 );
+
+    double minVal, maxVal;
+    cv::minMaxLoc( multiScale, &minVal, &maxVal );
+    EXPECT_GE( minVal, 0 );
+    EXPECT_LE( maxVal, maxEdge + 1e-5 );
+}
+
+}
@@ -89,6 +89,23 @@ public:
         std::vector<Rect> &bboxes,
         std::vector<double> &confidences) = 0;
 
+    /** @brief Detect objects on image using WaldBoost detector at the given scales
+    @param img Input image for detection, 8-bit single-channel
+    @param scales Scales at which the image is scanned, at scale s the window of the detector
+    covers 24/s pixels of the image
+    @param step Distance in pixels between neighbouring windows of a scaled image
+    @param bboxes Bounding boxes coordinates output vector
+    @param confidences Confidence values for bounding boxes output vector
+
+    The scales and the rows of the scaled images are scanned in parallel.
+    */
+    virtual void detect(
+        const Mat& img,
+        const std::vector<float>& scales,
+        int step,
+        std::vector<Rect> &bboxes,
+        std::vector<double> &confidences) = 0;
+
     /** @brief Create instance of WBDetector
     */
     static Ptr<WBDetector> create();
@@ -128,6 +128,14 @@ public:
     virtual void setWindow(const cv::Point& p) = 0;
     virtual void writeFeatures( cv::FileStorage &fs, const cv::Mat& featureMap ) const = 0;
     virtual float operator()(int featureIdx) = 0;
+    // Appends the offsets used to evaluate a feature on an integral image with the given row step
+    // (in elements) to offsets
+    virtual void getFeatureOffsets(int featureIdx, int sumStep, std::vector<int>& offsets) const = 0;
+    // Evaluates a feature, given by its offsets, on the windows of a row of an integral image
+    // starting at the columns cols. Unlike setImage()/setWindow() this does not change the
+    // evaluator, so several threads can use it at the same time.
+    virtual void calcFeatures(const int* offsets, const int* rowSum,
+                              const int* cols, int n, float* values) const = 0;
     static cv::Ptr<CvFeatureEvaluator> create();
 
     int getNumFeatures() const { return numFeatures; }
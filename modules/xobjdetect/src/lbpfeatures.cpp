@@ -74,6 +74,20 @@ void CvLBPEvaluator::setImage(const Mat &img, uchar clsLabel, int idx,
     }
 }
 
+void CvLBPEvaluator::getFeatureOffsets(int featureIdx, int sumStep, std::vector<int>& offsets) const
+{
+    int points[16];
+    features[featureIdx].calcPoints(sumStep, points);
+    offsets.insert(offsets.end(), points, points + 16);
+}
+
+void CvLBPEvaluator::calcFeatures(const int* offsets, const int* rowSum,
+                                  const int* cols, int n, float* values) const
+{
+    for (int i = 0; i < n; ++i)
+        values[i] = (float)Feature::calc(rowSum + cols[i], offsets);
+}
+
 void CvLBPEvaluator::writeFeatures( FileStorage &fs, const Mat& featureMap ) const
 {
     _writeFeatures( features, fs, featureMap );
@@ -108,17 +122,24 @@ CvLBPEvaluator::Feature::Feature( int offset, int x, int y, int _blockWidth, int
 
 void CvLBPEvaluator::Feature::calcPoints(int offset)
 {
-    Rect tr = rect = cvRect(x_, y_, block_w_, block_h_);
-    CV_SUM_OFFSETS( p[0], p[1], p[4], p[5], tr, offset )
-    tr.x += 2*rect.width;
-    CV_SUM_OFFSETS( p[2], p[3], p[6], p[7], tr, offset )
-    tr.y +=2*rect.height;
-    CV_SUM_OFFSETS( p[10], p[11], p[14], p[15], tr, offset )
-    tr.x -= 2*rect.width;
-    CV_SUM_OFFSETS( p[8], p[9], p[12], p[13], tr, offset )
+    rect = cvRect(x_, y_, block_w_, block_h_);
+    calcPoints(offset, p);
     offset_ = offset;
 }
 
+void CvLBPEvaluator::Feature::calcPoints(int offset, int* points) const
+{
+    Rect block = cvRect(x_, y_, block_w_, block_h_);
+    Rect tr = block;
+    CV_SUM_OFFSETS( points[0], points[1], points[4], points[5], tr, offset )
+    tr.x += 2*block.width;
+    CV_SUM_OFFSETS( points[2], points[3], points[6], points[7], tr, offset )
+    tr.y +=2*block.height;
+    CV_SUM_OFFSETS( points[10], points[11], points[14], points[15], tr, offset )
+    tr.x -= 2*block.width;
+    CV_SUM_OFFSETS( points[8], points[9], points[12], points[13], tr, offset )
+}
+
 void CvLBPEvaluator::Feature::write(FileStorage &fs) const
 {
     fs << CC_RECT << "[:" << rect.x << rect.y << rect.width << rect.height << "]";
@@ -70,6 +70,9 @@ public:
     { cur_sum = sum.rowRange(p.y, p.y + winSize.height).colRange(p.x, p.x + winSize.width); }
     virtual float operator()(int featureIdx)
     { return (float)features[featureIdx].calc( cur_sum ); }
+    virtual void getFeatureOffsets(int featureIdx, int sumStep, std::vector<int>& offsets) const;
+    virtual void calcFeatures(const int* offsets, const int* rowSum,
+                              const int* cols, int n, float* values) const;
     virtual void writeFeatures( cv::FileStorage &fs, const cv::Mat& featureMap ) const;
 protected:
     virtual void generateFeatures();
@@ -80,6 +83,7 @@ protected:
         Feature();
         Feature( int offset, int x, int y, int _block_w, int _block_h  );
         uchar calc( const cv::Mat& _sum );
+        static uchar calc( const int* psum, const int* p );
         void write( cv::FileStorage &fs ) const;
 
         cv::Rect rect;
@@ -87,6 +91,7 @@ protected:
 
         int x_, y_, block_w_, block_h_, offset_;
         void calcPoints(int offset);
+        void calcPoints(int offset, int* points) const;
     };
     std::vector<Feature> features;
 
@@ -96,8 +101,11 @@ protected:
 
 inline uchar CvLBPEvaluator::Feature::calc(const cv::Mat &_sum)
 {
-    const int* psum = _sum.ptr<int>();
+    return calc(_sum.ptr<int>(), p);
+}
 
+inline uchar CvLBPEvaluator::Feature::calc(const int* psum, const int* p)
+{
     int cval = psum[p[5]] - psum[p[6]] - psum[p[9]] + psum[p[10]];
 
     return (uchar)((psum[p[0]] - psum[p[1]] - psum[p[4]] + psum[p[5]] >= cval ? 128 : 0) |   // 0
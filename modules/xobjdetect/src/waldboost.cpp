@@ -47,22 +47,6 @@ the use of this software, even if advised of the possibility of such damage.
 namespace cv {
 namespace xobjdetect {
 
-static void compute_cdf(const Mat1b& data,
-                        const Mat1f& weights,
-                        Mat1f& cdf)
-{
-    for (int i = 0; i < cdf.cols; ++i)
-        cdf(0, i) = 0;
-
-    for (int i = 0; i < weights.cols; ++i) {
-        cdf(0, data(0, i)) += weights(0, i);
-    }
-
-    for (int i = 1; i < cdf.cols; ++i) {
-        cdf(0, i) += cdf(0, i - 1);
-    }
-}
-
 static void compute_min_step(const Mat &data_pos, const Mat &data_neg, size_t n_bins,
                       Mat &data_min, Mat &data_step)
 {
@@ -118,68 +102,357 @@ std::vector<int> WaldBoost::get_feature_indices()
     return feature_indices_;
 }
 
-void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
-            const Mat& img, const std::vector<float>& scales,
-            std::vector<Rect>& bboxes, Mat1f& confidences)
+// Integral image of a scale of the image and offsets of the cascade features in it
+struct WaldBoostLevel
+{
+    float scale;
+    Size size;
+    Mat sum;
+    std::vector<int> offsets;
+    int offsets_step;
+};
+
+class WaldBoostLevelInvoker : public ParallelLoopBody
+{
+public:
+    WaldBoostLevelInvoker(const CvFeatureEvaluator& eval, const Mat& img,
+                          const std::vector<float>& scales,
+                          const std::vector<int>& feature_indices,
+                          std::vector<WaldBoostLevel>& levels) :
+        eval_(eval), img_(img), scales_(scales),
+        feature_indices_(feature_indices), levels_(levels) {}
+
+    void operator()(const Range& range) const
+    {
+        Mat resized_img;
+        for (int i = range.start; i < range.end; ++i) {
+            WaldBoostLevel& level = levels_[i];
+            level.scale = scales_[i];
+            resize(img_, resized_img, Size(), level.scale, level.scale);
+            integral(resized_img, level.sum, CV_32S);
+            level.size = resized_img.size();
+            int sum_step = (int)level.sum.step1();
+            level.offsets.clear();
+            for (size_t j = 0; j < feature_indices_.size(); ++j)
+                eval_.getFeatureOffsets(feature_indices_[j], sum_step, level.offsets);
+            level.offsets_step = (int)(level.offsets.size() / feature_indices_.size());
+        }
+    }
+
+private:
+    const CvFeatureEvaluator& eval_;
+    const Mat& img_;
+    const std::vector<float>& scales_;
+    const std::vector<int>& feature_indices_;
+    std::vector<WaldBoostLevel>& levels_;
+};
+
+class WaldBoostScanInvoker : public ParallelLoopBody
+{
+public:
+    WaldBoostScanInvoker(const WaldBoost& boost, const CvFeatureEvaluator& eval,
+                         const std::vector<WaldBoostLevel>& levels,
+                         const std::vector<Point>& rows, int step,
+                         std::vector<std::vector<int> >& cols,
+                         std::vector<std::vector<float> >& scores) :
+        boost_(boost), eval_(eval), levels_(levels), rows_(rows), step_(step),
+        cols_(cols), scores_(scores) {}
+
+    void operator()(const Range& range) const
+    {
+        std::vector<float> values;
+        for (int i = range.start; i < range.end; ++i) {
+            const WaldBoostLevel& level = levels_[rows_[i].x];
+            std::vector<int>& cols = cols_[i];
+            cols.clear();
+            for (int c = 0; c + 24 < level.size.width; c += step_)
+                cols.push_back(c);
+            boost_.scan_row(eval_, level.sum.ptr<int>(rows_[i].y),
+                            &level.offsets[0], level.offsets_step,
+                            cols, scores_[i], values);
+        }
+    }
+
+private:
+    const WaldBoost& boost_;
+    const CvFeatureEvaluator& eval_;
+    const std::vector<WaldBoostLevel>& levels_;
+    const std::vector<Point>& rows_;
+    int step_;
+    std::vector<std::vector<int> >& cols_;
+    std::vector<std::vector<float> >& scores_;
+};
+
+void WaldBoost::scan_row(const CvFeatureEvaluator& eval, const int* row_sum,
+                         const int* offsets, int offsets_step,
+                         std::vector<int>& cols, std::vector<float>& scores,
+                         std::vector<float>& values) const
+{
+    // Every weak classifier is evaluated on all the windows of the row still in the
+    // cascade, then the rejected windows are removed
+    int n = (int)cols.size();
+    scores.assign(n, 0.f);
+    values.resize(n);
+    for (int i = 0; i < weak_count_ && n > 0; ++i) {
+        eval.calcFeatures(offsets + i * offsets_step, row_sum, &cols[0], n, &values[0]);
+        const float threshold = thresholds_[i], alpha = alphas_[i];
+        const float cascade_threshold = cascade_thresholds_[i];
+        const int polarity = polarities_[i];
+        int alive = 0;
+        for (int j = 0; j < n; ++j) {
+            int label = polarity * (values[j] - threshold) > 0 ? +1: -1;
+            float res = scores[j] + alpha * label;
+            if (res < cascade_threshold)
+                continue;
+            cols[alive] = cols[j];
+            scores[alive] = res;
+            ++alive;
+        }
+        n = alive;
+    }
+
+    int accepted = 0;
+    for (int j = 0; j < n; ++j) {
+        if (scores[j] > cascade_thresholds_[weak_count_ - 1]) {
+            cols[accepted] = cols[j];
+            scores[accepted] = scores[j];
+            ++accepted;
+        }
+    }
+    cols.resize(accepted);
+    scores.resize(accepted);
+}
+
+void WaldBoost::scan(const CvFeatureEvaluator& eval,
+            const Mat& img, const std::vector<float>& scales, int step,
+            std::vector<Rect>& bboxes, std::vector<float>& confidences) const
 {
+    CV_Assert(img.type() == CV_8UC1 && step > 0);
+    CV_Assert(weak_count_ > 0 && feature_indices_.size() == size_t(weak_count_));
     bboxes.clear();
-    confidences.release();
-
-    Mat resized_img;
-    int step = 4;
-    float h;
-    for (size_t i = 0; i < scales.size(); ++i) {
-        float scale = scales[i];
-        resize(img, resized_img, Size(), scale, scale);
-        eval->setImage(resized_img, 0, 0, feature_indices_);
+    confidences.clear();
+
+    std::vector<WaldBoostLevel> levels(scales.size());
+    parallel_for_(Range(0, (int)levels.size()),
+                  WaldBoostLevelInvoker(eval, img, scales, feature_indices_, levels));
+
+    // The rows of all the scales are scanned together, so the small scales do not
+    // leave threads idle
+    std::vector<Point> rows;
+    for (size_t i = 0; i < levels.size(); ++i)
+        for (int r = 0; r + 24 < levels[i].size.height; r += step)
+            rows.push_back(Point((int)i, r));
+
+    std::vector<std::vector<int> > cols(rows.size());
+    std::vector<std::vector<float> > scores(rows.size());
+    parallel_for_(Range(0, (int)rows.size()),
+                  WaldBoostScanInvoker(*this, eval, levels, rows, step, cols, scores));
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        float scale = levels[rows[i].x].scale;
         int n_rows = (int)(24 / scale);
         int n_cols = (int)(24 / scale);
-        for (int r = 0; r + 24 < resized_img.rows; r += step) {
-            for (int c = 0; c + 24 < resized_img.cols; c += step) {
-                //eval->setImage(resized_img(Rect(c, r, 24, 24)), 0, 0);
-                eval->setWindow(Point(c, r));
-                if (predict(eval, &h) == +1) {
-                    int row = (int)(r / scale);
-                    int col = (int)(c / scale);
-                    bboxes.push_back(Rect(col, row, n_cols, n_rows));
-                    confidences.push_back(h);
-                }
-            }
+        int row = (int)(rows[i].y / scale);
+        for (size_t j = 0; j < cols[i].size(); ++j) {
+            int col = (int)(cols[i][j] / scale);
+            bboxes.push_back(Rect(col, row, n_cols, n_rows));
+            confidences.push_back(scores[i][j]);
         }
     }
+}
+
+void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
+            const Mat& img, const std::vector<float>& scales,
+            std::vector<Rect>& bboxes, Mat1f& confidences, int step) const
+{
+    std::vector<float> scores;
+    scan(*eval, img, scales, step, bboxes, scores);
+    confidences = Mat1f(scores, true);
     groupRectangles(bboxes, 3, 0.7);
 }
 
 void WaldBoost::detect(Ptr<CvFeatureEvaluator> eval,
             const Mat& img, const std::vector<float>& scales,
-            std::vector<Rect>& bboxes, std::vector<double>& confidences)
+            std::vector<Rect>& bboxes, std::vector<double>& confidences, int step) const
 {
-    bboxes.clear();
-    confidences.clear();
+    std::vector<float> scores;
+    scan(*eval, img, scales, step, bboxes, scores);
+    confidences.assign(scores.begin(), scores.end());
+    std::vector<int> levels(bboxes.size(), 0);
+    groupRectangles(bboxes, levels, confidences, 3, 0.7);
+}
 
-    Mat resized_img;
-    int step = 4;
-    float h;
-    for (size_t i = 0; i < scales.size(); ++i) {
-        float scale = scales[i];
-        resize(img, resized_img, Size(), scale, scale);
-        eval->setImage(resized_img, 0, 0, feature_indices_);
-        int n_rows = (int)(24 / scale);
-        int n_cols = (int)(24 / scale);
-        for (int r = 0; r + 24 < resized_img.rows; r += step) {
-            for (int c = 0; c + 24 < resized_img.cols; c += step) {
-                eval->setWindow(Point(c, r));
-                if (predict(eval, &h) == +1) {
-                    int row = (int)(r / scale);
-                    int col = (int)(c / scale);
-                    bboxes.push_back(Rect(col, row, n_cols, n_rows));
-                    confidences.push_back(h);
+WaldBoostSamples::WaldBoostSamples(size_t max_memory):
+    max_memory_(max_memory),
+    memory_(0),
+    samples_(0),
+    features_(0) {}
+
+WaldBoostSamples::~WaldBoostSamples()
+{
+    for (size_t i = 0; i < files_.size(); ++i)
+        if (!files_[i].empty())
+            std::remove(files_[i].c_str());
+}
+
+void WaldBoostSamples::add(const Mat& block)
+{
+    CV_Assert(block.type() == CV_8U && block.isContinuous());
+    CV_Assert(features_ == 0 || block.rows == features_);
+    features_ = block.rows;
+    size_t block_memory = block.total();
+    if (memory_ + block_memory <= max_memory_) {
+        blocks_.push_back(block);
+        files_.push_back(std::string());
+        memory_ += block_memory;
+    } else {
+        std::string filename = tempfile(".wbs");
+        std::ofstream file(filename.c_str(), std::ios::binary);
+        file.write((const char*)block.data, block_memory);
+        if (!file)
+            CV_Error(Error::StsError, "Can't write WaldBoost samples to " + filename);
+        blocks_.push_back(Mat());
+        files_.push_back(filename);
+    }
+    sizes_.push_back(block.cols);
+    samples_ += block.cols;
+}
+
+void WaldBoostSamples::get(int i, Mat& block) const
+{
+    if (files_[i].empty()) {
+        block = blocks_[i];
+        return;
+    }
+    block.create(features_, sizes_[i], CV_8U);
+    std::ifstream file(files_[i].c_str(), std::ios::binary);
+    file.read((char*)block.data, block.total());
+    if (!file)
+        CV_Error(Error::StsError, "Can't read WaldBoost samples from " + files_[i]);
+}
+
+void WaldBoostSamples::get_row(int i, int row, Mat& values) const
+{
+    if (files_[i].empty()) {
+        values = blocks_[i].row(row);
+        return;
+    }
+    values.create(1, sizes_[i], CV_8U);
+    std::ifstream file(files_[i].c_str(), std::ios::binary);
+    file.seekg((std::streamoff)row * sizes_[i]);
+    file.read((char*)values.data, sizes_[i]);
+    if (!file)
+        CV_Error(Error::StsError, "Can't read WaldBoost samples from " + files_[i]);
+}
+
+// Accumulates the weights of the samples of a block in the histograms of their feature values
+class WaldBoostHistogramInvoker : public ParallelLoopBody
+{
+public:
+    WaldBoostHistogramInvoker(const Mat& block, const float* weights,
+                              int n_bins, float* histograms) :
+        block_(block), weights_(weights), n_bins_(n_bins), histograms_(histograms) {}
+
+    void operator()(const Range& range) const
+    {
+        for (int feat_i = range.start; feat_i < range.end; ++feat_i) {
+            const uchar* values = block_.ptr<uchar>(feat_i);
+            float* hist = histograms_ + (size_t)feat_i * n_bins_;
+            for (int j = 0; j < block_.cols; ++j)
+                hist[values[j]] += weights_[j];
+        }
+    }
+
+private:
+    const Mat& block_;
+    const float* weights_;
+    int n_bins_;
+    float* histograms_;
+};
+
+struct WaldBoostSplit
+{
+    double err;
+    int polarity;
+    int threshold_q;
+};
+
+// Finds the best threshold of every feature from the histograms of its values
+class WaldBoostSplitInvoker : public ParallelLoopBody
+{
+public:
+    WaldBoostSplitInvoker(const std::vector<float>& pos_hist, const std::vector<float>& neg_hist,
+                          float neg_total, int n_bins, const std::vector<bool>& feature_ignore,
+                          std::vector<WaldBoostSplit>& splits) :
+        pos_hist_(pos_hist), neg_hist_(neg_hist), neg_total_(neg_total), n_bins_(n_bins),
+        feature_ignore_(feature_ignore), splits_(splits) {}
+
+    void operator()(const Range& range) const
+    {
+        std::vector<float> pos_cdf(n_bins_), neg_cdf(n_bins_);
+        for (int feat_i = range.start; feat_i < range.end; ++feat_i) {
+            if (feature_ignore_[feat_i])
+                continue;
+
+            const float* pos_hist = &pos_hist_[(size_t)feat_i * n_bins_];
+            const float* neg_hist = &neg_hist_[(size_t)feat_i * n_bins_];
+            pos_cdf[0] = pos_hist[0];
+            neg_cdf[0] = neg_hist[0];
+            for (int i = 1; i < n_bins_; ++i) {
+                pos_cdf[i] = pos_hist[i] + pos_cdf[i - 1];
+                neg_cdf[i] = neg_hist[i] + neg_cdf[i - 1];
+            }
+
+            float err1 = FLT_MAX, err2 = FLT_MAX;
+            int idx1 = 0, idx2 = 0;
+            for (int i = 0; i < n_bins_; ++i) {
+                float err_direct = pos_cdf[i] + neg_total_ - neg_cdf[i];
+                float err_backward = 1.0f - err_direct;
+                if (err_direct < err1) {
+                    err1 = err_direct;
+                    idx1 = i;
                 }
+                if (err_backward < err2) {
+                    err2 = err_backward;
+                    idx2 = i;
+                }
+            }
+
+            WaldBoostSplit& split = splits_[feat_i];
+            if (err1 < err2) {
+                split.err = err1;
+                split.polarity = +1;
+                split.threshold_q = idx1;
+            } else {
+                split.err = err2;
+                split.polarity = -1;
+                split.threshold_q = idx2;
             }
         }
     }
-    std::vector<int> levels(bboxes.size(), 0);
-    groupRectangles(bboxes, levels, confidences, 3, 0.7);
+
+private:
+    const std::vector<float>& pos_hist_;
+    const std::vector<float>& neg_hist_;
+    float neg_total_;
+    int n_bins_;
+    const std::vector<bool>& feature_ignore_;
+    std::vector<WaldBoostSplit>& splits_;
+};
+
+static void compute_histograms(const WaldBoostSamples& samples,
+                               const std::vector<float>& weights,
+                               int n_bins, std::vector<float>& histograms)
+{
+    histograms.assign((size_t)samples.features() * n_bins, 0.0f);
+    Mat block;
+    int first = 0;
+    for (int i = 0; i < samples.blocks(); ++i) {
+        samples.get(i, block);
+        parallel_for_(Range(0, samples.features()),
+                      WaldBoostHistogramInvoker(block, &weights[first], n_bins, &histograms[0]));
+        first += samples.block_size(i);
+    }
 }
 
 void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
@@ -188,82 +461,82 @@ void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
     // data_neg: F x N_neg
     // every feature corresponds to row
     // every sample corresponds to column
-    assert(data_pos.rows >= weak_count_);
     assert(data_pos.rows == data_neg.rows);
 
-    std::vector<bool> feature_ignore;
-    for (int i = 0; i < data_pos.rows; ++i) {
-        feature_ignore.push_back(false);
-    }
-
-    Mat1f pos_weights(1, data_pos.cols, 1.0f / (2 * data_pos.cols));
-    Mat1f neg_weights(1, data_neg.cols, 1.0f / (2 * data_neg.cols));
-    Mat1f pos_trace(1, data_pos.cols, 0.0f);
-    Mat1f neg_trace(1, data_neg.cols, 0.0f);
-
-    bool quantize = false;
+    Mat1f data_min, data_step;
     if (data_pos.type() != CV_8U) {
         std::cerr << "quantize" << std::endl;
-        quantize = true;
-    }
-
-    Mat1f data_min, data_step;
-    int n_bins = 256;
-    if (quantize) {
-        compute_min_step(data_pos, data_neg, n_bins, data_min, data_step);
+        compute_min_step(data_pos, data_neg, 256, data_min, data_step);
         quantize_data(data_pos, data_min, data_step);
         quantize_data(data_neg, data_min, data_step);
     }
 
-    std::cerr << "pos=" << data_pos.cols << " neg=" << data_neg.cols << std::endl;
+    WaldBoostSamples pos, neg;
+    pos.add(data_pos.isContinuous() ? data_pos : data_pos.clone());
+    neg.add(data_neg.isContinuous() ? data_neg : data_neg.clone());
+    fit(pos, neg, data_min, data_step);
+}
+
+void WaldBoost::fit(const WaldBoostSamples& pos, const WaldBoostSamples& neg,
+                    const Mat1f& data_min, const Mat1f& data_step)
+{
+    const int n_features = pos.features();
+    const int n_pos = pos.samples();
+    const int n_neg = neg.samples();
+    assert(n_features >= weak_count_);
+    assert(n_features == neg.features());
+
+    std::vector<bool> feature_ignore(n_features, false);
+
+    std::vector<float> pos_weights(n_pos, 1.0f / (2 * n_pos));
+    std::vector<float> neg_weights(n_neg, 1.0f / (2 * n_neg));
+    std::vector<float> pos_trace(n_pos, 0.0f);
+    std::vector<float> neg_trace(n_neg, 0.0f);
+    // The rejected negative samples keep a zero weight
+    std::vector<uchar> neg_active(n_neg, 1);
+    int neg_count = n_neg;
+
+    bool quantize = !data_min.empty();
+    const int n_bins = 256;
+    std::vector<float> pos_hist, neg_hist;
+    std::vector<WaldBoostSplit> splits(n_features);
+    Mat values;
+
+    std::cerr << "pos=" << n_pos << " neg=" << n_neg << std::endl;
     for (int i = 0; i < weak_count_; ++i) {
-        // Train weak learner with lowest error using weights
+        // Train weak learner with lowest error using weights, the features are
+        // searched in parallel
+        compute_histograms(pos, pos_weights, n_bins, pos_hist);
+        compute_histograms(neg, neg_weights, n_bins, neg_hist);
+
+        double neg_sum = 0;
+        for (int j = 0; j < n_neg; ++j)
+            neg_sum += neg_weights[j];
+        float neg_total = (float)neg_sum;
+
+        parallel_for_(Range(0, n_features),
+                      WaldBoostSplitInvoker(pos_hist, neg_hist, neg_total, n_bins,
+                                            feature_ignore, splits));
+
         double min_err = DBL_MAX;
         int min_feature_ind = -1;
         int min_polarity = 0;
         int threshold_q = 0;
         float min_threshold = 0;
-//#pragma omp parallel for
-        for (int feat_i = 0; feat_i < data_pos.rows; ++feat_i) {
-            if (feature_ignore[feat_i])
+        for (int feat_i = 0; feat_i < n_features; ++feat_i) {
+            if (feature_ignore[feat_i] || !(splits[feat_i].err < min_err))
                 continue;
-
-            // Construct cdf
-            Mat1f pos_cdf(1, n_bins), neg_cdf(1, n_bins);
-            compute_cdf(data_pos.row(feat_i), pos_weights, pos_cdf);
-            compute_cdf(data_neg.row(feat_i), neg_weights, neg_cdf);
-
-            float neg_total = (float)sum(neg_weights)[0];
-            Mat1f err_direct = pos_cdf + neg_total - neg_cdf;
-            Mat1f err_backward = 1.0f - err_direct;
-
-            int idx1[2], idx2[2];
-            double err1, err2;
-            minMaxIdx(err_direct, &err1, NULL, idx1);
-            minMaxIdx(err_backward, &err2, NULL, idx2);
-//#pragma omp critical
-            {
-            if (min(err1, err2) < min_err) {
-                if (err1 < err2) {
-                    min_err = err1;
-                    min_polarity = +1;
-                    threshold_q = idx1[1];
-                } else {
-                    min_err = err2;
-                    min_polarity = -1;
-                    threshold_q = idx2[1];
-                }
-                min_feature_ind = feat_i;
-                if (quantize) {
-                    min_threshold = data_min(feat_i, 0) + data_step(feat_i, 0) *
-                        (threshold_q + .5f);
-                } else {
-                    min_threshold = threshold_q + .5f;
-                }
-            }
-            }
+            min_err = splits[feat_i].err;
+            min_polarity = splits[feat_i].polarity;
+            threshold_q = splits[feat_i].threshold_q;
+            min_feature_ind = feat_i;
+        }
+        if (quantize) {
+            min_threshold = data_min(min_feature_ind, 0) + data_step(min_feature_ind, 0) *
+                (threshold_q + .5f);
+        } else {
+            min_threshold = threshold_q + .5f;
         }
-
 
         float alpha = .5f * (float)log((1 - min_err) / min_err);
         alphas_.push_back(alpha);
@@ -274,24 +547,33 @@ void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
 
         double loss = 0;
         // Update positive weights
-        for (int j = 0; j < data_pos.cols; ++j) {
-            int val = data_pos.at<unsigned char>(min_feature_ind, j);
-            int label = min_polarity * (val - threshold_q) >= 0 ? +1 : -1;
-            pos_weights(0, j) *= exp(-alpha * label);
-            pos_trace(0, j) += alpha * label;
-            loss += exp(-pos_trace(0, j)) / (2.0f * data_pos.cols);
+        for (int b = 0, j = 0; b < pos.blocks(); ++b) {
+            pos.get_row(b, min_feature_ind, values);
+            const uchar* v = values.ptr<uchar>();
+            for (int k = 0; k < values.cols; ++k, ++j) {
+                int val = v[k];
+                int label = min_polarity * (val - threshold_q) >= 0 ? +1 : -1;
+                pos_weights[j] *= exp(-alpha * label);
+                pos_trace[j] += alpha * label;
+                loss += exp(-pos_trace[j]) / (2.0f * n_pos);
+            }
         }
 
         // Update negative weights
-        for (int j = 0; j < data_neg.cols; ++j) {
-            int val = data_neg.at<unsigned char>(min_feature_ind, j);
-            int label = min_polarity * (val - threshold_q) >= 0 ? +1 : -1;
-            neg_weights(0, j) *= exp(alpha * label);
-            neg_trace(0, j) += alpha * label;
-            loss += exp(+neg_trace(0, j)) / (2.0f * data_neg.cols);
+        for (int b = 0, j = 0; b < neg.blocks(); ++b) {
+            neg.get_row(b, min_feature_ind, values);
+            const uchar* v = values.ptr<uchar>();
+            for (int k = 0; k < values.cols; ++k, ++j) {
+                if (!neg_active[j])
+                    continue;
+                int val = v[k];
+                int label = min_polarity * (val - threshold_q) >= 0 ? +1 : -1;
+                neg_weights[j] *= exp(alpha * label);
+                neg_trace[j] += alpha * label;
+                loss += exp(+neg_trace[j]) / (2.0f * neg_count);
+            }
         }
-        double cascade_threshold = -1;
-        minMaxIdx(pos_trace, &cascade_threshold);
+        double cascade_threshold = *std::min_element(pos_trace.begin(), pos_trace.end());
         cascade_thresholds_.push_back((float)cascade_threshold);
 
         std::cerr << "i=" << std::setw(4) << i;
@@ -303,33 +585,19 @@ void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
              << alpha << " err=" << std::fixed << std::setprecision(3) << min_err
              << " loss=" << std::scientific << loss << std::endl;
 
-        //int pos = 0;
-        //for (int j = 0; j < data_pos.cols; ++j) {
-        //    if (pos_trace(0, j) > cascade_threshold - 0.5) {
-        //        pos_trace(0, pos) = pos_trace(0, j);
-        //        data_pos.col(j).copyTo(data_pos.col(pos));
-        //        pos_weights(0, pos) = pos_weights(0, j);
-        //        pos += 1;
-        //    }
-        //}
-        //std::cerr << "pos " << data_pos.cols << "/" << pos << std::endl;
-        //pos_trace = pos_trace.colRange(0, pos);
-        //data_pos = data_pos.colRange(0, pos);
-        //pos_weights = pos_weights.colRange(0, pos);
-
-        int pos = 0;
-        for (int j = 0; j < data_neg.cols; ++j) {
-            if (neg_trace(0, j) > cascade_threshold - 0.5) {
-                neg_trace(0, pos) = neg_trace(0, j);
-                data_neg.col(j).copyTo(data_neg.col(pos));
-                neg_weights(0, pos) = neg_weights(0, j);
-                pos += 1;
+        int kept = 0;
+        for (int j = 0; j < n_neg; ++j) {
+            if (!neg_active[j])
+                continue;
+            if (neg_trace[j] > cascade_threshold - 0.5) {
+                kept += 1;
+            } else {
+                neg_active[j] = 0;
+                neg_weights[j] = 0;
             }
         }
-        std::cerr << "neg " << data_neg.cols << "/" << pos << std::endl;
-        neg_trace = neg_trace.colRange(0, pos);
-        data_neg = data_neg.colRange(0, pos);
-        neg_weights = neg_weights.colRange(0, pos);
+        std::cerr << "neg " << neg_count << "/" << kept << std::endl;
+        neg_count = kept;
 
 
         if (loss < 1e-50 || min_err > 0.5) {
@@ -339,9 +607,15 @@ void WaldBoost::fit(Mat& data_pos, Mat& data_neg)
         }
 
         // Normalize weights
-        double z = (sum(pos_weights) + sum(neg_weights))[0];
-        pos_weights /= z;
-        neg_weights /= z;
+        double z = 0;
+        for (int j = 0; j < n_pos; ++j)
+            z += pos_weights[j];
+        for (int j = 0; j < n_neg; ++j)
+            z += neg_weights[j];
+        for (int j = 0; j < n_pos; ++j)
+            pos_weights[j] = (float)(pos_weights[j] / z);
+        for (int j = 0; j < n_neg; ++j)
+            neg_weights[j] = (float)(neg_weights[j] / z);
     }
 }
 
@@ -50,6 +50,37 @@ the use of this software, even if advised of the possibility of such damage.
 namespace cv {
 namespace xobjdetect {
 
+// Quantized feature values of training samples, one row per feature and one column per
+// sample, split in blocks of samples. The blocks beyond max_memory bytes are written to
+// temporary files and read back one at a time, so the sample sets can exceed the memory.
+class WaldBoostSamples {
+public:
+    explicit WaldBoostSamples(size_t max_memory = (size_t)-1);
+    ~WaldBoostSamples();
+
+    void add(const Mat& block);
+    void get(int i, Mat& block) const;
+    void get_row(int i, int row, Mat& values) const;
+
+    int blocks() const { return (int)sizes_.size(); }
+    int block_size(int i) const { return sizes_[i]; }
+    int samples() const { return samples_; }
+    int features() const { return features_; }
+
+private:
+    WaldBoostSamples(const WaldBoostSamples&);
+    WaldBoostSamples& operator=(const WaldBoostSamples&);
+
+    size_t max_memory_;
+    size_t memory_;
+    int samples_;
+    int features_;
+    std::vector<int> sizes_;
+    // For each block either its values or the file holding them
+    std::vector<Mat> blocks_;
+    std::vector<std::string> files_;
+};
+
 class WaldBoost {
 public:
     WaldBoost(int weak_count);
@@ -60,15 +91,29 @@ public:
                 const Mat& img,
                 const std::vector<float>& scales,
                 std::vector<Rect>& bboxes,
-                Mat1f& confidences);
+                Mat1f& confidences,
+                int step = 4) const;
 
     void detect(Ptr<CvFeatureEvaluator> eval,
                 const Mat& img,
                 const std::vector<float>& scales,
                 std::vector<Rect>& bboxes,
-                std::vector<double>& confidences);
+                std::vector<double>& confidences,
+                int step = 4) const;
+
+    // Runs the cascade on the windows of a row of an integral image starting at the columns
+    // cols, offsets holds the offsets of the features of the weak classifiers, offsets_step
+    // values per weak classifier. On return cols and scores only hold the accepted windows.
+    void scan_row(const CvFeatureEvaluator& eval, const int* row_sum,
+                  const int* offsets, int offsets_step,
+                  std::vector<int>& cols, std::vector<float>& scores,
+                  std::vector<float>& values) const;
 
     void fit(Mat& data_pos, Mat& data_neg);
+    // data_min and data_step give the quantization of the features, empty for
+    // features that are not quantized
+    void fit(const WaldBoostSamples& pos, const WaldBoostSamples& neg,
+             const Mat1f& data_min = Mat1f(), const Mat1f& data_step = Mat1f());
     int predict(Ptr<CvFeatureEvaluator> eval, float *h) const;
     void save(const std::string& filename);
     void load(const std::string& filename);
@@ -80,6 +125,13 @@ public:
     ~WaldBoost();
 
 private:
+    void scan(const CvFeatureEvaluator& eval,
+              const Mat& img,
+              const std::vector<float>& scales,
+              int step,
+              std::vector<Rect>& bboxes,
+              std::vector<float>& confidences) const;
+
     int weak_count_;
     std::vector<float> thresholds_;
     std::vector<float> alphas_;
@@ -89,6 +89,66 @@ static vector<Mat> read_imgs(const string& path)
     return imgs;
 }
 
+WBDetectorImpl::WBDetectorImpl() :
+    params_(CvFeatureParams::create()),
+    eval_(CvFeatureEvaluator::create())
+{
+    eval_->init(params_, 1, Size(24, 24));
+}
+
+// Computes the values of all the features of a set of samples
+class FeatureInvoker : public ParallelLoopBody
+{
+public:
+    FeatureInvoker(const CvFeatureEvaluator& eval, const vector<Mat>& imgs,
+                   size_t first, Mat& data) :
+        eval_(eval), imgs_(imgs), first_(first), data_(data) {}
+
+    void operator()(const Range& range) const
+    {
+        const int n_features = eval_.getNumFeatures();
+        vector<int> offsets;
+        int sum_step = -1, offsets_step = 0;
+        Mat sum;
+        const int col = 0;
+        for (int k = range.start; k < range.end; ++k) {
+            integral(imgs_[first_ + k], sum, CV_32S);
+            if ((int)sum.step1() != sum_step) {
+                sum_step = (int)sum.step1();
+                offsets.clear();
+                for (int j = 0; j < n_features; ++j)
+                    eval_.getFeatureOffsets(j, sum_step, offsets);
+                offsets_step = (int)(offsets.size() / n_features);
+            }
+            for (int j = 0; j < n_features; ++j) {
+                float value;
+                eval_.calcFeatures(&offsets[j * offsets_step], sum.ptr<int>(), &col, 1, &value);
+                data_.at<uchar>(j, k) = (uchar)value;
+            }
+        }
+    }
+
+private:
+    const CvFeatureEvaluator& eval_;
+    const vector<Mat>& imgs_;
+    size_t first_;
+    Mat& data_;
+};
+
+// Computes the features of the samples block by block, the blocks that do not fit
+// in the memory of samples are written to disk as soon as they are computed
+static void compute_samples(const CvFeatureEvaluator& eval, const vector<Mat>& imgs,
+                            WaldBoostSamples& samples)
+{
+    const size_t block_size = 4096;
+    for (size_t first = 0; first < imgs.size(); first += block_size) {
+        int count = (int)min(block_size, imgs.size() - first);
+        Mat1b block(eval.getNumFeatures(), count);
+        parallel_for_(Range(0, count), FeatureInvoker(eval, imgs, first, block));
+        samples.add(block);
+    }
+}
+
 void WBDetectorImpl::read(const FileNode& node)
 {
     boost_.read(node);
@@ -112,7 +172,8 @@ void WBDetectorImpl::train(
     assert(neg_imgs.size());
 
     int n_features;
-    Mat pos_data, neg_data;
+    // Beyond this size the feature values are kept on disk during the training
+    const size_t max_memory = (size_t)1 << 30;
 
     Ptr<CvFeatureEvaluator> eval = CvFeatureEvaluator::create();
     eval->init(CvFeatureParams::create(), 1, Size(24, 24));
@@ -135,26 +196,13 @@ void WBDetectorImpl::train(
 
         cerr << "compute features" << endl;
 
-        pos_data = Mat1b(n_features, (int)pos_imgs.size());
-        neg_data = Mat1b(n_features, (int)neg_imgs.size());
-
-        for (size_t k = 0; k < pos_imgs.size(); ++k) {
-            eval->setImage(pos_imgs[k], +1, 0, boost_.get_feature_indices());
-            for (int j = 0; j < n_features; ++j) {
-                pos_data.at<uchar>(j, (int)k) = (uchar)(*eval)(j);
-            }
-        }
-
-        for (size_t k = 0; k < neg_imgs.size(); ++k) {
-            eval->setImage(neg_imgs[k], 0, 0, boost_.get_feature_indices());
-            for (int j = 0; j < n_features; ++j) {
-                neg_data.at<uchar>(j, (int)k) = (uchar)(*eval)(j);
-            }
-        }
-
+        WaldBoostSamples pos_samples(max_memory / 2), neg_samples(max_memory / 2);
+        compute_samples(*eval, pos_imgs, pos_samples);
+        compute_samples(*eval, neg_imgs, neg_samples);
+        CV_Assert(pos_samples.features() == n_features);
 
         boost_.reset(stages[i]);
-        boost_.fit(pos_data, neg_data);
+        boost_.fit(pos_samples, neg_samples);
 
         if (i + 1 == stage_count) {
             break;
@@ -198,17 +246,21 @@ void WBDetectorImpl::detect(
     vector<Rect> &bboxes,
     vector<double> &confidences)
 {
-    Mat test_img = img.clone();
-    bboxes.clear();
-    confidences.clear();
     vector<float> scales;
     for (float scale = 0.2f; scale < 1.2f; scale *= 1.1f) {
         scales.push_back(scale);
     }
-    Ptr<CvFeatureParams> params = CvFeatureParams::create();
-    Ptr<CvFeatureEvaluator> eval = CvFeatureEvaluator::create();
-    eval->init(params, 1, Size(24, 24));
-    boost_.detect(eval, img, scales, bboxes, confidences);
+    detect(img, scales, 4, bboxes, confidences);
+}
+
+void WBDetectorImpl::detect(
+    const Mat& img,
+    const vector<float>& scales,
+    int step,
+    vector<Rect> &bboxes,
+    vector<double> &confidences)
+{
+    boost_.detect(eval_, img, scales, bboxes, confidences, step);
     assert(confidences.size() == bboxes.size());
 }
 
@@ -55,6 +55,8 @@ namespace xobjdetect
 
 class WBDetectorImpl : public WBDetector {
 public:
+    WBDetectorImpl();
+
     virtual void read(const FileNode &node);
     virtual void write(FileStorage &fs) const;
 
@@ -67,8 +69,18 @@ public:
         std::vector<Rect> &bboxes,
         std::vector<double> &confidences);
 
+    virtual void detect(
+        const Mat& img,
+        const std::vector<float>& scales,
+        int step,
+        std::vector<Rect> &bboxes,
+        std::vector<double> &confidences);
+
 private:
     WaldBoost boost_;
+    // Only read by detect(), so it is created once and shared by the calls
+    Ptr<CvFeatureParams> params_;
+    Ptr<CvFeatureEvaluator> eval_;
 };
 
 } /* namespace xobjdetect */
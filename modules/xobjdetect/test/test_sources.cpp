@@ -0,0 +1,8 @@
+#include "test_precomp.hpp"
+
+// The WaldBoost classifier and the feature evaluator are internal to the
+// module and are not exported from the library, so their implementation is
+// built into the test binary.
+#include "../src/feature_evaluator.cpp"
+#include "../src/lbpfeatures.cpp"
+#include "../src/waldboost.cpp"
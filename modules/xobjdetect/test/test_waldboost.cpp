@@ -0,0 +1,88 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::xobjdetect;
+
+// quantized feature values, one row per feature and one column per sample;
+// the first features of the positive samples are shifted so that they can
+// be told apart from the negative ones
+static Mat makeSamples(RNG& rng, int features, int samples, bool positive)
+{
+    Mat data(features, samples, CV_8U);
+    rng.fill(data, RNG::UNIFORM, 0, 256);
+    if (positive)
+        for (int f = 0; f < 6; f++)
+            data.row(f) = data.row(f) * 0.5 + (f % 2 ? 0 : 100);
+    return data;
+}
+
+// the samples split in blocks of blockSize samples, only the first one
+// being kept in memory
+static void addBlocks(const Mat& data, int blockSize, WaldBoostSamples& samples)
+{
+    for (int first = 0; first < data.cols; first += blockSize)
+        samples.add(data.colRange(first, std::min(first + blockSize, data.cols)).clone());
+}
+
+static std::string serialize(const WaldBoost& boost)
+{
+    FileStorage fs(".yml", FileStorage::WRITE + FileStorage::MEMORY);
+    fs << "waldboost";
+    boost.write(fs);
+    return fs.releaseAndGetString();
+}
+
+TEST(xobjdetect_WaldBoost, blocks_and_spilled_samples_train_the_same_cascade)
+{
+    RNG rng(0x3141);
+    const int features = 50, weakCount = 8, blockSize = 64;
+    Mat dataPos = makeSamples(rng, features, 150, true);
+    Mat dataNeg = makeSamples(rng, features, 333, false);
+
+    WaldBoost expected(weakCount);
+    Mat pos = dataPos.clone(), neg = dataNeg.clone();
+    expected.fit(pos, neg);
+
+    WaldBoostSamples posSamples((size_t)features * blockSize), negSamples((size_t)features * blockSize);
+    addBlocks(dataPos, blockSize, posSamples);
+    addBlocks(dataNeg, blockSize, negSamples);
+    ASSERT_EQ(dataPos.cols, posSamples.samples());
+    ASSERT_EQ(dataNeg.cols, negSamples.samples());
+    ASSERT_GT(negSamples.blocks(), 2);
+
+    WaldBoost boost(weakCount);
+    boost.fit(posSamples, negSamples);
+
+    std::vector<int> expectedIndices = expected.get_feature_indices();
+    EXPECT_FALSE(expectedIndices.empty());
+    EXPECT_EQ(expectedIndices, boost.get_feature_indices());
+    // the thresholds, polarities and weights of the weak classifiers
+    EXPECT_EQ(serialize(expected), serialize(boost));
+}
+
+TEST(xobjdetect_WaldBoost, training_does_not_depend_on_threads)
+{
+    RNG rng(0x2718);
+    const int features = 50, weakCount = 8;
+    Mat dataPos = makeSamples(rng, features, 150, true);
+    Mat dataNeg = makeSamples(rng, features, 333, false);
+
+    int nthreads = getNumThreads();
+    WaldBoost serial(weakCount), parallel(weakCount);
+    Mat pos = dataPos.clone(), neg = dataNeg.clone();
+    setNumThreads(1);
+    serial.fit(pos, neg);
+    pos = dataPos.clone();
+    neg = dataNeg.clone();
+    setNumThreads(std::max(nthreads, 4));
+    parallel.fit(pos, neg);
+    setNumThreads(nthreads);
+
+    EXPECT_EQ(serial.get_feature_indices(), parallel.get_feature_indices());
+    EXPECT_EQ(serialize(serial), serialize(parallel));
+}
+
+}
@@ -0,0 +1,217 @@
+#include "test_precomp.hpp"
+
+namespace cvtest
+{
+
+using namespace cv;
+using namespace cv::xobjdetect;
+
+// a small cascade of LBP stumps that accepts part of the windows of a textured image
+static const char* wbdetector_model =
+    "%YAML:1.0\n"
+    "waldboost:\n"
+    "   waldboost_params:\n"
+    "      weak_count: 6\n"
+    "   thresholds: [ 100., 60., 150., 128., 30., 200. ]\n"
+    "   alphas: [ 1., .8, .6, .5, .4, .3 ]\n"
+    "   polarities: [ 1, -1, 1, -1, 1, -1 ]\n"
+    "   cascade_thresholds: [ -10., -10., -10., -10., -10., 0. ]\n"
+    "   feature_indices: [ 0, 250, 1000, 2500, 4000, 5500 ]\n";
+
+static Ptr<WBDetector> createTestDetector()
+{
+    FileStorage fs(wbdetector_model, FileStorage::READ + FileStorage::MEMORY);
+    Ptr<WBDetector> detector = WBDetector::create();
+    detector->read(fs.getFirstTopLevelNode());
+    return detector;
+}
+
+static Ptr<CvFeatureEvaluator> createTestEvaluator(Ptr<CvFeatureParams>& params)
+{
+    params = CvFeatureParams::create();
+    Ptr<CvFeatureEvaluator> eval = CvFeatureEvaluator::create();
+    eval->init(params, 1, Size(24, 24));
+    return eval;
+}
+
+static void readTestBoost(WaldBoost& boost)
+{
+    FileStorage fs(wbdetector_model, FileStorage::READ + FileStorage::MEMORY);
+    boost.read(fs.getFirstTopLevelNode());
+}
+
+static Mat createTestImage()
+{
+    RNG rng(0x5678);
+    Mat img(240, 320, CV_8UC1);
+    rng.fill(img, RNG::UNIFORM, 0, 256);
+    GaussianBlur(img, img, Size(5, 5), 1.5);
+    for (int i = 0; i < 20; i++)
+    {
+        Point center(rng.uniform(0, img.cols), rng.uniform(0, img.rows));
+        circle(img, center, rng.uniform(5, 40), Scalar::all(rng.uniform(0, 256)), -1);
+    }
+    return img;
+}
+
+static void expectSameDetections(const std::vector<Rect>& bboxes1, const std::vector<double>& confidences1,
+                                 const std::vector<Rect>& bboxes2, const std::vector<double>& confidences2)
+{
+    ASSERT_EQ(bboxes1.size(), bboxes2.size());
+    ASSERT_EQ(confidences1.size(), confidences2.size());
+    for (size_t i = 0; i < bboxes1.size(); i++)
+    {
+        EXPECT_EQ(bboxes1[i], bboxes2[i]) << "detection " << i;
+        EXPECT_EQ(confidences1[i], confidences2[i]) << "detection " << i;
+    }
+}
+
+// windows accepted by the cascade, evaluated one window at a time on the
+// features of the current window of the evaluator
+static void predictWindows(const WaldBoost& boost, const Ptr<CvFeatureEvaluator>& eval,
+                           const Mat& resized, const std::vector<int>& featureIndices,
+                           int step, std::vector<Point>& windows, std::vector<float>& scores)
+{
+    windows.clear();
+    scores.clear();
+    eval->setImage(resized, 0, 0, featureIndices);
+    for (int r = 0; r + 24 < resized.rows; r += step)
+        for (int c = 0; c + 24 < resized.cols; c += step)
+        {
+            eval->setWindow(Point(c, r));
+            float h = 0;
+            if (boost.predict(eval, &h) == +1)
+            {
+                windows.push_back(Point(c, r));
+                scores.push_back(h);
+            }
+        }
+}
+
+TEST(xobjdetect_WBDetector, scan_row_matches_window_by_window_prediction)
+{
+    Ptr<CvFeatureParams> params;
+    Ptr<CvFeatureEvaluator> eval = createTestEvaluator(params);
+    WaldBoost boost;
+    readTestBoost(boost);
+    std::vector<int> featureIndices = boost.get_feature_indices();
+    Mat img = createTestImage();
+
+    const float scales[] = { 0.35f, 0.6f, 1.f };
+    const int step = 3;
+    int accepted = 0;
+    for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); s++)
+    {
+        Mat resized, sum;
+        resize(img, resized, Size(), scales[s], scales[s]);
+        integral(resized, sum, CV_32S);
+
+        std::vector<int> offsets;
+        for (size_t i = 0; i < featureIndices.size(); i++)
+            eval->getFeatureOffsets(featureIndices[i], (int)sum.step1(), offsets);
+        int offsetsStep = (int)(offsets.size() / featureIndices.size());
+
+        // all the windows of a row go through the cascade together, the
+        // rejected ones being removed after each weak classifier
+        std::vector<Point> windows;
+        std::vector<float> scores, values;
+        for (int r = 0; r + 24 < resized.rows; r += step)
+        {
+            std::vector<int> cols;
+            std::vector<float> rowScores;
+            for (int c = 0; c + 24 < resized.cols; c += step)
+                cols.push_back(c);
+            boost.scan_row(*eval, sum.ptr<int>(r), &offsets[0], offsetsStep, cols, rowScores, values);
+            ASSERT_EQ(cols.size(), rowScores.size());
+            for (size_t j = 0; j < cols.size(); j++)
+            {
+                windows.push_back(Point(cols[j], r));
+                scores.push_back(rowScores[j]);
+            }
+        }
+
+        std::vector<Point> expectedWindows;
+        std::vector<float> expectedScores;
+        predictWindows(boost, eval, resized, featureIndices, step, expectedWindows, expectedScores);
+
+        ASSERT_EQ(expectedWindows.size(), windows.size()) << "scale " << scales[s];
+        for (size_t i = 0; i < windows.size(); i++)
+        {
+            EXPECT_EQ(expectedWindows[i], windows[i]) << "scale " << scales[s] << ", window " << i;
+            EXPECT_EQ(expectedScores[i], scores[i]) << "scale " << scales[s] << ", window " << i;
+        }
+        accepted += (int)windows.size();
+    }
+    EXPECT_GT(accepted, 0);
+}
+
+TEST(xobjdetect_WBDetector, detect_matches_window_by_window_prediction)
+{
+    Ptr<CvFeatureParams> params;
+    Ptr<CvFeatureEvaluator> eval = createTestEvaluator(params);
+    WaldBoost boost;
+    readTestBoost(boost);
+    std::vector<int> featureIndices = boost.get_feature_indices();
+    Mat img = createTestImage();
+
+    std::vector<float> scales;
+    for (float scale = 0.2f; scale < 1.2f; scale *= 1.1f)
+        scales.push_back(scale);
+
+    // the detections of all the scales, grouped as detect() does
+    std::vector<Rect> expectedBboxes;
+    std::vector<double> expectedConfidences;
+    for (size_t s = 0; s < scales.size(); s++)
+    {
+        Mat resized;
+        resize(img, resized, Size(), scales[s], scales[s]);
+        std::vector<Point> windows;
+        std::vector<float> scores;
+        predictWindows(boost, eval, resized, featureIndices, 4, windows, scores);
+
+        int size = (int)(24 / scales[s]);
+        for (size_t i = 0; i < windows.size(); i++)
+        {
+            expectedBboxes.push_back(Rect((int)(windows[i].x / scales[s]), (int)(windows[i].y / scales[s]), size, size));
+            expectedConfidences.push_back(scores[i]);
+        }
+    }
+    std::vector<int> levels(expectedBboxes.size(), 0);
+    groupRectangles(expectedBboxes, levels, expectedConfidences, 3, 0.7);
+    EXPECT_FALSE(expectedBboxes.empty());
+
+    std::vector<Rect> bboxes;
+    std::vector<double> confidences;
+    boost.detect(eval, img, scales, bboxes, confidences, 4);
+    expectSameDetections(expectedBboxes, expectedConfidences, bboxes, confidences);
+
+    // the detector uses the same scales and step by default
+    std::vector<Rect> detectorBboxes;
+    std::vector<double> detectorConfidences;
+    createTestDetector()->detect(img, detectorBboxes, detectorConfidences);
+    expectSameDetections(expectedBboxes, expectedConfidences, detectorBboxes, detectorConfidences);
+}
+
+TEST(xobjdetect_WBDetector, detect_does_not_depend_on_threads)
+{
+    Ptr<WBDetector> detector = createTestDetector();
+    Mat img = createTestImage();
+
+    std::vector<float> scales;
+    scales.push_back(0.5f);
+    scales.push_back(0.75f);
+    scales.push_back(1.0f);
+
+    int nthreads = getNumThreads();
+    std::vector<Rect> serialBboxes, parallelBboxes;
+    std::vector<double> serialConfidences, parallelConfidences;
+    setNumThreads(1);
+    detector->detect(img, scales, 2, serialBboxes, serialConfidences);
+    setNumThreads(std::max(nthreads, 4));
+    detector->detect(img, scales, 2, parallelBboxes, parallelConfidences);
+    setNumThreads(nthreads);
+
+    expectSameDetections(serialBboxes, serialConfidences, parallelBboxes, parallelConfidences);
+}
+
+}